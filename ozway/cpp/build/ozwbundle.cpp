@@ -0,0 +1,330 @@
+//-----------------------------------------------------------------------------
+//
+//	ozwbundle.cpp
+//
+//	Build time compiler for the precompiled device database bundle.
+//
+//	Walks the config folder and writes a single file containing the
+//	manufacturer and product tables from manufacturer_specific.xml (with
+//	the Revision of every product config file resolved up front), and the
+//	text of every other XML file, ready to be mapped by ConfigBundle.
+//
+//	Usage: ozwbundle <config folder> <output file>
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ConfigBundle.h"
+#include "tinyxml.h"
+
+using namespace OpenZWave;
+using namespace OpenZWave::Internal;
+
+static std::string s_strings;
+static std::map<std::string, uint32> s_stringIndex;
+
+//-----------------------------------------------------------------------------
+// <Intern>
+// Add a string to the string table, sharing identical strings
+//-----------------------------------------------------------------------------
+static uint32 Intern(std::string const& _str)
+{
+	std::map<std::string, uint32>::iterator it = s_stringIndex.find(_str);
+	if (it != s_stringIndex.end())
+	{
+		return it->second;
+	}
+	uint32 offset = (uint32) s_strings.size();
+	s_strings.append(_str);
+	s_strings.push_back('\0');
+	s_stringIndex[_str] = offset;
+	return offset;
+}
+
+//-----------------------------------------------------------------------------
+// <ReadFile>
+// Read a file, normalizing the line endings the same way TiXmlDocument::LoadFile does
+//-----------------------------------------------------------------------------
+static bool ReadFile(std::string const& _path, std::string* o_data)
+{
+	std::ifstream in(_path.c_str(), std::ios::in | std::ios::binary);
+	if (!in)
+	{
+		return false;
+	}
+	std::stringstream ss;
+	ss << in.rdbuf();
+	std::string const& raw = ss.str();
+	o_data->clear();
+	o_data->reserve(raw.size());
+	for (size_t i = 0; i < raw.size(); ++i)
+	{
+		if (raw[i] == '\r')
+		{
+			o_data->push_back('\n');
+			if (i + 1 < raw.size() && raw[i + 1] == '\n')
+			{
+				++i;
+			}
+		}
+		else
+		{
+			o_data->push_back(raw[i]);
+		}
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// <ListXMLFiles>
+// Recursively collect the XML files below the config folder
+//-----------------------------------------------------------------------------
+static void ListXMLFiles(std::string const& _root, std::string const& _relDir, std::vector<std::string>* o_files)
+{
+	DIR* dir = opendir((_root + _relDir).c_str());
+	if (!dir)
+	{
+		return;
+	}
+	while (struct dirent* entry = readdir(dir))
+	{
+		std::string name = entry->d_name;
+		if (name == "." || name == "..")
+		{
+			continue;
+		}
+		std::string rel = _relDir + name;
+		struct stat st;
+		if (stat((_root + rel).c_str(), &st) != 0)
+		{
+			continue;
+		}
+		if (S_ISDIR(st.st_mode))
+		{
+			ListXMLFiles(_root, rel + "/", o_files);
+		}
+		else if (name.size() > 4 && name.compare(name.size() - 4, 4, ".xml") == 0)
+		{
+			o_files->push_back(rel);
+		}
+	}
+	closedir(dir);
+}
+
+//-----------------------------------------------------------------------------
+// <ConfigRevision>
+// Read the Revision attribute of a product config file
+//-----------------------------------------------------------------------------
+static uint32 ConfigRevision(std::map<std::string, std::string> const& _files, std::string const& _relPath)
+{
+	std::map<std::string, std::string>::const_iterator it = _files.find(_relPath);
+	if (it == _files.end())
+	{
+		fprintf(stderr, "warning: %s is referenced by manufacturer_specific.xml but does not exist\n", _relPath.c_str());
+		return 0;
+	}
+	TiXmlDocument doc;
+	doc.Parse(it->second.c_str(), 0, TIXML_ENCODING_UTF8);
+	TiXmlElement const* root = doc.RootElement();
+	if (doc.Error() || !root || strcmp(root->Value(), "Product"))
+	{
+		fprintf(stderr, "warning: %s is not a valid product config file\n", _relPath.c_str());
+		return 0;
+	}
+	char const* str = root->Attribute("Revision");
+	return str ? (uint32) atol(str) : 0;
+}
+
+int main(int argc, char* argv[])
+{
+	if (argc != 3)
+	{
+		fprintf(stderr, "Usage: %s <config folder> <output file>\n", argv[0]);
+		return 1;
+	}
+	std::string root = argv[1];
+	if (root.size() && root[root.size() - 1] != '/')
+	{
+		root += "/";
+	}
+
+	std::vector<std::string> paths;
+	ListXMLFiles(root, "", &paths);
+	std::sort(paths.begin(), paths.end());
+
+	std::map<std::string, std::string> files;
+	std::map<std::string, struct stat> sources;
+	for (std::vector<std::string>::iterator it = paths.begin(); it != paths.end(); ++it)
+	{
+		if (stat((root + *it).c_str(), &sources[*it]) != 0 || !ReadFile(root + *it, &files[*it]))
+		{
+			fprintf(stderr, "Unable to read %s%s\n", root.c_str(), it->c_str());
+			return 1;
+		}
+	}
+
+	// Flatten manufacturer_specific.xml
+	std::map<std::string, std::string>::iterator mfs = files.find("manufacturer_specific.xml");
+	if (mfs == files.end())
+	{
+		fprintf(stderr, "No manufacturer_specific.xml in %s\n", root.c_str());
+		return 1;
+	}
+	TiXmlDocument doc;
+	doc.Parse(mfs->second.c_str(), 0, TIXML_ENCODING_UTF8);
+	if (doc.Error() || !doc.RootElement())
+	{
+		fprintf(stderr, "Unable to parse manufacturer_specific.xml: %s\n", doc.ErrorDesc());
+		return 1;
+	}
+
+	Bundle::Header header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.m_magic, Bundle::c_magic, sizeof(header.m_magic));
+	header.m_version = Bundle::c_version;
+	header.m_endian = Bundle::c_endian;
+	Intern("");
+
+	char const* str = doc.RootElement()->Attribute("Revision");
+	header.m_mfsRevision = str ? (uint32) atol(str) : 0;
+
+	std::vector<Bundle::Manufacturer> manufacturers;
+	std::vector<Bundle::Product> products;
+	std::set<uint64> productKeys;
+	for (TiXmlElement const* me = doc.RootElement()->FirstChildElement("Manufacturer"); me; me = me->NextSiblingElement("Manufacturer"))
+	{
+		char const* id = me->Attribute("id");
+		char const* name = me->Attribute("name");
+		if (!id || !name)
+		{
+			fprintf(stderr, "manufacturer_specific.xml line %d: missing manufacturer id or name\n", me->Row());
+			return 1;
+		}
+		Bundle::Manufacturer m;
+		memset(&m, 0, sizeof(m));
+		m.m_id = (uint16) strtol(id, NULL, 16);
+		m.m_name = Intern(name);
+		manufacturers.push_back(m);
+
+		for (TiXmlElement const* pe = me->FirstChildElement("Product"); pe; pe = pe->NextSiblingElement("Product"))
+		{
+			char const* type = pe->Attribute("type");
+			char const* pid = pe->Attribute("id");
+			char const* pname = pe->Attribute("name");
+			if (!type || !pid || !pname)
+			{
+				fprintf(stderr, "manufacturer_specific.xml line %d: missing product type, id or name\n", pe->Row());
+				return 1;
+			}
+			Bundle::Product p;
+			memset(&p, 0, sizeof(p));
+			p.m_manufacturerId = m.m_id;
+			p.m_productType = (uint16) strtol(type, NULL, 16);
+			p.m_productId = (uint16) strtol(pid, NULL, 16);
+			// the first definition wins, as it does when loading the XML
+			uint64 key = ((uint64) p.m_manufacturerId << 32) | ((uint64) p.m_productType << 16) | p.m_productId;
+			if (!productKeys.insert(key).second)
+			{
+				continue;
+			}
+			p.m_name = Intern(pname);
+			char const* config = pe->Attribute("config");
+			p.m_config = Intern(config ? config : "");
+			p.m_configRevision = config ? ConfigRevision(files, config) : 0;
+			products.push_back(p);
+		}
+	}
+
+	// Lay out the file: header, tables, string table, then the file contents
+	std::vector<Bundle::File> fileTable;
+	for (std::map<std::string, std::string>::iterator it = files.begin(); it != files.end(); ++it)
+	{
+		Bundle::File f;
+		memset(&f, 0, sizeof(f));
+		f.m_path = Intern(it->first);
+		f.m_data = 0;
+		f.m_length = (uint32) it->second.size();
+		// so that the library can tell when the installed copy has been changed
+		f.m_sourceSize = (uint32) sources[it->first].st_size;
+		f.m_sourceMTime = (uint64) sources[it->first].st_mtime;
+		fileTable.push_back(f);
+	}
+
+	uint32 offset = sizeof(header);
+	header.m_manufacturerOffset = offset;
+	header.m_manufacturerCount = (uint32) manufacturers.size();
+	offset += header.m_manufacturerCount * sizeof(Bundle::Manufacturer);
+	header.m_productOffset = offset;
+	header.m_productCount = (uint32) products.size();
+	offset += header.m_productCount * sizeof(Bundle::Product);
+	header.m_fileOffset = offset;
+	header.m_fileCount = (uint32) fileTable.size();
+	offset += header.m_fileCount * sizeof(Bundle::File);
+	header.m_stringsOffset = offset;
+	header.m_stringsSize = (uint32) s_strings.size();
+	offset += header.m_stringsSize;
+	for (std::vector<Bundle::File>::iterator it = fileTable.begin(); it != fileTable.end(); ++it)
+	{
+		it->m_data = offset;
+		offset += it->m_length + 1;
+	}
+
+	std::string tmp = std::string(argv[2]) + ".tmp";
+	FILE* out = fopen(tmp.c_str(), "wb");
+	if (!out)
+	{
+		fprintf(stderr, "Unable to create %s\n", tmp.c_str());
+		return 1;
+	}
+	bool ok = fwrite(&header, sizeof(header), 1, out) == 1;
+	ok = ok && (manufacturers.empty() || fwrite(&manufacturers[0], sizeof(Bundle::Manufacturer), manufacturers.size(), out) == manufacturers.size());
+	ok = ok && (products.empty() || fwrite(&products[0], sizeof(Bundle::Product), products.size(), out) == products.size());
+	ok = ok && (fileTable.empty() || fwrite(&fileTable[0], sizeof(Bundle::File), fileTable.size(), out) == fileTable.size());
+	ok = ok && fwrite(s_strings.data(), 1, s_strings.size(), out) == s_strings.size();
+	for (std::map<std::string, std::string>::iterator it = files.begin(); ok && it != files.end(); ++it)
+	{
+		ok = fwrite(it->second.c_str(), 1, it->second.size() + 1, out) == it->second.size() + 1;
+	}
+	ok = (fclose(out) == 0) && ok;
+	if (!ok || rename(tmp.c_str(), argv[2]) != 0)
+	{
+		fprintf(stderr, "Unable to write %s\n", argv[2]);
+		remove(tmp.c_str());
+		return 1;
+	}
+
+	printf("Wrote %s: Revision %u, %zu Manufacturers, %zu Products, %zu Files, %u bytes\n", argv[2], header.m_mfsRevision, manufacturers.size(), products.size(), fileTable.size(), offset);
+	return 0;
+}
@@ -0,0 +1,304 @@
+//-----------------------------------------------------------------------------
+//
+//	ConfigBundle.cpp
+//
+//	Precompiled Device Database Bundle
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#include <string.h>
+
+#include "ConfigBundle.h"
+#include "Options.h"
+#include "tinyxml.h"
+#include "platform/Log.h"
+#include "platform/FileOps.h"
+#include "platform/Mutex.h"
+#include "Utils.h"
+
+namespace OpenZWave
+{
+	namespace Internal
+	{
+
+		ConfigBundle* ConfigBundle::s_instance = NULL;
+
+//-----------------------------------------------------------------------------
+// <ConfigBundle::Create>
+// Static creation of the singleton.  Maps the bundle named by the ConfigBundle option
+//-----------------------------------------------------------------------------
+		ConfigBundle* ConfigBundle::Create()
+		{
+			if (s_instance == NULL)
+			{
+				s_instance = new ConfigBundle();
+
+				Options::Get()->GetOptionAsString(Options::OptionKey_ConfigPath, &s_instance->m_configPath);
+				string bundle;
+				Options::Get()->GetOptionAsString(Options::OptionKey_ConfigBundle, &bundle);
+				if (bundle.size() > 0)
+				{
+					if (bundle[0] != '/')
+					{
+						bundle = s_instance->m_configPath + bundle;
+					}
+					s_instance->Load(bundle);
+				}
+			}
+			return s_instance;
+		}
+
+//-----------------------------------------------------------------------------
+// <ConfigBundle::Destroy>
+// Static method to destroy the singleton
+//-----------------------------------------------------------------------------
+		void ConfigBundle::Destroy()
+		{
+			delete s_instance;
+			s_instance = NULL;
+		}
+
+//-----------------------------------------------------------------------------
+// <ConfigBundle::ConfigBundle>
+// Constructor
+//-----------------------------------------------------------------------------
+		ConfigBundle::ConfigBundle() :
+				m_mutex(new Internal::Platform::Mutex()), m_data(NULL), m_size(0), m_header(NULL), m_strings(NULL), m_manufacturers(NULL), m_products(NULL), m_files(NULL)
+		{
+		}
+
+//-----------------------------------------------------------------------------
+// <ConfigBundle::~ConfigBundle>
+// Destructor
+//-----------------------------------------------------------------------------
+		ConfigBundle::~ConfigBundle()
+		{
+			Unload();
+			m_mutex->Release();
+		}
+
+//-----------------------------------------------------------------------------
+// <ConfigBundle::Load>
+// Map the bundle file and validate its tables
+//-----------------------------------------------------------------------------
+		bool ConfigBundle::Load(string const& _filename)
+		{
+			Internal::Platform::FileOps::Create();
+			if (!Internal::Platform::FileOps::FileExists(_filename))
+			{
+				Log::Write(LogLevel_Info, "No Config Bundle at %s, using the XML config files", _filename.c_str());
+				return false;
+			}
+			if (!Internal::Platform::FileOps::FileMap(_filename, &m_data, &m_size))
+			{
+				Log::Write(LogLevel_Warning, "Unable to map Config Bundle %s", _filename.c_str());
+				return false;
+			}
+
+			Bundle::Header const* header = (Bundle::Header const*) m_data;
+			bool valid = (m_size >= sizeof(Bundle::Header)) && !memcmp(header->m_magic, Bundle::c_magic, sizeof(Bundle::c_magic));
+			if (valid && (header->m_version != Bundle::c_version || header->m_endian != Bundle::c_endian))
+			{
+				Log::Write(LogLevel_Warning, "Config Bundle %s is version %d (expected %d) or was built for a different architecture", _filename.c_str(), header->m_version, Bundle::c_version);
+				valid = false;
+			}
+			// make sure every table lies within the file before we hand out pointers into it
+			valid = valid && ((uint64) header->m_stringsOffset + header->m_stringsSize <= m_size) && (header->m_stringsSize > 0) && (m_data[header->m_stringsOffset + header->m_stringsSize - 1] == 0);
+			valid = valid && ((uint64) header->m_manufacturerOffset + (uint64) header->m_manufacturerCount * sizeof(Bundle::Manufacturer) <= m_size);
+			valid = valid && ((uint64) header->m_productOffset + (uint64) header->m_productCount * sizeof(Bundle::Product) <= m_size);
+			valid = valid && ((uint64) header->m_fileOffset + (uint64) header->m_fileCount * sizeof(Bundle::File) <= m_size);
+			if (valid)
+			{
+				Bundle::File const* files = (Bundle::File const*) (m_data + header->m_fileOffset);
+				for (uint32 i = 0; valid && i < header->m_fileCount; ++i)
+				{
+					valid = ((uint64) files[i].m_data + files[i].m_length < m_size) && (m_data[files[i].m_data + files[i].m_length] == 0) && (files[i].m_path < header->m_stringsSize);
+				}
+			}
+			if (!valid)
+			{
+				Log::Write(LogLevel_Warning, "Config Bundle %s is corrupt, using the XML config files", _filename.c_str());
+				Unload();
+				return false;
+			}
+
+			m_header = header;
+			m_strings = (char const*) (m_data + header->m_stringsOffset);
+			m_manufacturers = (Bundle::Manufacturer const*) (m_data + header->m_manufacturerOffset);
+			m_products = (Bundle::Product const*) (m_data + header->m_productOffset);
+			m_files = (Bundle::File const*) (m_data + header->m_fileOffset);
+			Log::Write(LogLevel_Info, "Loaded Config Bundle %s (Revision %d, %d Manufacturers, %d Products, %d Files)", _filename.c_str(), header->m_mfsRevision, header->m_manufacturerCount, header->m_productCount, header->m_fileCount);
+			return true;
+		}
+
+//-----------------------------------------------------------------------------
+// <ConfigBundle::Unload>
+// Release the mapping
+//-----------------------------------------------------------------------------
+		void ConfigBundle::Unload()
+		{
+			if (m_data)
+			{
+				Internal::Platform::FileOps::FileUnmap(m_data, m_size);
+			}
+			m_data = NULL;
+			m_size = 0;
+			m_header = NULL;
+			m_strings = NULL;
+			m_manufacturers = NULL;
+			m_products = NULL;
+			m_files = NULL;
+		}
+
+//-----------------------------------------------------------------------------
+// <ConfigBundle::FindFile>
+// Binary search the (path sorted) file table
+//-----------------------------------------------------------------------------
+		Bundle::File const* ConfigBundle::FindFile(string const& _relPath) const
+		{
+			if (!m_header)
+			{
+				return NULL;
+			}
+			uint32 lo = 0;
+			uint32 hi = m_header->m_fileCount;
+			while (lo < hi)
+			{
+				uint32 mid = lo + (hi - lo) / 2;
+				int cmp = strcmp(GetString(m_files[mid].m_path), _relPath.c_str());
+				if (cmp == 0)
+				{
+					return &m_files[mid];
+				}
+				if (cmp < 0)
+				{
+					lo = mid + 1;
+				}
+				else
+				{
+					hi = mid;
+				}
+			}
+			return NULL;
+		}
+
+//-----------------------------------------------------------------------------
+// <ConfigBundle::Invalidate>
+// A newer copy of this file exists on disk
+//-----------------------------------------------------------------------------
+		void ConfigBundle::Invalidate(string const& _relPath)
+		{
+			LockGuard LG(m_mutex);
+			m_invalidated.insert(_relPath);
+		}
+
+//-----------------------------------------------------------------------------
+// <ConfigBundle::IsValid>
+// Can this file be served from the bundle
+//-----------------------------------------------------------------------------
+		bool ConfigBundle::IsValid(string const& _relPath)
+		{
+			LockGuard LG(m_mutex);
+			if (!IsLoaded() || (m_invalidated.find(_relPath) != m_invalidated.end()))
+			{
+				return false;
+			}
+			Bundle::File const* file = FindFile(_relPath);
+			if (!file)
+			{
+				return false;
+			}
+			// a file that is missing from the ConfigPath can only come from the bundle
+			uint64 mtime;
+			uint64 size;
+			if (Internal::Platform::FileOps::FileStat(m_configPath + _relPath, &mtime, &size) && (mtime != file->m_sourceMTime || size != file->m_sourceSize))
+			{
+				Log::Write(LogLevel_Info, "%s has changed since the Config Bundle was built, using the XML file", _relPath.c_str());
+				m_invalidated.insert(_relPath);
+				return false;
+			}
+			return true;
+		}
+
+//-----------------------------------------------------------------------------
+// <ConfigBundle::LoadDocument>
+// Parse a config file from the bundle, falling back to the file in ConfigPath
+//-----------------------------------------------------------------------------
+		bool ConfigBundle::LoadDocument(string const& _relPath, TiXmlDocument* _doc, string* o_path)
+		{
+			string configPath;
+			Options::Get()->GetOptionAsString(Options::OptionKey_ConfigPath, &configPath);
+			string path = configPath + _relPath;
+			if (o_path)
+			{
+				*o_path = path;
+			}
+
+			if (s_instance && s_instance->IsValid(_relPath))
+			{
+				if (Bundle::File const* file = s_instance->FindFile(_relPath))
+				{
+					_doc->Parse((char const*) (s_instance->m_data + file->m_data), 0, TIXML_ENCODING_UTF8);
+					if (!_doc->Error())
+					{
+						return true;
+					}
+					Log::Write(LogLevel_Warning, "Failed to parse %s from the Config Bundle: %s", _relPath.c_str(), _doc->ErrorDesc());
+					_doc->Clear();
+					_doc->ClearError();
+				}
+			}
+
+			return _doc->LoadFile(path.c_str(), TIXML_ENCODING_UTF8);
+		}
+
+//-----------------------------------------------------------------------------
+// <ConfigBundle::LoadStream>
+// Start streaming a config file from the bundle, falling back to the file in ConfigPath
+//-----------------------------------------------------------------------------
+		bool ConfigBundle::LoadStream(string const& _relPath, TiXmlStreamReader* _reader, string* o_path)
+		{
+			string configPath;
+			Options::Get()->GetOptionAsString(Options::OptionKey_ConfigPath, &configPath);
+			string path = configPath + _relPath;
+			if (o_path)
+			{
+				*o_path = path;
+			}
+
+			if (s_instance && s_instance->IsValid(_relPath))
+			{
+				if (Bundle::File const* file = s_instance->FindFile(_relPath))
+				{
+					// the text stays mapped until the bundle is destroyed, so it does not need to be copied
+					if (_reader->Parse((char const*) (s_instance->m_data + file->m_data), TIXML_ENCODING_UTF8))
+					{
+						return true;
+					}
+					Log::Write(LogLevel_Warning, "Failed to parse %s from the Config Bundle: %s", _relPath.c_str(), _reader->ErrorDesc());
+				}
+			}
+
+			return _reader->LoadFile(path.c_str(), TIXML_ENCODING_UTF8);
+		}
+	} // namespace Internal
+} // namespace OpenZWave
@@ -0,0 +1,207 @@
+//-----------------------------------------------------------------------------
+//
+//	ConfigBundle.h
+//
+//	Precompiled Device Database Bundle
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef _ConfigBundle_H
+#define _ConfigBundle_H
+
+#include <string>
+#include <set>
+
+#include "Defs.h"
+
+class TiXmlDocument;
+class TiXmlStreamReader;
+
+namespace OpenZWave
+{
+	namespace Internal
+	{
+		namespace Platform
+		{
+			class Mutex;
+		}
+
+		/** \brief On-disk layout of the precompiled config bundle.
+		 *
+		 * The bundle is produced at build time by the ozwbundle tool (see cpp/build/Makefile)
+		 * from the config/ folder, and is mapped read-only at runtime.  All offsets are in
+		 * bytes from the start of the file, and all strings are interned into a single
+		 * NUL terminated string table.  The bundle is native endian, and is rejected if
+		 * m_endian does not match.
+		 */
+		namespace Bundle
+		{
+			static const char c_magic[4] = { 'O', 'Z', 'W', 'B' };
+			static const uint32 c_version = 2;
+			static const uint32 c_endian = 0x01020304;
+
+			struct Header
+			{
+					char m_magic[4];
+					uint32 m_version;
+					uint32 m_endian;
+					uint32 m_mfsRevision;			// Revision attribute of manufacturer_specific.xml
+					uint32 m_stringsOffset;
+					uint32 m_stringsSize;
+					uint32 m_manufacturerOffset;
+					uint32 m_manufacturerCount;
+					uint32 m_productOffset;
+					uint32 m_productCount;
+					uint32 m_fileOffset;
+					uint32 m_fileCount;
+			};
+
+			struct Manufacturer
+			{
+					uint16 m_id;
+					uint16 m_reserved;
+					uint32 m_name;					// string table offset
+			};
+
+			struct Product
+			{
+					uint16 m_manufacturerId;
+					uint16 m_productType;
+					uint16 m_productId;
+					uint16 m_reserved;
+					uint32 m_name;					// string table offset
+					uint32 m_config;				// string table offset, empty string if there is no config file
+					uint32 m_configRevision;		// Revision attribute of the product config file
+			};
+
+			struct File
+			{
+					uint32 m_path;					// string table offset, relative to the ConfigPath
+					uint32 m_data;					// file offset of the NUL terminated (line-ending normalized) XML text
+					uint32 m_length;				// length of the XML text, excluding the NUL
+					uint32 m_sourceSize;			// size of the file the text was read from
+					uint64 m_sourceMTime;			// modification time of that file, in seconds since the epoch
+			};
+		} // namespace Bundle
+
+		/** \brief Read-only view of the precompiled device database bundle.
+		 *
+		 * Every process would otherwise re-parse manufacturer_specific.xml, every product
+		 * config file (just to read its Revision), Localization.xml, NotificationCCTypes.xml and
+		 * SensorMultiLevelCCTypes.xml on startup.  When a bundle is present the manufacturer
+		 * and product tables are read directly from the mapped file and the remaining XML
+		 * documents are parsed from memory.  Any file that is not in the bundle, or whose
+		 * size or modification time in the ConfigPath no longer matches the copy in the bundle
+		 * (e.g. after a config download or a manual edit, even in an earlier run) is loaded
+		 * from the ConfigPath as before.
+		 */
+		class ConfigBundle
+		{
+			public:
+				static ConfigBundle* Create();
+				static ConfigBundle* Get()
+				{
+					return s_instance;
+				}
+				static void Destroy();
+
+				/**
+				 * Load an XML document from the config folder, using the bundle when possible.
+				 * \param _relPath the path of the file relative to the ConfigPath option
+				 * \param _doc the document to populate
+				 * \param o_path if not NULL, receives the path that was used (for error messages)
+				 * \return true if the document was loaded and parsed
+				 */
+				static bool LoadDocument(string const& _relPath, TiXmlDocument* _doc, string* o_path = NULL);
+				/**
+				 * As LoadDocument, but for the large files that are read with a streaming parser.
+				 */
+				static bool LoadStream(string const& _relPath, TiXmlStreamReader* _reader, string* o_path = NULL);
+
+				bool IsLoaded() const
+				{
+					return m_header != NULL;
+				}
+				/**
+				 * Stop serving a file from the bundle, because a newer copy has been written
+				 * to the config folder.  This catches a rewrite within the same second, which
+				 * IsValid's check of the file on disk cannot.
+				 */
+				void Invalidate(string const& _relPath);
+				/**
+				 * Can _relPath be served from the bundle.  False if it is not in the bundle, if
+				 * it has been invalidated, or if the copy in the ConfigPath has a different size
+				 * or modification time than the one the bundle was built from.
+				 */
+				bool IsValid(string const& _relPath);
+
+				uint32 GetMfsRevision() const
+				{
+					return m_header ? m_header->m_mfsRevision : 0;
+				}
+				uint32 GetManufacturerCount() const
+				{
+					return m_header ? m_header->m_manufacturerCount : 0;
+				}
+				Bundle::Manufacturer const* GetManufacturer(uint32 _idx) const
+				{
+					return &m_manufacturers[_idx];
+				}
+				uint32 GetProductCount() const
+				{
+					return m_header ? m_header->m_productCount : 0;
+				}
+				Bundle::Product const* GetProduct(uint32 _idx) const
+				{
+					return &m_products[_idx];
+				}
+				char const* GetString(uint32 _offset) const
+				{
+					return (_offset < m_header->m_stringsSize) ? m_strings + _offset : "";
+				}
+
+			private:
+				ConfigBundle();
+				~ConfigBundle();
+
+				bool Load(string const& _filename);
+				void Unload();
+				Bundle::File const* FindFile(string const& _relPath) const;
+
+				Internal::Platform::Mutex* m_mutex;
+
+				uint8 const* m_data;
+				size_t m_size;
+				Bundle::Header const* m_header;
+				char const* m_strings;
+				Bundle::Manufacturer const* m_manufacturers;
+				Bundle::Product const* m_products;
+				Bundle::File const* m_files;
+				string m_configPath;
+				set<string> m_invalidated;
+
+				static ConfigBundle* s_instance;
+		};
+	} // namespace Internal
+} // namespace OpenZWave
+
+#endif
@@ -32,11 +32,14 @@
 #include "Node.h"
 #include "Msg.h"
 #include "Notification.h"
+#include "NotificationPool.h"
 #include "Scene.h"
 #include "DNSThread.h"
 #include "TimerThread.h"
 #include "Http.h"
 #include "ManufacturerSpecificDB.h"
+#include "Metrics.h"
+#include "NodeLocks.h"
 
 #include "platform/Event.h"
 #include "platform/Mutex.h"
@@ -48,6 +51,7 @@
 #include "command_classes/ApplicationStatus.h"
 #include "command_classes/ControllerReplication.h"
 #include "command_classes/Security.h"
+#include "command_classes/MultiCmd.h"
 #include "command_classes/WakeUp.h"
 #include "command_classes/SwitchAll.h"
 #include "command_classes/ManufacturerSpecific.h"
@@ -116,11 +120,11 @@ static char const* c_sendQueueNames[] =
 // Constructor
 //-----------------------------------------------------------------------------
 Driver::Driver(string const& _controllerPath, ControllerInterface const& _interface) :
-		m_driverThread(new Internal::Platform::Thread("driver")), m_dns(new Internal::DNSThread(this)), m_dnsThread(new Internal::Platform::Thread("dns")), m_initMutex(new Internal::Platform::Mutex()), m_exit(false), m_init(false), m_awakeNodesQueried(false), m_allNodesQueried(false), m_notifytransactions(false), m_timer(new Internal::TimerThread(this)), m_timerThread(new Internal::Platform::Thread("timer")), m_controllerInterfaceType(_interface), m_controllerPath(_controllerPath),
-		m_homeId(0), m_libraryVersion(""), m_libraryTypeName(""), m_libraryType(0), m_manufacturerId(0), m_productType(0), m_productId(0), m_initVersion(0), m_initCaps(0), m_controllerCaps(0), m_Controller_nodeId(0), m_nodeMutex(new Internal::Platform::Mutex()), m_controllerReplication( NULL), m_transmitOptions( TRANSMIT_OPTION_ACK | TRANSMIT_OPTION_AUTO_ROUTE | TRANSMIT_OPTION_EXPLORE), m_waitingForAck(false), m_expectedCallbackId(0), m_expectedReply(0), m_expectedCommandClassId(
-				0), m_expectedNodeId(0), m_pollThread(new Internal::Platform::Thread("poll")), m_pollMutex(new Internal::Platform::Mutex()), m_pollInterval(0), m_bIntervalBetweenPolls(false),				// if set to true (via SetPollInterval), the pollInterval will be interspersed between each poll (so a much smaller m_pollInterval like 100, 500, or 1,000 may be appropriate)
-		m_currentControllerCommand( NULL), m_SUCNodeId(0), m_controllerResetEvent( NULL), m_sendMutex(new Internal::Platform::Mutex()), m_currentMsg( NULL), m_virtualNeighborsReceived(false), m_notificationsEvent(new Internal::Platform::Event()), m_SOFCnt(0), m_ACKWaiting(0), m_readAborts(0), m_badChecksum(0), m_readCnt(0), m_writeCnt(0), m_CANCnt(0), m_NAKCnt(0), m_ACKCnt(0), m_OOFCnt(0), m_dropped(0), m_retries(0), m_callbacks(0), m_badroutes(0), m_noack(0), m_netbusy(0), m_notidle(0), m_txverified(
-				0), m_nondelivery(0), m_routedbusy(0), m_broadcastReadCnt(0), m_broadcastWriteCnt(0), AuthKey(0), EncryptKey(0), m_nonceReportSent(0), m_nonceReportSentAttempt(0), m_queueMsgEvent(new Internal::Platform::Event()), m_eventMutex(new Internal::Platform::Mutex())
+		m_driverThread(new Internal::Platform::Thread("driver")), m_dns(new Internal::DNSThread(this)), m_dnsThread(new Internal::Platform::Thread("dns")), m_initMutex(new Internal::Platform::Mutex("init")), m_exit(false), m_init(false), m_awakeNodesQueried(false), m_allNodesQueried(false), m_notifytransactions(false), m_timer(new Internal::TimerThread(this)), m_timerThread(new Internal::Platform::Thread("timer")), m_controllerInterfaceType(_interface), m_controllerPath(_controllerPath),
+		m_homeId(0), m_libraryVersion(""), m_libraryTypeName(""), m_libraryType(0), m_manufacturerId(0), m_productType(0), m_productId(0), m_initVersion(0), m_initCaps(0), m_controllerCaps(0), m_Controller_nodeId(0), m_nodeMutex(new Internal::Platform::Mutex("nodes")), m_controllerReplication( NULL), m_transmitOptions( TRANSMIT_OPTION_ACK | TRANSMIT_OPTION_AUTO_ROUTE | TRANSMIT_OPTION_EXPLORE), m_nodeLocks(new Internal::NodeLocks(m_nodeMutex)), m_nodeQueriesCheckDeferred(false), m_waitingForAck(false), m_expectedCallbackId(0), m_expectedReply(0), m_expectedCommandClassId(
+				0), m_expectedNodeId(0), m_pollThread(new Internal::Platform::Thread("poll")), m_pollMutex(new Internal::Platform::Mutex("poll")), m_pollInterval(0), m_bIntervalBetweenPolls(false), m_pollEvent(new Internal::Platform::Event()), m_adaptivePolling(false), m_adaptivePollCeiling(1), m_pollCnt(0), m_pollSkipped(0), m_pollMultiCmd(0), m_pollLagTotal(0), m_pollLagMax(0),				// if set to true (via SetPollInterval), the pollInterval will be interspersed between each poll (so a much smaller m_pollInterval like 100, 500, or 1,000 may be appropriate)
+		m_currentControllerCommand( NULL), m_SUCNodeId(0), m_controllerResetEvent( NULL), m_sendMutex(new Internal::Platform::Mutex("send")), m_currentMsg( NULL), m_virtualNeighborsReceived(false), m_notificationsEvent(new Internal::Platform::Event()), m_notificationMutex(new Internal::Platform::Mutex("notifications")), m_notificationPool(NULL), m_notificationHighWatermark(0), m_notificationLowWatermark(0), m_notificationBacklog(0), m_notificationOverload(false), m_notificationsShed(0), m_notificationsCoalesced(0), m_notificationOverloads(0), m_SOFCnt(0), m_ACKWaiting(0), m_readAborts(0), m_badChecksum(0), m_readCnt(0), m_writeCnt(0), m_CANCnt(0), m_NAKCnt(0), m_ACKCnt(0), m_OOFCnt(0), m_dropped(0), m_duplicateDropped(0), m_duplicateReplaced(0), m_retries(0), m_callbacks(0), m_badroutes(0), m_noack(0), m_netbusy(0), m_notidle(0), m_txverified(
+				0), m_nondelivery(0), m_routedbusy(0), m_broadcastReadCnt(0), m_broadcastWriteCnt(0), m_pollLagHistogram(NULL), m_notificationHistogram(NULL), AuthKey(0), EncryptKey(0), m_nonceReportSent(0), m_nonceReportSentAttempt(0), m_queueMsgEvent(new Internal::Platform::Event()), m_eventMutex(new Internal::Platform::Mutex("events"))
 {
  	// set a timestamp to indicate when this driver started
  	Internal::Platform::TimeStamp m_startTime;
@@ -142,6 +146,29 @@ Driver::Driver(string const& _controllerPath, ControllerInterface const& _interf
 // 	Options::Get()->GetOptionAsBool("NotifyTransactions", &m_notifytransactions);
 // 	Options::Get()->GetOptionAsInt("PollInterval", &m_pollInterval);
 // 	Options::Get()->GetOptionAsBool("IntervalBetweenPolls", &m_bIntervalBetweenPolls);
+	Options::Get()->GetOptionAsBool(Options::OptionKey_AdaptivePolling, &m_adaptivePolling);
+	Options::Get()->GetOptionAsInt(Options::OptionKey_AdaptivePollCeiling, &m_adaptivePollCeiling);
+	if (m_adaptivePollCeiling < 1)
+	{
+		m_adaptivePollCeiling = 1;
+	}
+	int32 notificationThreads = 0;
+	Options::Get()->GetOptionAsInt(Options::OptionKey_NotificationThreads, &notificationThreads);
+	if (notificationThreads > 0)
+	{
+		m_notificationPool = new Internal::NotificationPool(this, (uint32) notificationThreads);
+	}
+	int32 highWatermark = 0;
+	int32 lowWatermark = 0;
+	Options::Get()->GetOptionAsInt(Options::OptionKey_NotificationHighWatermark, &highWatermark);
+	Options::Get()->GetOptionAsInt(Options::OptionKey_NotificationLowWatermark, &lowWatermark);
+	if (highWatermark > 0)
+	{
+		m_notificationHighWatermark = (uint32) highWatermark;
+		m_notificationLowWatermark = (lowWatermark > 0 && lowWatermark < highWatermark) ? (uint32) lowWatermark : m_notificationHighWatermark / 2;
+	}
+	memset(m_queuedNodeEvents, 0, sizeof(m_queuedNodeEvents));
+	RegisterMetrics();
 
 	// TODO remove those funcitons from the project If public, make dummies
 // 	m_mfs = Internal::ManufacturerSpecificDB::Create();
@@ -192,7 +219,7 @@ Driver::Driver(string const& _controllerPath, ControllerInterface const& _interf
 			}
 			else
 			{
-				Internal::LockGuard LG(m_nodeMutex);
+				Internal::NodesLockGuard LG(this);
 				Node* node = GetNode(nodeId);
 				if (node)
 				{
@@ -238,13 +265,22 @@ Driver::~Driver()
 	notification->SetHomeAndNodeIds(m_homeId, 0);
 	QueueNotification(notification);
 	NotifyWatchers();
+	if (m_notificationPool)
+	{
+		m_notificationPool->Flush();
+	}
+
+	// the gauges read the queues, which are about to go
+	Internal::Metrics::Get()->Remove(this);
+	m_pollLagHistogram = NULL;
+	m_notificationHistogram = NULL;
 
 	// append final driver stats output to the log file
 	LogDriverStatistics();
 
 	// Save the driver config before deleting anything else
 	bool save;
-	if (Options::Get()->GetOptionAsBool("SaveConfiguration", &save))
+	if (Options::Get()->GetOptionAsBool(Options::OptionKey_SaveConfiguration, &save))
 	{
 		if (save)
 		{
@@ -274,6 +310,12 @@ Driver::~Driver()
 	m_timerThread->Release();
 	delete m_timer;
 
+	// Nothing else will queue notifications for the pool now.  Deliver what it has,
+	// and do any that follow here, as the node and value notifications below
+	// must reach the watchers before the driver is gone.
+	delete m_notificationPool;
+	m_notificationPool = NULL;
+
 	m_sendMutex->Release();
 
 	m_initMutex->Release();
@@ -285,7 +327,7 @@ Driver::~Driver()
 
 	// Clear the node data
 	{
-		Internal::LockGuard LG(m_nodeMutex);
+		Internal::NodesLockGuard LG(this);
 		for (int i = 0; i < 256; ++i)
 		{
 			if (GetNodeUnsafe(i))
@@ -300,6 +342,7 @@ Driver::~Driver()
 	}
 	// Don't release until all nodes have removed their poll values
 	m_pollMutex->Release();
+	m_pollEvent->Release();
 
 	// Clear the send Queue
 	for (int32 i = 0; i < MsgQueue_Count; ++i)
@@ -329,7 +372,7 @@ Driver::~Driver()
 	 * that can return half destructed Driver references for internal classes (as per Greg's note above)
 	 */
 	bool notify;
-	if (Options::Get()->GetOptionAsBool("NotifyOnDriverUnload", &notify))
+	if (Options::Get()->GetOptionAsBool(Options::OptionKey_NotifyOnDriverUnload, &notify))
 	{
 		if (notify)
 		{
@@ -350,6 +393,8 @@ Driver::~Driver()
 		delete m_controllerReplication;
 
 	m_notificationsEvent->Release();
+	m_notificationMutex->Release();
+	delete m_nodeLocks;
 	m_nodeMutex->Release();
 	m_queueMsgEvent->Release();
 	m_eventMutex->Release();
@@ -424,7 +469,7 @@ void Driver::DriverThreadProc(Internal::Platform::Event* _exitEvent)
 
 			Internal::Platform::TimeStamp retryTimeStamp;
 			int retryTimeout = RETRY_TIMEOUT;
-			Options::Get()->GetOptionAsInt("RetryTimeout", &retryTimeout);
+			Options::Get()->GetOptionAsInt(Options::OptionKey_RetryTimeout, &retryTimeout);
 			//retryTimeout = RETRY_TIMEOUT * 10;
 			while (true)
 			{
@@ -524,7 +569,7 @@ void Driver::DriverThreadProc(Internal::Platform::Event* _exitEvent)
 		++attempts;
 
 		uint32 maxAttempts = 0;
-		Options::Get()->GetOptionAsInt("DriverMaxAttempts", (int32 *) &maxAttempts);
+		Options::Get()->GetOptionAsInt(Options::OptionKey_DriverMaxAttempts, (int32 *) &maxAttempts);
 		if (maxAttempts && (attempts >= maxAttempts))
 		{
 			Manager::Get()->Manager::SetDriverReady(this, false);
@@ -593,7 +638,7 @@ void Driver::RemoveQueues(uint8 const _nodeId)
 	// Clear the send Queue
 	for (int32 i = 0; i < MsgQueue_Count; ++i)
 	{
-		list<MsgQueueItem>::iterator it = m_msgQueue[i].begin();
+		MsgQueueList::iterator it = m_msgQueue[i].begin();
 		while (it != m_msgQueue[i].end())
 		{
 			bool remove = false;
@@ -647,18 +692,19 @@ bool Driver::ReadCache()
 
 	// Load the XML document that contains the driver configuration
 	string userPath;
-	Options::Get()->GetOptionAsString("UserPath", &userPath);
+	Options::Get()->GetOptionAsString(Options::OptionKey_UserPath, &userPath);
 
 	snprintf(str, sizeof(str), "ozwcache_0x%08x.xml", m_homeId);
 	string filename = userPath + string(str);
 
-	TiXmlDocument doc;
-	if (!doc.LoadFile(filename.c_str(), TIXML_ENCODING_UTF8))
+	// The cache can be large, so it is streamed rather than loaded as a document
+	TiXmlStreamReader reader;
+	if (!reader.LoadFile(filename.c_str(), TIXML_ENCODING_UTF8))
 	{
 		return false;
 	}
-	doc.SetUserData((void *) filename.c_str());
-	TiXmlElement const* driverElement = doc.RootElement();
+	reader.Document()->SetUserData((void *) filename.c_str());
+	TiXmlElement const* driverElement = reader.RootElement();
 
 	char const *xmlns = driverElement->Attribute("xmlns");
 	if (strcmp(xmlns, "https://github.com/OpenZWave/open-zwave"))
@@ -674,12 +720,6 @@ bool Driver::ReadCache()
 		return false;
 	}
 
-	// Capabilities
-	if (TIXML_SUCCESS == driverElement->QueryIntAttribute("revision", &intVal))
-	{
-		m_mfs->setLatestRevision(intVal);
-	}
-
 	// Home ID
 	char const* homeIdStr = driverElement->Attribute("home_id");
 	if (homeIdStr)
@@ -714,6 +754,33 @@ bool Driver::ReadCache()
 		return false;
 	}
 
+	// Read the nodes.  Only the Node elements are kept, and nothing is applied until
+	// the whole file has parsed, so a truncated or corrupt cache is rejected as a whole.
+	vector<TiXmlElement*> nodeElements;
+	while (TiXmlElement const* nodeElement = reader.NextElement())
+	{
+		char const* str = nodeElement->Value();
+		if (str && !strcmp(str, "Node"))
+		{
+			nodeElements.push_back(nodeElement->Clone()->ToElement());
+		}
+	}
+	if (reader.Error())
+	{
+		Log::Write(LogLevel_Warning, "WARNING: Driver::ReadCache - %s is truncated or corrupt at line %d (%s), and cannot be loaded", filename.c_str(), reader.ErrorRow(), reader.ErrorDesc());
+		for (vector<TiXmlElement*>::iterator it = nodeElements.begin(); it != nodeElements.end(); ++it)
+		{
+			delete *it;
+		}
+		return false;
+	}
+
+	// Revision
+	if (TIXML_SUCCESS == driverElement->QueryIntAttribute("revision", &intVal))
+	{
+		m_mfs->setLatestRevision(intVal);
+	}
+
 	// Capabilities
 	if (TIXML_SUCCESS == driverElement->QueryIntAttribute("api_capabilities", &intVal))
 	{
@@ -738,36 +805,32 @@ bool Driver::ReadCache()
 		m_bIntervalBetweenPolls = !strcmp(cstr, "true");
 	}
 
-	// Read the nodes
-	Internal::LockGuard LG(m_nodeMutex);
-	TiXmlElement const* nodeElement = driverElement->FirstChildElement();
-	while (nodeElement)
+	// Create the nodes
+	Internal::NodesLockGuard LG(this);
+	for (vector<TiXmlElement*>::iterator it = nodeElements.begin(); it != nodeElements.end(); ++it)
 	{
-		char const* str = nodeElement->Value();
-		if (str && !strcmp(str, "Node"))
+		TiXmlElement const* nodeElement = *it;
+		// Get the node Id from the XML
+		if (TIXML_SUCCESS == nodeElement->QueryIntAttribute("id", &intVal))
 		{
-			// Get the node Id from the XML
-			if (TIXML_SUCCESS == nodeElement->QueryIntAttribute("id", &intVal))
-			{
-				uint8 nodeId = (uint8) intVal;
-				Node* node = new Node(m_homeId, nodeId);
-				m_nodes[nodeId] = node;
+			uint8 nodeId = (uint8) intVal;
+			Node* node = new Node(m_homeId, nodeId);
+			m_nodes[nodeId] = node;
 
-				Notification* notification = new Notification(Notification::Type_NodeAdded);
-				notification->SetHomeAndNodeIds(m_homeId, nodeId);
-				QueueNotification(notification);
+			Notification* notification = new Notification(Notification::Type_NodeAdded);
+			notification->SetHomeAndNodeIds(m_homeId, nodeId);
+			QueueNotification(notification);
 
-				// Read the rest of the node configuration from the XML
-				node->ReadXML(nodeElement);
-			}
+			// Read the rest of the node configuration from the XML
+			node->ReadXML(nodeElement);
 		}
-
-		nodeElement = nodeElement->NextSiblingElement();
+		delete *it;
 	}
 
 	LG.Unlock();
 
 	// restore the previous state (for now, polling) for the nodes/values just retrieved
+	map<uint8, vector<ValueID> > polled;
 	for (int i = 0; i < 256; i++)
 	{
 		if (m_nodes[i] != NULL)
@@ -777,10 +840,15 @@ bool Driver::ReadCache()
 			{
 				Internal::VC::Value* value = it->second;
 				if (value->m_pollIntensity != 0)
-					EnablePoll(value->GetID(), value->m_pollIntensity);
+					polled[value->m_pollIntensity].push_back(value->GetID());
 			}
 		}
 	}
+	// one pass per distinct intensity, rather than one per value
+	for (map<uint8, vector<ValueID> >::iterator it = polled.begin(); it != polled.end(); ++it)
+	{
+		EnablePoll(it->second, it->first);
+	}
 
 	return true;
 }
@@ -833,7 +901,7 @@ void Driver::WriteCache()
 	driverElement->SetAttribute("poll_interval_between", str);
 
 	{
-		Internal::LockGuard LG(m_nodeMutex);
+		Internal::NodesLockGuard LG(this);
 
 		for (int i = 0; i < 256; ++i)
 		{
@@ -852,7 +920,7 @@ void Driver::WriteCache()
 		}
 	}
 	string userPath;
-	Options::Get()->GetOptionAsString("UserPath", &userPath);
+	Options::Get()->GetOptionAsString(Options::OptionKey_UserPath, &userPath);
 
 	snprintf(str, sizeof(str), "ozwcache_0x%08x.xml", m_homeId);
 	string filename = userPath + string(str);
@@ -884,17 +952,65 @@ Node* Driver::GetNodeUnsafe(uint8 _nodeId)
 //-----------------------------------------------------------------------------
 Node* Driver::GetNode(uint8 _nodeId)
 {
-	if (m_nodeMutex->IsSignalled())
+	Node* node = m_nodes[_nodeId];
+	if (m_nodeMutex->IsSignalled() && ((node == NULL) || node->m_mutex->IsSignalled()))
 	{
 		Log::Write(LogLevel_Error, _nodeId, "Driver Thread is Not Locked during Call to GetNode");
 		return NULL;
 	}
-	if (Node* node = m_nodes[_nodeId])
+	return node;
+}
+
+//-----------------------------------------------------------------------------
+//	Node locking
+//-----------------------------------------------------------------------------
+
+// The poll requests PollNext is gathering on this thread, if any
+struct PollBatch
+{
+	Driver* m_driver;
+	uint8 m_nodeId;
+	vector<Internal::Msg*>* m_msgs;
+};
+static thread_local PollBatch s_pollBatch = { NULL, 0, NULL };
+
+//-----------------------------------------------------------------------------
+// <Driver::LockNode>
+// Lock a single node (see Internal::NodeLocks)
+//-----------------------------------------------------------------------------
+Node* Driver::LockNode(uint8 const _nodeId, Internal::Platform::Mutex** o_mutex, bool* o_refused)
+{
+	return m_nodeLocks->LockNode(m_nodes, _nodeId, o_mutex, o_refused);
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::UnlockNode>
+// Release a lock taken by LockNode, and do any node list work that had to wait for it
+//-----------------------------------------------------------------------------
+void Driver::UnlockNode(Internal::Platform::Mutex* _mutex)
+{
+	if (m_nodeLocks->UnlockNode(_mutex) && m_nodeQueriesCheckDeferred.exchange(false))
 	{
-		return node;
+		CheckCompletedNodeQueries();
 	}
+}
 
-	return NULL;
+//-----------------------------------------------------------------------------
+// <Driver::LockNodes>
+// Lock the node list and every node
+//-----------------------------------------------------------------------------
+bool Driver::LockNodes()
+{
+	return m_nodeLocks->LockNodes();
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::UnlockNodes>
+// Release a lock taken by LockNodes
+//-----------------------------------------------------------------------------
+void Driver::UnlockNodes()
+{
+	m_nodeLocks->UnlockNodes();
 }
 
 //-----------------------------------------------------------------------------
@@ -913,8 +1029,8 @@ void Driver::SendQueryStageComplete(uint8 const _nodeId, Node::QueryStage const
 	item.m_queryStage = _stage;
 	item.m_retry = false;
 
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		if (!node->IsListeningDevice())
 		{
@@ -925,7 +1041,8 @@ void Driver::SendQueryStageComplete(uint8 const _nodeId, Node::QueryStage const
 					// If the message is for a sleeping node, we queue it in the node itself.
 					Log::Write(LogLevel_Info, "");
 					Log::Write(LogLevel_Detail, node->GetNodeId(), "Queuing (%s) Query Stage Complete (%s)", c_sendQueueNames[MsgQueue_WakeUp], node->GetQueryStageName(_stage).c_str());
-					wakeUp->QueueMsg(item);
+					// it has to follow the queries for the stage
+					wakeUp->QueueMsg(item, MsgQueue_Query);
 					return;
 				}
 			}
@@ -954,7 +1071,7 @@ void Driver::RetryQueryStageComplete(uint8 const _nodeId, Node::QueryStage const
 
 	m_sendMutex->Lock();
 
-	for (list<MsgQueueItem>::iterator it = m_msgQueue[MsgQueue_Query].begin(); it != m_msgQueue[MsgQueue_Query].end(); ++it)
+	for (MsgQueueList::iterator it = m_msgQueue[MsgQueue_Query].begin(); it != m_msgQueue[MsgQueue_Query].end(); ++it)
 	{
 		if (*it == item)
 		{
@@ -979,8 +1096,8 @@ void Driver::SendMsg(Internal::Msg* _msg, MsgQueue const _queue)
 	_msg->SetHomeId(m_homeId);
 	_msg->Finalize();
 	{
-		Internal::LockGuard LG(m_nodeMutex);
-		if (Node* node = GetNode(_msg->GetTargetNodeId()))
+		Internal::NodeLockGuard LG(this, _msg->GetTargetNodeId());
+		if (Node* node = LG.GetNode())
 		{
 			/* if the node Supports the Security Class - check if this message is meant to be encapsulated */
 			if (node->GetCommandClass(Internal::CC::Security::StaticGetCommandClassId()))
@@ -1015,20 +1132,298 @@ void Driver::SendMsg(Internal::Msg* _msg, MsgQueue const _queue)
 						{
 							Log::Write(LogLevel_Detail, GetNodeNumber(_msg), "Queuing (%s) %s", c_sendQueueNames[MsgQueue_WakeUp], _msg->GetAsString().c_str());
 						}
-						wakeUp->QueueMsg(item);
+						wakeUp->QueueMsg(item, (item.m_command == MsgQueueCmd_Controller) ? MsgQueue_Controller : _queue);
 						return;
 					}
 				}
 			}
+
+			// The poll thread is gathering the requests for this node.  The batch is
+			// thread local, so requests made on any other thread are queued as usual.
+			if ((s_pollBatch.m_msgs != NULL) && (s_pollBatch.m_driver == this) && (_queue == MsgQueue_Poll) && (s_pollBatch.m_nodeId == node->GetNodeId()) && !_msg->isEncrypted())
+			{
+				s_pollBatch.m_msgs->push_back(_msg);
+				return;
+			}
 		}
 	}
-	Log::Write(LogLevel_Detail, GetNodeNumber(_msg), "Queuing (%s) %s", c_sendQueueNames[_queue], _msg->GetAsString().c_str());
 	m_sendMutex->Lock();
+	if (IsDuplicateRequest(_msg, _queue))
+	{
+		m_sendMutex->Unlock();
+		Log::Write(LogLevel_Detail, GetNodeNumber(_msg), "Dropping (%s) %s, the same request is already queued", c_sendQueueNames[_queue], _msg->GetAsString().c_str());
+		m_duplicateDropped++;
+		delete _msg;
+		return;
+	}
+	Log::Write(LogLevel_Detail, GetNodeNumber(_msg), "Queuing (%s) %s", c_sendQueueNames[_queue], _msg->GetAsString().c_str());
 	m_msgQueue[_queue].push_back(item);
 	m_queueEvent[_queue]->Set();
 	m_sendMutex->Unlock();
 }
 
+//-----------------------------------------------------------------------------
+// <Driver::IsDuplicateRequest>
+// Is an identical request already waiting to be sent no later than this one
+// would be.  Only messages that ask for a reply are considered, as sending a
+// request twice just returns the same answer twice, while dropping a repeated
+// set could change the final state of the device.  Must hold m_sendMutex.
+//-----------------------------------------------------------------------------
+bool Driver::IsDuplicateRequest(Internal::Msg const* _msg, MsgQueue const _queue)
+{
+	if (_msg->GetExpectedReply() != FUNC_ID_APPLICATION_COMMAND_HANDLER)
+	{
+		return false;
+	}
+	for (int32 i = 0; i <= _queue; ++i)
+	{
+		if (m_msgQueue[i].Contains(_msg))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::MsgQueueList::GetNodeKey>
+// Which FIFO an item goes in
+//-----------------------------------------------------------------------------
+uint8 Driver::MsgQueueList::GetNodeKey(MsgQueueItem const& _item)
+{
+	switch (_item.m_command)
+	{
+		case MsgQueueCmd_SendMsg:
+		{
+			return _item.m_msg->GetTargetNodeId();
+		}
+		case MsgQueueCmd_QueryStageComplete:
+		case MsgQueueCmd_ReloadNode:
+		{
+			return _item.m_nodeId;
+		}
+		default:
+		{
+			// controller commands are run one after the other
+			return 0;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::MsgQueueList::front>
+// The oldest item for the node whose turn it is
+//-----------------------------------------------------------------------------
+Driver::MsgQueueItem& Driver::MsgQueueList::front()
+{
+	return m_nodes[m_turns.front()].m_entries.front().m_item;
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::MsgQueueList::pop_front>
+// Remove the front item, and pass the turn on to the next node
+//-----------------------------------------------------------------------------
+void Driver::MsgQueueList::pop_front()
+{
+	uint8 key = m_turns.front();
+	NodeQueue& nq = m_nodes[key];
+	uint32 wait = (uint32) ((Internal::Platform::TimeStamp() - m_epoch) - nq.m_entries.front().m_queued);
+	nq.m_sent++;
+	nq.m_waitTotal += wait;
+	if (wait > nq.m_waitMax)
+	{
+		nq.m_waitMax = wait;
+	}
+	RemoveFrame(nq.m_entries.front());
+	nq.m_entries.pop_front();
+	--m_size;
+
+	m_turns.pop_front();
+	if (!nq.m_entries.empty())
+	{
+		m_turns.push_back(key);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::MsgQueueList::push_back>
+// Add an item behind the others for its node
+//-----------------------------------------------------------------------------
+void Driver::MsgQueueList::push_back(MsgQueueItem const& _item)
+{
+	uint8 key = GetNodeKey(_item);
+	NodeQueue& nq = m_nodes[key];
+	if (nq.m_entries.empty())
+	{
+		m_turns.push_back(key);
+	}
+	Entry entry;
+	entry.m_item = _item;
+	entry.m_queued = Internal::Platform::TimeStamp() - m_epoch;
+	AddFrame(&entry);
+	nq.m_entries.push_back(entry);
+	++m_size;
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::MsgQueueList::push_front>
+// Add an item ahead of everything else
+//-----------------------------------------------------------------------------
+void Driver::MsgQueueList::push_front(MsgQueueItem const& _item)
+{
+	uint8 key = GetNodeKey(_item);
+	NodeQueue& nq = m_nodes[key];
+	if (!nq.m_entries.empty())
+	{
+		RemoveTurn(key);
+	}
+	m_turns.push_front(key);
+	Entry entry;
+	entry.m_item = _item;
+	entry.m_queued = Internal::Platform::TimeStamp() - m_epoch;
+	AddFrame(&entry);
+	nq.m_entries.push_front(entry);
+	++m_size;
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::MsgQueueList::erase>
+// Remove an item from anywhere in the queue
+//-----------------------------------------------------------------------------
+Driver::MsgQueueList::iterator Driver::MsgQueueList::erase(iterator _it)
+{
+	NodeQueue& nq = _it.m_node->second;
+	RemoveFrame(*_it.m_entry);
+	_it.m_entry = nq.m_entries.erase(_it.m_entry);
+	--m_size;
+	if (nq.m_entries.empty())
+	{
+		RemoveTurn(_it.m_node->first);
+	}
+	_it.SkipEmpty();
+	return _it;
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::MsgQueueList::RemoveTurn>
+// A node no longer has anything waiting
+//-----------------------------------------------------------------------------
+void Driver::MsgQueueList::RemoveTurn(uint8 const _key)
+{
+	deque<uint8>::iterator it = find(m_turns.begin(), m_turns.end(), _key);
+	if (it != m_turns.end())
+	{
+		m_turns.erase(it);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::MsgQueueList::AddFrame>
+// Index a message by its frame
+//-----------------------------------------------------------------------------
+void Driver::MsgQueueList::AddFrame(Entry* _entry)
+{
+	_entry->m_hash = 0;
+	if (MsgQueueCmd_SendMsg == _entry->m_item.m_command)
+	{
+		_entry->m_hash = _entry->m_item.m_msg->GetHash();
+		m_frames.insert(make_pair(_entry->m_hash, _entry->m_item.m_msg));
+	}
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::MsgQueueList::RemoveFrame>
+// Remove a message from the frame index.  The message itself may already have been deleted.
+//-----------------------------------------------------------------------------
+void Driver::MsgQueueList::RemoveFrame(Entry const& _entry)
+{
+	if (MsgQueueCmd_SendMsg == _entry.m_item.m_command)
+	{
+		pair<unordered_multimap<uint32, Internal::Msg const*>::iterator, unordered_multimap<uint32, Internal::Msg const*>::iterator> range = m_frames.equal_range(_entry.m_hash);
+		for (unordered_multimap<uint32, Internal::Msg const*>::iterator it = range.first; it != range.second; ++it)
+		{
+			if (it->second == _entry.m_item.m_msg)
+			{
+				m_frames.erase(it);
+				break;
+			}
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::MsgQueueList::Contains>
+// Is a message with the same frame already waiting
+//-----------------------------------------------------------------------------
+bool Driver::MsgQueueList::Contains(Internal::Msg const* _msg) const
+{
+	pair<unordered_multimap<uint32, Internal::Msg const*>::const_iterator, unordered_multimap<uint32, Internal::Msg const*>::const_iterator> range = m_frames.equal_range(_msg->GetHash());
+	for (unordered_multimap<uint32, Internal::Msg const*>::const_iterator it = range.first; it != range.second; ++it)
+	{
+		if (*it->second == *_msg)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::MsgQueueList::GetNodeStatistics>
+// Queue statistics for a node
+//-----------------------------------------------------------------------------
+void Driver::MsgQueueList::GetNodeStatistics(uint8 const _nodeId, uint32* o_depth, uint32* o_sent, uint64* o_waitTotal, uint32* o_waitMax)
+{
+	NodeMap::iterator it = m_nodes.find(_nodeId);
+	if (it != m_nodes.end())
+	{
+		*o_depth += (uint32) it->second.m_entries.size();
+		*o_sent += it->second.m_sent;
+		*o_waitTotal += it->second.m_waitTotal;
+		*o_waitMax = max(*o_waitMax, it->second.m_waitMax);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::MsgQueueList::iterator::iterator>
+// Start at the first item of a node
+//-----------------------------------------------------------------------------
+Driver::MsgQueueList::iterator::iterator(NodeMap::iterator _node, NodeMap::iterator _end) :
+		m_node(_node), m_end(_end)
+{
+	if (m_node != m_end)
+	{
+		m_entry = m_node->second.m_entries.begin();
+		SkipEmpty();
+	}
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::MsgQueueList::iterator::operator++>
+// Move on to the next item
+//-----------------------------------------------------------------------------
+Driver::MsgQueueList::iterator& Driver::MsgQueueList::iterator::operator++()
+{
+	++m_entry;
+	SkipEmpty();
+	return *this;
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::MsgQueueList::iterator::SkipEmpty>
+// If we are at the end of a node's items, move on to the next node that has some
+//-----------------------------------------------------------------------------
+void Driver::MsgQueueList::iterator::SkipEmpty()
+{
+	while (m_node != m_end && m_entry == m_node->second.m_entries.end())
+	{
+		if (++m_node != m_end)
+		{
+			m_entry = m_node->second.m_entries.begin();
+		}
+	}
+}
+
 //-----------------------------------------------------------------------------
 // <Driver::WriteNextMsg>
 // Transmit a queued message to the Z-Wave controller
@@ -1194,6 +1589,9 @@ void Driver::RemoveCurrentMsg()
 	m_waitingForAck = false;
 	m_nonceReportSent = 0;
 	m_nonceReportSentAttempt = 0;
+
+	// the poll thread waits for the send queues to drain before polling again
+	m_pollEvent->Set();
 }
 
 //-----------------------------------------------------------------------------
@@ -1243,7 +1641,7 @@ bool Driver::MoveMessagesToWakeUpQueue(uint8 const _targetNodeId, bool const _mo
 								MsgQueueItem item;
 								item.m_command = MsgQueueCmd_SendMsg;
 								item.m_msg = m_currentMsg;
-								wakeUp->QueueMsg(item);
+								wakeUp->QueueMsg(item, m_currentMsgQueueSource);
 							}
 							else
 							{
@@ -1262,7 +1660,7 @@ bool Driver::MoveMessagesToWakeUpQueue(uint8 const _targetNodeId, bool const _mo
 					// Now the message queues
 					for (int i = 0; i < MsgQueue_Count; ++i)
 					{
-						list<MsgQueueItem>::iterator it = m_msgQueue[i].begin();
+						MsgQueueList::iterator it = m_msgQueue[i].begin();
 						while (it != m_msgQueue[i].end())
 						{
 							bool remove = false;
@@ -1279,7 +1677,7 @@ bool Driver::MoveMessagesToWakeUpQueue(uint8 const _targetNodeId, bool const _mo
 										Log::Write(LogLevel_Info, item.m_msg->GetTargetNodeId(), "Node not responding - moving message to Wake-Up queue: %s", item.m_msg->GetAsString().c_str());
 										/* reset any SendAttempts */
 										item.m_msg->SetSendAttempts(0);
-										wakeUp->QueueMsg(item);
+										wakeUp->QueueMsg(item, (MsgQueue) i);
 									}
 									else
 									{
@@ -1294,7 +1692,7 @@ bool Driver::MoveMessagesToWakeUpQueue(uint8 const _targetNodeId, bool const _mo
 								{
 									Log::Write(LogLevel_Info, _targetNodeId, "Node not responding - moving QueryStageComplete command to Wake-Up queue");
 
-									wakeUp->QueueMsg(item);
+									wakeUp->QueueMsg(item, (MsgQueue) i);
 									remove = true;
 								}
 							}
@@ -1304,7 +1702,7 @@ bool Driver::MoveMessagesToWakeUpQueue(uint8 const _targetNodeId, bool const _mo
 								{
 									Log::Write(LogLevel_Info, _targetNodeId, "Node not responding - moving controller command to Wake-Up queue: %s", c_controllerCommandNames[item.m_cci->m_controllerCommand]);
 
-									wakeUp->QueueMsg(item);
+									wakeUp->QueueMsg(item, (MsgQueue) i);
 									remove = true;
 								}
 							}
@@ -1411,6 +1809,13 @@ bool Driver::HandleErrorResponse(uint8 const _error, uint8 const _nodeId, char c
 //-----------------------------------------------------------------------------
 void Driver::CheckCompletedNodeQueries()
 {
+	if (Internal::NodeLocks::HoldsSingleNode())
+	{
+		// We are called from a node's query stages or its alive state, and have to
+		// wait for every node below.  UnlockNode picks this up once the node is released.
+		m_nodeQueriesCheckDeferred = true;
+		return;
+	}
 	Log::Write(LogLevel_Warning, "CheckCompletedNodeQueries m_allNodesQueried=%d m_awakeNodesQueried=%d", m_allNodesQueried, m_awakeNodesQueried);
 	if (!m_allNodesQueried)
 	{
@@ -1419,7 +1824,7 @@ void Driver::CheckCompletedNodeQueries()
 		bool deadFound = false;
 
 		{
-			Internal::LockGuard LG(m_nodeMutex);
+			Internal::NodesLockGuard LG(this);
 			for (int i = 0; i < 256; ++i)
 			{
 				if (m_nodes[i])
@@ -2248,7 +2653,7 @@ void Driver::HandleGetSUCNodeIdResponse(uint8* _data)
 	if (_data[2] == 0)
 	{
 		bool enableSIS = true;
-		Options::Get()->GetOptionAsBool("EnableSIS", &enableSIS);
+		Options::Get()->GetOptionAsBool(Options::OptionKey_EnableSIS, &enableSIS);
 		if (enableSIS)
 		{
 			if (IsAPICallSupported(FUNC_ID_ZW_ENABLE_SUC) && IsAPICallSupported(FUNC_ID_ZW_SET_SUC_NODE_ID))
@@ -2339,7 +2744,7 @@ ZSA: Original OZW code: remove complete function and all refences
 					}
 					else
 					{
-						Internal::LockGuard LG(m_nodeMutex);
+						Internal::NodesLockGuard LG(this);
 						Node* node = GetNode(nodeId);
 						if (node)
 						{
@@ -2367,7 +2772,7 @@ ZSA: Original OZW code: remove complete function and all refences
 				}
 				else
 				{
-					Internal::LockGuard LG(m_nodeMutex);
+					Internal::NodesLockGuard LG(this);
 					if (GetNode(nodeId))
 					{
 						// This node no longer exists in the Z-Wave network
@@ -2614,7 +3019,7 @@ void Driver::HandleGetRoutingInfoResponse(uint8* _data)
 {
 	Log::Write(LogLevel_Info, GetNodeNumber(m_currentMsg), "Received reply to FUNC_ID_ZW_GET_ROUTING_INFO");
 
-	Internal::LockGuard LG(m_nodeMutex);
+	Internal::NodesLockGuard LG(this);
 	if (Node* node = GetNode(GetNodeNumber(m_currentMsg)))
 	{
 		// copy the 29-byte bitmap received (29*8=232 possible nodes) into this node's neighbors member variable
@@ -2679,6 +3084,7 @@ void Driver::HandleSendDataRequest(uint8* _data, uint8 _length, bool _replicatio
 					node->m_averageRequestRTT = node->m_lastRequestRTT;
 				}
 				Log::Write(LogLevel_Info, nodeId, "Request RTT %d Average Request RTT %d", node->m_lastRequestRTT, node->m_averageRequestRTT);
+				node->RecordLatency(Node::Latency_Ack, m_currentMsg->GetSendingCommandClass(), node->m_lastRequestRTT);
 			}
 			/* if the frame has txStatus message, then extract it */
 			// petergebruers, changed test (_length > 7) to >= 23 to avoid extracting non-existent data, highest is _data[22]
@@ -2872,7 +3278,7 @@ void Driver::HandleRemoveNodeFromNetworkRequest(uint8* _data)
 			{
 				if (_data[5] >= 3)
 				{
-					Internal::LockGuard LG(m_nodeMutex);
+					Internal::NodesLockGuard LG(this);
 					for (int i = 0; i < 256; i++)
 					{
 						if (m_nodes[i] == NULL)
@@ -2933,7 +3339,7 @@ void Driver::HandleRemoveNodeFromNetworkRequest(uint8* _data)
 				if (m_currentControllerCommand->m_controllerCommandNode != 0 && m_currentControllerCommand->m_controllerCommandNode != 0xff)
 				{
 					{
-						Internal::LockGuard LG(m_nodeMutex);
+						Internal::NodesLockGuard LG(this);
 						delete m_nodes[m_currentControllerCommand->m_controllerCommandNode];
 						m_nodes[m_currentControllerCommand->m_controllerCommandNode] = NULL;
 					}
@@ -3070,7 +3476,7 @@ void Driver::HandleRemoveFailedNodeRequest(uint8* _data)
 			Log::Write(LogLevel_Info, nodeId, "Received reply to FUNC_ID_ZW_REMOVE_FAILED_NODE_ID - node %d successfully moved to failed nodes list", m_currentControllerCommand->m_controllerCommandNode);
 			state = ControllerState_Completed;
 			{
-				Internal::LockGuard LG(m_nodeMutex);
+				Internal::NodesLockGuard LG(this);
 				delete m_nodes[m_currentControllerCommand->m_controllerCommandNode];
 				m_nodes[m_currentControllerCommand->m_controllerCommandNode] = NULL;
 			}
@@ -3190,6 +3596,7 @@ void Driver::HandleApplicationCommandHandlerRequest(uint8* _data, bool encrypted
 				node->m_averageResponseRTT = node->m_lastResponseRTT;
 			}
 			Log::Write(LogLevel_Info, nodeId, "Response RTT %d Average Response RTT %d", node->m_lastResponseRTT, node->m_averageResponseRTT);
+			node->RecordLatency(Node::Latency_Report, classId, node->m_lastResponseRTT);
 		}
 		else
 		{
@@ -3391,7 +3798,7 @@ bool Driver::HandleApplicationUpdateRequest(uint8* _data)
 		{
 			Log::Write(LogLevel_Info, nodeId, "** Network change **: Z-Wave node %d was removed", nodeId);
 			{
-				Internal::LockGuard LG(m_nodeMutex);
+				Internal::NodesLockGuard LG(this);
 				delete m_nodes[nodeId];
 				m_nodes[nodeId] = NULL;
 			}
@@ -3618,65 +4025,90 @@ void Driver::CommonAddNodeStatusRequestHandler(uint8 _funcId, uint8* _data)
 //-----------------------------------------------------------------------------
 bool Driver::EnablePoll(ValueID const &_valueId, uint8 const _intensity)
 {
-	// make sure the polling thread doesn't lock the node while we're in this function
-	m_pollMutex->Lock();
+	vector<ValueID> valueIds(1, _valueId);
+	return EnablePoll(valueIds, _intensity) == 1;
+}
 
-	// confirm that this node exists
-	uint8 nodeId = _valueId.GetNodeId();
-	Internal::LockGuard LG(m_nodeMutex);
-	Node* node = GetNode(nodeId);
-	if (node != NULL)
+//-----------------------------------------------------------------------------
+// <Driver::EnablePoll>
+// Enable polling of a set of values, taking the locks once
+//-----------------------------------------------------------------------------
+uint32 Driver::EnablePoll(vector<ValueID> const &_valueIds, uint8 const _intensity)
+{
+	vector<ValueID> enabled;
 	{
-		// confirm that this value is in the node's value store
-		if (Internal::VC::Value* value = node->GetValue(_valueId))
+		// make sure the polling thread doesn't lock the node while we're in this function
+		Internal::LockGuard PLG(m_pollMutex);
+		Internal::NodesLockGuard LG(this);
+		if (!LG.IsLocked())
+		{
+			return 0;
+		}
+		int32 now = GetPollTime();
+		for (vector<ValueID>::const_iterator it = _valueIds.begin(); it != _valueIds.end(); ++it)
 		{
+			// confirm that this node exists
+			uint8 nodeId = it->GetNodeId();
+			Node* node = GetNode(nodeId);
+			if (node == NULL)
+			{
+				Log::Write(LogLevel_Info, "EnablePoll failed - node %d not found", nodeId);
+				continue;
+			}
+
+			// confirm that this value is in the node's value store
+			Internal::VC::Value* value = node->GetValue(*it);
+			if (value == NULL)
+			{
+				Log::Write(LogLevel_Info, nodeId, "EnablePoll failed - value not found for node %d", nodeId);
+				continue;
+			}
+
 			// update the value's pollIntensity
 			value->SetPollIntensity(_intensity);
+			uint8 intensity = value->GetPollIntensity();
+			uint32 changeCount = value->m_changeCount;
+			uint32 reportCount = value->m_reportCount;
+			value->Release();
 
-			// Add the valueid to the polling list
-			// See if the node is already in the poll list.
-			for (list<PollEntry>::iterator it = m_pollList.begin(); it != m_pollList.end(); ++it)
+			// See if the value is already in the poll list.
+			unordered_map<uint64, PollEntry>::iterator pit = m_pollIndex.find(it->GetId());
+			if (pit != m_pollIndex.end())
 			{
-				if ((*it).m_id == _valueId)
-				{
-					// It is already in the poll list, so we have nothing to do.
-					Log::Write(LogLevel_Detail, "EnablePoll not required to do anything (value is already in the poll list)");
-					value->Release();
-					m_pollMutex->Unlock();
-					return true;
-				}
+				// It is already in the poll list, so just pick up the new intensity.
+				pit->second.m_intensity = intensity;
+				Log::Write(LogLevel_Detail, "EnablePoll not required to do anything (value is already in the poll list)");
+				enabled.push_back(*it);
+				continue;
 			}
 
-			// Not in the list, so we add it
-			PollEntry pe;
-			pe.m_id = _valueId;
-			pe.m_pollCounter = value->GetPollIntensity();
-			m_pollList.push_back(pe);
-			value->Release();
-			m_pollMutex->Unlock();
+			// Not in the list, so we add it.  It is due straight away, and
+			// the poll thread spreads the polls out from there.
+			PollEntry& pe = m_pollIndex[it->GetId()];
+			pe.m_id = *it;
+			pe.m_intensity = intensity;
+			pe.m_period = 0;
+			pe.m_generation = 0;
+			pe.m_backoff = 1;
+			pe.m_changeCount = changeCount;
+			pe.m_reportCount = reportCount;
+			SchedulePoll(pe, now);
+			enabled.push_back(*it);
 
 			// send notification to indicate polling is enabled
 			Notification* notification = new Notification(Notification::Type_PollingEnabled);
-			notification->SetHomeAndNodeIds(m_homeId, _valueId.GetNodeId());
-			notification->SetValueId(_valueId);
+			notification->SetHomeAndNodeIds(m_homeId, nodeId);
+			notification->SetValueId(*it);
 			QueueNotification(notification);
-			Log::Write(LogLevel_Info, nodeId, "EnablePoll for HomeID 0x%.8x, value(cc=0x%02x,in=0x%02x,id=0x%02x)--poll list has %d items", _valueId.GetHomeId(), _valueId.GetCommandClassId(), _valueId.GetIndex(), _valueId.GetInstance(), m_pollList.size());
-			return true;
+			Log::Write(LogLevel_Info, nodeId, "EnablePoll for HomeID 0x%.8x, value(cc=0x%02x,in=0x%02x,id=0x%02x)--poll list has %d items", it->GetHomeId(), it->GetCommandClassId(), it->GetIndex(), it->GetInstance(), m_pollIndex.size());
+		}
+		if (!enabled.empty())
+		{
+			m_pollEvent->Set();
 		}
-
-		// allow the poll thread to continue
-		m_pollMutex->Unlock();
-
-		Log::Write(LogLevel_Info, nodeId, "EnablePoll failed - value not found for node %d", nodeId);
-		return false;
 	}
-
-	// allow the poll thread to continue
-	m_pollMutex->Unlock();
-
-	Log::Write(LogLevel_Info, "EnablePoll failed - node %d not found", nodeId);
-	return false;
-}
+	return (uint32) enabled.size();
+}
 
 //-----------------------------------------------------------------------------
 // <Driver::DisablePoll>
@@ -3684,53 +4116,52 @@ bool Driver::EnablePoll(ValueID const &_valueId, uint8 const _intensity)
 //-----------------------------------------------------------------------------
 bool Driver::DisablePoll(ValueID const &_valueId)
 {
-	// make sure the polling thread doesn't lock the node while we're in this function
-	m_pollMutex->Lock();
+	vector<ValueID> valueIds(1, _valueId);
+	return DisablePoll(valueIds) == 1;
+}
 
-	// confirm that this node exists
-	uint8 nodeId = _valueId.GetNodeId();
-	Internal::LockGuard LG(m_nodeMutex);
-	Node* node = GetNode(nodeId);
-	if (node != NULL)
+//-----------------------------------------------------------------------------
+// <Driver::DisablePoll>
+// Disable polling of a set of values, taking the locks once
+//-----------------------------------------------------------------------------
+uint32 Driver::DisablePoll(vector<ValueID> const &_valueIds)
+{
+	uint32 disabled = 0;
+
+	// make sure the polling thread doesn't lock the node while we're in this function
+	Internal::LockGuard PLG(m_pollMutex);
+	Internal::NodesLockGuard LG(this);
+	if (!LG.IsLocked())
 	{
-		// See if the value is already in the poll list.
-		for (list<PollEntry>::iterator it = m_pollList.begin(); it != m_pollList.end(); ++it)
-		{
-			if ((*it).m_id == _valueId)
-			{
-				// Found it
-				// remove it from the poll list
-				m_pollList.erase(it);
+		return 0;
+	}
+	for (vector<ValueID>::const_iterator it = _valueIds.begin(); it != _valueIds.end(); ++it)
+	{
+		uint8 nodeId = it->GetNodeId();
 
-				// get the value object and reset pollIntensity to zero (indicating no polling)
-				Internal::VC::Value* value = GetValue(_valueId);
-				if (!value)
-					continue;
-				value->SetPollIntensity(0);
-				value->Release();
-				m_pollMutex->Unlock();
+		// remove it from the poll list.  Its entry in the poll heap is discarded when it reaches the top.
+		if (m_pollIndex.erase(it->GetId()) == 0)
+		{
+			Log::Write(LogLevel_Info, nodeId, "DisablePoll failed - value not on list");
+			continue;
+		}
+		++disabled;
 
-				// send notification to indicate polling is disabled
-				Notification* notification = new Notification(Notification::Type_PollingDisabled);
-				notification->SetHomeAndNodeIds(m_homeId, _valueId.GetNodeId());
-				notification->SetValueId(_valueId);
-				QueueNotification(notification);
-				Log::Write(LogLevel_Info, nodeId, "DisablePoll for HomeID 0x%.8x, value(cc=0x%02x,in=0x%02x,id=0x%02x)--poll list has %d items", _valueId.GetHomeId(), _valueId.GetCommandClassId(), _valueId.GetIndex(), _valueId.GetInstance(), m_pollList.size());
-				return true;
-			}
+		// get the value object and reset pollIntensity to zero (indicating no polling)
+		if (Internal::VC::Value* value = GetValue(*it))
+		{
+			value->SetPollIntensity(0);
+			value->Release();
 		}
 
-		// Not in the list
-		m_pollMutex->Unlock();
-		Log::Write(LogLevel_Info, nodeId, "DisablePoll failed - value not on list");
-		return false;
+		// send notification to indicate polling is disabled
+		Notification* notification = new Notification(Notification::Type_PollingDisabled);
+		notification->SetHomeAndNodeIds(m_homeId, nodeId);
+		notification->SetValueId(*it);
+		QueueNotification(notification);
+		Log::Write(LogLevel_Info, nodeId, "DisablePoll for HomeID 0x%.8x, value(cc=0x%02x,in=0x%02x,id=0x%02x)--poll list has %d items", it->GetHomeId(), it->GetCommandClassId(), it->GetIndex(), it->GetInstance(), m_pollIndex.size());
 	}
-
-	// allow the poll thread to continue
-	m_pollMutex->Unlock();
-
-	Log::Write(LogLevel_Info, "DisablePoll failed - node %d not found", nodeId);
-	return false;
+	return disabled;
 }
 
 //-----------------------------------------------------------------------------
@@ -3739,90 +4170,172 @@ bool Driver::DisablePoll(ValueID const &_valueId)
 //-----------------------------------------------------------------------------
 bool Driver::isPolled(ValueID const &_valueId)
 {
-	bool bPolled;
+	// the poll list is kept in step with each value's poll intensity by
+	// EnablePoll, DisablePoll and SetPollIntensity, so it is enough to look there
+	Internal::LockGuard PLG(m_pollMutex);
+	return m_pollIndex.find(_valueId.GetId()) != m_pollIndex.end();
+}
 
-	// make sure the polling thread doesn't lock the node while we're in this function
-	m_pollMutex->Lock();
+//-----------------------------------------------------------------------------
+// <Driver::SetPollIntensity>
+// Set the intensity with which this value is polled
+//-----------------------------------------------------------------------------
+void Driver::SetPollIntensity(ValueID const &_valueId, uint8 const _intensity)
+{
+	// make sure the polling thread doesn't lock the value while we're in this function
+	Internal::LockGuard PLG(m_pollMutex);
 
 	Internal::VC::Value* value = GetValue(_valueId);
-	if (value && value->GetPollIntensity() != 0)
+	if (!value)
+		return;
+	value->SetPollIntensity(_intensity);
+	value->Release();
+
+	unordered_map<uint64, PollEntry>::iterator it = m_pollIndex.find(_valueId.GetId());
+	if (it != m_pollIndex.end())
 	{
-		bPolled = true;
+		it->second.m_intensity = _intensity;
 	}
-	else
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::SetPollPeriod>
+// Poll a value every _milliseconds, rather than according to its intensity
+//-----------------------------------------------------------------------------
+bool Driver::SetPollPeriod(ValueID const &_valueId, int32 const _milliseconds)
+{
+	Internal::LockGuard PLG(m_pollMutex);
+
+	unordered_map<uint64, PollEntry>::iterator it = m_pollIndex.find(_valueId.GetId());
+	if (it == m_pollIndex.end())
 	{
-		bPolled = false;
+		Log::Write(LogLevel_Info, _valueId.GetNodeId(), "SetPollPeriod failed - value is not polled");
+		return false;
 	}
 
-	if (value)
-		value->Release();
-
-	/*
-	 * This code is retained for the moment as a belt-and-suspenders test to confirm that
-	 * the pollIntensity member of each value and the pollList contents do not get out
-	 * of sync.
-	 */
-	// confirm that this node exists
-	uint8 nodeId = _valueId.GetNodeId();
-	Internal::LockGuard LG(m_nodeMutex);
-	Node* node = GetNode(nodeId);
-	if (node != NULL)
+	PollEntry& pe = it->second;
+	pe.m_period = (_milliseconds > 0) ? _milliseconds : 0;
+	// if the new period brings the next poll forward, reschedule it
+	int32 now = GetPollTime();
+	if (now + GetPollPeriod(pe) < pe.m_due)
 	{
+		SchedulePoll(pe, now + GetPollPeriod(pe));
+		m_pollEvent->Set();
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::SchedulePoll>
+// Set when a value is next due, and push the new deadline onto the poll heap
+//-----------------------------------------------------------------------------
+void Driver::SchedulePoll(PollEntry& _entry, int32 const _due)
+{
+	// any earlier deadline for this value is now stale
+	_entry.m_due = _due;
+	_entry.m_generation++;
 
-		// See if the value is already in the poll list.
-		for (list<PollEntry>::iterator it = m_pollList.begin(); it != m_pollList.end(); ++it)
+	PollDeadline deadline;
+	deadline.m_due = _due;
+	deadline.m_key = _entry.m_id.GetId();
+	deadline.m_generation = _entry.m_generation;
+	m_pollHeap.push_back(deadline);
+	push_heap(m_pollHeap.begin(), m_pollHeap.end(), PollDeadlineLater);
+
+	// don't let stale deadlines pile up when values are rescheduled or disabled a lot
+	if (m_pollHeap.size() > 2 * m_pollIndex.size() + 64)
+	{
+		m_pollHeap.clear();
+		for (unordered_map<uint64, PollEntry>::iterator it = m_pollIndex.begin(); it != m_pollIndex.end(); ++it)
 		{
-			if ((*it).m_id == _valueId)
-			{
-				// Found it
-				if (bPolled)
-				{
-					m_pollMutex->Unlock();
-					return true;
-				}
-				else
-				{
-					Log::Write(LogLevel_Error, nodeId, "IsPolled setting for valueId 0x%016x is not consistent with the poll list", _valueId.GetId());
-				}
-			}
+			deadline.m_due = it->second.m_due;
+			deadline.m_key = it->first;
+			deadline.m_generation = it->second.m_generation;
+			m_pollHeap.push_back(deadline);
 		}
+		make_heap(m_pollHeap.begin(), m_pollHeap.end(), PollDeadlineLater);
+	}
+}
 
-		// Not in the list
+//-----------------------------------------------------------------------------
+// <Driver::GetNextPoll>
+// Return the value that is due to be polled next, discarding stale deadlines
+//-----------------------------------------------------------------------------
+Driver::PollEntry* Driver::GetNextPoll()
+{
+	while (!m_pollHeap.empty())
+	{
+		PollDeadline const& top = m_pollHeap.front();
+		unordered_map<uint64, PollEntry>::iterator it = m_pollIndex.find(top.m_key);
+		if (it != m_pollIndex.end() && it->second.m_generation == top.m_generation)
+		{
+			return &it->second;
+		}
+		pop_heap(m_pollHeap.begin(), m_pollHeap.end(), PollDeadlineLater);
+		m_pollHeap.pop_back();
+	}
+	return NULL;
+}
 
-		if (!bPolled)
+//-----------------------------------------------------------------------------
+// <Driver::GetPollTime>
+// Milliseconds since m_pollEpoch
+//-----------------------------------------------------------------------------
+int32 Driver::GetPollTime()
+{
+	Internal::Platform::TimeStamp now;
+	int32 elapsed = now - m_pollEpoch;
+	if (elapsed > 0x40000000)
+	{
+		// move the epoch forward every 12 days or so, so the due times cannot overflow
+		for (unordered_map<uint64, PollEntry>::iterator it = m_pollIndex.begin(); it != m_pollIndex.end(); ++it)
 		{
-			m_pollMutex->Unlock();
-			return false;
+			it->second.m_due -= elapsed;
 		}
-		else
+		for (vector<PollDeadline>::iterator it = m_pollHeap.begin(); it != m_pollHeap.end(); ++it)
 		{
-			Log::Write(LogLevel_Error, nodeId, "IsPolled setting for valueId 0x%016x is not consistent with the poll list", _valueId.GetId());
+			it->m_due -= elapsed;
 		}
+		m_pollEpoch.SetTime();
+		elapsed = 0;
 	}
-
-	// allow the poll thread to continue
-	m_pollMutex->Unlock();
-
-	Log::Write(LogLevel_Info, "isPolled failed - node %d not found (the value reported that it is%s polled)", nodeId, bPolled ? "" : " not");
-	return false;
+	return elapsed;
 }
 
 //-----------------------------------------------------------------------------
-// <Driver::SetPollIntensity>
-// Set the intensity with which this value is polled
+// <Driver::GetPollPeriod>
+// Time between polls of a value
 //-----------------------------------------------------------------------------
-void Driver::SetPollIntensity(ValueID const &_valueId, uint8 const _intensity)
+int32 Driver::GetPollPeriod(PollEntry const& _entry)
 {
-	// make sure the polling thread doesn't lock the value while we're in this function
-	m_pollMutex->Lock();
+	if (_entry.m_period > 0)
+	{
+		return _entry.m_period * _entry.m_backoff;
+	}
 
-	Internal::VC::Value* value = GetValue(_valueId);
-	if (!value)
-		return;
-	value->SetPollIntensity(_intensity);
+	int32 pollInterval = m_pollInterval;
+	if (pollInterval < 100)
+	{
+		Log::Write(LogLevel_Info, "The pollInterval setting is only %d, which appears to be a legacy setting.  Multiplying by 1000 to convert to ms.", pollInterval);
+		pollInterval *= 1000;
+	}
+	// One pass through the list takes m_pollInterval, unless the interval is between
+	// each poll.  Values with an intensity of n are polled on every n'th pass.
+	if (m_bIntervalBetweenPolls)
+	{
+		pollInterval *= (int32) m_pollIndex.size();
+	}
+	return pollInterval * (_entry.m_intensity ? _entry.m_intensity : 1) * _entry.m_backoff;
+}
 
-	value->Release();
-	m_pollMutex->Unlock();
+//-----------------------------------------------------------------------------
+// <Driver::IsSendIdle>
+// Are there no messages waiting to be sent or in progress
+//-----------------------------------------------------------------------------
+bool Driver::IsSendIdle()
+{
+	Internal::LockGuard LG(m_sendMutex);
+	return m_msgQueue[MsgQueue_Poll].empty() && m_msgQueue[MsgQueue_Send].empty() && m_msgQueue[MsgQueue_Command].empty() && m_msgQueue[MsgQueue_Query].empty() && (m_currentMsg == NULL);
 }
 
 //-----------------------------------------------------------------------------
@@ -3839,137 +4352,312 @@ void Driver::PollThreadEntryPoint(Internal::Platform::Event* _exitEvent, void* _
 }
 
 //-----------------------------------------------------------------------------
-// <Driver::PollThreadProc>
-// Thread for poll Z-Wave devices
+// <Driver::PollNext>
+// Request the values at the top of the poll list, and schedule their next polls
 //-----------------------------------------------------------------------------
-void Driver::PollThreadProc(Internal::Platform::Event* _exitEvent)
+bool Driver::PollNext()
 {
-	while (1)
-	{
-		int32 pollInterval = m_pollInterval;
+	// The caller holds m_pollMutex, and has checked that a value is due
+	int32 now = GetPollTime();
+	PollEntry* pe = GetNextPoll();
+	pop_heap(m_pollHeap.begin(), m_pollHeap.end(), PollDeadlineLater);
+	m_pollHeap.pop_back();
 
-		if (m_awakeNodesQueried && !m_pollList.empty())
+	Internal::NodesLockGuard LG(this);
+	uint8 const nodeId = pe->m_id.GetNodeId();
+
+	// Gather every other value on the same node that is also due, so they can go out together.
+	// Their heap entries go stale when they are rescheduled, and are dropped by GetNextPoll.
+	vector<PollEntry*> batch(1, pe);
+	for (vector<PollDeadline>::iterator it = m_pollHeap.begin(); it != m_pollHeap.end(); ++it)
+	{
+		if (it->m_due > now)
+		{
+			continue;
+		}
+		unordered_map<uint64, PollEntry>::iterator pit = m_pollIndex.find(it->m_key);
+		if ((pit != m_pollIndex.end()) && (pit->second.m_generation == it->m_generation) && (pit->second.m_id.GetNodeId() == nodeId) && (&pit->second != pe))
 		{
-			// We only bother getting the lock if the pollList is not empty
-			m_pollMutex->Lock();
+			batch.push_back(&pit->second);
+		}
+	}
 
-			// Get the next value to be polled
-			PollEntry pe = m_pollList.front();
-			m_pollList.pop_front();
-			ValueID valueId = pe.m_id;
+	vector<ValueID> valueIds;
+	for (vector<PollEntry*>::iterator it = batch.begin(); it != batch.end(); ++it)
+	{
+		ValueID const valueId = (*it)->m_id;
+		if (PreparePoll(*it, now))
+		{
+			valueIds.push_back(valueId);
+		}
+	}
+	if (valueIds.empty())
+	{
+		return false;
+	}
 
-			// only execute this poll if pe.m_pollCounter == 1; otherwise decrement the counter and process the next polled value
-			if (pe.m_pollCounter != 1)
+	// Request the state of the values from the node to which they belong
+	Node* node = GetNode(nodeId);
+	if (!node)
+	{
+		return false;
+	}
+	if (!node->IsListeningDevice())
+	{
+		// The device is not awake all the time.  If it is not awake, we mark it
+		// as requiring a poll.  The poll will be done next time the node wakes up.
+		if (Internal::CC::WakeUp* wakeUp = static_cast<Internal::CC::WakeUp*>(node->GetCommandClass(Internal::CC::WakeUp::StaticGetCommandClassId())))
+		{
+			if (!wakeUp->IsAwake())
 			{
-				pe.m_pollCounter--;
-				m_pollList.push_back(pe);
-				m_pollMutex->Unlock();
-				continue;
+				wakeUp->SetPollRequired();
+				return false;
 			}
+		}
+	}
+
+	// Collect the requests rather than queuing them one at a time
+	vector<Internal::Msg*> msgs;
+	s_pollBatch.m_driver = this;
+	s_pollBatch.m_nodeId = nodeId;
+	s_pollBatch.m_msgs = &msgs;
+	for (vector<ValueID>::iterator it = valueIds.begin(); it != valueIds.end(); ++it)
+	{
+		Internal::CC::CommandClass* cc = node->GetCommandClass(it->GetCommandClassId());
+		if (cc)
+		{
+			uint16_t index = it->GetIndex();
+			uint8_t instance = it->GetInstance();
+			Log::Write(LogLevel_Detail, nodeId, "Polling: %s index = %d instance = %d (poll queue has %d messages)", cc->GetCommandClassName().c_str(), index, instance, m_msgQueue[MsgQueue_Poll].size());
+			cc->RequestValue(0, index, instance, MsgQueue_Poll);
+		}
+	}
+	s_pollBatch.m_msgs = NULL;
+
+	bool sent = !msgs.empty();
+	SendPollBatch(nodeId, msgs);
+	return sent;
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::PreparePoll>
+// Account for a due poll and schedule the next one.  Returns false if the
+// value does not need to be requested this time.
+//-----------------------------------------------------------------------------
+bool Driver::PreparePoll(PollEntry* _entry, int32 const _now)
+{
+	// The caller holds m_pollMutex and all the nodes
+	uint32 lag = (uint32) (_now - _entry->m_due);
+	m_pollCnt++;
+	m_pollLagTotal += lag;
+	if (lag > m_pollLagMax)
+	{
+		m_pollLagMax = lag;
+	}
+	if (m_pollLagHistogram)
+	{
+		m_pollLagHistogram->Observe(lag);
+	}
+
+	ValueID const valueId = _entry->m_id;
+	Internal::VC::Value* value = GetValue(valueId);
+	if (!value)
+	{
+		// the value has gone away, so it drops out of the poll list
+		Log::Write(LogLevel_Info, valueId.GetNodeId(), "Polled value (cc=0x%02x,in=0x%02x,id=0x%02x) no longer exists", valueId.GetCommandClassId(), valueId.GetInstance(), valueId.GetIndex());
+		m_pollIndex.erase(valueId.GetId());
+		return false;
+	}
+	uint32 changeCount = value->m_changeCount;
+	uint32 reportCount = value->m_reportCount;
+	int64 age = Internal::VC::Value::GetTimeMs() - value->m_reportTime;
+
+	if (m_adaptivePolling)
+	{
+		bool changed = (changeCount != _entry->m_changeCount);
+		if (changed)
+		{
+			// the value has changed since it was last due, so go back to the normal rate
+			_entry->m_changeCount = changeCount;
+			_entry->m_backoff = 1;
+		}
+
+		// if a report that no poll asked for has refreshed the value within its period,
+		// there is no need to ask for it
+		bool reported = (reportCount != _entry->m_reportCount);
+		_entry->m_reportCount = reportCount;
+		int32 period = GetPollPeriod(*_entry);
+		if (reported && age >= 0 && age < period)
+		{
+			value->Release();
+			Log::Write(LogLevel_Detail, valueId.GetNodeId(), "Polling: skipped (cc=0x%02x,in=0x%02x,id=0x%02x), reported %d ms ago", valueId.GetCommandClassId(), valueId.GetInstance(), valueId.GetIndex(), (int32) age);
+			m_pollSkipped++;
+			SchedulePoll(*_entry, _now + period - (int32) age);
+			return false;
+		}
+
+		if (!changed)
+		{
+			// polled, and no change since the last poll, so poll it half as often, up to the ceiling
+			_entry->m_backoff = min(_entry->m_backoff * 2, m_adaptivePollCeiling);
+		}
+	}
+
+	// the answer to this poll does not count as a report
+	value->m_pollPending = true;
+	value->Release();
+
+	// keep to the cadence, unless we have fallen more than a whole period behind
+	int32 period = GetPollPeriod(*_entry);
+	int32 due = _entry->m_due + period;
+	SchedulePoll(*_entry, (due > _now) ? due : _now + period);
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::SendPollBatch>
+// Queue the poll requests for a node, in as few MultiCmd frames as will hold
+// them if the node supports it, otherwise back to back
+//-----------------------------------------------------------------------------
+void Driver::SendPollBatch(uint8 const _nodeId, vector<Internal::Msg*>& _msgs)
+{
+	// Payload of a single frame, less the MultiCmd header
+	static uint32 const c_maxMultiCmdPayload = 46 - 3;
+
+	Node* node = GetNode(_nodeId);
+	bool multiCmd = (_msgs.size() > 1) && node && (node->GetCommandClass(Internal::CC::MultiCmd::StaticGetCommandClassId()) != NULL);
 
-			// reset the poll counter to the full pollIntensity value and push it at the end of the list
-			// release the value object referenced; call GetNode to ensure the node objects are locked during this period
+	size_t i = 0;
+	while (i < _msgs.size())
+	{
+		// See how many of the requests fit in one frame
+		size_t count = 0;
+		uint32 size = 0;
+		while (multiCmd && (i + count < _msgs.size()))
+		{
+			uint8 length;
+			if (!_msgs[i + count]->GetPayload(&length) || (size + length + 1 > c_maxMultiCmdPayload))
 			{
-				Internal::LockGuard LG(m_nodeMutex);
-				(void) GetNode(valueId.GetNodeId());
-				Internal::VC::Value* value = GetValue(valueId);
-				if (!value)
-					continue;
-				pe.m_pollCounter = value->GetPollIntensity();
-				m_pollList.push_back(pe);
-				value->Release();
+				break;
 			}
-			// If the polling interval is for the whole poll list, calculate the time before the next poll,
-			// so that all polls can take place within the user-specified interval.
-			if (!m_bIntervalBetweenPolls)
+			size += length + 1;
+			++count;
+		}
+
+		if (count < 2)
+		{
+			// nothing to gain by encapsulating, so send the request as it is
+			SendMsg(_msgs[i], MsgQueue_Poll);
+			++i;
+			continue;
+		}
+
+		// The node answers with a report for each command, which the command classes
+		// match to their values as they would any other report.
+		Internal::Msg* msg = new Internal::Msg("MultiCmd Encap (Poll)", _nodeId, REQUEST, FUNC_ID_ZW_SEND_DATA, true, true);
+		msg->Append(_nodeId);
+		msg->Append((uint8) (size + 3));
+		msg->Append(Internal::CC::MultiCmd::StaticGetCommandClassId());
+		msg->Append(Internal::CC::MultiCmd::MultiCmdCmd_Encap);
+		msg->Append((uint8) count);
+		for (size_t j = i; j < i + count; ++j)
+		{
+			uint8 length;
+			uint8 const* payload = _msgs[j]->GetPayload(&length);
+			msg->Append(length);
+			msg->AppendArray(payload, length);
+			delete _msgs[j];
+		}
+		msg->Append(GetTransmitOptions());
+		SendMsg(msg, MsgQueue_Poll);
+		m_pollMultiCmd += (uint32) count;
+		i += count;
+	}
+	_msgs.clear();
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::PollThreadProc>
+// Thread for poll Z-Wave devices
+//-----------------------------------------------------------------------------
+void Driver::PollThreadProc(Internal::Platform::Event* _exitEvent)
+{
+	Internal::Platform::Wait* waitObjects[2];
+	waitObjects[0] = _exitEvent;	// Thread must exit.
+	waitObjects[1] = m_pollEvent;	// The poll list has changed, or the send queues have drained.
+
+	while (1)
+	{
+		// don't poll until the awake nodes have been queried; check again every 500ms
+		int32 timeout = 500;
+		bool due = false;
+		bool polled = false;
+
+		m_pollEvent->Reset();
+		if (m_awakeNodesQueried)
+		{
+			Internal::LockGuard LG(m_pollMutex);
+			PollEntry* next = GetNextPoll();
+			if (next == NULL)
 			{
-				if (pollInterval < 100)
-				{
-					Log::Write(LogLevel_Info, "The pollInterval setting is only %d, which appears to be a legacy setting.  Multiplying by 1000 to convert to ms.", pollInterval);
-					pollInterval *= 1000;
-				}
-				pollInterval /= (int32) m_pollList.size();
+				timeout = Internal::Platform::Wait::Timeout_Infinite;
 			}
-
+			else
 			{
-				Internal::LockGuard LG(m_nodeMutex);
-				// Request the state of the value from the node to which it belongs
-				if (Node* node = GetNode(valueId.GetNodeId()))
+				// sleep until the earliest poll is due
+				timeout = next->m_due - GetPollTime();
+				if (timeout <= 0)
 				{
-					bool requestState = true;
-					if (!node->IsListeningDevice())
-					{
-						// The device is not awake all the time.  If it is not awake, we mark it
-						// as requiring a poll.  The poll will be done next time the node wakes up.
-						if (Internal::CC::WakeUp* wakeUp = static_cast<Internal::CC::WakeUp*>(node->GetCommandClass(Internal::CC::WakeUp::StaticGetCommandClassId())))
-						{
-							if (!wakeUp->IsAwake())
-							{
-								wakeUp->SetPollRequired();
-								requestState = false;
-							}
-						}
-					}
-
-					if (requestState)
-					{
-						// Request an update of the value
-						Internal::CC::CommandClass* cc = node->GetCommandClass(valueId.GetCommandClassId());
-						if (cc)
-						{
-							uint16_t index = valueId.GetIndex();
-							uint8_t instance = valueId.GetInstance();
-							Log::Write(LogLevel_Detail, node->m_nodeId, "Polling: %s index = %d instance = %d (poll queue has %d messages)", cc->GetCommandClassName().c_str(), index, instance, m_msgQueue[MsgQueue_Poll].size());
-							cc->RequestValue(0, index, instance, MsgQueue_Poll);
-						}
-					}
-
+					due = true;
+					polled = PollNext();
 				}
 			}
+		}
 
-			m_pollMutex->Unlock();
-
+		if (polled)
+		{
 			// Polling messages are only sent when there are no other messages waiting to be sent
 			// While this makes the polls much more variable and uncertain if some other activity dominates
 			// a send queue, that may be appropriate
-			// TODO we can have a debate about whether to test all four queues or just the Poll queue
 			// Wait until the library isn't actively sending messages (or in the midst of a transaction)
-			int i32;
-			int loopCount = 0;
-			while (!m_msgQueue[MsgQueue_Poll].empty() || !m_msgQueue[MsgQueue_Send].empty() || !m_msgQueue[MsgQueue_Command].empty() || !m_msgQueue[MsgQueue_Query].empty() || m_currentMsg != NULL)
+			Internal::Platform::TimeStamp busySince;
+			bool warned = false;
+			while (!IsSendIdle())
 			{
-				i32 = Internal::Platform::Wait::Single(_exitEvent, 10);		// test conditions every 10ms
-				if (i32 == 0)
+				// RemoveCurrentMsg wakes us when a message completes
+				if (Internal::Platform::Wait::Multiple(waitObjects, 2, 1000) == 0)
 				{
 					// Exit has been called
 					return;
 				}
-				loopCount++;
-				if (loopCount == 3000 * 10)		// 300 seconds worth of delay?  Something unusual is going on
+				m_pollEvent->Reset();
+				if (!warned && (Internal::Platform::TimeStamp() - busySince) >= 300000)		// Something unusual is going on
 				{
 					Log::Write(LogLevel_Warning, "Poll queue hasn't been able to execute for 300 secs or more");
 					Log::QueueDump();
-					//					assert( 0 );
+					warned = true;
 				}
 			}
 
-			// ready for next poll...insert the pollInterval delay
-			i32 = Internal::Platform::Wait::Single(_exitEvent, pollInterval);
-			if (i32 == 0)
+			// if the interval is between polls, it is the minimum gap between any two of them
+			if (m_bIntervalBetweenPolls && (Internal::Platform::Wait::Single(_exitEvent, m_pollInterval) == 0))
 			{
 				// Exit has been called
 				return;
 			}
+			continue;
 		}
-		else		// poll list is empty or awake nodes haven't been fully queried yet
+
+		if (due)
 		{
-			// don't poll just yet, wait for the pollInterval or exit before re-checking to see if the pollList has elements
-			int32 i32 = Internal::Platform::Wait::Single(_exitEvent, 500);
-			if (i32 == 0)
-			{
-				// Exit has been called
-				return;
-			}
+			// the value that was due could not be polled, so move on to the next
+			continue;
+		}
+
+		if (Internal::Platform::Wait::Multiple(waitObjects, 2, timeout) == 0)
+		{
+			// Exit has been called
+			return;
 		}
 	}
 }
@@ -3986,7 +4674,7 @@ void Driver::InitAllNodes()
 {
 	// Delete all the node data
 	{
-		Internal::LockGuard LG(m_nodeMutex);
+		Internal::NodesLockGuard LG(this);
 		for (int i = 0; i < 256; ++i)
 		{
 			if (m_nodes[i])
@@ -4010,7 +4698,7 @@ void Driver::InitNode(uint8 const _nodeId, bool newNode, bool secure, uint8 cons
 {
 	// Delete any existing node and replace it with a new one
 	{
-		Internal::LockGuard LG(m_nodeMutex);
+		Internal::NodesLockGuard LG(this);
 		if (m_nodes[_nodeId])
 		{
 			// Remove the original node
@@ -4055,8 +4743,8 @@ void Driver::InitNode(uint8 const _nodeId, bool newNode, bool secure, uint8 cons
 bool Driver::IsNodeListeningDevice(uint8 const _nodeId)
 {
 	bool res = false;
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		res = node->IsListeningDevice();
 	}
@@ -4071,8 +4759,8 @@ bool Driver::IsNodeListeningDevice(uint8 const _nodeId)
 bool Driver::IsNodeFrequentListeningDevice(uint8 const _nodeId)
 {
 	bool res = false;
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		res = node->IsFrequentListeningDevice();
 	}
@@ -4087,8 +4775,8 @@ bool Driver::IsNodeFrequentListeningDevice(uint8 const _nodeId)
 bool Driver::IsNodeBeamingDevice(uint8 const _nodeId)
 {
 	bool res = false;
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		res = node->IsBeamingDevice();
 	}
@@ -4103,8 +4791,8 @@ bool Driver::IsNodeBeamingDevice(uint8 const _nodeId)
 bool Driver::IsNodeRoutingDevice(uint8 const _nodeId)
 {
 	bool res = false;
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		res = node->IsRoutingDevice();
 	}
@@ -4119,8 +4807,8 @@ bool Driver::IsNodeRoutingDevice(uint8 const _nodeId)
 bool Driver::IsNodeSecurityDevice(uint8 const _nodeId)
 {
 	bool security = false;
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		security = node->IsSecurityDevice();
 	}
@@ -4135,8 +4823,8 @@ bool Driver::IsNodeSecurityDevice(uint8 const _nodeId)
 uint32 Driver::GetNodeMaxBaudRate(uint8 const _nodeId)
 {
 	uint32 baud = 0;
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		baud = node->GetMaxBaudRate();
 	}
@@ -4151,8 +4839,8 @@ uint32 Driver::GetNodeMaxBaudRate(uint8 const _nodeId)
 uint8 Driver::GetNodeVersion(uint8 const _nodeId)
 {
 	uint8 version = 0;
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		version = node->GetVersion();
 	}
@@ -4167,8 +4855,8 @@ uint8 Driver::GetNodeVersion(uint8 const _nodeId)
 uint8 Driver::GetNodeSecurity(uint8 const _nodeId)
 {
 	uint8 security = 0;
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		security = node->GetSecurity();
 	}
@@ -4183,8 +4871,8 @@ uint8 Driver::GetNodeSecurity(uint8 const _nodeId)
 uint8 Driver::GetNodeBasic(uint8 const _nodeId)
 {
 	uint8 basic = 0;
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		basic = node->GetBasic();
 	}
@@ -4199,8 +4887,8 @@ uint8 Driver::GetNodeBasic(uint8 const _nodeId)
 uint8 Driver::GetNodeGeneric(uint8 const _nodeId)
 {
 	uint8 genericType = 0;
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		genericType = node->GetGeneric();
 	}
@@ -4215,8 +4903,8 @@ uint8 Driver::GetNodeGeneric(uint8 const _nodeId)
 uint8 Driver::GetNodeSpecific(uint8 const _nodeId)
 {
 	uint8 specific = 0;
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		specific = node->GetSpecific();
 	}
@@ -4231,8 +4919,8 @@ uint8 Driver::GetNodeSpecific(uint8 const _nodeId)
 //-----------------------------------------------------------------------------
 string Driver::GetNodeType(uint8 const _nodeId)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		return node->GetType();
 	}
@@ -4242,8 +4930,8 @@ string Driver::GetNodeType(uint8 const _nodeId)
 
 bool Driver::IsNodeZWavePlus(uint8 const _nodeId)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		return node->IsNodeZWavePlus();
 	}
@@ -4257,8 +4945,8 @@ bool Driver::IsNodeZWavePlus(uint8 const _nodeId)
 uint32 Driver::GetNodeNeighbors(uint8 const _nodeId, uint8** o_neighbors)
 {
 	uint32 numNeighbors = 0;
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		numNeighbors = node->GetNeighbors(o_neighbors);
 	}
@@ -4273,8 +4961,8 @@ uint32 Driver::GetNodeNeighbors(uint8 const _nodeId, uint8** o_neighbors)
 //-----------------------------------------------------------------------------
 string Driver::GetNodeManufacturerName(uint8 const _nodeId)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		return node->GetManufacturerName();
 	}
@@ -4289,8 +4977,8 @@ string Driver::GetNodeManufacturerName(uint8 const _nodeId)
 //-----------------------------------------------------------------------------
 string Driver::GetNodeProductName(uint8 const _nodeId)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		return node->GetProductName();
 	}
@@ -4305,8 +4993,8 @@ string Driver::GetNodeProductName(uint8 const _nodeId)
 //-----------------------------------------------------------------------------
 string Driver::GetNodeName(uint8 const _nodeId)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		return node->GetNodeName();
 	}
@@ -4321,8 +5009,8 @@ string Driver::GetNodeName(uint8 const _nodeId)
 //-----------------------------------------------------------------------------
 string Driver::GetNodeLocation(uint8 const _nodeId)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		return node->GetLocation();
 	}
@@ -4337,8 +5025,8 @@ string Driver::GetNodeLocation(uint8 const _nodeId)
 //-----------------------------------------------------------------------------
 uint16 Driver::GetNodeManufacturerId(uint8 const _nodeId)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		return node->GetManufacturerId();
 	}
@@ -4353,8 +5041,8 @@ uint16 Driver::GetNodeManufacturerId(uint8 const _nodeId)
 //-----------------------------------------------------------------------------
 uint16 Driver::GetNodeProductType(uint8 const _nodeId)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		return node->GetProductType();
 	}
@@ -4369,8 +5057,8 @@ uint16 Driver::GetNodeProductType(uint8 const _nodeId)
 //-----------------------------------------------------------------------------
 uint16 Driver::GetNodeProductId(uint8 const _nodeId)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		return node->GetProductId();
 	}
@@ -4384,8 +5072,8 @@ uint16 Driver::GetNodeProductId(uint8 const _nodeId)
 //-----------------------------------------------------------------------------
 uint16 Driver::GetNodeDeviceType(uint8 const _nodeId)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		return node->GetDeviceType();
 	}
@@ -4401,8 +5089,8 @@ uint16 Driver::GetNodeDeviceType(uint8 const _nodeId)
 string Driver::GetNodeDeviceTypeString(uint8 const _nodeId)
 {
 
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		return node->GetDeviceTypeString();
 	}
@@ -4416,8 +5104,8 @@ string Driver::GetNodeDeviceTypeString(uint8 const _nodeId)
 //-----------------------------------------------------------------------------
 uint8 Driver::GetNodeRole(uint8 const _nodeId)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		return node->GetRoleType();
 	}
@@ -4431,8 +5119,8 @@ uint8 Driver::GetNodeRole(uint8 const _nodeId)
 //-----------------------------------------------------------------------------
 string Driver::GetNodeRoleString(uint8 const _nodeId)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		return node->GetRoleTypeString();
 	}
@@ -4446,8 +5134,8 @@ string Driver::GetNodeRoleString(uint8 const _nodeId)
 //-----------------------------------------------------------------------------
 uint8 Driver::GetNodePlusType(uint8 const _nodeId)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		return node->GetNodeType();
 	}
@@ -4460,8 +5148,8 @@ uint8 Driver::GetNodePlusType(uint8 const _nodeId)
 //-----------------------------------------------------------------------------
 string Driver::GetNodePlusTypeString(uint8 const _nodeId)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		return node->GetNodeTypeString();
 	}
@@ -4474,8 +5162,8 @@ string Driver::GetNodePlusTypeString(uint8 const _nodeId)
 //-----------------------------------------------------------------------------
 void Driver::SetNodeManufacturerName(uint8 const _nodeId, string const& _manufacturerName)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		node->SetManufacturerName(_manufacturerName);
 	}
@@ -4487,8 +5175,8 @@ void Driver::SetNodeManufacturerName(uint8 const _nodeId, string const& _manufac
 //-----------------------------------------------------------------------------
 void Driver::SetNodeProductName(uint8 const _nodeId, string const& _productName)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		node->SetProductName(_productName);
 	}
@@ -4500,8 +5188,8 @@ void Driver::SetNodeProductName(uint8 const _nodeId, string const& _productName)
 //-----------------------------------------------------------------------------
 void Driver::SetNodeName(uint8 const _nodeId, string const& _nodeName)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		node->SetNodeName(_nodeName);
 	}
@@ -4513,8 +5201,8 @@ void Driver::SetNodeName(uint8 const _nodeId, string const& _nodeName)
 //-----------------------------------------------------------------------------
 void Driver::SetNodeLocation(uint8 const _nodeId, string const& _location)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		node->SetLocation(_location);
 	}
@@ -4526,8 +5214,8 @@ void Driver::SetNodeLocation(uint8 const _nodeId, string const& _location)
 //-----------------------------------------------------------------------------
 void Driver::SetNodeLevel(uint8 const _nodeId, uint8 const _level)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		node->SetLevel(_level);
 	}
@@ -4539,8 +5227,8 @@ void Driver::SetNodeLevel(uint8 const _nodeId, uint8 const _level)
 //-----------------------------------------------------------------------------
 void Driver::SetNodeOn(uint8 const _nodeId)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		node->SetNodeOn();
 	}
@@ -4552,8 +5240,8 @@ void Driver::SetNodeOn(uint8 const _nodeId)
 //-----------------------------------------------------------------------------
 void Driver::SetNodeOff(uint8 const _nodeId)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		node->SetNodeOff();
 	}
@@ -5170,7 +5858,11 @@ void Driver::AddNodeStop(uint8 const _funcId)
 //-----------------------------------------------------------------------------
 void Driver::TestNetwork(uint8 const _nodeId, uint32 const _count)
 {
-	Internal::LockGuard LG(m_nodeMutex);
+	Internal::NodesLockGuard LG(this);
+	if (!LG.IsLocked())
+	{
+		return;
+	}
 	if (_nodeId == 0)	// send _count messages to every node
 	{
 		for (int i = 0; i < 256; ++i)
@@ -5211,7 +5903,11 @@ void Driver::SwitchAllOn()
 {
 	Internal::CC::SwitchAll::On(this, 0xff);
 
-	Internal::LockGuard LG(m_nodeMutex);
+	Internal::NodesLockGuard LG(this);
+	if (!LG.IsLocked())
+	{
+		return;
+	}
 	for (int i = 0; i < 256; ++i)
 	{
 		if (GetNodeUnsafe(i))
@@ -5232,7 +5928,11 @@ void Driver::SwitchAllOff()
 {
 	Internal::CC::SwitchAll::Off(this, 0xff);
 
-	Internal::LockGuard LG(m_nodeMutex);
+	Internal::NodesLockGuard LG(this);
+	if (!LG.IsLocked())
+	{
+		return;
+	}
 	for (int i = 0; i < 256; ++i)
 	{
 		if (GetNodeUnsafe(i))
@@ -5251,8 +5951,8 @@ void Driver::SwitchAllOff()
 //-----------------------------------------------------------------------------
 bool Driver::SetConfigParam(uint8 const _nodeId, uint8 const _param, int32 _value, uint8 _size)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		return node->SetConfigParam(_param, _value, _size);
 	}
@@ -5266,8 +5966,8 @@ bool Driver::SetConfigParam(uint8 const _nodeId, uint8 const _param, int32 _valu
 //-----------------------------------------------------------------------------
 void Driver::RequestConfigParam(uint8 const _nodeId, uint8 const _param)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		node->RequestConfigParam(_param);
 	}
@@ -5280,8 +5980,8 @@ void Driver::RequestConfigParam(uint8 const _nodeId, uint8 const _param)
 uint8 Driver::GetNumGroups(uint8 const _nodeId)
 {
 	uint8 numGroups = 0;
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		numGroups = node->GetNumGroups();
 	}
@@ -5296,8 +5996,8 @@ uint8 Driver::GetNumGroups(uint8 const _nodeId)
 uint32 Driver::GetAssociations(uint8 const _nodeId, uint8 const _groupIdx, uint8** o_associations)
 {
 	uint32 numAssociations = 0;
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		numAssociations = node->GetAssociations(_groupIdx, o_associations);
 	}
@@ -5312,8 +6012,8 @@ uint32 Driver::GetAssociations(uint8 const _nodeId, uint8 const _groupIdx, uint8
 uint32 Driver::GetAssociations(uint8 const _nodeId, uint8 const _groupIdx, InstanceAssociation** o_associations)
 {
 	uint32 numAssociations = 0;
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		numAssociations = node->GetAssociations(_groupIdx, o_associations);
 	}
@@ -5328,8 +6028,8 @@ uint32 Driver::GetAssociations(uint8 const _nodeId, uint8 const _groupIdx, Insta
 uint8 Driver::GetMaxAssociations(uint8 const _nodeId, uint8 const _groupIdx)
 {
 	uint8 maxAssociations = 0;
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		maxAssociations = node->GetMaxAssociations(_groupIdx);
 	}
@@ -5344,8 +6044,8 @@ uint8 Driver::GetMaxAssociations(uint8 const _nodeId, uint8 const _groupIdx)
 bool Driver::IsMultiInstance(uint8 const _nodeId, uint8 const _groupIdx)
 {
 	bool multiInstance = false;
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		multiInstance = node->IsMultiInstance(_groupIdx);
 	}
@@ -5359,8 +6059,8 @@ bool Driver::IsMultiInstance(uint8 const _nodeId, uint8 const _groupIdx)
 string Driver::GetGroupLabel(uint8 const _nodeId, uint8 const _groupIdx)
 {
 	string label = "";
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		label = node->GetGroupLabel(_groupIdx);
 	}
@@ -5374,8 +6074,8 @@ string Driver::GetGroupLabel(uint8 const _nodeId, uint8 const _groupIdx)
 //-----------------------------------------------------------------------------
 void Driver::AddAssociation(uint8 const _nodeId, uint8 const _groupIdx, uint8 const _targetNodeId, uint8 const _instance)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		node->AddAssociation(_groupIdx, _targetNodeId, _instance);
 	}
@@ -5387,8 +6087,8 @@ void Driver::AddAssociation(uint8 const _nodeId, uint8 const _groupIdx, uint8 co
 //-----------------------------------------------------------------------------
 void Driver::RemoveAssociation(uint8 const _nodeId, uint8 const _groupIdx, uint8 const _targetNodeId, uint8 const _instance)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	if (Node* node = GetNode(_nodeId))
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
 	{
 		node->RemoveAssociation(_groupIdx, _targetNodeId, _instance);
 	}
@@ -5400,52 +6100,174 @@ void Driver::RemoveAssociation(uint8 const _nodeId, uint8 const _groupIdx, uint8
 //-----------------------------------------------------------------------------
 void Driver::QueueNotification(Notification* _notification)
 {
+	Internal::LockGuard LG(m_notificationMutex);
+	if (m_notificationHighWatermark)
+	{
+		if (!m_notificationOverload && m_notificationBacklog >= m_notificationHighWatermark)
+		{
+			SetNotificationOverload(true);
+		}
+		if (m_notificationOverload && ShedNotification(_notification))
+		{
+			delete _notification;
+			return;
+		}
+	}
+	++m_notificationBacklog;
 	m_notifications.push_back(_notification);
 	m_notificationsEvent->Set();
 }
 
+//-----------------------------------------------------------------------------
+// <Driver::ShedNotification>
+// Decide whether a notification can be dropped while the backlog is overloaded
+//-----------------------------------------------------------------------------
+bool Driver::ShedNotification(Notification* _notification)
+{
+	switch (_notification->GetType())
+	{
+		case Notification::Type_ValueRefreshed:
+		{
+			// the value has not changed, so nothing is lost
+			m_notificationsShed++;
+			return true;
+		}
+		case Notification::Type_NodeEvent:
+		{
+			Notification*& last = m_queuedNodeEvents[_notification->GetNodeId()];
+			if (last && last->GetValueID() == _notification->GetValueID() && last->GetEvent() == _notification->GetEvent())
+			{
+				m_notificationsCoalesced++;
+				return true;
+			}
+			last = _notification;
+			return false;
+		}
+		default:
+		{
+			return false;
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::SetNotificationOverload>
+// Start or stop shedding notifications, and tell the application
+//-----------------------------------------------------------------------------
+void Driver::SetNotificationOverload(bool const _overload)
+{
+	m_notificationOverload = _overload;
+	Notification* notification = new Notification(Notification::Type_UserAlerts);
+	notification->SetHomeAndNodeIds(m_homeId, 0);
+	if (_overload)
+	{
+		m_notificationOverloads++;
+		memset(m_queuedNodeEvents, 0, sizeof(m_queuedNodeEvents));
+		Log::Write(LogLevel_Warning, "%d notifications are waiting to be delivered, dropping low priority notifications until there are %d", (uint32) m_notificationBacklog, m_notificationLowWatermark);
+		notification->SetUserAlertNotification(Notification::Alert_NotificationOverload);
+	}
+	else
+	{
+		Log::Write(LogLevel_Info, "Notification backlog is down to %d, delivering all notifications again", (uint32) m_notificationBacklog);
+		notification->SetUserAlertNotification(Notification::Alert_NotificationOverloadCleared);
+	}
+	++m_notificationBacklog;
+	m_notifications.push_back(notification);
+	m_notificationsEvent->Set();
+}
+
 //-----------------------------------------------------------------------------
 // <Driver::NotifyWatchers>
 // Notify any watching objects of a value change
 //-----------------------------------------------------------------------------
 void Driver::NotifyWatchers()
 {
-	list<Notification*>::iterator nit = m_notifications.begin();
-	while (nit != m_notifications.end())
+	// Nodes are no longer all locked while notifications are queued, so take the
+	// list as it stands and let anything queued from now on wake us again
+	list<Notification*> notifications;
 	{
-		Notification* notification = m_notifications.front();
-		m_notifications.pop_front();
+		Internal::LockGuard LG(m_notificationMutex);
+		notifications.swap(m_notifications);
+		m_notificationsEvent->Reset();
+		if (m_notificationOverload)
+		{
+			// only NodeEvents still in m_notifications can be coalesced
+			memset(m_queuedNodeEvents, 0, sizeof(m_queuedNodeEvents));
+		}
+	}
+
+	while (!notifications.empty())
+	{
+		Notification* notification = notifications.front();
+		notifications.pop_front();
+
+		if (m_notificationPool)
+		{
+			m_notificationPool->Queue(notification);
+		}
+		else
+		{
+			DeliverNotification(notification, false);
+		}
+	}
+}
 
-		/* check the any ValueID's sent as part of the Notification are still valid */
-		switch (notification->GetType())
+//-----------------------------------------------------------------------------
+// <Driver::DeliverNotification>
+// Pass a notification to the watchers, then delete it.  _concurrent is set
+// when it is delivered by the notification pool, alongside those for other nodes.
+//-----------------------------------------------------------------------------
+void Driver::DeliverNotification(Notification* _notification, bool const _concurrent)
+{
+	/* check the any ValueID's sent as part of the Notification are still valid */
+	switch (_notification->GetType())
+	{
+		case Notification::Type_ValueAdded:
+		case Notification::Type_ValueChanged:
+		case Notification::Type_ValueRefreshed:
 		{
-			case Notification::Type_ValueAdded:
-			case Notification::Type_ValueChanged:
-			case Notification::Type_ValueRefreshed:
+			Internal::VC::Value *val = GetValue(_notification->GetValueID());
+			if (!val)
 			{
-				Internal::VC::Value *val = GetValue(notification->GetValueID());
-				if (!val)
-				{
-					Log::Write(LogLevel_Info, notification->GetNodeId(), "Dropping Notification as ValueID does not exist");
-					nit = m_notifications.begin();
-					delete notification;
-					continue;
-				}
-				val->Release();
-				break;
+				Log::Write(LogLevel_Info, _notification->GetNodeId(), "Dropping Notification as ValueID does not exist");
+				delete _notification;
+				NotificationDelivered();
+				return;
 			}
-			default:
-				break;
+			val->Release();
+			break;
 		}
+		default:
+			break;
+	}
 
-		Log::Write(LogLevel_Detail, notification->GetNodeId(), "Notification: %s", notification->GetAsString().c_str());
+	Log::Write(LogLevel_Detail, _notification->GetNodeId(), "Notification: %s", _notification->GetAsString().c_str());
 
-		Manager::Get()->NotifyWatchers(notification);
+	Internal::Platform::TimeStamp start;
+	Manager::Get()->NotifyWatchers(_notification, _concurrent);
+	if (m_notificationHistogram)
+	{
+		m_notificationHistogram->Observe((uint32) (Internal::Platform::TimeStamp() - start));
+	}
+	delete _notification;
+	NotificationDelivered();
+}
 
-		delete notification;
-		nit = m_notifications.begin();
+//-----------------------------------------------------------------------------
+// <Driver::NotificationDelivered>
+// Take a notification off the backlog, and stop shedding once it is down to
+// the low watermark
+//-----------------------------------------------------------------------------
+void Driver::NotificationDelivered()
+{
+	if (--m_notificationBacklog <= m_notificationLowWatermark && m_notificationOverload)
+	{
+		Internal::LockGuard LG(m_notificationMutex);
+		if (m_notificationOverload)
+		{
+			SetNotificationOverload(false);
+		}
 	}
-	m_notificationsEvent->Reset();
 }
 
 //-----------------------------------------------------------------------------
@@ -5629,7 +6451,7 @@ void Driver::SaveButtons()
 
 	snprintf(str, sizeof(str), "%d", 1);
 	nodesElement->SetAttribute("version", str);
-	Internal::LockGuard LG(m_nodeMutex);
+	Internal::NodesLockGuard LG(this);
 	for (int i = 1; i < 256; i++)
 	{
 		if (m_nodes[i] == NULL || m_nodes[i]->m_buttonMap.empty())
@@ -5660,7 +6482,7 @@ void Driver::SaveButtons()
 	}
 
 	string userPath;
-	Options::Get()->GetOptionAsString("UserPath", &userPath);
+	Options::Get()->GetOptionAsString(Options::OptionKey_UserPath, &userPath);
 
 	string filename = userPath + "zwbutton.xml";
 
@@ -5679,7 +6501,7 @@ void Driver::ReadButtons(uint8 const _nodeId)
 
 	// Load the XML document that contains the driver configuration
 	string userPath;
-	Options::Get()->GetOptionAsString("UserPath", &userPath);
+	Options::Get()->GetOptionAsString(Options::OptionKey_UserPath, &userPath);
 
 	string filename = userPath + "zwbutton.xml";
 
@@ -6041,6 +6863,104 @@ void Driver::UpdateNodeRoutes(uint8 const _nodeId, bool _doUpdate		// = false
 	}
 }
 
+//-----------------------------------------------------------------------------
+// <Driver::RegisterMetrics>
+// Add the driver's counters, gauges and histograms to the metrics registry,
+// labelled with the controller path
+//-----------------------------------------------------------------------------
+void Driver::RegisterMetrics()
+{
+	static struct
+	{
+		char const* m_name;
+		char const* m_help;
+		std::atomic<uint32> Driver::* m_counter;
+	} const c_counters[] =
+	{
+	{ "ozw_frames_received_total", "Number of SOF bytes received", &Driver::m_SOFCnt },
+	{ "ozw_ack_waiting_total", "Number of unsolicited messages while waiting for an ACK", &Driver::m_ACKWaiting },
+	{ "ozw_read_aborts_total", "Number of times reads were aborted due to timeouts", &Driver::m_readAborts },
+	{ "ozw_bad_checksums_total", "Number of bad checksums", &Driver::m_badChecksum },
+	{ "ozw_messages_read_total", "Number of messages successfully read", &Driver::m_readCnt },
+	{ "ozw_messages_written_total", "Number of messages successfully sent", &Driver::m_writeCnt },
+	{ "ozw_can_received_total", "Number of CAN bytes received", &Driver::m_CANCnt },
+	{ "ozw_nak_received_total", "Number of NAK bytes received", &Driver::m_NAKCnt },
+	{ "ozw_ack_received_total", "Number of ACK bytes received", &Driver::m_ACKCnt },
+	{ "ozw_out_of_frame_total", "Number of bytes out of framing", &Driver::m_OOFCnt },
+	{ "ozw_messages_dropped_total", "Number of messages dropped and not delivered", &Driver::m_dropped },
+	{ "ozw_duplicates_dropped_total", "Number of requests dropped as an identical one was already queued", &Driver::m_duplicateDropped },
+	{ "ozw_duplicates_replaced_total", "Number of Wake-Up queue messages replaced by a newer copy", &Driver::m_duplicateReplaced },
+	{ "ozw_retries_total", "Number of retransmitted messages", &Driver::m_retries },
+	{ "ozw_unexpected_callbacks_total", "Number of unexpected callbacks", &Driver::m_callbacks },
+	{ "ozw_bad_routes_total", "Number of failed messages due to bad route response", &Driver::m_badroutes },
+	{ "ozw_no_ack_total", "Number of no ACK returned errors", &Driver::m_noack },
+	{ "ozw_network_busy_total", "Number of network busy/failure messages", &Driver::m_netbusy },
+	{ "ozw_not_idle_total", "Number of not idle messages", &Driver::m_notidle },
+	{ "ozw_tx_verified_total", "Number of TX Verified messages", &Driver::m_txverified },
+	{ "ozw_non_delivery_total", "Number of messages not delivered to the network", &Driver::m_nondelivery },
+	{ "ozw_routed_busy_total", "Number of messages received with routed busy status", &Driver::m_routedbusy },
+	{ "ozw_broadcasts_read_total", "Number of broadcasts read", &Driver::m_broadcastReadCnt },
+	{ "ozw_broadcasts_written_total", "Number of broadcasts sent", &Driver::m_broadcastWriteCnt },
+	{ "ozw_polls_total", "Number of polls that fell due", &Driver::m_pollCnt },
+	{ "ozw_polls_skipped_total", "Number of polls skipped because the value had recently been refreshed", &Driver::m_pollSkipped },
+	{ "ozw_polls_multicmd_total", "Number of polls sent together with others in a MultiCmd frame", &Driver::m_pollMultiCmd },
+	{ "ozw_notifications_shed_total", "Number of low priority notifications dropped while the backlog was overloaded", &Driver::m_notificationsShed },
+	{ "ozw_notifications_coalesced_total", "Number of repeated NodeEvent notifications coalesced while the backlog was overloaded", &Driver::m_notificationsCoalesced },
+	{ "ozw_notification_overloads_total", "Number of times the notification backlog passed the high watermark", &Driver::m_notificationOverloads } };
+
+	Internal::Metrics* metrics = Internal::Metrics::Get();
+	if (!metrics)
+	{
+		return;
+	}
+	string labels = Internal::Metrics::Label("controller", m_controllerPath);
+	for (size_t i = 0; i < sizeof(c_counters) / sizeof(c_counters[0]); ++i)
+	{
+		metrics->AddCounter(this, c_counters[i].m_name, c_counters[i].m_help, labels, &(this->*c_counters[i].m_counter));
+	}
+
+	metrics->AddGauge(this, "ozw_send_queue_depth", "Number of messages waiting in the send queues", labels, Driver::GetSendQueueMetric, this);
+	metrics->AddGauge(this, "ozw_poll_list_size", "Number of values being polled", labels, Driver::GetPollListMetric, this);
+	metrics->AddGauge(this, "ozw_notification_backlog", "Number of notifications queued and not yet delivered", labels, Driver::GetNotificationBacklogMetric, this);
+
+	static uint32 const c_bounds[] = { 1, 5, 10, 50, 100, 500, 1000, 5000, 10000, 60000 };
+	vector<uint32> bounds(c_bounds, c_bounds + sizeof(c_bounds) / sizeof(c_bounds[0]));
+	m_pollLagHistogram = metrics->AddHistogram(this, "ozw_poll_lag_milliseconds", "Time polls were sent after they were due", labels, bounds);
+	m_notificationHistogram = metrics->AddHistogram(this, "ozw_notification_handling_milliseconds", "Time the watchers took to handle a notification", labels, bounds);
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::GetSendQueueMetric>
+// Gauge of the messages waiting to be sent
+//-----------------------------------------------------------------------------
+int64 Driver::GetSendQueueMetric(void* _context)
+{
+	Driver* driver = (Driver*) _context;
+	Internal::LockGuard LG(driver->m_sendMutex);
+	return driver->GetSendQueueCount();
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::GetPollListMetric>
+// Gauge of the values being polled
+//-----------------------------------------------------------------------------
+int64 Driver::GetPollListMetric(void* _context)
+{
+	Driver* driver = (Driver*) _context;
+	Internal::LockGuard LG(driver->m_pollMutex);
+	return (int64) driver->m_pollIndex.size();
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::GetNotificationBacklogMetric>
+// Gauge of the notifications waiting to be delivered
+//-----------------------------------------------------------------------------
+int64 Driver::GetNotificationBacklogMetric(void* _context)
+{
+	Driver* driver = (Driver*) _context;
+	return driver->m_notificationBacklog;
+}
+
 //-----------------------------------------------------------------------------
 // <Driver::GetDriverStatistics>
 // Return driver statistics
@@ -6069,6 +6989,16 @@ void Driver::GetDriverStatistics(DriverData* _data)
 	_data->m_routedbusy = m_routedbusy;
 	_data->m_broadcastReadCnt = m_broadcastReadCnt;
 	_data->m_broadcastWriteCnt = m_broadcastWriteCnt;
+	_data->m_pollCnt = m_pollCnt;
+	_data->m_pollSkipped = m_pollSkipped;
+	_data->m_pollMultiCmd = m_pollMultiCmd;
+	_data->m_duplicateDropped = m_duplicateDropped;
+	_data->m_duplicateReplaced = m_duplicateReplaced;
+	_data->m_pollLagAvg = m_pollCnt ? (uint32) (m_pollLagTotal / m_pollCnt) : 0;
+	_data->m_pollLagMax = m_pollLagMax;
+	_data->m_notificationsShed = m_notificationsShed;
+	_data->m_notificationsCoalesced = m_notificationsCoalesced;
+	_data->m_notificationOverloads = m_notificationOverloads;
 }
 
 //-----------------------------------------------------------------------------
@@ -6077,11 +7007,46 @@ void Driver::GetDriverStatistics(DriverData* _data)
 //-----------------------------------------------------------------------------
 void Driver::GetNodeStatistics(uint8 const _nodeId, Node::NodeData* _data)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	Node* node = GetNode(_nodeId);
+	Internal::NodeLockGuard LG(this, _nodeId);
+	Node* node = LG.GetNode();
 	if (node != NULL)
 	{
 		node->GetNodeStatistics(_data);
+
+		uint32 sent = 0;
+		uint64 waitTotal = 0;
+		_data->m_queueDepth = 0;
+		_data->m_maxQueueWait = 0;
+		m_sendMutex->Lock();
+		for (int32 i = 0; i < MsgQueue_Count; ++i)
+		{
+			m_msgQueue[i].GetNodeStatistics(_nodeId, &_data->m_queueDepth, &sent, &waitTotal, &_data->m_maxQueueWait);
+		}
+		m_sendMutex->Unlock();
+		_data->m_averageQueueWait = sent ? (uint32) (waitTotal / sent) : 0;
+
+		_data->m_notificationBacklog = 0;
+		_data->m_maxNotificationBacklog = 0;
+		_data->m_averageNotificationDelay = 0;
+		_data->m_maxNotificationDelay = 0;
+		if (m_notificationPool)
+		{
+			uint32 delivered;
+			m_notificationPool->GetStrandStatistics(_nodeId, &_data->m_notificationBacklog, &_data->m_maxNotificationBacklog, &delivered, &_data->m_averageNotificationDelay, &_data->m_maxNotificationDelay);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// <Driver::RecordLatency>
+// Count a latency in a node's histograms, from outside the driver thread
+//-----------------------------------------------------------------------------
+void Driver::RecordLatency(uint8 const _nodeId, uint8 const _commandClassId, Node::Latency const _kind, uint32 const _ms)
+{
+	Internal::NodeLockGuard LG(this, _nodeId);
+	if (Node* node = LG.GetNode())
+	{
+		node->RecordLatency(_kind, _commandClassId, _ms);
 	}
 }
 
@@ -6111,10 +7076,15 @@ void Driver::LogDriverStatistics()
 	Log::Write(LogLevel_Always, "Total messages successfully received: . . . . . . . . . . %ld", data.m_readCnt);
 	Log::Write(LogLevel_Always, "Total Messages successfully sent: . . . . . . . . . . . . %ld", data.m_writeCnt);
 	Log::Write(LogLevel_Always, "ACKs received from controller:  . . . . . . . . . . . . . %ld", data.m_ACKCnt);
+	Log::Write(LogLevel_Always, "Polls due (average / longest delay):  . . . . . . . . . . %ld (%ld ms / %ld ms)", data.m_pollCnt, data.m_pollLagAvg, data.m_pollLagMax);
+	Log::Write(LogLevel_Always, "Polls skipped as the value was recently refreshed:  . . . %ld", data.m_pollSkipped);
+	Log::Write(LogLevel_Always, "Polls sent in a MultiCmd frame: . . . . . . . . . . . . . %ld", data.m_pollMultiCmd);
+	Log::Write(LogLevel_Always, "Requests dropped as already queued: . . . . . . . . . . . %ld", data.m_duplicateDropped);
+	Log::Write(LogLevel_Always, "Wake-Up queue messages replaced by a newer copy:  . . . . %ld", data.m_duplicateReplaced);
+	Log::Write(LogLevel_Always, "Notification overloads (dropped / coalesced):  . . . . . %ld (%ld / %ld)", data.m_notificationOverloads, data.m_notificationsShed, data.m_notificationsCoalesced);
 	// Consider tracking and adding:
 	//		Initialization messages
 	//		Ad-hoc command messages
-	//		Polling messages
 	//		Messages inititated by network
 	//		Others?
 	Log::Write(LogLevel_Always, "*** Errors");
@@ -6143,7 +7113,7 @@ uint8 *Driver::GetNetworkKey()
 	static bool keySet = false;
 	if (keySet == false)
 	{
-		Options::Get()->GetOptionAsString("NetworkKey", &networkKey);
+		Options::Get()->GetOptionAsString(Options::OptionKey_NetworkKey, &networkKey);
 		Internal::split(elems, networkKey, ",", true);
 		if (elems.size() != 16)
 		{
@@ -6177,7 +7147,7 @@ uint8 *Driver::GetNetworkKey()
 bool Driver::isNetworkKeySet()
 {
 	std::string networkKey;
-	if (!Options::Get()->GetOptionAsString("NetworkKey", &networkKey))
+	if (!Options::Get()->GetOptionAsString(Options::OptionKey_NetworkKey, &networkKey))
 	{
 		return false;
 	}
@@ -6219,7 +7189,7 @@ void Driver::processConfigRevision(Internal::DNSLookup *result)
 		{
 			if (result->NodeID > 0)
 			{
-				Internal::LockGuard LG(m_nodeMutex);
+				Internal::NodesLockGuard LG(this);
 				Node *node = this->GetNode(result->NodeID);
 				if (!node)
 				{
@@ -6236,7 +7206,7 @@ void Driver::processConfigRevision(Internal::DNSLookup *result)
 					QueueNotification(notification);
 
 					bool update = false;
-					Options::Get()->GetOptionAsBool("AutoUpdateConfigFile", &update);
+					Options::Get()->GetOptionAsBool(Options::OptionKey_AutoUpdateConfigFile, &update);
 
 					if (update)
 						m_mfs->updateConfigFile(this, node);
@@ -6255,7 +7225,7 @@ void Driver::processConfigRevision(Internal::DNSLookup *result)
 					QueueNotification(notification);
 
 					bool update = false;
-					Options::Get()->GetOptionAsBool("AutoUpdateConfigFile", &update);
+					Options::Get()->GetOptionAsBool(Options::OptionKey_AutoUpdateConfigFile, &update);
 
 					if (update)
 					{
@@ -6337,9 +7307,13 @@ bool Driver::startMFSDownload(string configfile)
 
 bool Driver::refreshNodeConfig(uint8 _nodeId)
 {
-	Internal::LockGuard LG(m_nodeMutex);
+	Internal::NodesLockGuard LG(this);
+	if (!LG.IsLocked())
+	{
+		return false;
+	}
 	string action;
-	Options::Get()->GetOptionAsString("ReloadAfterUpdate", &action);
+	Options::Get()->GetOptionAsString(Options::OptionKey_ReloadAfterUpdate, &action);
 	if (Internal::ToUpper(action) == "NEVER")
 	{
 		Notification* notification = new Notification(Notification::Type_UserAlerts);
@@ -6394,14 +7368,29 @@ bool Driver::refreshNodeConfig(uint8 _nodeId)
 //-----------------------------------------------------------------------------
 void Driver::ReloadNode(uint8 const _nodeId)
 {
-	Internal::LockGuard LG(m_nodeMutex);
+	Internal::NodesLockGuard LG(this);
+	if (!LG.IsLocked())
+	{
+		// We are called from a node's own code, such as its wake up.  Leave the
+		// reload to the driver thread, which picks it up once the node is released.
+		Log::Write(LogLevel_Info, _nodeId, "Queuing (%s) Reload Node", c_sendQueueNames[MsgQueue_Command]);
+		MsgQueueItem item;
+		item.m_command = MsgQueueCmd_ReloadNode;
+		item.m_nodeId = _nodeId;
+		item.m_retry = false;
+		m_sendMutex->Lock();
+		m_msgQueue[MsgQueue_Command].push_back(item);
+		m_queueEvent[MsgQueue_Command]->Set();
+		m_sendMutex->Unlock();
+		return;
+	}
 	Log::Write(LogLevel_Detail, _nodeId, "Reloading Node");
 	/* delete any cached information about this node so we start from fresh */
 	char str[32];
 	int32 intVal;
 
 	string userPath;
-	Options::Get()->GetOptionAsString("UserPath", &userPath);
+	Options::Get()->GetOptionAsString(Options::OptionKey_UserPath, &userPath);
 
 	snprintf(str, sizeof(str), "ozwcache_0x%08x.xml", m_homeId);
 	string filename = userPath + string(str);
@@ -6556,8 +7545,8 @@ void Driver::ProcessEventMsg()
 //-----------------------------------------------------------------------------
 string const Driver::GetMetaData(uint8 const _nodeId, Node::MetaDataFields _metadata)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	Node* node = GetNode(_nodeId);
+	Internal::NodeLockGuard LG(this, _nodeId);
+	Node* node = LG.GetNode();
 	if (node != NULL)
 	{
 		return node->GetMetaData(_metadata);
@@ -6571,8 +7560,8 @@ string const Driver::GetMetaData(uint8 const _nodeId, Node::MetaDataFields _meta
 //-----------------------------------------------------------------------------
 Node::ChangeLogEntry const Driver::GetChangeLog(uint8 const _nodeId, uint32_t revision)
 {
-	Internal::LockGuard LG(m_nodeMutex);
-	Node* node = GetNode(_nodeId);
+	Internal::NodeLockGuard LG(this, _nodeId);
+	Node* node = LG.GetNode();
 	if (node != NULL)
 	{
 		return node->GetChangeLog(revision);
@@ -31,6 +31,10 @@
 #include <string>
 #include <map>
 #include <list>
+#include <vector>
+#include <deque>
+#include <unordered_map>
+#include <atomic>
 
 #include "Defs.h"
 #include "Group.h"
@@ -86,10 +90,16 @@ namespace OpenZWave
 		}
 		class DNSThread;
 		struct DNSLookup;
+		class Histogram;
 		class i_HttpClient;
 		struct HttpDownload;
 		class ManufacturerSpecificDB;
 		class Msg;
+		class NodeLockGuard;
+		class NodeLocks;
+		class NodesLockGuard;
+		class NotificationPool;
+		class Scene;
 		class TimerThread;
 	}
 
@@ -117,7 +127,12 @@ namespace OpenZWave
 			friend class Internal::CC::Security;
 			friend class Internal::Msg;
 			friend class Internal::ManufacturerSpecificDB;
+			friend class Internal::Scene;
 			friend class TimerThread;
+			friend class Internal::NotificationPool;
+			friend class Internal::NodeLockGuard;
+			friend class Internal::NodesLockGuard;
+			friend class MsgQueueListTest;
 
 			//-----------------------------------------------------------------------------
 			// ZWay
@@ -369,12 +384,32 @@ namespace OpenZWave
 			bool m_hasExtendedTxStatus;						// True if the controller accepted SERIAL_API_SETUP_CMD_TX_STATUS_REPORT
 			uint8 m_Controller_nodeId;						// Z-Wave Controller's own node ID.
 			Node* m_nodes[256];								// Array containing all the node objects.
-			Internal::Platform::Mutex* m_nodeMutex;								// Serializes access to node data
+			Internal::Platform::Mutex* m_nodeMutex;								// Guards m_nodes, and while held with Internal::NodesLockGuard, every node's data
 
 			Internal::CC::ControllerReplication* m_controllerReplication;					// Controller replication is handled separately from the other command classes, due to older hand-held controllers using invalid node IDs.
 
 			uint8 m_transmitOptions;
 
+			//-----------------------------------------------------------------------------
+			//	Node locking
+			//-----------------------------------------------------------------------------
+			// Code that works on a single node takes only that node's lock (Internal::NodeLockGuard),
+			// so that requests for different nodes can run in parallel.  Code that walks the node
+			// list, adds or removes nodes, or touches several nodes at once takes them all
+			// (Internal::NodesLockGuard).  A thread may hold the lock of one node, or of all of them.
+			// While it holds a single node, asking for a second one or for all of them fails, as
+			// either could deadlock with another thread (see Internal::NodeLocks).  Work reached from
+			// single node code that needs every node, such as CheckCompletedNodeQueries and
+			// ReloadNode, is deferred until the node is released.
+		private:
+			Node* LockNode(uint8 const _nodeId, Internal::Platform::Mutex** o_mutex, bool* o_refused);
+			void UnlockNode(Internal::Platform::Mutex* _mutex);
+			bool LockNodes();
+			void UnlockNodes();
+
+			Internal::NodeLocks* m_nodeLocks;
+			std::atomic<bool> m_nodeQueriesCheckDeferred;				// CheckCompletedNodeQueries was called while holding a single node
+
 			//-----------------------------------------------------------------------------
 			//	Receiving Z-Wave messages
 			//-----------------------------------------------------------------------------
@@ -464,22 +499,60 @@ namespace OpenZWave
 				m_bIntervalBetweenPolls = _bIntervalBetweenPolls;
 			}
 			bool EnablePoll(const ValueID &_valueId, uint8 _intensity = 1);
+			uint32 EnablePoll(vector<ValueID> const &_valueIds, uint8 _intensity = 1);
 			bool DisablePoll(const ValueID &_valueId);
+			uint32 DisablePoll(vector<ValueID> const &_valueIds);
 			bool isPolled(const ValueID &_valueId);
 			void SetPollIntensity(const ValueID &_valueId, uint8 _intensity);
+			bool SetPollPeriod(const ValueID &_valueId, int32 _milliseconds);
 			static void PollThreadEntryPoint(Internal::Platform::Event* _exitEvent, void* _context);
 			void PollThreadProc(Internal::Platform::Event* _exitEvent);
+			bool PollNext();
+			bool IsSendIdle();
+			void SendPollBatch(uint8 const _nodeId, vector<Internal::Msg*>& _msgs);
 
 			Internal::Platform::Thread* m_pollThread;								// Thread for polling devices on the Z-Wave network
 			struct PollEntry
 			{
 					ValueID m_id;
-					uint8 m_pollCounter;
+					uint8 m_intensity;								// Poll on every m_intensity'th pass through the list
+					int32 m_period;									// If non-zero, poll every m_period ms instead
+					int32 m_due;									// When the next poll is due, in ms since m_pollEpoch
+					uint32 m_generation;							// Identifies the current entry for this value in m_pollHeap
+					int32 m_backoff;								// With adaptive polling, multiplies the period while the value does not change
+					uint32 m_changeCount;							// Value::m_changeCount when the value was last due
+					uint32 m_reportCount;							// Value::m_reportCount when the value was last due
 			};
-			list<PollEntry> m_pollList;									// List of nodes that need to be polled
+			struct PollDeadline
+			{
+					int32 m_due;
+					uint64 m_key;									// ValueID::GetId() of the value
+					uint32 m_generation;							// Stale if it does not match the PollEntry
+			};
+			static bool PollDeadlineLater(PollDeadline const& _a, PollDeadline const& _b)
+			{
+				return _a.m_due > _b.m_due;
+			}
+			void SchedulePoll(PollEntry& _entry, int32 const _due);
+			PollEntry* GetNextPoll();
+			bool PreparePoll(PollEntry* _entry, int32 const _now);
+			int32 GetPollPeriod(PollEntry const& _entry);
+			int32 GetPollTime();
+
+			unordered_map<uint64, PollEntry> m_pollIndex;				// Values that need to be polled, by ValueID::GetId()
+			vector<PollDeadline> m_pollHeap;							// When each value is next due, earliest first
 			Internal::Platform::Mutex* m_pollMutex;								// Serialize access to the polling list
 			int32 m_pollInterval;								// Time interval during which all nodes must be polled
 			bool m_bIntervalBetweenPolls;					// if true, the library intersperses m_pollInterval between polls; if false, the library attempts to complete all polls within m_pollInterval
+			Internal::Platform::Event* m_pollEvent;				// Wakes the poll thread when the poll list changes or the send queues drain
+			Internal::Platform::TimeStamp m_pollEpoch;			// Time base for PollEntry::m_due
+			bool m_adaptivePolling;							// Defer polls of recently refreshed values, and back off values that do not change
+			int32 m_adaptivePollCeiling;						// Largest m_backoff
+			std::atomic<uint32> m_pollCnt;								// Number of polls that fell due
+			std::atomic<uint32> m_pollSkipped;							// Number of polls skipped by adaptive polling
+			std::atomic<uint32> m_pollMultiCmd;							// Number of polls sent inside a MultiCmd frame
+			uint64 m_pollLagTotal;							// Sum of the time polls were sent after they were due, in ms
+			uint32 m_pollLagMax;							// Longest time a poll was sent after it was due, in ms
 
 			//-----------------------------------------------------------------------------
 			//	Retrieving Node information
@@ -700,6 +773,7 @@ namespace OpenZWave
 			}
 
 		private:
+			bool IsDuplicateRequest(Internal::Msg const* _msg, MsgQueue const _queue);	// Is the same request already waiting in this queue or one that goes before it
 			/**
 			 *  If there are messages in the send queue (m_sendQueue), gets the next message in the
 			 *  queue and writes it to the serial port.  In sending the message, SendMsg also initializes
@@ -811,7 +885,127 @@ namespace OpenZWave
 					ControllerCommandItem* m_cci;
 			};
 
-			list<MsgQueueItem> m_msgQueue[MsgQueue_Count];
+			/** \brief One of the send queues.
+			 *
+			 * Each node has its own FIFO, and the nodes take turns, one message at a
+			 * time, so a burst of messages for one node (a slow or heavily routed one in
+			 * particular) does not hold up the messages for every other node in the same
+			 * queue.  The order of the messages for any one node is unchanged.  Controller
+			 * commands and messages that are not for a node each share a FIFO.
+			 */
+			class MsgQueueList
+			{
+				private:
+					struct Entry
+					{
+							MsgQueueItem m_item;
+							int32 m_queued;					// when it was queued, in ms since m_epoch
+							uint32 m_hash;					// Msg::GetHash, kept here as the message may be deleted before it is erased
+					};
+					struct NodeQueue
+					{
+							NodeQueue() :
+									m_sent(0), m_waitTotal(0), m_waitMax(0)
+							{
+							}
+							list<Entry> m_entries;
+							uint32 m_sent;					// Number of items taken from the queue
+							uint64 m_waitTotal;				// Total time they waited, in ms
+							uint32 m_waitMax;				// Longest time one waited, in ms
+					};
+					typedef map<uint8, NodeQueue> NodeMap;
+
+				public:
+					/** \brief Visits every item in the queue, a node at a time. */
+					class iterator
+					{
+						public:
+							MsgQueueItem& operator*() const
+							{
+								return m_entry->m_item;
+							}
+							MsgQueueItem* operator->() const
+							{
+								return &m_entry->m_item;
+							}
+							iterator& operator++();
+							bool operator==(iterator const& _other) const
+							{
+								return (m_node == _other.m_node) && (m_node == m_end || m_entry == _other.m_entry);
+							}
+							bool operator!=(iterator const& _other) const
+							{
+								return !(*this == _other);
+							}
+
+						private:
+							friend class MsgQueueList;
+							iterator(NodeMap::iterator _node, NodeMap::iterator _end);
+							void SkipEmpty();
+
+							NodeMap::iterator m_node;
+							NodeMap::iterator m_end;
+							list<Entry>::iterator m_entry;
+					};
+
+					MsgQueueList() :
+							m_size(0)
+					{
+					}
+
+					bool empty() const
+					{
+						return m_size == 0;
+					}
+					size_t size() const
+					{
+						return m_size;
+					}
+					/** The next item to send: the oldest one for the node whose turn it is */
+					MsgQueueItem& front();
+					/** Remove the front item, and pass the turn on to the next node */
+					void pop_front();
+					void push_back(MsgQueueItem const& _item);
+					/** Queue an item ahead of everything else, for a node that keeps its turn */
+					void push_front(MsgQueueItem const& _item);
+					iterator begin()
+					{
+						return iterator(m_nodes.begin(), m_nodes.end());
+					}
+					iterator end()
+					{
+						return iterator(m_nodes.end(), m_nodes.end());
+					}
+					iterator erase(iterator _it);
+
+					/**
+					 * Queue statistics for a node.
+					 * \param o_depth receives the number of items waiting
+					 * \param o_sent receives the number of items taken from the queue
+					 * \param o_waitTotal receives the total time those items waited, in ms
+					 * \param o_waitMax receives the longest time one of them waited, in ms
+					 */
+					void GetNodeStatistics(uint8 const _nodeId, uint32* o_depth, uint32* o_sent, uint64* o_waitTotal, uint32* o_waitMax);
+					/** Is a message with the same frame as _msg already waiting */
+					bool Contains(Internal::Msg const* _msg) const;
+
+				private:
+					MsgQueueList(MsgQueueList const&);					// prevent copy
+					MsgQueueList& operator =(MsgQueueList const&);		// prevent assignment
+
+					static uint8 GetNodeKey(MsgQueueItem const& _item);
+					void RemoveTurn(uint8 const _key);
+					void AddFrame(Entry* _entry);
+					void RemoveFrame(Entry const& _entry);
+
+					NodeMap m_nodes;
+					unordered_multimap<uint32, Internal::Msg const*> m_frames;	// The messages waiting, by Msg::GetHash
+					deque<uint8> m_turns;				// Nodes with items waiting.  The one at the front goes next.
+					size_t m_size;
+					Internal::Platform::TimeStamp m_epoch;
+			};
+
+			MsgQueueList m_msgQueue[MsgQueue_Count];
 			Internal::Platform::Event* m_queueEvent[MsgQueue_Count];		// Events for each queue, which are signaled when the queue is not empty
 			Internal::Platform::Mutex* m_sendMutex;						// Serialize access to the queues
 			Internal::Msg* m_currentMsg;
@@ -883,8 +1077,28 @@ namespace OpenZWave
 		private:
 			void QueueNotification(Notification* _notification);				// Adds a notification to the list.  Notifications are queued until a point in the thread where we know we do not have any nodes locked.
 			void NotifyWatchers();												// Passes the notifications to all the registered watcher callbacks in turn.
+			void DeliverNotification(Notification* _notification, bool const _concurrent);	// Passes one notification to the watchers, and deletes it
 			list<Notification*> m_notifications;
 			Internal::Platform::Event* m_notificationsEvent;
+			Internal::Platform::Mutex* m_notificationMutex;					// Guards m_notifications
+			Internal::NotificationPool* m_notificationPool;						// Delivers the notifications when the NotificationThreads option is set
+
+			// Overload protection.  Once m_notificationHighWatermark notifications are waiting to be
+			// delivered, ValueRefreshed notifications are dropped and a NodeEvent that repeats the last
+			// one queued for its node is coalesced into it, until the backlog is back down to
+			// m_notificationLowWatermark.  Everything else, and so every structural change, is always
+			// delivered.  Each transition is reported with a Type_UserAlerts notification.
+			bool ShedNotification(Notification* _notification);				// Called with m_notificationMutex held while overloaded
+			void SetNotificationOverload(bool const _overload);				// Called with m_notificationMutex held
+			void NotificationDelivered();										// Called when a notification has been delivered, or dropped by DeliverNotification
+			uint32 m_notificationHighWatermark;									// 0 if overload protection is off
+			uint32 m_notificationLowWatermark;
+			std::atomic<uint32> m_notificationBacklog;							// Notifications queued and not yet delivered, including those in the pool
+			std::atomic<bool> m_notificationOverload;
+			Notification* m_queuedNodeEvents[256];								// The last NodeEvent in m_notifications for each node, while overloaded
+			std::atomic<uint32> m_notificationsShed;
+			std::atomic<uint32> m_notificationsCoalesced;
+			std::atomic<uint32> m_notificationOverloads;
 
 			//-----------------------------------------------------------------------------
 			//	Statistics
@@ -914,35 +1128,57 @@ namespace OpenZWave
 					uint32 m_routedbusy;		// Number of messages received with routed busy status
 					uint32 m_broadcastReadCnt;	// Number of broadcasts read
 					uint32 m_broadcastWriteCnt;	// Number of broadcasts sent
+					uint32 m_pollCnt;			// Number of polls that fell due
+					uint32 m_pollSkipped;		// Number of polls skipped because the value had recently been refreshed
+					uint32 m_pollMultiCmd;		// Number of polls sent together with others for the same node in a MultiCmd frame
+					uint32 m_duplicateDropped;	// Number of requests dropped as an identical one was already queued
+					uint32 m_duplicateReplaced;	// Number of messages in a Wake-Up queue replaced by a newer copy of the same request
+					uint32 m_pollLagAvg;		// Average time polls were sent after they were due, in ms
+					uint32 m_pollLagMax;		// Longest time a poll was sent after it was due, in ms
+					uint32 m_notificationsShed;	// Number of low priority notifications dropped while the notification backlog was overloaded
+					uint32 m_notificationsCoalesced;	// Number of repeated NodeEvent notifications coalesced while overloaded
+					uint32 m_notificationOverloads;	// Number of times the notification backlog passed the high watermark
 			};
 			void LogDriverStatistics();
+			void RecordLatency(uint8 const _nodeId, uint8 const _commandClassId, Node::Latency const _kind, uint32 const _ms);
 
 		private:
 			void GetDriverStatistics(DriverData* _data);
 			void GetNodeStatistics(uint8 const _nodeId, Node::NodeData* _data);
 
-			uint32 m_SOFCnt;			// Number of SOF bytes received
-			uint32 m_ACKWaiting;		// Number of unsolicited messages while waiting for an ACK
-			uint32 m_readAborts;		// Number of times read were aborted due to timeouts
-			uint32 m_badChecksum;		// Number of bad checksums
-			uint32 m_readCnt;			// Number of messages successfully read
-			uint32 m_writeCnt;			// Number of messages successfully sent
-			uint32 m_CANCnt;			// Number of CAN bytes received
-			uint32 m_NAKCnt;			// Number of NAK bytes received
-			uint32 m_ACKCnt;			// Number of ACK bytes received
-			uint32 m_OOFCnt;			// Number of bytes out of framing
-			uint32 m_dropped;			// Number of messages dropped & not delivered
-			uint32 m_retries;			// Number of retransmitted messages
-			uint32 m_callbacks;			// Number of unexpected callbacks
-			uint32 m_badroutes;			// Number of failed messages due to bad route response
-			uint32 m_noack;				// Number of no ACK returned errors
-			uint32 m_netbusy;			// Number of network busy/failure messages
-			uint32 m_notidle;			// Number of not idle messages
-			uint32 m_txverified;		// Number of TX Verified messages
-			uint32 m_nondelivery;		// Number of messages not delivered to network
-			uint32 m_routedbusy;		// Number of messages received with routed busy status
-			uint32 m_broadcastReadCnt;	// Number of broadcasts read
-			uint32 m_broadcastWriteCnt;	// Number of broadcasts sent
+			std::atomic<uint32> m_SOFCnt;			// Number of SOF bytes received
+			std::atomic<uint32> m_ACKWaiting;		// Number of unsolicited messages while waiting for an ACK
+			std::atomic<uint32> m_readAborts;		// Number of times read were aborted due to timeouts
+			std::atomic<uint32> m_badChecksum;		// Number of bad checksums
+			std::atomic<uint32> m_readCnt;			// Number of messages successfully read
+			std::atomic<uint32> m_writeCnt;			// Number of messages successfully sent
+			std::atomic<uint32> m_CANCnt;			// Number of CAN bytes received
+			std::atomic<uint32> m_NAKCnt;			// Number of NAK bytes received
+			std::atomic<uint32> m_ACKCnt;			// Number of ACK bytes received
+			std::atomic<uint32> m_OOFCnt;			// Number of bytes out of framing
+			std::atomic<uint32> m_dropped;			// Number of messages dropped & not delivered
+			std::atomic<uint32> m_duplicateDropped;	// Number of requests dropped as an identical one was already queued
+			std::atomic<uint32> m_duplicateReplaced;	// Number of Wake-Up queue messages replaced by a newer copy
+			std::atomic<uint32> m_retries;			// Number of retransmitted messages
+			std::atomic<uint32> m_callbacks;			// Number of unexpected callbacks
+			std::atomic<uint32> m_badroutes;			// Number of failed messages due to bad route response
+			std::atomic<uint32> m_noack;				// Number of no ACK returned errors
+			std::atomic<uint32> m_netbusy;			// Number of network busy/failure messages
+			std::atomic<uint32> m_notidle;			// Number of not idle messages
+			std::atomic<uint32> m_txverified;		// Number of TX Verified messages
+			std::atomic<uint32> m_nondelivery;		// Number of messages not delivered to network
+			std::atomic<uint32> m_routedbusy;		// Number of messages received with routed busy status
+			std::atomic<uint32> m_broadcastReadCnt;	// Number of broadcasts read
+			std::atomic<uint32> m_broadcastWriteCnt;	// Number of broadcasts sent
+
+			// The counters above are registered with Internal::Metrics as they are, alongside
+			// these gauges and histograms
+			void RegisterMetrics();
+			static int64 GetSendQueueMetric(void* _context);
+			static int64 GetPollListMetric(void* _context);
+			static int64 GetNotificationBacklogMetric(void* _context);
+			Internal::Histogram* m_pollLagHistogram;				// Time polls were sent after they were due, in ms
+			Internal::Histogram* m_notificationHistogram;			// Time the watchers took to handle each notification, in ms
 			//time_t m_commandStart;	// Start time of last command
 			//time_t m_timeoutLost;		// Cumulative time lost to timeouts
 
@@ -1032,6 +1268,82 @@ namespace OpenZWave
 
 	};
 
+	namespace Internal
+	{
+		/** \brief Locks a single node for as long as it is in scope.
+		 *
+		 * Only the node's own lock is held, so other threads can work on other nodes
+		 * at the same time.  GetNode returns NULL if there is no such node, or if the
+		 * lock was refused because this thread holds a different node.  IsRefused
+		 * tells the two apart: after a refusal the node must not be touched at all.
+		 */
+		class NodeLockGuard
+		{
+			public:
+				NodeLockGuard(Driver* _driver, uint8 const _nodeId) :
+						m_driver(_driver), m_mutex(NULL), m_refused(false)
+				{
+					m_node = m_driver->LockNode(_nodeId, &m_mutex, &m_refused);
+				}
+				~NodeLockGuard()
+				{
+					m_driver->UnlockNode(m_mutex);
+				}
+				Node* GetNode() const
+				{
+					return m_node;
+				}
+				bool IsRefused() const
+				{
+					return m_refused;
+				}
+			private:
+				NodeLockGuard(NodeLockGuard const&);
+				NodeLockGuard& operator =(NodeLockGuard const&);
+
+				Driver* m_driver;
+				Node* m_node;
+				Platform::Mutex* m_mutex;
+				bool m_refused;
+		};
+
+		/** \brief Locks the node list and every node for as long as it is in scope.
+		 *
+		 * The lock is refused if this thread holds a single node.  Code that can be
+		 * reached from a single node must check IsLocked, and fail or defer its work.
+		 */
+		class NodesLockGuard
+		{
+			public:
+				NodesLockGuard(Driver* _driver) :
+						m_driver(_driver)
+				{
+					m_locked = m_driver->LockNodes();
+				}
+				~NodesLockGuard()
+				{
+					Unlock();
+				}
+				void Unlock()
+				{
+					if (m_locked)
+					{
+						m_locked = false;
+						m_driver->UnlockNodes();
+					}
+				}
+				bool IsLocked() const
+				{
+					return m_locked;
+				}
+			private:
+				NodesLockGuard(NodesLockGuard const&);
+				NodesLockGuard& operator =(NodesLockGuard const&);
+
+				Driver* m_driver;
+				bool m_locked;
+		};
+	} // namespace Internal
 } // namespace OpenZWave
 
 #endif // _Driver_H
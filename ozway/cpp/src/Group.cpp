@@ -363,7 +363,7 @@ void Group::OnGroupChanged(vector<InstanceAssociation> const& _associations)
 		Manager::Get()->GetDriver(m_homeId)->QueueNotification(notification);
 		// Update routes on remote node if necessary
 		bool update = false;
-		Options::Get()->GetOptionAsBool("PerformReturnRoutes", &update);
+		Options::Get()->GetOptionAsBool(Options::OptionKey_PerformReturnRoutes, &update);
 		if (update)
 		{
 			Driver *drv = Manager::Get()->GetDriver(m_homeId);
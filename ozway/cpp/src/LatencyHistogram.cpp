@@ -0,0 +1,158 @@
+//-----------------------------------------------------------------------------
+//
+//	LatencyHistogram.cpp
+//
+//	Fixed size log-linear histogram of latencies
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#include <string.h>
+
+#include "LatencyHistogram.h"
+
+namespace OpenZWave
+{
+
+//-----------------------------------------------------------------------------
+// <LatencyHistogram::LatencyHistogram>
+// Constructor
+//-----------------------------------------------------------------------------
+	LatencyHistogram::LatencyHistogram()
+	{
+		Clear();
+	}
+
+//-----------------------------------------------------------------------------
+// <LatencyHistogram::Clear>
+// Forget everything recorded so far
+//-----------------------------------------------------------------------------
+	void LatencyHistogram::Clear()
+	{
+		memset(m_buckets, 0, sizeof(m_buckets));
+	}
+
+//-----------------------------------------------------------------------------
+// <LatencyHistogram::GetBucket>
+// The bucket a latency is counted in.  Buckets 0-3 hold 0-3 ms.  After that,
+// each group of four buckets covers one power of two.
+//-----------------------------------------------------------------------------
+	uint32 LatencyHistogram::GetBucket(uint32 const _ms)
+	{
+		if (_ms >= 65536)
+		{
+			// Past the last power of two we split, and shifting by 32 below would never reach 0
+			return c_bucketCount - 1;
+		}
+		if (_ms < 4)
+		{
+			return _ms;
+		}
+		uint32 exponent = 2;
+		while ((_ms >> (exponent + 1)) != 0)
+		{
+			++exponent;
+		}
+		return 4 + (exponent - 2) * 4 + ((_ms >> (exponent - 2)) & 3);
+	}
+
+//-----------------------------------------------------------------------------
+// <LatencyHistogram::GetBucketLow>
+// Smallest latency counted in a bucket
+//-----------------------------------------------------------------------------
+	uint32 LatencyHistogram::GetBucketLow(uint32 const _idx)
+	{
+		if (_idx < 4)
+		{
+			return _idx;
+		}
+		if (_idx >= c_bucketCount - 1)
+		{
+			return 65536;
+		}
+		return (4 + ((_idx - 4) & 3)) << ((_idx - 4) / 4);
+	}
+
+//-----------------------------------------------------------------------------
+// <LatencyHistogram::GetBucketHigh>
+// Largest latency counted in a bucket
+//-----------------------------------------------------------------------------
+	uint32 LatencyHistogram::GetBucketHigh(uint32 const _idx)
+	{
+		if (_idx >= c_bucketCount - 1)
+		{
+			return 0xffffffff;
+		}
+		return GetBucketLow(_idx + 1) - 1;
+	}
+
+//-----------------------------------------------------------------------------
+// <LatencyHistogram::Record>
+// Count one latency
+//-----------------------------------------------------------------------------
+	void LatencyHistogram::Record(uint32 const _ms)
+	{
+		m_buckets[GetBucket(_ms)]++;
+	}
+
+//-----------------------------------------------------------------------------
+// <LatencyHistogram::GetCount>
+// Number of latencies recorded
+//-----------------------------------------------------------------------------
+	uint32 LatencyHistogram::GetCount() const
+	{
+		uint32 count = 0;
+		for (uint32 i = 0; i < c_bucketCount; ++i)
+		{
+			count += m_buckets[i];
+		}
+		return count;
+	}
+
+//-----------------------------------------------------------------------------
+// <LatencyHistogram::GetPercentile>
+// Estimate a percentile from the buckets
+//-----------------------------------------------------------------------------
+	uint32 LatencyHistogram::GetPercentile(uint32 const _percentile) const
+	{
+		uint64 count = GetCount();
+		if (count == 0)
+		{
+			return 0;
+		}
+		// the rank of the sample at the percentile, rounded up
+		uint64 rank = (count * (_percentile > 100 ? 100 : _percentile) + 99) / 100;
+		if (rank == 0)
+		{
+			rank = 1;
+		}
+		uint64 seen = 0;
+		for (uint32 i = 0; i < c_bucketCount - 1; ++i)
+		{
+			seen += m_buckets[i];
+			if (seen >= rank)
+			{
+				return GetBucketHigh(i);
+			}
+		}
+		return GetBucketLow(c_bucketCount - 1);
+	}
+} // namespace OpenZWave
@@ -0,0 +1,86 @@
+//-----------------------------------------------------------------------------
+//
+//	LatencyHistogram.h
+//
+//	Fixed size log-linear histogram of latencies
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef _LatencyHistogram_H
+#define _LatencyHistogram_H
+
+#include "Defs.h"
+
+namespace OpenZWave
+{
+	/** \brief Histogram of latencies in ms, in a fixed amount of memory.
+	 *
+	 * Times under 4 ms each have their own bucket.  Above that, every power of two is split
+	 * into four equal buckets, so a bucket is never wider than a quarter of the values in it,
+	 * up to 65535 ms.  Anything longer is counted in a single overflow bucket.  That is
+	 * precise enough to tell a device that is usually fast but sometimes takes seconds from
+	 * one that is always slow, which an average cannot do.
+	 */
+	class OPENZWAVE_EXPORT LatencyHistogram
+	{
+		public:
+			enum
+			{
+				c_bucketCount = 61
+			};
+
+			LatencyHistogram();
+
+			/** Count one latency */
+			void Record(uint32 const _ms);
+			/** Forget everything recorded so far */
+			void Clear();
+
+			/** Number of latencies recorded */
+			uint32 GetCount() const;
+			/** Number of latencies recorded in bucket _idx */
+			uint32 GetBucketCount(uint32 const _idx) const
+			{
+				return (_idx < c_bucketCount) ? m_buckets[_idx] : 0;
+			}
+			/** Smallest latency that is counted in bucket _idx */
+			static uint32 GetBucketLow(uint32 const _idx);
+			/** Largest latency that is counted in bucket _idx.  0xffffffff for the overflow bucket. */
+			static uint32 GetBucketHigh(uint32 const _idx);
+
+			/**
+			 * Estimate a percentile.
+			 * \param _percentile between 0 and 100, eg 99 for the p99
+			 * \return the largest latency in the bucket that holds the percentile, so the true
+			 * value is no larger.  65536 if it is in the overflow bucket, and 0 if nothing has
+			 * been recorded.
+			 */
+			uint32 GetPercentile(uint32 const _percentile) const;
+
+		private:
+			static uint32 GetBucket(uint32 const _ms);
+
+			uint32 m_buckets[c_bucketCount];
+	};
+} // namespace OpenZWave
+
+#endif
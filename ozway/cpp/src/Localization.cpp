@@ -24,10 +24,12 @@
 //	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
 //
 //-----------------------------------------------------------------------------
+#include <algorithm>
 #include <bitset>
 #include <string.h>
 
 #include "Localization.h"
+#include "ConfigBundle.h"
 #include "tinyxml.h"
 #include "Options.h"
 #include "platform/Log.h"
@@ -48,6 +50,22 @@ namespace OpenZWave
 		std::map<std::string, std::shared_ptr<LabelLocalizationEntry> > Localization::m_globalLabelLocalizationMap;
 		std::string Localization::m_selectedLang = "";
 		uint32 Localization::m_revision = 0;
+		bool Localization::m_flatten = true;
+		std::unordered_map<uint64, LocalizedValue> Localization::m_flatValueMap;
+		std::unordered_map<std::string, std::string> Localization::m_flatGlobalLabelMap;
+
+		static bool CompareItemIndex(pair<int32, string> const& item, int32 itemIndex)
+		{
+			return item.first < itemIndex;
+		}
+
+		static string const* FindItem(vector<pair<int32, string> > const& items, int32 itemIndex)
+		{
+			vector<pair<int32, string> >::const_iterator it = std::lower_bound(items.begin(), items.end(), itemIndex, CompareItemIndex);
+			if (it == items.end() || it->first != itemIndex)
+				return NULL;
+			return &it->second;
+		}
 
 		LabelLocalizationEntry::LabelLocalizationEntry(uint16 _index, uint32 _pos) :
 				m_index(_index), m_pos(_pos)
@@ -234,6 +252,29 @@ namespace OpenZWave
 			return false;
 		}
 
+		void ValueLocalizationEntry::Flatten(string const& lang, LocalizedValue* o_value)
+		{
+			o_value->m_label = GetLabel(lang);
+			o_value->m_help = GetHelp(lang);
+
+			/* the selected language overrides the default text for each item */
+			map<int32, string> items = m_DefaultItemLabelText;
+			if (m_ItemLabelText.find(lang) != m_ItemLabelText.end())
+			{
+				for (map<int32, string>::iterator it = m_ItemLabelText[lang].begin(); it != m_ItemLabelText[lang].end(); ++it)
+					items[it->first] = it->second;
+			}
+			o_value->m_itemLabels.assign(items.begin(), items.end());
+
+			items = m_DefaultItemHelpText;
+			if (m_ItemHelpText.find(lang) != m_ItemHelpText.end())
+			{
+				for (map<int32, string>::iterator it = m_ItemHelpText[lang].begin(); it != m_ItemHelpText[lang].end(); ++it)
+					items[it->first] = it->second;
+			}
+			o_value->m_itemHelp.assign(items.begin(), items.end());
+		}
+
 		Localization::Localization()
 		{
 		}
@@ -241,21 +282,17 @@ namespace OpenZWave
 		void Localization::ReadXML()
 		{
 			// Parse the Z-Wave manufacturer and product XML file.
-			string configPath;
-			Options::Get()->GetOptionAsString("ConfigPath", &configPath);
-
-			string path = configPath + "Localization.xml";
-			TiXmlDocument* pDoc = new TiXmlDocument();
-			if (!pDoc->LoadFile(path.c_str(), TIXML_ENCODING_UTF8))
+			string path;
+			TiXmlStreamReader reader;
+			if (!ConfigBundle::LoadStream("Localization.xml", &reader, &path))
 			{
-				Log::Write(LogLevel_Warning, "Unable to load Localization file %s: %s", path.c_str(), pDoc->ErrorDesc());
-				delete pDoc;
+				Log::Write(LogLevel_Warning, "Unable to load Localization file %s: %s", path.c_str(), reader.ErrorDesc());
 				return;
 			}
-			pDoc->SetUserData((void*) path.c_str());
+			reader.Document()->SetUserData((void*) path.c_str());
 			Log::Write(LogLevel_Info, "Loading Localization File %s", path.c_str());
 
-			TiXmlElement const* root = pDoc->RootElement();
+			TiXmlElement const* root = reader.RootElement();
 			char const *str = root->Value();
 			if (str && !strcmp(str, "Localization"))
 			{
@@ -264,14 +301,12 @@ namespace OpenZWave
 				if (!str)
 				{
 					Log::Write(LogLevel_Info, "Error in Product Config file at line %d - missing Revision  attribute", root->Row());
-					delete pDoc;
 					return;
 				}
 				m_revision = atol(str);
 			}
 
-			TiXmlElement const* CCElement = root->FirstChildElement();
-			while (CCElement)
+			while (TiXmlElement const* CCElement = reader.NextElement())
 			{
 				char const* str = CCElement->Value();
 				char* pStopChar;
@@ -281,7 +316,6 @@ namespace OpenZWave
 					if (!str)
 					{
 						Log::Write(LogLevel_Warning, "Localization::ReadXML: Error in %s at line %d - missing commandclass ID attribute", CCElement->GetDocument()->GetUserData(), CCElement->Row());
-						CCElement = CCElement->NextSiblingElement();
 						continue;
 					}
 					uint8 ccID = (uint8) strtol(str, &pStopChar, 10);
@@ -314,11 +348,12 @@ namespace OpenZWave
 						nextElement = nextElement->NextSiblingElement();
 					}
 				}
-
-				CCElement = CCElement->NextSiblingElement();
 			}
-			Log::Write(LogLevel_Info, "Loaded %s With Revision %d", pDoc->GetUserData(), m_revision);
-			delete pDoc;
+			if (reader.Error())
+			{
+				Log::Write(LogLevel_Warning, "Localization::ReadXML: Error in %s at line %d: %s", path.c_str(), reader.ErrorRow(), reader.ErrorDesc());
+			}
+			Log::Write(LogLevel_Info, "Loaded %s With Revision %d", path.c_str(), m_revision);
 		}
 
 		void Localization::ReadGlobalXMLLabel(const TiXmlElement *labelElement)
@@ -333,6 +368,8 @@ namespace OpenZWave
 			}
 			if (labelElement->Attribute("lang"))
 				Language = labelElement->Attribute("lang");
+			if (IsUnusedLang(Language))
+				return;
 			if (m_globalLabelLocalizationMap.find(str) == m_globalLabelLocalizationMap.end())
 			{
 				m_globalLabelLocalizationMap[str] = std::shared_ptr<LabelLocalizationEntry>(new LabelLocalizationEntry(0));
@@ -360,6 +397,8 @@ namespace OpenZWave
 			string Language;
 			if (labelElement->Attribute("lang"))
 				Language = labelElement->Attribute("lang");
+			if (IsUnusedLang(Language))
+				return;
 
 			if (m_commandClassLocalizationMap.find(ccID) == m_commandClassLocalizationMap.end())
 			{
@@ -427,6 +466,8 @@ namespace OpenZWave
 			string Language;
 			if (labelElement->Attribute("lang"))
 				Language = labelElement->Attribute("lang");
+			if (IsUnusedLang(Language))
+				return;
 			if (!labelElement->GetText())
 			{
 				Log::Write(LogLevel_Warning, "Localization::ReadXMLVIDLabel: Error in %s at line %d - No Label Entry for CommandClass %d, ValueID: %d (%d):  %s (Lang: %s)", labelElement->GetDocument()->GetUserData(), labelElement->Row(), ccID, indexId, pos, labelElement->GetText(), Language.c_str());
@@ -451,6 +492,7 @@ namespace OpenZWave
 			{
 				m_valueLocalizationMap[key]->AddLabel(labelElement->GetText(), Language);
 			}
+			FlattenValue(key);
 		}
 
 		void Localization::ReadXMLVIDHelp(uint8 node, uint8 ccID, uint16 indexId, uint32 pos, const TiXmlElement *labelElement)
@@ -459,6 +501,8 @@ namespace OpenZWave
 			string Language;
 			if (labelElement->Attribute("lang"))
 				Language = labelElement->Attribute("lang");
+			if (IsUnusedLang(Language))
+				return;
 			if (!labelElement->GetText())
 			{
 				if (ccID != 112)
@@ -488,6 +532,7 @@ namespace OpenZWave
 			{
 				m_valueLocalizationMap[key]->AddHelp(labelElement->GetText(), Language);
 			}
+			FlattenValue(key);
 		}
 
 		void Localization::ReadXMLVIDItemLabel(uint8 node, uint8 ccID, uint16 indexId, uint32 pos, const TiXmlElement *labelElement)
@@ -498,6 +543,8 @@ namespace OpenZWave
 			int32 itemIndex;
 			if (labelElement->Attribute("lang"))
 				Language = labelElement->Attribute("lang");
+			if (IsUnusedLang(Language))
+				return;
 			if (!labelElement->GetText())
 			{
 				Log::Write(LogLevel_Warning, "Localization::ReadXMLVIDItemLabel: Error in %s at line %d - No ItemIndex Label Entry for CommandClass %d, ValueID: %d (%d):  %s (Lang: %s)", labelElement->GetDocument()->GetUserData(), labelElement->Row(), ccID, indexId, pos, labelElement->GetText(), Language.c_str());
@@ -529,6 +576,7 @@ namespace OpenZWave
 			{
 				m_valueLocalizationMap[key]->AddItemLabel(labelElement->GetText(), itemIndex, Language);
 			}
+			FlattenValue(key);
 		}
 
 		uint64 Localization::GetValueKey(uint8 _node, uint8 _commandClass, uint16 _index, uint32 _pos, bool unique)
@@ -554,6 +602,32 @@ namespace OpenZWave
 			return ((uint64) _commandClass << 48) | ((uint64) _index << 32) | ((uint64) _pos);
 		}
 
+		bool Localization::IsUnusedLang(string const& lang)
+		{
+			return m_flatten && !lang.empty() && (lang != m_selectedLang);
+		}
+
+		void Localization::FlattenValue(uint64 key)
+		{
+			/* while Localization.xml is being read, the flat tables are built in one pass at the end */
+			if (!m_flatten || !m_instance)
+				return;
+			map<uint64, std::shared_ptr<ValueLocalizationEntry> >::iterator it = m_valueLocalizationMap.find(key);
+			if (it == m_valueLocalizationMap.end())
+			{
+				m_flatValueMap.erase(key);
+				return;
+			}
+			it->second->Flatten(m_selectedLang, &m_flatValueMap[key]);
+		}
+
+		void Localization::FlattenGlobalLabel(string const& index)
+		{
+			if (!m_flatten || !m_instance)
+				return;
+			m_flatGlobalLabelMap[index] = m_globalLabelLocalizationMap[index]->GetLabel(m_selectedLang);
+		}
+
 		void Localization::SetupCommandClass(Internal::CC::CommandClass *cc)
 		{
 			uint8 ccID = cc->GetCommandClassId();
@@ -570,6 +644,8 @@ namespace OpenZWave
 
 		bool Localization::SetValueHelp(uint8 _node, uint8 ccID, uint16 indexId, uint32 pos, string help, string lang)
 		{
+			if (IsUnusedLang(lang))
+				return true;
 			uint64 key = GetValueKey(_node, ccID, indexId, pos);
 			if (m_valueLocalizationMap.find(key) == m_valueLocalizationMap.end())
 			{
@@ -588,10 +664,13 @@ namespace OpenZWave
 			{
 				m_valueLocalizationMap[key]->AddHelp(help, lang);
 			}
+			FlattenValue(key);
 			return true;
 		}
 		bool Localization::SetValueLabel(uint8 node, uint8 ccID, uint16 indexId, uint32 pos, string label, string lang)
 		{
+			if (IsUnusedLang(lang))
+				return true;
 			uint64 key = GetValueKey(node, ccID, indexId, pos);
 			if (m_valueLocalizationMap.find(key) == m_valueLocalizationMap.end())
 			{
@@ -610,12 +689,23 @@ namespace OpenZWave
 			{
 				m_valueLocalizationMap[key]->AddLabel(label, lang);
 			}
+			FlattenValue(key);
 			return true;
 		}
 
 		std::string const Localization::GetValueHelp(uint8 node, uint8 ccID, uint16 indexId, uint32 pos)
 		{
 			uint64 key = GetValueKey(node, ccID, indexId, pos);
+			if (m_flatten)
+			{
+				unordered_map<uint64, LocalizedValue>::const_iterator it = m_flatValueMap.find(key);
+				if (it == m_flatValueMap.end())
+				{
+					Log::Write(LogLevel_Warning, "Localization::GetValueHelp: No Help for CommandClass %xd, ValueID: %d (%d)", ccID, indexId, pos);
+					return "";
+				}
+				return it->second.m_help;
+			}
 			if (m_valueLocalizationMap.find(key) == m_valueLocalizationMap.end())
 			{
 				Log::Write(LogLevel_Warning, "Localization::GetValueHelp: No Help for CommandClass %xd, ValueID: %d (%d)", ccID, indexId, pos);
@@ -627,6 +717,16 @@ namespace OpenZWave
 		std::string const Localization::GetValueLabel(uint8 node, uint8 ccID, uint16 indexId, int32 pos) const
 		{
 			uint64 key = GetValueKey(node, ccID, indexId, pos);
+			if (m_flatten)
+			{
+				unordered_map<uint64, LocalizedValue>::const_iterator it = m_flatValueMap.find(key);
+				if (it == m_flatValueMap.end())
+				{
+					Log::Write(LogLevel_Warning, "Localization::GetValueLabel: No Label for CommandClass %xd, ValueID: %d (%d)", ccID, indexId, pos);
+					return "";
+				}
+				return it->second.m_label;
+			}
 			if (m_valueLocalizationMap.find(key) == m_valueLocalizationMap.end())
 			{
 				Log::Write(LogLevel_Warning, "Localization::GetValueLabel: No Label for CommandClass %xd, ValueID: %d (%d)", ccID, indexId, pos);
@@ -643,6 +743,22 @@ namespace OpenZWave
 				unique = true;
 			}
 			uint64 key = GetValueKey(node, ccID, indexId, pos, unique);
+			if (m_flatten)
+			{
+				unordered_map<uint64, LocalizedValue>::const_iterator it = m_flatValueMap.find(key);
+				if (it == m_flatValueMap.end())
+				{
+					Log::Write(LogLevel_Warning, "Localization::GetValueItemLabel: No ValueLocalizationMap for CommandClass %xd, ValueID: %d (%d) ItemIndex %d", ccID, indexId, pos, itemIndex);
+					return "";
+				}
+				string const* label = FindItem(it->second.m_itemLabels, itemIndex);
+				if (!label)
+				{
+					Log::Write(LogLevel_Warning, "ValueLocalizationEntry::GetItemLabel: Unable to find Default Item Label Text for Index Item %d (%s)", itemIndex, it->second.m_label.c_str());
+					return "undefined";
+				}
+				return *label;
+			}
 			if (m_valueLocalizationMap.find(key) == m_valueLocalizationMap.end())
 			{
 				Log::Write(LogLevel_Warning, "Localization::GetValueItemLabel: No ValueLocalizationMap for CommandClass %xd, ValueID: %d (%d) ItemIndex %d", ccID, indexId, pos, itemIndex);
@@ -653,6 +769,8 @@ namespace OpenZWave
 
 		bool Localization::SetValueItemLabel(uint8 node, uint8 ccID, uint16 indexId, int32 pos, int32 itemIndex, string label, string lang)
 		{
+			if (IsUnusedLang(lang))
+				return true;
 			bool unique = false;
 			if ((ccID == Internal::CC::SoundSwitch::StaticGetCommandClassId()) && (indexId == 1 || indexId == 3))
 			{
@@ -669,6 +787,7 @@ namespace OpenZWave
 				Log::Write(LogLevel_Warning, "Localization::SetValueItemLabel: Duplicate Item Entry for CommandClass %d, ValueID: %d (%d) itemIndex %d:  %s (Lang: %s)", ccID, indexId, pos, itemIndex, label.c_str(), lang.c_str());
 			}
 			m_valueLocalizationMap[key]->AddItemLabel(label, itemIndex, lang);
+			FlattenValue(key);
 			return true;
 		}
 
@@ -681,6 +800,22 @@ namespace OpenZWave
 			}
 
 			uint64 key = GetValueKey(node, ccID, indexId, pos, unique);
+			if (m_flatten)
+			{
+				unordered_map<uint64, LocalizedValue>::const_iterator it = m_flatValueMap.find(key);
+				if (it == m_flatValueMap.end())
+				{
+					Log::Write(LogLevel_Warning, "Localization::GetValueItemHelp: No ValueLocalizationMap for CommandClass %xd, ValueID: %d (%d) ItemIndex %d", ccID, indexId, pos, itemIndex);
+					return "";
+				}
+				string const* help = FindItem(it->second.m_itemHelp, itemIndex);
+				if (!help)
+				{
+					Log::Write(LogLevel_Warning, "No ItemHelp Entry for Language %s (Index %d)", m_selectedLang.c_str(), itemIndex);
+					return "Undefined";
+				}
+				return *help;
+			}
 			if (m_valueLocalizationMap.find(key) == m_valueLocalizationMap.end())
 			{
 				Log::Write(LogLevel_Warning, "Localization::GetValueItemHelp: No ValueLocalizationMap for CommandClass %xd, ValueID: %d (%d) ItemIndex %d", ccID, indexId, pos, itemIndex);
@@ -691,6 +826,8 @@ namespace OpenZWave
 
 		bool Localization::SetValueItemHelp(uint8 node, uint8 ccID, uint16 indexId, int32 pos, int32 itemIndex, string label, string lang)
 		{
+			if (IsUnusedLang(lang))
+				return true;
 			bool unique = false;
 			if ((ccID == Internal::CC::SoundSwitch::StaticGetCommandClassId()) && (indexId == 1 || indexId == 3))
 			{
@@ -707,11 +844,22 @@ namespace OpenZWave
 				Log::Write(LogLevel_Warning, "Localization::SetValueItemHelp: Duplicate Item Entry for CommandClass %d, ValueID: %d (%d) ItemIndex %d:  %s (Lang: %s)", ccID, indexId, pos, itemIndex, label.c_str(), lang.c_str());
 			}
 			m_valueLocalizationMap[key]->AddItemHelp(label, itemIndex, lang);
+			FlattenValue(key);
 			return true;
 		}
 
 		std::string const Localization::GetGlobalLabel(string index)
 		{
+			if (m_flatten)
+			{
+				unordered_map<string, string>::const_iterator it = m_flatGlobalLabelMap.find(index);
+				if (it == m_flatGlobalLabelMap.end())
+				{
+					Log::Write(LogLevel_Warning, "Localization::GetGlobalLabel: No globalLabelLocalizationMap for Index %s", index.c_str());
+					return index;
+				}
+				return it->second;
+			}
 			if (m_globalLabelLocalizationMap.find(index) == m_globalLabelLocalizationMap.end())
 			{
 				Log::Write(LogLevel_Warning, "Localization::GetGlobalLabel: No globalLabelLocalizationMap for Index %s", index.c_str());
@@ -722,6 +870,8 @@ namespace OpenZWave
 		}
 		bool Localization::SetGlobalLabel(string index, string text, string lang)
 		{
+			if (IsUnusedLang(lang))
+				return true;
 			if (m_globalLabelLocalizationMap.find(index) == m_globalLabelLocalizationMap.end())
 			{
 				m_globalLabelLocalizationMap[index] = std::shared_ptr<LabelLocalizationEntry>(new LabelLocalizationEntry(0));
@@ -741,6 +891,7 @@ namespace OpenZWave
 				m_globalLabelLocalizationMap[index]->AddLabel(text, lang);
 
 			}
+			FlattenGlobalLabel(index);
 			return true;
 		}
 
@@ -766,9 +917,19 @@ namespace OpenZWave
 			{
 				return m_instance;
 			}
-			m_instance = new Localization();
+			/* the language has to be known before reading, so the other languages can be skipped */
+			Options::Get()->GetOptionAsString(Options::OptionKey_Language, &m_selectedLang);
+			Options::Get()->GetOptionAsBool(Options::OptionKey_FlattenLocalization, &m_flatten);
 			ReadXML();
-			Options::Get()->GetOptionAsString("Language", &m_selectedLang);
+			m_instance = new Localization();
+			if (m_flatten)
+			{
+				for (map<uint64, std::shared_ptr<ValueLocalizationEntry> >::iterator it = m_valueLocalizationMap.begin(); it != m_valueLocalizationMap.end(); ++it)
+					FlattenValue(it->first);
+				for (map<string, std::shared_ptr<LabelLocalizationEntry> >::iterator it = m_globalLabelLocalizationMap.begin(); it != m_globalLabelLocalizationMap.end(); ++it)
+					FlattenGlobalLabel(it->first);
+				Log::Write(LogLevel_Info, "Flattened %d Value and %d Global Localization entries for Language \"%s\"", (int) m_flatValueMap.size(), (int) m_flatGlobalLabelMap.size(), m_selectedLang.c_str());
+			}
 			return m_instance;
 		}
 	} // namespace Internal
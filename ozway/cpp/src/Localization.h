@@ -31,6 +31,8 @@
 #include <cstdio>
 #include <string>
 #include <map>
+#include <unordered_map>
+#include <vector>
 #include "Defs.h"
 #include "Driver.h"
 #include "command_classes/CommandClass.h"
@@ -59,6 +61,18 @@ namespace OpenZWave
 				string m_defaultLabel;
 		};
 
+		/** \brief The Label, Help and Item texts of a Value, resolved for the selected language.
+		 *
+		 * Item texts are kept sorted by item index so they can be found with a binary search.
+		 */
+		struct LocalizedValue
+		{
+				string m_label;
+				string m_help;
+				vector<pair<int32, string> > m_itemLabels;
+				vector<pair<int32, string> > m_itemHelp;
+		};
+
 		class ValueLocalizationEntry: public Internal::Platform::Ref
 		{
 			public:
@@ -80,6 +94,7 @@ namespace OpenZWave
 				void AddItemHelp(string label, int32 itemIndex, string lang = "");
 				string GetItemHelp(string lang, int32 itemIndex);
 				bool HasItemHelp(int32 itemIndex, string lang);
+				void Flatten(string const& lang, LocalizedValue* o_value);
 
 			private:
 				uint8 m_commandClass;
@@ -110,6 +125,9 @@ namespace OpenZWave
 				static void ReadXMLVIDItemLabel(uint8 node, uint8 ccID, uint16 indexId, uint32 pos, const TiXmlElement *labelElement);
 				static void ReadGlobalXMLLabel(const TiXmlElement *labelElement);
 				static uint64 GetValueKey(uint8 _node, uint8 _commandClass, uint16 _index, uint32 _pos, bool unique = false);
+				static bool IsUnusedLang(string const& lang);
+				static void FlattenValue(uint64 key);
+				static void FlattenGlobalLabel(string const& index);
 			public:
 				static Localization* Get();
 				void SetupCommandClass(Internal::CC::CommandClass *cc);
@@ -142,6 +160,12 @@ namespace OpenZWave
 				static string m_selectedLang;
 				static uint32 m_revision;
 
+				// When FlattenLocalization is enabled, only the default and selected languages are kept, and
+				// the Get methods read from these tables, resolved once per entry, instead of the maps above
+				static bool m_flatten;
+				static unordered_map<uint64, LocalizedValue> m_flatValueMap;
+				static unordered_map<string, string> m_flatGlobalLabelMap;
+
 		};
 	} // namespace Internal
 } // namespace OpenZWave
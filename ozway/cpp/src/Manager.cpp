@@ -32,9 +32,11 @@
 
 #include "Defs.h"
 #include "CompatOptionManager.h"
+#include "ConfigBundle.h"
 #include "Manager.h"
 #include "Driver.h"
 #include "Localization.h"
+#include "Metrics.h"
 #include "Node.h"
 #include "Notification.h"
 #include "NotificationCCTypes.h"
@@ -46,6 +48,7 @@
 #include "platform/Mutex.h"
 #include "platform/Event.h"
 #include "platform/Log.h"
+#include "platform/TimeStamp.h"
 
 #include "command_classes/CommandClasses.h"
 #include "command_classes/CommandClass.h"
@@ -279,30 +282,30 @@ ozwversion Manager::getVersion()
 // Constructor
 //-----------------------------------------------------------------------------
 Manager::Manager() :
-		m_notificationMutex(new Internal::Platform::Mutex())
+		m_notificationMutex(new Internal::Platform::Mutex("watchers"))
 {
 	// Ensure the singleton instance is set
 	s_instance = this;
 
 	// Create the log file (if enabled)
 	bool logging = false;
-	Options::Get()->GetOptionAsBool("Logging", &logging);
+	Options::Get()->GetOptionAsBool(Options::OptionKey_Logging, &logging);
 
 	string userPath = "";
-	Options::Get()->GetOptionAsString("UserPath", &userPath);
+	Options::Get()->GetOptionAsString(Options::OptionKey_UserPath, &userPath);
 
 	string logFileNameBase = "OZW_Log.txt";
-	Options::Get()->GetOptionAsString("LogFileName", &logFileNameBase);
+	Options::Get()->GetOptionAsString(Options::OptionKey_LogFileName, &logFileNameBase);
 
 	bool bAppend = false;
-	Options::Get()->GetOptionAsBool("AppendLogFile", &bAppend);
+	Options::Get()->GetOptionAsBool(Options::OptionKey_AppendLogFile, &bAppend);
 
 	bool bConsoleOutput = true;
-	Options::Get()->GetOptionAsBool("ConsoleOutput", &bConsoleOutput);
+	Options::Get()->GetOptionAsBool(Options::OptionKey_ConsoleOutput, &bConsoleOutput);
 
 	int nSaveLogLevel = (int) LogLevel_Detail;
 
-	Options::Get()->GetOptionAsInt("SaveLogLevel", &nSaveLogLevel);
+	Options::Get()->GetOptionAsInt(Options::OptionKey_SaveLogLevel, &nSaveLogLevel);
 	if ((nSaveLogLevel == 0) || (nSaveLogLevel > LogLevel_StreamDetail))
 	{
 		Log::Write(LogLevel_Warning, "Invalid LogLevel Specified for SaveLogLevel in Options.xml");
@@ -310,7 +313,7 @@ Manager::Manager() :
 	}
 
 	int nQueueLogLevel = (int) LogLevel_Debug;
-	Options::Get()->GetOptionAsInt("QueueLogLevel", &nQueueLogLevel);
+	Options::Get()->GetOptionAsInt(Options::OptionKey_QueueLogLevel, &nQueueLogLevel);
 	if ((nQueueLogLevel == 0) || (nQueueLogLevel > LogLevel_StreamDetail))
 	{
 		Log::Write(LogLevel_Warning, "Invalid LogLevel Specified for QueueLogLevel in Options.xml");
@@ -318,12 +321,24 @@ Manager::Manager() :
 	}
 
 	int nDumpTrigger = (int) LogLevel_Warning;
-	Options::Get()->GetOptionAsInt("DumpTriggerLevel", &nDumpTrigger);
+	Options::Get()->GetOptionAsInt(Options::OptionKey_DumpTriggerLevel, &nDumpTrigger);
 
 	string logFilename = userPath + logFileNameBase;
 	Log::Create(logFilename, bAppend, bConsoleOutput, (LogLevel) nSaveLogLevel, (LogLevel) nQueueLogLevel, (LogLevel) nDumpTrigger);
 	Log::SetLoggingState(logging);
 
+	bool lockProfiling = false;
+	Options::Get()->GetOptionAsBool(Options::OptionKey_LockProfiling, &lockProfiling);
+	Internal::Platform::Mutex::EnableProfiling(lockProfiling);
+
+	string threadAffinity;
+	string threadScheduling;
+	Options::Get()->GetOptionAsString(Options::OptionKey_ThreadAffinity, &threadAffinity);
+	Options::Get()->GetOptionAsString(Options::OptionKey_ThreadScheduling, &threadScheduling);
+	Internal::Platform::Thread::SetPlacement(threadAffinity, threadScheduling);
+
+	Internal::ConfigBundle::Create();
+	Internal::Metrics::Create();
 	Internal::CC::CommandClasses::RegisterCommandClasses();
 	Internal::Scene::ReadScenes();
 	// petergebruers replace getVersionAsString() with getVersionLongAsString() because
@@ -410,6 +425,8 @@ Manager::~Manager()
 	}
 	Node::s_nodeTypes.clear();
 
+	Internal::Metrics::Destroy();
+	Internal::ConfigBundle::Destroy();
 	Log::Destroy();
 }
 
@@ -818,6 +835,34 @@ bool Manager::EnablePoll(ValueID const &_valueId, uint8 const _intensity)
 	return false;
 }
 
+//-----------------------------------------------------------------------------
+// <Manager::EnablePoll>
+// Enable polling of a set of values
+//-----------------------------------------------------------------------------
+uint32 Manager::EnablePoll(vector<ValueID> const &_valueIds, uint8 const _intensity)
+{
+	// hand each driver its own values in one call
+	map<uint32, vector<ValueID> > byHome;
+	for (vector<ValueID>::const_iterator it = _valueIds.begin(); it != _valueIds.end(); ++it)
+	{
+		byHome[it->GetHomeId()].push_back(*it);
+	}
+
+	uint32 count = 0;
+	for (map<uint32, vector<ValueID> >::iterator it = byHome.begin(); it != byHome.end(); ++it)
+	{
+		if (Driver* driver = GetDriver(it->first))
+		{
+			count += driver->EnablePoll(it->second, _intensity);
+		}
+		else
+		{
+			Log::Write(LogLevel_Info, "mgr,     EnablePoll failed - Driver with Home ID 0x%.8x is not available", it->first);
+		}
+	}
+	return count;
+}
+
 //-----------------------------------------------------------------------------
 // <Manager::DisablePoll>
 // Disable polling of a value
@@ -833,6 +878,33 @@ bool Manager::DisablePoll(ValueID const &_valueId)
 	return false;
 }
 
+//-----------------------------------------------------------------------------
+// <Manager::DisablePoll>
+// Disable polling of a set of values
+//-----------------------------------------------------------------------------
+uint32 Manager::DisablePoll(vector<ValueID> const &_valueIds)
+{
+	map<uint32, vector<ValueID> > byHome;
+	for (vector<ValueID>::const_iterator it = _valueIds.begin(); it != _valueIds.end(); ++it)
+	{
+		byHome[it->GetHomeId()].push_back(*it);
+	}
+
+	uint32 count = 0;
+	for (map<uint32, vector<ValueID> >::iterator it = byHome.begin(); it != byHome.end(); ++it)
+	{
+		if (Driver* driver = GetDriver(it->first))
+		{
+			count += driver->DisablePoll(it->second);
+		}
+		else
+		{
+			Log::Write(LogLevel_Info, "mgr,     DisablePoll failed - Driver with Home ID 0x%.8x is not available", it->first);
+		}
+	}
+	return count;
+}
+
 //-----------------------------------------------------------------------------
 // <Manager::isPolled>
 // Check polling status of a value
@@ -862,6 +934,21 @@ void Manager::SetPollIntensity(ValueID const &_valueId, uint8 const _intensity)
 	Log::Write(LogLevel_Error, "mgr,     SetPollIntensity failed - Driver with Home ID 0x%.8x is not available", _valueId.GetHomeId());
 }
 
+//-----------------------------------------------------------------------------
+// <Manager::SetPollPeriod>
+// Poll a value at a fixed period
+//-----------------------------------------------------------------------------
+bool Manager::SetPollPeriod(ValueID const &_valueId, int32 const _milliseconds)
+{
+	if (Driver* driver = GetDriver(_valueId.GetHomeId()))
+	{
+		return driver->SetPollPeriod(_valueId, _milliseconds);
+	}
+
+	Log::Write(LogLevel_Error, "mgr,     SetPollPeriod failed - Driver with Home ID 0x%.8x is not available", _valueId.GetHomeId());
+	return false;
+}
+
 //-----------------------------------------------------------------------------
 // <Manager::GetPollIntensity>
 // Change the intensity with which this value is polled
@@ -871,7 +958,11 @@ uint8 Manager::GetPollIntensity(ValueID const &_valueId)
 	uint8 intensity = 0;
 	if (Driver* driver = GetDriver(_valueId.GetHomeId()))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _valueId.GetNodeId());
+		if (LG.IsRefused())
+		{
+			return intensity;
+		}
 		if (Internal::VC::Value* value = driver->GetValue(_valueId))
 		{
 			intensity = value->GetPollIntensity();
@@ -900,7 +991,11 @@ bool Manager::RefreshNodeInfo(uint32 const _homeId, uint8 const _nodeId)
 	{
 		// Cause the node's data to be obtained from the Z-Wave network
 		// in the same way as if it had just been added.
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return false;
+		}
 		driver->ReloadNode(_nodeId);
 		return true;
 	}
@@ -916,7 +1011,11 @@ bool Manager::RequestNodeState(uint32 const _homeId, uint8 const _nodeId)
 {
 	if (Driver* driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return false;
+		}
 		// Retreive the Node's session and dynamic data
 		Node* node = driver->GetNode(_nodeId);
 		if (node)
@@ -936,7 +1035,11 @@ bool Manager::RequestNodeDynamic(uint32 const _homeId, uint8 const _nodeId)
 {
 	if (Driver* driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return false;
+		}
 		// Retreive the Node's dynamic data
 		Node* node = driver->GetNode(_nodeId);
 		if (node)
@@ -1446,7 +1549,11 @@ bool Manager::IsNodeInfoReceived(uint32 const _homeId, uint8 const _nodeId)
 		Node *node;
 
 		// Need to lock and unlock nodes to check this information
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _nodeId);
+		if (LG.IsRefused())
+		{
+			return result;
+		}
 
 		if ((node = driver->GetNode(_nodeId)) != NULL)
 		{
@@ -1470,7 +1577,11 @@ bool Manager::GetNodeClassInformation(uint32 const _homeId, uint8 const _nodeId,
 		Node *node;
 
 		// Need to lock and unlock nodes to check this information
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _nodeId);
+		if (LG.IsRefused())
+		{
+			return result;
+		}
 
 		if ((node = driver->GetNode(_nodeId)) != NULL)
 		{
@@ -1509,7 +1620,11 @@ bool Manager::IsNodeAwake(uint32 const _homeId, uint8 const _nodeId)
 	if (Driver* driver = GetDriver(_homeId))
 	{
 		// Need to lock and unlock nodes to check this information
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _nodeId);
+		if (LG.IsRefused())
+		{
+			return result;
+		}
 
 		if (Node* node = driver->GetNode(_nodeId))
 		{
@@ -1531,7 +1646,11 @@ bool Manager::IsNodeFailed(uint32 const _homeId, uint8 const _nodeId)
 	bool result = false;
 	if (Driver* driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _nodeId);
+		if (LG.IsRefused())
+		{
+			return result;
+		}
 		if (Node* node = driver->GetNode(_nodeId))
 		{
 			result = !node->IsNodeAlive();
@@ -1549,7 +1668,11 @@ string Manager::GetNodeQueryStage(uint32 const _homeId, uint8 const _nodeId)
 	string result = "Unknown";
 	if (Driver* driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _nodeId);
+		if (LG.IsRefused())
+		{
+			return result;
+		}
 		if (Node* node = driver->GetNode(_nodeId))
 		{
 			result = node->GetQueryStageName(node->GetCurrentQueryStage());
@@ -1591,7 +1714,11 @@ string Manager::GetInstanceLabel(uint32 const _homeId, uint8 const _node, uint8
 	string label;
 	if (Driver* driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _node);
+		if (LG.IsRefused())
+		{
+			return label;
+		}
 		if (Node* node = driver->GetNode(_node))
 		{
 			label = node->GetInstanceLabel(_cc, _instance);
@@ -1619,7 +1746,11 @@ string Manager::GetValueLabel(ValueID const& _id, int32 _pos)
 	string label;
 	if (Driver* driver = GetDriver(_id.GetHomeId()))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+		if (LG.IsRefused())
+		{
+			return label;
+		}
 		if (_pos != -1)
 		{
 			if (_id.GetType() != ValueID::ValueType_BitSet)
@@ -1635,7 +1766,7 @@ string Manager::GetValueLabel(ValueID const& _id, int32 _pos)
 		else
 		{
 			bool useinstancelabels = true;
-			Options::Get()->GetOptionAsBool("IncludeInstanceLabel", &useinstancelabels);
+			Options::Get()->GetOptionAsBool(Options::OptionKey_IncludeInstanceLabel, &useinstancelabels);
 			Node* node = driver->GetNode(_id.GetNodeId());
 			if ((useinstancelabels) && (node))
 			{
@@ -1665,7 +1796,11 @@ void Manager::SetValueLabel(ValueID const& _id, string const& _value, int32 _pos
 {
 	if (Driver* driver = GetDriver(_id.GetHomeId()))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+		if (LG.IsRefused())
+		{
+			return;
+		}
 		if (_pos != -1)
 		{
 			if (_id.GetType() != ValueID::ValueType_BitSet)
@@ -1700,7 +1835,11 @@ string Manager::GetValueUnits(ValueID const& _id)
 	string units;
 	if (Driver* driver = GetDriver(_id.GetHomeId()))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+		if (LG.IsRefused())
+		{
+			return units;
+		}
 		if (Internal::VC::Value* value = driver->GetValue(_id))
 		{
 			units = value->GetUnits();
@@ -1723,7 +1862,11 @@ void Manager::SetValueUnits(ValueID const& _id, string const& _value)
 {
 	if (Driver* driver = GetDriver(_id.GetHomeId()))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+		if (LG.IsRefused())
+		{
+			return;
+		}
 		if (Internal::VC::Value* value = driver->GetValue(_id))
 		{
 			value->SetUnits(_value);
@@ -1745,7 +1888,11 @@ string Manager::GetValueHelp(ValueID const& _id, int32 _pos)
 	string help;
 	if (Driver* driver = GetDriver(_id.GetHomeId()))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+		if (LG.IsRefused())
+		{
+			return help;
+		}
 		if (_pos != -1)
 		{
 			if (_id.GetType() != ValueID::ValueType_BitSet)
@@ -1780,7 +1927,11 @@ void Manager::SetValueHelp(ValueID const& _id, string const& _value, int32 _pos)
 {
 	if (Driver* driver = GetDriver(_id.GetHomeId()))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+		if (LG.IsRefused())
+		{
+			return;
+		}
 		if (_pos != -1)
 		{
 			if (_id.GetType() != ValueID::ValueType_BitSet)
@@ -1815,7 +1966,11 @@ int32 Manager::GetValueMin(ValueID const& _id)
 	int32 limit = 0;
 	if (Driver* driver = GetDriver(_id.GetHomeId()))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+		if (LG.IsRefused())
+		{
+			return limit;
+		}
 		if (Internal::VC::Value* value = driver->GetValue(_id))
 		{
 			limit = value->GetMin();
@@ -1839,7 +1994,11 @@ int32 Manager::GetValueMax(ValueID const& _id)
 	int32 limit = 0;
 	if (Driver* driver = GetDriver(_id.GetHomeId()))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+		if (LG.IsRefused())
+		{
+			return limit;
+		}
 		if (Internal::VC::Value* value = driver->GetValue(_id))
 		{
 			limit = value->GetMax();
@@ -1863,7 +2022,11 @@ bool Manager::IsValueReadOnly(ValueID const& _id)
 	bool res = false;
 	if (Driver* driver = GetDriver(_id.GetHomeId()))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+		if (LG.IsRefused())
+		{
+			return res;
+		}
 		if (Internal::VC::Value* value = driver->GetValue(_id))
 		{
 			res = value->IsReadOnly();
@@ -1887,7 +2050,11 @@ bool Manager::IsValueWriteOnly(ValueID const& _id)
 	bool res = false;
 	if (Driver* driver = GetDriver(_id.GetHomeId()))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+		if (LG.IsRefused())
+		{
+			return res;
+		}
 		if (Internal::VC::Value* value = driver->GetValue(_id))
 		{
 			res = value->IsWriteOnly();
@@ -1911,7 +2078,11 @@ bool Manager::IsValueSet(ValueID const& _id)
 	bool res = false;
 	if (Driver* driver = GetDriver(_id.GetHomeId()))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+		if (LG.IsRefused())
+		{
+			return res;
+		}
 		if (Internal::VC::Value* value = driver->GetValue(_id))
 		{
 			res = value->IsSet();
@@ -1935,7 +2106,11 @@ bool Manager::IsValuePolled(ValueID const& _id)
 	bool res = false;
 	if (Driver* driver = GetDriver(_id.GetHomeId()))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+		if (LG.IsRefused())
+		{
+			return res;
+		}
 		if (Internal::VC::Value* value = driver->GetValue(_id))
 		{
 			res = value->IsPolled();
@@ -1958,7 +2133,11 @@ bool Manager::IsValueValid(ValueID const& _id)
 {
 	if (Driver* driver = GetDriver(_id.GetHomeId()))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+		if (LG.IsRefused())
+		{
+			return false;
+		}
 		if (Internal::VC::Value* value = driver->GetValue(_id))
 		{
 			value->Release();
@@ -1982,7 +2161,11 @@ bool Manager::GetValueAsBitSet(ValueID const& _id, uint8 _pos, bool* o_value)
 		{
 			if (Driver* driver = GetDriver(_id.GetHomeId()))
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return false;
+				}
 				if (Internal::VC::ValueBitSet* value = static_cast<Internal::VC::ValueBitSet*>(driver->GetValue(_id)))
 				{
 					*o_value = value->GetBit(_pos);
@@ -2046,7 +2229,11 @@ bool Manager::GetValueAsByte(ValueID const& _id, uint8* o_value)
 		{
 			if (Driver* driver = GetDriver(_id.GetHomeId()))
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueByte* value = static_cast<Internal::VC::ValueByte*>(driver->GetValue(_id)))
 				{
 					*o_value = value->GetValue();
@@ -2082,7 +2269,11 @@ bool Manager::GetValueAsFloat(ValueID const& _id, float* o_value)
 		{
 			if (Driver* driver = GetDriver(_id.GetHomeId()))
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueDecimal* value = static_cast<Internal::VC::ValueDecimal*>(driver->GetValue(_id)))
 				{
 					string str = value->GetValue();
@@ -2117,7 +2308,11 @@ bool Manager::GetValueAsInt(ValueID const& _id, int32* o_value)
 	{
 		if (Driver* driver = GetDriver(_id.GetHomeId()))
 		{
-			Internal::LockGuard LG(driver->m_nodeMutex);
+			Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+			if (LG.IsRefused())
+			{
+				return res;
+			}
 
 			if (ValueID::ValueType_Int == _id.GetType())
 			{
@@ -2169,7 +2364,11 @@ bool Manager::GetValueAsRaw(ValueID const& _id, uint8** o_value, uint8* o_length
 		{
 			if (Driver* driver = GetDriver(_id.GetHomeId()))
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueRaw* value = static_cast<Internal::VC::ValueRaw*>(driver->GetValue(_id)))
 				{
 					*o_length = value->GetLength();
@@ -2207,7 +2406,11 @@ bool Manager::GetValueAsShort(ValueID const& _id, int16* o_value)
 		{
 			if (Driver* driver = GetDriver(_id.GetHomeId()))
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueShort* value = static_cast<Internal::VC::ValueShort*>(driver->GetValue(_id)))
 				{
 					*o_value = value->GetValue();
@@ -2243,7 +2446,11 @@ bool Manager::GetValueAsString(ValueID const& _id, string* o_value)
 	{
 		if (Driver* driver = GetDriver(_id.GetHomeId()))
 		{
-			Internal::LockGuard LG(driver->m_nodeMutex);
+			Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+			if (LG.IsRefused())
+			{
+				return res;
+			}
 
 			switch (_id.GetType())
 			{
@@ -2436,7 +2643,11 @@ bool Manager::GetValueListSelection(ValueID const& _id, string* o_value)
 		{
 			if (Driver* driver = GetDriver(_id.GetHomeId()))
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueList* value = static_cast<Internal::VC::ValueList*>(driver->GetValue(_id)))
 				{
 					Internal::VC::ValueList::Item const *item = value->GetItem();
@@ -2481,7 +2692,11 @@ bool Manager::GetValueListSelection(ValueID const& _id, int32* o_value)
 		{
 			if (Driver* driver = GetDriver(_id.GetHomeId()))
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueList* value = static_cast<Internal::VC::ValueList*>(driver->GetValue(_id)))
 				{
 					Internal::VC::ValueList::Item const *item = value->GetItem();
@@ -2526,7 +2741,11 @@ bool Manager::GetValueListItems(ValueID const& _id, vector<string>* o_value)
 		{
 			if (Driver* driver = GetDriver(_id.GetHomeId()))
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueList* value = static_cast<Internal::VC::ValueList*>(driver->GetValue(_id)))
 				{
 					o_value->clear();
@@ -2562,7 +2781,11 @@ bool Manager::GetValueListValues(ValueID const& _id, vector<int32>* o_value)
 		{
 			if (Driver* driver = GetDriver(_id.GetHomeId()))
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueList* value = static_cast<Internal::VC::ValueList*>(driver->GetValue(_id)))
 				{
 					o_value->clear();
@@ -2598,7 +2821,11 @@ bool Manager::GetValueFloatPrecision(ValueID const& _id, uint8* o_value)
 		{
 			if (Driver* driver = GetDriver(_id.GetHomeId()))
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueDecimal* value = static_cast<Internal::VC::ValueDecimal*>(driver->GetValue(_id)))
 				{
 					*o_value = value->GetPrecision();
@@ -2634,7 +2861,11 @@ bool Manager::SetValue(ValueID const& _id, uint8 _pos, bool const _value)
 		{
 			if (_id.GetNodeId() != driver->GetControllerNodeId())
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueBitSet* value = static_cast<Internal::VC::ValueBitSet*>(driver->GetValue(_id)))
 				{
 					if (_value)
@@ -2660,6 +2891,40 @@ bool Manager::SetValue(ValueID const& _id, uint8 _pos, bool const _value)
 
 // ZSA begin
 
+// A set or get made through the regular API, passed to Z-Way as the job callback argument
+// so that the time until Z-Way confirms the job lands in the node's latency histograms
+struct LatencyJob
+{
+		Driver* m_driver;
+		uint8 m_nodeId;
+		uint8 m_commandClassId;
+		Node::Latency m_kind;
+		Internal::Platform::TimeStamp m_start;
+};
+
+static LatencyJob* NewLatencyJob(Driver* _driver, ValueID const& _id, Node::Latency const _kind)
+{
+	LatencyJob* job = new LatencyJob();
+	job->m_driver = _driver;
+	job->m_nodeId = _id.GetNodeId();
+	job->m_commandClassId = _id.GetCommandClassId();
+	job->m_kind = _kind;
+	return job;
+}
+
+static void OnLatencyJobSuccess(const ZWay _zway, ZWBYTE _functionId, void* _arg)
+{
+	LatencyJob* job = (LatencyJob*) _arg;
+	job->m_driver->RecordLatency(job->m_nodeId, job->m_commandClassId, job->m_kind, (uint32) (Internal::Platform::TimeStamp() - job->m_start));
+	delete job;
+}
+
+static void OnLatencyJobFailure(const ZWay _zway, ZWBYTE _functionId, void* _arg)
+{
+	// Only completed jobs are counted, as SetValueAsync does
+	delete (LatencyJob*) _arg;
+}
+
 // typedef void (*ZJobCustomCallback)(const ZWay zway, ZWBYTE functionId, void* arg);
 // zway_cc_switch_binary_set(ZWay zway, ZWBYTE node_id, ZWBYTE instance_id, ZWBOOL value, ZJobCustomCallback successCallback, ZJobCustomCallback failureCallback, void* callbackArg);
 //-----------------------------------------------------------------------------
@@ -2684,7 +2949,12 @@ bool Manager::SetValue(ValueID const& _id, bool const _value)
 						{
 							case ValueID_Index_SwitchBinary::Level:
 							{
-								zway_cc_switch_binary_set(driver->zway, _id.GetNodeId(), _id.GetInstance(), _value, NULL, NULL, NULL);
+								LatencyJob* job = NewLatencyJob(driver, _id, Node::Latency_Confirmed);
+								res = (zway_cc_switch_binary_set(driver->zway, _id.GetNodeId(), _id.GetInstance(), _value, OnLatencyJobSuccess, OnLatencyJobFailure, job) == NoError);
+								if (!res)
+								{
+									delete job;
+								}
 								break;
 							}
 							case ValueID_Index_SwitchBinary::TargetState:
@@ -2711,6 +2981,286 @@ bool Manager::SetValue(ValueID const& _id, bool const _value)
 
 	return res;
 }
+
+// The state of a SetValueAsync call, passed to Z-Way as the job callback argument
+struct SetValueJob
+{
+		Manager::SetValueResult m_result;
+		Internal::Platform::TimeStamp m_start;
+		Manager::pfnOnSetValueComplete_t m_callback;
+		void* m_context;
+		Driver* m_driver;
+};
+
+//-----------------------------------------------------------------------------
+// <SetValueJobDone>
+// Report the outcome of a SetValueAsync call
+//-----------------------------------------------------------------------------
+static void SetValueJobDone(SetValueJob* _job, bool const _success)
+{
+	_job->m_result.m_success = _success;
+	_job->m_result.m_roundTrip = (uint32) (Internal::Platform::TimeStamp() - _job->m_start);
+	Log::Write(_success ? LogLevel_Detail : LogLevel_Warning, _job->m_result.m_id.GetNodeId(), "SetValueAsync %s after %d ms", _success ? "acknowledged" : "failed", _job->m_result.m_roundTrip);
+	if (_success)
+	{
+		_job->m_driver->RecordLatency(_job->m_result.m_id.GetNodeId(), _job->m_result.m_id.GetCommandClassId(), Node::Latency_Confirmed, _job->m_result.m_roundTrip);
+	}
+	_job->m_callback(_job->m_result, _job->m_context);
+	delete _job;
+}
+
+static void OnSetValueSuccess(const ZWay _zway, ZWBYTE _functionId, void* _arg)
+{
+	SetValueJobDone((SetValueJob*) _arg, true);
+}
+
+static void OnSetValueFailure(const ZWay _zway, ZWBYTE _functionId, void* _arg)
+{
+	SetValueJobDone((SetValueJob*) _arg, false);
+}
+
+//-----------------------------------------------------------------------------
+// <OnSetValueFuture>
+// Completes the future returned by SetValueAsync
+//-----------------------------------------------------------------------------
+static void OnSetValueFuture(Manager::SetValueResult const& _result, void* _context)
+{
+	std::promise<Manager::SetValueResult>* promise = (std::promise<Manager::SetValueResult>*) _context;
+	promise->set_value(_result);
+	delete promise;
+}
+
+//-----------------------------------------------------------------------------
+// <Manager::SendSetValue>
+// Hand a set to Z-Way
+//-----------------------------------------------------------------------------
+bool Manager::SendSetValue(ValueID const& _id, uint8 const _value, ZJobCustomCallback _success, ZJobCustomCallback _failure, void* _arg)
+{
+	Driver* driver = GetDriver(_id.GetHomeId());
+	if (!driver || _id.GetNodeId() == driver->GetControllerNodeId())
+	{
+		return false;
+	}
+
+	ZWError r;
+	if (_id.GetCommandClassId() == 0x25 && _id.GetIndex() == ValueID_Index_SwitchBinary::Level)
+	{
+		r = zway_cc_switch_binary_set(driver->zway, _id.GetNodeId(), _id.GetInstance(), _value ? TRUE : FALSE, _success, _failure, _arg);
+	}
+	else if (_id.GetCommandClassId() == 0x26 && _id.GetIndex() == ValueID_Index_SwitchMultiLevel::Level)
+	{
+		// 0xff is the device's default duration
+		r = zway_cc_switch_multilevel_set(driver->zway, _id.GetNodeId(), _id.GetInstance(), _value, 0xff, _success, _failure, _arg);
+	}
+	else if (_id.GetCommandClassId() == 0x20 && _id.GetIndex() == ValueID_Index_Basic::Set)
+	{
+		r = zway_cc_basic_set(driver->zway, _id.GetNodeId(), _id.GetInstance(), _value, _success, _failure, _arg);
+	}
+	else
+	{
+		Log::Write(LogLevel_Warning, _id.GetNodeId(), "SetValueAsync is not supported for Command Class 0x%.2x index %d", _id.GetCommandClassId(), _id.GetIndex());
+		return false;
+	}
+
+	if (r != NoError)
+	{
+		Log::Write(LogLevel_Warning, _id.GetNodeId(), "SetValueAsync could not queue the command: %s", zstrerror(r));
+		return false;
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// <Manager::SendGetValue>
+// Ask Z-Way to refresh a value from the device
+//-----------------------------------------------------------------------------
+bool Manager::SendGetValue(ValueID const& _id, ZJobCustomCallback _success, ZJobCustomCallback _failure, void* _arg)
+{
+	Driver* driver = GetDriver(_id.GetHomeId());
+	if (!driver || _id.GetNodeId() == driver->GetControllerNodeId())
+	{
+		return false;
+	}
+
+	ZWError r;
+	if (_id.GetCommandClassId() == 0x25 && _id.GetIndex() == ValueID_Index_SwitchBinary::Level)
+	{
+		r = zway_cc_switch_binary_get(driver->zway, _id.GetNodeId(), _id.GetInstance(), _success, _failure, _arg);
+	}
+	else if (_id.GetCommandClassId() == 0x26 && _id.GetIndex() == ValueID_Index_SwitchMultiLevel::Level)
+	{
+		r = zway_cc_switch_multilevel_get(driver->zway, _id.GetNodeId(), _id.GetInstance(), _success, _failure, _arg);
+	}
+	else if (_id.GetCommandClassId() == 0x20 && _id.GetIndex() == ValueID_Index_Basic::Set)
+	{
+		r = zway_cc_basic_get(driver->zway, _id.GetNodeId(), _id.GetInstance(), _success, _failure, _arg);
+	}
+	else
+	{
+		return false;
+	}
+
+	if (r != NoError)
+	{
+		Log::Write(LogLevel_Warning, _id.GetNodeId(), "RefreshValue could not queue the command: %s", zstrerror(r));
+		return false;
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// <Manager::QueueSetValue>
+// Hand a set to Z-Way, reporting the outcome to _callback
+//-----------------------------------------------------------------------------
+bool Manager::QueueSetValue(ValueID const& _id, uint8 const _value, pfnOnSetValueComplete_t _callback, void* _context)
+{
+	if (_callback == NULL)
+	{
+		// Z-Way would call back with nowhere to report the outcome
+		Log::Write(LogLevel_Error, _id.GetNodeId(), "SetValueAsync called without a callback");
+		return false;
+	}
+
+	SetValueJob* job = new SetValueJob();
+	job->m_result.m_id = _id;
+	job->m_callback = _callback;
+	job->m_context = _context;
+	job->m_driver = GetDriver(_id.GetHomeId());
+	if (!SendSetValue(_id, _value, OnSetValueSuccess, OnSetValueFailure, job))
+	{
+		delete job;
+		return false;
+	}
+	return true;
+}
+
+//-----------------------------------------------------------------------------
+// <Manager::SetValueAsync>
+// Sets a bool, and reports when the device has acknowledged it
+//-----------------------------------------------------------------------------
+bool Manager::SetValueAsync(ValueID const& _id, bool const _value, pfnOnSetValueComplete_t _callback, void* _context)
+{
+	if (ValueID::ValueType_Bool != _id.GetType())
+	{
+		OZW_ERROR(OZWException::OZWEXCEPTION_CANNOT_CONVERT_VALUEID, "ValueID passed to SetValueAsync is not a bool Value");
+		return false;
+	}
+
+	return QueueSetValue(_id, _value ? 0xff : 0x00, _callback, _context);
+}
+
+//-----------------------------------------------------------------------------
+// <Manager::SetValueAsync>
+// Sets a byte, and reports when the device has acknowledged it
+//-----------------------------------------------------------------------------
+bool Manager::SetValueAsync(ValueID const& _id, uint8 const _value, pfnOnSetValueComplete_t _callback, void* _context)
+{
+	if (ValueID::ValueType_Byte != _id.GetType())
+	{
+		OZW_ERROR(OZWException::OZWEXCEPTION_CANNOT_CONVERT_VALUEID, "ValueID passed to SetValueAsync is not a Byte Value");
+		return false;
+	}
+
+	return QueueSetValue(_id, _value, _callback, _context);
+}
+
+//-----------------------------------------------------------------------------
+// <Manager::SetValueAsync>
+// Sets a bool, returning the outcome in a future
+//-----------------------------------------------------------------------------
+std::future<Manager::SetValueResult> Manager::SetValueAsync(ValueID const& _id, bool const _value)
+{
+	std::promise<SetValueResult>* promise = new std::promise<SetValueResult>();
+	std::future<SetValueResult> result = promise->get_future();
+	if (!SetValueAsync(_id, _value, OnSetValueFuture, promise))
+	{
+		SetValueResult failed;
+		failed.m_id = _id;
+		failed.m_success = false;
+		failed.m_roundTrip = 0;
+		OnSetValueFuture(failed, promise);
+	}
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+// <Manager::SetValueAsync>
+// Sets a byte, returning the outcome in a future
+//-----------------------------------------------------------------------------
+std::future<Manager::SetValueResult> Manager::SetValueAsync(ValueID const& _id, uint8 const _value)
+{
+	std::promise<SetValueResult>* promise = new std::promise<SetValueResult>();
+	std::future<SetValueResult> result = promise->get_future();
+	if (!SetValueAsync(_id, _value, OnSetValueFuture, promise))
+	{
+		SetValueResult failed;
+		failed.m_id = _id;
+		failed.m_success = false;
+		failed.m_roundTrip = 0;
+		OnSetValueFuture(failed, promise);
+	}
+	return result;
+}
+
+//-----------------------------------------------------------------------------
+// <SetValuesLevel>
+// The level SetValues sends for a target, or -1 if it cannot set it
+//-----------------------------------------------------------------------------
+static int32 SetValuesLevel(pair<ValueID, uint8> const& _target)
+{
+	if (ValueID::ValueType_Bool == _target.first.GetType())
+	{
+		return _target.second ? 0xff : 0x00;
+	}
+	if (ValueID::ValueType_Byte == _target.first.GetType())
+	{
+		return _target.second;
+	}
+	Log::Write(LogLevel_Warning, _target.first.GetNodeId(), "SetValues: skipping a ValueID that is not a bool or byte Value");
+	return -1;
+}
+
+//-----------------------------------------------------------------------------
+// <Manager::SetValues>
+// Sets many values, without waiting for each to complete before the next
+//-----------------------------------------------------------------------------
+uint32 Manager::SetValues(vector<pair<ValueID, uint8> > const& _targets, pfnOnSetValueComplete_t _callback, void* _context)
+{
+	uint32 queued = 0;
+	for (vector<pair<ValueID, uint8> >::const_iterator it = _targets.begin(); it != _targets.end(); ++it)
+	{
+		int32 value = SetValuesLevel(*it);
+		if (value >= 0 && QueueSetValue(it->first, (uint8) value, _callback, _context))
+		{
+			++queued;
+		}
+	}
+	return queued;
+}
+
+//-----------------------------------------------------------------------------
+// <Manager::SetValues>
+// Sets many values, returning the outcome for each in a future
+//-----------------------------------------------------------------------------
+vector<std::future<Manager::SetValueResult> > Manager::SetValues(vector<pair<ValueID, uint8> > const& _targets)
+{
+	vector<std::future<SetValueResult> > results;
+	for (vector<pair<ValueID, uint8> >::const_iterator it = _targets.begin(); it != _targets.end(); ++it)
+	{
+		std::promise<SetValueResult>* promise = new std::promise<SetValueResult>();
+		results.push_back(promise->get_future());
+		int32 value = SetValuesLevel(*it);
+		if (value < 0 || !QueueSetValue(it->first, (uint8) value, OnSetValueFuture, promise))
+		{
+			SetValueResult failed;
+			failed.m_id = it->first;
+			failed.m_success = false;
+			failed.m_roundTrip = 0;
+			OnSetValueFuture(failed, promise);
+		}
+	}
+	return results;
+}
 // ZSA end
 
 //-----------------------------------------------------------------------------
@@ -2727,7 +3277,11 @@ bool Manager::SetValue(ValueID const& _id, uint8 const _value)
 		{
 			if (_id.GetNodeId() != driver->GetControllerNodeId())
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueByte* value = static_cast<Internal::VC::ValueByte*>(driver->GetValue(_id)))
 				{
 					res = value->Set(_value);
@@ -2746,7 +3300,11 @@ bool Manager::SetValue(ValueID const& _id, uint8 const _value)
 		{
 			if (_id.GetNodeId() != driver->GetControllerNodeId())
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueBitSet* value = static_cast<Internal::VC::ValueBitSet*>(driver->GetValue(_id)))
 				{
 					if (value->GetSize() == 1)
@@ -2788,7 +3346,11 @@ bool Manager::SetValue(ValueID const& _id, float const _value)
 		{
 			if (_id.GetNodeId() != driver->GetControllerNodeId())
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueDecimal* value = static_cast<Internal::VC::ValueDecimal*>(driver->GetValue(_id)))
 				{
 					char str[256];
@@ -2843,7 +3405,11 @@ bool Manager::SetValue(ValueID const& _id, int32 const _value)
 		{
 			if (_id.GetNodeId() != driver->GetControllerNodeId())
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueInt* value = static_cast<Internal::VC::ValueInt*>(driver->GetValue(_id)))
 				{
 					res = value->Set(_value);
@@ -2862,7 +3428,11 @@ bool Manager::SetValue(ValueID const& _id, int32 const _value)
 		{
 			if (_id.GetNodeId() != driver->GetControllerNodeId())
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueBitSet* value = static_cast<Internal::VC::ValueBitSet*>(driver->GetValue(_id)))
 				{
 					if (value->GetSize() == 4)
@@ -2904,7 +3474,11 @@ bool Manager::SetValue(ValueID const& _id, uint8 const* _value, uint8 const _len
 		{
 			if (_id.GetNodeId() != driver->GetControllerNodeId())
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueRaw* value = static_cast<Internal::VC::ValueRaw*>(driver->GetValue(_id)))
 				{
 					res = value->Set(_value, _length);
@@ -2939,7 +3513,11 @@ bool Manager::SetValue(ValueID const& _id, int16 const _value)
 		{
 			if (_id.GetNodeId() != driver->GetControllerNodeId())
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueShort* value = static_cast<Internal::VC::ValueShort*>(driver->GetValue(_id)))
 				{
 					res = value->Set(_value);
@@ -2958,7 +3536,11 @@ bool Manager::SetValue(ValueID const& _id, int16 const _value)
 		{
 			if (_id.GetNodeId() != driver->GetControllerNodeId())
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueBitSet* value = static_cast<Internal::VC::ValueBitSet*>(driver->GetValue(_id)))
 				{
 					if (value->GetSize() == 2)
@@ -3000,7 +3582,11 @@ bool Manager::SetValueListSelection(ValueID const& _id, string const& _selectedI
 		{
 			if (_id.GetNodeId() != driver->GetControllerNodeId())
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueList* value = static_cast<Internal::VC::ValueList*>(driver->GetValue(_id)))
 				{
 					res = value->SetByLabel(_selectedItem);
@@ -3034,7 +3620,11 @@ bool Manager::SetValue(ValueID const& _id, string const& _value)
 	{
 		if (_id.GetNodeId() != driver->GetControllerNodeId())
 		{
-			Internal::LockGuard LG(driver->m_nodeMutex);
+			Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+			if (LG.IsRefused())
+			{
+				return res;
+			}
 
 			switch (_id.GetType())
 			{
@@ -3197,7 +3787,11 @@ bool Manager::RefreshValue(ValueID const& _id)
 		Node *node;
 
 		// Need to lock and unlock nodes to check this information
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+		if (LG.IsRefused())
+		{
+			return bRet;
+		}
 
 		if ((node = driver->GetNode(_id.GetNodeId())) != NULL)
 		{
@@ -3207,7 +3801,13 @@ bool Manager::RefreshValue(ValueID const& _id)
 				uint16_t index = _id.GetIndex();
 				uint8 instance = _id.GetInstance();
 				Log::Write(LogLevel_Info, "mgr,     Refreshing node %d: %s index = %d instance = %d (to confirm a reported change)", node->m_nodeId, cc->GetCommandClassName().c_str(), index, instance);
-				cc->RequestValue(0, index, instance, Driver::MsgQueue_Send);
+				LatencyJob* job = NewLatencyJob(driver, _id, Node::Latency_Ack);
+				if (!SendGetValue(_id, OnLatencyJobSuccess, OnLatencyJobFailure, job))
+				{
+					// Not a value Z-Way can get for us
+					delete job;
+					cc->RequestValue(0, index, instance, Driver::MsgQueue_Send);
+				}
 				bRet = true;
 			}
 			else
@@ -3228,7 +3828,11 @@ void Manager::SetChangeVerified(ValueID const& _id, bool _verify)
 {
 	if (Driver* driver = GetDriver(_id.GetHomeId()))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+		if (LG.IsRefused())
+		{
+			return;
+		}
 		if (Internal::VC::Value* value = driver->GetValue(_id))
 		{
 			value->SetChangeVerified(_verify);
@@ -3250,7 +3854,11 @@ bool Manager::GetChangeVerified(ValueID const& _id)
 	bool res = false;
 	if (Driver* driver = GetDriver(_id.GetHomeId()))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+		if (LG.IsRefused())
+		{
+			return res;
+		}
 		if (Internal::VC::Value* value = driver->GetValue(_id))
 		{
 			res = value->GetChangeVerified();
@@ -3276,7 +3884,11 @@ bool Manager::PressButton(ValueID const& _id)
 	{
 		if (Driver* driver = GetDriver(_id.GetHomeId()))
 		{
-			Internal::LockGuard LG(driver->m_nodeMutex);
+			Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+			if (LG.IsRefused())
+			{
+				return res;
+			}
 			if (Internal::VC::ValueButton* value = static_cast<Internal::VC::ValueButton*>(driver->GetValue(_id)))
 			{
 				res = value->PressButton();
@@ -3308,7 +3920,11 @@ bool Manager::ReleaseButton(ValueID const& _id)
 	{
 		if (Driver* driver = GetDriver(_id.GetHomeId()))
 		{
-			Internal::LockGuard LG(driver->m_nodeMutex);
+			Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+			if (LG.IsRefused())
+			{
+				return res;
+			}
 			if (Internal::VC::ValueButton* value = static_cast<Internal::VC::ValueButton*>(driver->GetValue(_id)))
 			{
 				res = value->ReleaseButton();
@@ -3340,7 +3956,11 @@ bool Manager::SetBitMask(ValueID const& _id, uint32 _mask)
 	{
 		if (Driver* driver = GetDriver(_id.GetHomeId()))
 		{
-			Internal::LockGuard LG(driver->m_nodeMutex);
+			Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+			if (LG.IsRefused())
+			{
+				return res;
+			}
 			if (Internal::VC::ValueBitSet* value = static_cast<Internal::VC::ValueBitSet*>(driver->GetValue(_id)))
 			{
 				res = value->SetBitMask(_mask);
@@ -3375,7 +3995,11 @@ bool Manager::GetBitMask(ValueID const& _id, int32* o_mask)
 		{
 			if (Driver* driver = GetDriver(_id.GetHomeId()))
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueBitSet* value = static_cast<Internal::VC::ValueBitSet*>(driver->GetValue(_id)))
 				{
 					*o_mask = value->GetBitMask();
@@ -3411,7 +4035,11 @@ bool Manager::GetBitSetSize(ValueID const& _id, uint8* o_size)
 		{
 			if (Driver* driver = GetDriver(_id.GetHomeId()))
 			{
-				Internal::LockGuard LG(driver->m_nodeMutex);
+				Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+				if (LG.IsRefused())
+				{
+					return res;
+				}
 				if (Internal::VC::ValueBitSet* value = static_cast<Internal::VC::ValueBitSet*>(driver->GetValue(_id)))
 				{
 					*o_size = value->GetSize();
@@ -3450,7 +4078,11 @@ uint8 Manager::GetNumSwitchPoints(ValueID const& _id)
 	{
 		if (Driver* driver = GetDriver(_id.GetHomeId()))
 		{
-			Internal::LockGuard LG(driver->m_nodeMutex);
+			Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+			if (LG.IsRefused())
+			{
+				return numSwitchPoints;
+			}
 			if (Internal::VC::ValueSchedule* value = static_cast<Internal::VC::ValueSchedule*>(driver->GetValue(_id)))
 			{
 				numSwitchPoints = value->GetNumSwitchPoints();
@@ -3482,7 +4114,11 @@ bool Manager::SetSwitchPoint(ValueID const& _id, uint8 const _hours, uint8 const
 	{
 		if (Driver* driver = GetDriver(_id.GetHomeId()))
 		{
-			Internal::LockGuard LG(driver->m_nodeMutex);
+			Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+			if (LG.IsRefused())
+			{
+				return res;
+			}
 			if (Internal::VC::ValueSchedule* value = static_cast<Internal::VC::ValueSchedule*>(driver->GetValue(_id)))
 			{
 				res = value->SetSwitchPoint(_hours, _minutes, _setback);
@@ -3514,7 +4150,11 @@ bool Manager::RemoveSwitchPoint(ValueID const& _id, uint8 const _hours, uint8 co
 	{
 		if (Driver* driver = GetDriver(_id.GetHomeId()))
 		{
-			Internal::LockGuard LG(driver->m_nodeMutex);
+			Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+			if (LG.IsRefused())
+			{
+				return res;
+			}
 			if (Internal::VC::ValueSchedule* value = static_cast<Internal::VC::ValueSchedule*>(driver->GetValue(_id)))
 			{
 				uint8 idx;
@@ -3550,7 +4190,11 @@ void Manager::ClearSwitchPoints(ValueID const& _id)
 	{
 		if (Driver* driver = GetDriver(_id.GetHomeId()))
 		{
-			Internal::LockGuard LG(driver->m_nodeMutex);
+			Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+			if (LG.IsRefused())
+			{
+				return;
+			}
 			if (Internal::VC::ValueSchedule* value = static_cast<Internal::VC::ValueSchedule*>(driver->GetValue(_id)))
 			{
 				value->ClearSwitchPoints();
@@ -3580,7 +4224,11 @@ bool Manager::GetSwitchPoint(ValueID const& _id, uint8 const _idx, uint8* o_hour
 	{
 		if (Driver* driver = GetDriver(_id.GetHomeId()))
 		{
-			Internal::LockGuard LG(driver->m_nodeMutex);
+			Internal::NodeLockGuard LG(driver, _id.GetNodeId());
+			if (LG.IsRefused())
+			{
+				return res;
+			}
 			if (Internal::VC::ValueSchedule* value = static_cast<Internal::VC::ValueSchedule*>(driver->GetValue(_id)))
 			{
 				res = value->GetSwitchPoint(_idx, o_hours, o_minutes, o_setback);
@@ -3666,7 +4314,11 @@ void Manager::RequestAllConfigParams(uint32 const _homeId, uint8 const _nodeId)
 {
 	if (Driver* driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _nodeId);
+		if (LG.IsRefused())
+		{
+			return;
+		}
 		Node* node = driver->GetNode(_nodeId);
 		if (node)
 		{
@@ -3826,7 +4478,15 @@ bool Manager::RemoveWatcher(pfnOnNotification_t _watcher, void* _context)
 	{
 		if (((*it)->m_callback == _watcher) && ((*it)->m_context == _context))
 		{
-			delete (*it);
+			if ((*it)->m_calls)
+			{
+				// NotifyWatchers deletes it when the calls return
+				(*it)->m_removed = true;
+			}
+			else
+			{
+				delete (*it);
+			}
 			list<Watcher*>::iterator next = m_watchers.erase(it);
 			for (list<list<Watcher*>::iterator*>::iterator extIt = m_watcherIterators.begin(); extIt != m_watcherIterators.end(); ++extIt)
 			{
@@ -3849,7 +4509,8 @@ bool Manager::RemoveWatcher(pfnOnNotification_t _watcher, void* _context)
 // <Manager::NotifyWatchers>
 // Notify any watching objects of a value change
 //-----------------------------------------------------------------------------
-void Manager::NotifyWatchers(Notification* _notification)
+void Manager::NotifyWatchers(Notification* _notification, bool const _concurrent	// = false
+		)
 {
 	m_notificationMutex->Lock();
 	list<Watcher*>::iterator it = m_watchers.begin();
@@ -3857,9 +4518,23 @@ void Manager::NotifyWatchers(Notification* _notification)
 	while (it != m_watchers.end())
 	{
 		Watcher* pWatcher = *(it++);
+		pWatcher->m_calls++;
+		// Notifications from the notification pool do not wait for each other
+		if (_concurrent)
+		{
+			m_notificationMutex->Unlock();
+		}
 		pWatcher->m_callback(_notification, pWatcher->m_context);
+		if (_concurrent)
+		{
+			m_notificationMutex->Lock();
+		}
+		if ((--pWatcher->m_calls == 0) && pWatcher->m_removed)
+		{
+			delete pWatcher;
+		}
 	}
-	m_watcherIterators.pop_back();
+	m_watcherIterators.remove(&it);
 	m_notificationMutex->Unlock();
 }
 
@@ -3966,7 +4641,11 @@ void Manager::HealNetworkNode(uint32 const _homeId, uint8 const _nodeId, bool _d
 {
 	if (Driver* driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return;
+		}
 		Node* node = driver->GetNode(_nodeId);
 		if (node)
 		{
@@ -3987,7 +4666,11 @@ void Manager::HealNetwork(uint32 const _homeId, bool _doRR)
 {
 	if (Driver* driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return;
+		}
 		for (uint8 i = 0; i < 255; i++)
 		{
 			if (driver->m_nodes[i] != NULL)
@@ -4009,7 +4692,11 @@ bool Manager::AddNode(uint32 const _homeId, bool _doSecurity)
 {
 	if (Driver *driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return false;
+		}
 		/* we use the Args option to communicate if Security CC should be initialized */
 		return driver->BeginControllerCommand(Driver::ControllerCommand_AddDevice,
 		NULL, NULL, true, 0, (_doSecurity == true ? 1 : 0));
@@ -4025,7 +4712,11 @@ bool Manager::RemoveNode(uint32 const _homeId)
 {
 	if (Driver *driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return false;
+		}
 		return driver->BeginControllerCommand(Driver::ControllerCommand_RemoveDevice,
 		NULL, NULL, true, 0, 0);
 	}
@@ -4040,7 +4731,11 @@ bool Manager::RemoveFailedNode(uint32 const _homeId, uint8 const _nodeId)
 {
 	if (Driver *driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return false;
+		}
 		return driver->BeginControllerCommand(Driver::ControllerCommand_RemoveFailedNode,
 		NULL, NULL, true, _nodeId, 0);
 	}
@@ -4055,7 +4750,11 @@ bool Manager::HasNodeFailed(uint32 const _homeId, uint8 const _nodeId)
 {
 	if (Driver *driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return false;
+		}
 		return driver->BeginControllerCommand(Driver::ControllerCommand_HasNodeFailed,
 		NULL, NULL, true, _nodeId, 0);
 	}
@@ -4070,7 +4769,11 @@ bool Manager::AssignReturnRoute(uint32 const _homeId, uint8 const _nodeId)
 {
 	if (Driver *driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return false;
+		}
 		return driver->BeginControllerCommand(Driver::ControllerCommand_AssignReturnRoute,
 		NULL, NULL, true, _nodeId, 0);
 	}
@@ -4085,7 +4788,11 @@ bool Manager::RequestNodeNeighborUpdate(uint32 const _homeId, uint8 const _nodeI
 {
 	if (Driver *driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return false;
+		}
 		return driver->BeginControllerCommand(Driver::ControllerCommand_RequestNodeNeighborUpdate,
 		NULL, NULL, true, _nodeId, 0);
 	}
@@ -4100,7 +4807,11 @@ bool Manager::DeleteAllReturnRoutes(uint32 const _homeId, uint8 const _nodeId)
 {
 	if (Driver *driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return false;
+		}
 		return driver->BeginControllerCommand(Driver::ControllerCommand_DeleteAllReturnRoutes,
 		NULL, NULL, true, _nodeId, 0);
 	}
@@ -4115,7 +4826,11 @@ bool Manager::SendNodeInformation(uint32 const _homeId, uint8 const _nodeId)
 {
 	if (Driver *driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return false;
+		}
 		return driver->BeginControllerCommand(Driver::ControllerCommand_SendNodeInformation,
 		NULL, NULL, true, _nodeId, 0);
 	}
@@ -4130,7 +4845,11 @@ bool Manager::CreateNewPrimary(uint32 const _homeId)
 {
 	if (Driver *driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return false;
+		}
 		return driver->BeginControllerCommand(Driver::ControllerCommand_CreateNewPrimary,
 		NULL, NULL, true, 0, 0);
 	}
@@ -4145,7 +4864,11 @@ bool Manager::ReceiveConfiguration(uint32 const _homeId)
 {
 	if (Driver *driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return false;
+		}
 		return driver->BeginControllerCommand(Driver::ControllerCommand_ReceiveConfiguration,
 		NULL, NULL, true, 0, 0);
 	}
@@ -4160,7 +4883,11 @@ bool Manager::ReplaceFailedNode(uint32 const _homeId, uint8 const _nodeId)
 {
 	if (Driver *driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return false;
+		}
 		return driver->BeginControllerCommand(Driver::ControllerCommand_ReplaceFailedNode,
 		NULL, NULL, true, _nodeId, 0);
 	}
@@ -4175,7 +4902,11 @@ bool Manager::TransferPrimaryRole(uint32 const _homeId)
 {
 	if (Driver *driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return false;
+		}
 		return driver->BeginControllerCommand(Driver::ControllerCommand_TransferPrimaryRole,
 		NULL, NULL, true, 0, 0);
 	}
@@ -4190,7 +4921,11 @@ bool Manager::RequestNetworkUpdate(uint32 const _homeId, uint8 const _nodeId)
 {
 	if (Driver *driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return false;
+		}
 		return driver->BeginControllerCommand(Driver::ControllerCommand_RequestNetworkUpdate,
 		NULL, NULL, true, _nodeId, 0);
 	}
@@ -4205,7 +4940,11 @@ bool Manager::ReplicationSend(uint32 const _homeId, uint8 const _nodeId)
 {
 	if (Driver *driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return false;
+		}
 		return driver->BeginControllerCommand(Driver::ControllerCommand_ReplicationSend,
 		NULL, NULL, true, _nodeId, 0);
 	}
@@ -4220,7 +4959,11 @@ bool Manager::CreateButton(uint32 const _homeId, uint8 const _nodeId, uint8 cons
 {
 	if (Driver *driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return false;
+		}
 		return driver->BeginControllerCommand(Driver::ControllerCommand_CreateButton,
 		NULL, NULL, true, _nodeId, _buttonid);
 	}
@@ -4235,7 +4978,11 @@ bool Manager::DeleteButton(uint32 const _homeId, uint8 const _nodeId, uint8 cons
 {
 	if (Driver *driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodesLockGuard LG(driver);
+		if (!LG.IsLocked())
+		{
+			return false;
+		}
 		return driver->BeginControllerCommand(Driver::ControllerCommand_DeleteButton,
 		NULL, NULL, true, _nodeId, _buttonid);
 	}
@@ -4251,7 +4998,11 @@ void Manager::SendRawData(uint32 const _homeId, uint8 const _nodeId, string cons
 {
 	if (Driver *driver = GetDriver(_homeId))
 	{
-		Internal::LockGuard LG(driver->m_nodeMutex);
+		Internal::NodeLockGuard LG(driver, _nodeId);
+		if (LG.IsRefused())
+		{
+			return;
+		}
 		Node* node = driver->GetNode(_nodeId);
 		if (node)
 		{
@@ -4832,6 +5583,51 @@ if (Driver* driver = GetDriver(_homeId))
 
 }
 
+//-----------------------------------------------------------------------------
+// <Manager::GetLockStatistics>
+// Retrieve the lock statistics
+//-----------------------------------------------------------------------------
+void Manager::GetLockStatistics(vector<LockData>* o_data)
+{
+	Internal::Platform::Mutex::GetStatistics(o_data);
+}
+
+//-----------------------------------------------------------------------------
+// <Manager::LogLockStatistics>
+// Send the lock statistics to the log file
+//-----------------------------------------------------------------------------
+void Manager::LogLockStatistics()
+{
+	Internal::Platform::Mutex::LogStatistics();
+}
+
+//-----------------------------------------------------------------------------
+// <Manager::GetThreadStatistics>
+// Retrieve the CPU time and wakeups of our threads
+//-----------------------------------------------------------------------------
+void Manager::GetThreadStatistics(vector<ThreadData>* o_data)
+{
+	Internal::Platform::Thread::GetStatistics(o_data);
+}
+
+//-----------------------------------------------------------------------------
+// <Manager::LogThreadStatistics>
+// Send the thread statistics to the log file
+//-----------------------------------------------------------------------------
+void Manager::LogThreadStatistics()
+{
+	Internal::Platform::Thread::LogStatistics();
+}
+
+//-----------------------------------------------------------------------------
+// <Manager::GetMetrics>
+// Retrieve the metrics in the Prometheus text format
+//-----------------------------------------------------------------------------
+string Manager::GetMetrics()
+{
+	return Internal::Metrics::Get()->Export();
+}
+
 //-----------------------------------------------------------------------------
 // <Manager::GetNodeStatistics>
 // Retrieve driver based counters.
@@ -4929,7 +5725,11 @@ bool Manager::checkLatestConfigFileRevision(uint32 const _homeId, uint8 const _n
 {
 if (Driver *driver = GetDriver(_homeId))
 {
-	Internal::LockGuard LG(driver->m_nodeMutex);
+	Internal::NodesLockGuard LG(driver);
+	if (!LG.IsLocked())
+	{
+		return false;
+	}
 	Node* node = driver->GetNode(_nodeId);
 	if (node)
 	{
@@ -4960,7 +5760,11 @@ bool Manager::downloadLatestConfigFileRevision(uint32 const _homeId, uint8 const
 {
 if (Driver *driver = GetDriver(_homeId))
 {
-	Internal::LockGuard LG(driver->m_nodeMutex);
+	Internal::NodesLockGuard LG(driver);
+	if (!LG.IsLocked())
+	{
+		return false;
+	}
 	Node* node = driver->GetNode(_nodeId);
 	if (node)
 	{
@@ -34,6 +34,7 @@
 #include <map>
 #include <list>
 #include <deque>
+#include <future>
 
 #include "Defs.h"
 #include "Driver.h"
@@ -57,6 +58,7 @@ namespace OpenZWave
 			class ValueStore;
 		}
 		class Msg;
+		class Scene;
 	}
 	class Options;
 	class Node;
@@ -117,6 +119,7 @@ namespace OpenZWave
 			friend class Internal::VC::Value;
 			friend class Internal::VC::ValueStore;
 			friend class Internal::Msg;
+			friend class Internal::Scene;
 
 			//-----------------------------------------------------------------------------
 			// ZWay
@@ -418,6 +421,14 @@ namespace OpenZWave
 			 */
 			bool EnablePoll(ValueID const &_valueId, uint8 const _intensity = 1);
 
+			/**
+			 * \brief Enable the polling of a set of values.
+			 * \param _valueIds The IDs of the values to start polling.  They may belong to different drivers.
+			 * \param _intensity, number of polling for one polling interval.
+			 * \return The number of values for which polling is enabled.
+			 */
+			uint32 EnablePoll(vector<ValueID> const &_valueIds, uint8 const _intensity = 1);
+
 			/**
 			 * \brief Disable the polling of a device's state.
 			 * \param _valueId The ID of the value to stop polling.
@@ -425,6 +436,13 @@ namespace OpenZWave
 			 */
 			bool DisablePoll(ValueID const &_valueId);
 
+			/**
+			 * \brief Disable the polling of a set of values.
+			 * \param _valueIds The IDs of the values to stop polling.  They may belong to different drivers.
+			 * \return The number of values for which polling was disabled.
+			 */
+			uint32 DisablePoll(vector<ValueID> const &_valueIds);
+
 			/**
 			 * \brief Determine the polling of a device's state.
 			 * \param _valueId The ID of the value to check polling.
@@ -447,6 +465,15 @@ namespace OpenZWave
 			 */
 			uint8 GetPollIntensity(ValueID const &_valueId);
 
+			/**
+			 * \brief Poll a value at a fixed period, rather than according to its poll intensity.
+			 * \param _valueId The ID of a value that is being polled.
+			 * \param _milliseconds Time between polls of this value.  0 to go back to using the poll intensity.
+			 * \return True if the period was set, false if the value is not being polled.
+			 * \see EnablePoll, SetPollIntensity
+			 */
+			bool SetPollPeriod(ValueID const &_valueId, int32 const _milliseconds);
+
 			/*@}*/
 
 			//-----------------------------------------------------------------------------
@@ -1363,6 +1390,67 @@ namespace OpenZWave
 			 */
 			bool SetValue(ValueID const& _id, string const& _value);
 
+			/**
+			 * \brief The outcome of a SetValueAsync call.
+			 */
+			struct SetValueResult
+			{
+					ValueID m_id;
+					bool m_success;					// true if the device acknowledged the command
+					uint32 m_roundTrip;				// ms from the SetValueAsync call until the acknowledgement or failure
+			};
+			typedef void (*pfnOnSetValueComplete_t)(SetValueResult const& _result, void* _context);
+
+			/**
+			 * \brief Sets the state of a bool, and reports when the device has acknowledged it.
+			 * Unlike SetValue, this does not wait for, or assume, the outcome.  Many sets can be outstanding at once.
+			 * Supported for Switch Binary values.
+			 * \param _id The unique identifier of the bool value.
+			 * \param _value The new value of the bool.
+			 * \param _callback called once, on a Z-Way thread, when the command has been acknowledged or has failed.  It must not block.
+			 * It must not be NULL.
+			 * \param _context passed to _callback.
+			 * \return true if the command was queued, in which case _callback will be called.  false if it could not be, or _callback
+			 * is NULL, and _callback will not be called.
+			 * \throws OZWException with Type OZWException::OZWEXCEPTION_CANNOT_CONVERT_VALUEID if the Actual Value is off a different type
+			 * \see SetValue
+			 */
+			bool SetValueAsync(ValueID const& _id, bool const _value, pfnOnSetValueComplete_t _callback, void* _context);
+			/**
+			 * \brief Sets the value of a byte, and reports when the device has acknowledged it.
+			 * Supported for Switch Multilevel and Basic values.
+			 * \see SetValueAsync(ValueID const&, bool const, pfnOnSetValueComplete_t, void*)
+			 */
+			bool SetValueAsync(ValueID const& _id, uint8 const _value, pfnOnSetValueComplete_t _callback, void* _context);
+			/**
+			 * \brief As the callback versions of SetValueAsync, but the result is returned in a future.
+			 * If the command could not be queued the future is ready straight away, with m_success false.
+			 */
+			std::future<SetValueResult> SetValueAsync(ValueID const& _id, bool const _value);
+			std::future<SetValueResult> SetValueAsync(ValueID const& _id, uint8 const _value);
+			/**
+			 * \brief Sets many bool or byte values at once.
+			 * Every target is sent its own set, as SetValueAsync does, without waiting for the previous one
+			 * to complete.  The sets are unicast only: Z-Way does not expose multicast here, so the devices
+			 * change one after the other rather than together.
+			 * \param _targets the values to set.  For bool values any non-zero value means true.
+			 * \param _callback called once for each target that was queued, on a Z-Way thread.  See SetValueAsync.
+			 * \param _context passed to _callback.
+			 * \return the number of targets that were queued.  The others are not supported, or not a bool or byte value, and are logged.
+			 */
+			uint32 SetValues(vector<pair<ValueID, uint8> > const& _targets, pfnOnSetValueComplete_t _callback, void* _context);
+			/**
+			 * \brief As SetValues, but the result for each target is returned in a future, in the same order as _targets.
+			 */
+			vector<std::future<SetValueResult> > SetValues(vector<pair<ValueID, uint8> > const& _targets);
+
+		private:
+			bool SendSetValue(ValueID const& _id, uint8 const _value, ZJobCustomCallback _success, ZJobCustomCallback _failure, void* _arg);	// Hand a set to Z-Way.  Exactly one of _success or _failure is called if this returns true.
+			bool QueueSetValue(ValueID const& _id, uint8 const _value, pfnOnSetValueComplete_t _callback, void* _context);	// SetValueAsync for a bool or byte value, without the type check
+			bool SendGetValue(ValueID const& _id, ZJobCustomCallback _success, ZJobCustomCallback _failure, void* _arg);	// Hand a get to Z-Way.  False if it cannot get this value, or could not queue it.
+
+		public:
+
 			/**
 			 * \brief Sets the selected item in a list.
 			 * Due to the possibility of a device being asleep, the command is assumed to succeed, and the value
@@ -1774,6 +1862,8 @@ namespace OpenZWave
 			 * An application needs only add a single watcher - all notifications will be reported to it.
 			 * \param _watcher pointer to a function that will be called by the notification system.
 			 * \param _context pointer to user defined data that will be passed to the watcher function with each notification.
+			 * When the NotificationThreads option is set, the watcher is called on several threads at once, although never
+			 * with two notifications for the same node at the same time.
 			 * \return true if the watcher was successfully added.
 			 * \see RemoveWatcher, Notification
 			 */
@@ -1783,6 +1873,8 @@ namespace OpenZWave
 			 * \brief Remove a notification watcher.
 			 * \param _watcher pointer to a function that must match that passed to a previous call to AddWatcher
 			 * \param _context pointer to user defined data that must match the one passed in that same previous call to AddWatcher.
+			 * When the NotificationThreads option is set, calls to the watcher that have already started on other threads
+			 * may still be running when this returns.
 			 * \return true if the watcher was successfully removed.
 			 * \see AddWatcher, Notification
 			 */
@@ -1790,15 +1882,17 @@ namespace OpenZWave
 			/*@}*/
 
 		private:
-			void NotifyWatchers(Notification* _notification);					// Passes the notifications to all the registered watcher callbacks in turn.
+			void NotifyWatchers(Notification* _notification, bool const _concurrent = false);	// Passes the notifications to all the registered watcher callbacks in turn.
 
 			struct Watcher
 			{
 					pfnOnNotification_t m_callback;
 					void* m_context;
+					uint32 m_calls;				// Calls to m_callback in progress
+					bool m_removed;				// RemoveWatcher was called during a call, so delete it once m_calls drops to 0
 
 					Watcher(pfnOnNotification_t _callback, void* _context) :
-							m_callback(_callback), m_context(_context)
+							m_callback(_callback), m_context(_context), m_calls(0), m_removed(false)
 					{
 					}
 			};
@@ -2602,6 +2696,52 @@ namespace OpenZWave
 			 */
 			static string GetNodeRouteSpeed(Node::NodeData *_data);
 
+			/**
+			 * Lock statistics for the mutexes sharing a name (the node list, send queues,
+			 * poll list, notifications, timers and so on).  Times are in microseconds.
+			 */
+			typedef Internal::Platform::Mutex::Statistics LockData;
+
+			/**
+			 * \brief Retrieve lock statistics
+			 * They are only collected while the LockProfiling option is set.
+			 * \param o_data Receives one entry for each mutex name
+			 */
+			void GetLockStatistics(vector<LockData>* o_data);
+
+			/**
+			 * \brief Send the lock statistics to the log file
+			 */
+			void LogLockStatistics();
+
+			/**
+			 * Placement and accounting for one of the threads OpenZWave started (driver, poll,
+			 * timer, dns, notify and so on).  The threads Z-Way runs itself are not included.
+			 */
+			typedef Internal::Platform::Thread::Statistics ThreadData;
+
+			/**
+			 * \brief Retrieve the CPU time and wakeup counts of the threads
+			 * The CPUs and scheduling they were asked to run with are set by the ThreadAffinity
+			 * and ThreadScheduling options.
+			 * \param o_data Receives one entry for each thread
+			 */
+			void GetThreadStatistics(vector<ThreadData>* o_data);
+
+			/**
+			 * \brief Send the thread statistics to the log file
+			 */
+			void LogThreadStatistics();
+
+			/**
+			 * \brief Retrieve every metric in the Prometheus text format
+			 * This includes the driver counters, the queue depths and the latency histograms of
+			 * each driver, labelled with its controller path.  The MetricsExport option can also
+			 * have them written to a file or served on a local socket.
+			 * \return the metrics, one sample per line
+			 */
+			string GetMetrics();
+
 			/*@}*/
 
 			//-----------------------------------------------------------------------------
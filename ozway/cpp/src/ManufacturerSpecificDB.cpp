@@ -26,6 +26,7 @@
 //-----------------------------------------------------------------------------
 
 #include "ManufacturerSpecificDB.h"
+#include "ConfigBundle.h"
 #include "tinyxml.h"
 
 #include "Options.h"
@@ -89,16 +90,12 @@ namespace OpenZWave
 //-----------------------------------------------------------------------------
 		void ManufacturerSpecificDB::LoadConfigFileRevision(ProductDescriptor *product)
 		{
-			// Parse the Z-Wave manufacturer and product XML file.
-			string configPath;
-			Options::Get()->GetOptionAsString("ConfigPath", &configPath);
-
 			if (product->GetConfigPath().size() > 0)
 			{
-				string path = configPath + product->GetConfigPath();
+				string path;
 
 				TiXmlDocument* pDoc = new TiXmlDocument();
-				if (!pDoc->LoadFile(path.c_str(), TIXML_ENCODING_UTF8))
+				if (!ConfigBundle::LoadDocument(product->GetConfigPath(), pDoc, &path))
 				{
 					delete pDoc;
 					Log::Write(LogLevel_Info, "Unable to load config file %s", path.c_str());
@@ -138,40 +135,51 @@ namespace OpenZWave
 		{
 			LockGuard LG(m_MfsMutex);
 
-			// Parse the Z-Wave manufacturer and product XML file.
-			string configPath;
-			Options::Get()->GetOptionAsString("ConfigPath", &configPath);
+			// The precompiled bundle already holds the flattened manufacturer and product tables
+			if (LoadProductBundle())
+			{
+				return true;
+			}
 
-			string filename = configPath + "manufacturer_specific.xml";
+			// Parse the Z-Wave manufacturer and product XML file.
+			string filename;
 
-			TiXmlDocument* pDoc = new TiXmlDocument();
-			if (!pDoc->LoadFile(filename.c_str(), TIXML_ENCODING_UTF8))
+			TiXmlStreamReader reader;
+			if (!ConfigBundle::LoadStream("manufacturer_specific.xml", &reader, &filename))
 			{
-				delete pDoc;
 				Log::Write(LogLevel_Info, "Unable to load %s", filename.c_str());
 				return false;
 			}
-			pDoc->SetUserData((void *) filename.c_str());
-			TiXmlElement const* root = pDoc->RootElement();
+			reader.Document()->SetUserData((void *) filename.c_str());
+			TiXmlElement const* root = reader.RootElement();
 
 			char const* str;
 			char* pStopChar;
 
+			int32 revision = 0;
 			str = root->Attribute("Revision");
 			if (str)
 			{
 				Log::Write(LogLevel_Info, "Manufacturer_Specific.xml file Revision is %s", str);
-				m_revision = atoi(str);
+				revision = atoi(str);
 			}
 			else
 			{
 				Log::Write(LogLevel_Warning, "Manufacturer_Specific.xml file has no Revision");
-				m_revision = 0;
 			}
 
-			TiXmlElement const* manufacturerElement = root->FirstChildElement();
-			while (manufacturerElement)
+			// The tables are only updated once the whole file has parsed, so that a truncated or
+			// corrupt file is rejected as a whole, as it was when it was loaded as a document
+			map<uint16, string> manufacturers;
+			vector<ProductDescriptor*> products;
+			bool ok = true;
+			while (ok)
 			{
+				TiXmlElement const* manufacturerElement = reader.NextElement();
+				if (!manufacturerElement)
+				{
+					break;
+				}
 				str = manufacturerElement->Value();
 				if (str && !strcmp(str, "Manufacturer"))
 				{
@@ -180,8 +188,8 @@ namespace OpenZWave
 					if (!str)
 					{
 						Log::Write(LogLevel_Info, "Error in manufacturer_specific.xml at line %d - missing manufacturer id attribute", manufacturerElement->Row());
-						delete pDoc;
-						return false;
+						ok = false;
+						break;
 					}
 					uint16 manufacturerId = (uint16) strtol(str, &pStopChar, 16);
 
@@ -189,12 +197,12 @@ namespace OpenZWave
 					if (!str)
 					{
 						Log::Write(LogLevel_Info, "Error in manufacturer_specific.xml at line %d - missing manufacturer name attribute", manufacturerElement->Row());
-						delete pDoc;
-						return false;
+						ok = false;
+						break;
 					}
 
 					// Add this manufacturer to the map
-					s_manufacturerMap[manufacturerId] = str;
+					manufacturers[manufacturerId] = str;
 
 					// Parse all the products for this manufacturer
 					TiXmlElement const* productElement = manufacturerElement->FirstChildElement();
@@ -207,8 +215,8 @@ namespace OpenZWave
 							if (!str)
 							{
 								Log::Write(LogLevel_Info, "Error in manufacturer_specific.xml at line %d - missing product type attribute", productElement->Row());
-								delete pDoc;
-								return false;
+								ok = false;
+								break;
 							}
 							uint16 productType = (uint16) strtol(str, &pStopChar, 16);
 
@@ -216,8 +224,8 @@ namespace OpenZWave
 							if (!str)
 							{
 								Log::Write(LogLevel_Info, "Error in manufacturer_specific.xml at line %d - missing product id attribute", productElement->Row());
-								delete pDoc;
-								return false;
+								ok = false;
+								break;
 							}
 							uint16 productId = (uint16) strtol(str, &pStopChar, 16);
 
@@ -225,8 +233,8 @@ namespace OpenZWave
 							if (!str)
 							{
 								Log::Write(LogLevel_Info, "Error in manufacturer_specific.xml at line %d - missing product name attribute", productElement->Row());
-								delete pDoc;
-								return false;
+								ok = false;
+								break;
 							}
 							string productName = str;
 
@@ -238,32 +246,96 @@ namespace OpenZWave
 								dconfigPath = str;
 							}
 
-							// Add the product to the map
-							ProductDescriptor* product = new ProductDescriptor(manufacturerId, productType, productId, productName, s_manufacturerMap[manufacturerId], dconfigPath);
-							if (s_productMap[product->GetKey()] != NULL)
-							{
-								std::shared_ptr<ProductDescriptor> c = s_productMap[product->GetKey()];
-								Log::Write(LogLevel_Info, "Product name collision: %s type %x id %x manufacturerid %x, collides with %s, type %x id %x manufacturerid %x", productName.c_str(), productType, productId, manufacturerId, c->GetProductName().c_str(), c->GetProductType(), c->GetProductId(), c->GetManufacturerId());
-								delete product;
-							}
-							else
-							{
-								LoadConfigFileRevision(product);
-								s_productMap[product->GetKey()] = std::shared_ptr<ProductDescriptor>(product);
-							}
+							products.push_back(new ProductDescriptor(manufacturerId, productType, productId, productName, manufacturers[manufacturerId], dconfigPath));
 						}
 
 						// Move on to the next product.
 						productElement = productElement->NextSiblingElement();
 					}
 				}
+			}
+			if (reader.Error())
+			{
+				Log::Write(LogLevel_Warning, "Error in %s at line %d: %s", filename.c_str(), reader.ErrorRow(), reader.ErrorDesc());
+				ok = false;
+			}
+			if (!ok)
+			{
+				for (vector<ProductDescriptor*>::iterator it = products.begin(); it != products.end(); ++it)
+				{
+					delete *it;
+				}
+				return false;
+			}
 
-				// Move on to the next manufacturer.
-				manufacturerElement = manufacturerElement->NextSiblingElement();
+			m_revision = revision;
+			for (map<uint16, string>::iterator it = manufacturers.begin(); it != manufacturers.end(); ++it)
+			{
+				s_manufacturerMap[it->first] = it->second;
+			}
+			for (vector<ProductDescriptor*>::iterator it = products.begin(); it != products.end(); ++it)
+			{
+				// Add the product to the map
+				ProductDescriptor* product = *it;
+				if (s_productMap[product->GetKey()] != NULL)
+				{
+					std::shared_ptr<ProductDescriptor> c = s_productMap[product->GetKey()];
+					Log::Write(LogLevel_Info, "Product name collision: %s type %x id %x manufacturerid %x, collides with %s, type %x id %x manufacturerid %x", product->GetProductName().c_str(), product->GetProductType(), product->GetProductId(), product->GetManufacturerId(), c->GetProductName().c_str(), c->GetProductType(), c->GetProductId(), c->GetManufacturerId());
+					delete product;
+				}
+				else
+				{
+					LoadConfigFileRevision(product);
+					s_productMap[product->GetKey()] = std::shared_ptr<ProductDescriptor>(product);
+				}
 			}
 			s_bXmlLoaded = true;
 
-			delete pDoc;
+			return true;
+		}
+
+//-----------------------------------------------------------------------------
+// <ManufacturerSpecificDB::LoadProductBundle>
+// Populate the manufacturer and product maps from the precompiled config bundle
+//-----------------------------------------------------------------------------
+		bool ManufacturerSpecificDB::LoadProductBundle()
+		{
+			ConfigBundle* bundle = ConfigBundle::Get();
+			if (!bundle || !bundle->IsValid("manufacturer_specific.xml"))
+			{
+				return false;
+			}
+
+			m_revision = bundle->GetMfsRevision();
+			Log::Write(LogLevel_Info, "Manufacturer_Specific.xml Revision %d loaded from the Config Bundle", m_revision);
+
+			for (uint32 i = 0; i < bundle->GetManufacturerCount(); ++i)
+			{
+				Bundle::Manufacturer const* manufacturer = bundle->GetManufacturer(i);
+				s_manufacturerMap[manufacturer->m_id] = bundle->GetString(manufacturer->m_name);
+			}
+
+			for (uint32 i = 0; i < bundle->GetProductCount(); ++i)
+			{
+				Bundle::Product const* p = bundle->GetProduct(i);
+				int64 key = ProductDescriptor::GetKey(p->m_manufacturerId, p->m_productType, p->m_productId);
+				if (s_productMap.find(key) != s_productMap.end())
+				{
+					continue;
+				}
+				ProductDescriptor* product = new ProductDescriptor(p->m_manufacturerId, p->m_productType, p->m_productId, bundle->GetString(p->m_name), s_manufacturerMap[p->m_manufacturerId], bundle->GetString(p->m_config));
+				if (product->GetConfigPath().size() > 0 && !bundle->IsValid(product->GetConfigPath()))
+				{
+					// this config file has been updated since the bundle was built
+					LoadConfigFileRevision(product);
+				}
+				else
+				{
+					product->SetConfigRevision(p->m_configRevision);
+				}
+				s_productMap[key] = std::shared_ptr<ProductDescriptor>(product);
+			}
+			s_bXmlLoaded = true;
 			return true;
 		}
 
@@ -301,7 +373,7 @@ namespace OpenZWave
 				LoadProductXML();
 
 			string configPath;
-			Options::Get()->GetOptionAsString("ConfigPath", &configPath);
+			Options::Get()->GetOptionAsString(Options::OptionKey_ConfigPath, &configPath);
 
 			map<int64, std::shared_ptr<ProductDescriptor> >::iterator pit;
 			for (pit = s_productMap.begin(); pit != s_productMap.end(); pit++)
@@ -346,6 +418,10 @@ namespace OpenZWave
 			if (iter != m_downloading.end())
 			{
 				m_downloading.erase(iter);
+				if (success)
+				{
+					InvalidateBundleFile(file);
+				}
 				if ((node > 0) && success)
 				{
 					driver->refreshNodeConfig(node);
@@ -371,6 +447,7 @@ namespace OpenZWave
 				m_downloading.erase(iter);
 				if (success)
 				{
+					InvalidateBundleFile(file);
 					UnloadProductXML();
 					LoadProductXML();
 					checkConfigFiles(driver);
@@ -383,6 +460,23 @@ namespace OpenZWave
 			checkInitialized();
 		}
 
+//-----------------------------------------------------------------------------
+// <ManufacturerSpecificDB::InvalidateBundleFile>
+// A downloaded file supersedes the copy held in the config bundle
+//-----------------------------------------------------------------------------
+		void ManufacturerSpecificDB::InvalidateBundleFile(string const& _file)
+		{
+			if (ConfigBundle* bundle = ConfigBundle::Get())
+			{
+				string configPath;
+				Options::Get()->GetOptionAsString(Options::OptionKey_ConfigPath, &configPath);
+				if (_file.compare(0, configPath.size(), configPath) == 0)
+				{
+					bundle->Invalidate(_file.substr(configPath.size()));
+				}
+			}
+		}
+
 		bool ManufacturerSpecificDB::isReady()
 		{
 			if (!m_initializing && (m_downloading.size() == 0))
@@ -426,7 +520,7 @@ namespace OpenZWave
 		{
 			string configPath;
 			bool ret = false;
-			Options::Get()->GetOptionAsString("ConfigPath", &configPath);
+			Options::Get()->GetOptionAsString(Options::OptionKey_ConfigPath, &configPath);
 			string path = configPath + node->getConfigPath();
 
 			if (driver->startConfigDownload(node->GetManufacturerId(), node->GetProductType(), node->GetProductId(), path, node->GetNodeId()))
@@ -448,7 +542,7 @@ namespace OpenZWave
 		{
 			bool ret = false;
 			string configPath;
-			Options::Get()->GetOptionAsString("ConfigPath", &configPath);
+			Options::Get()->GetOptionAsString(Options::OptionKey_ConfigPath, &configPath);
 			string path = configPath + "manufacturer_specific.xml";
 
 			if (driver->startMFSDownload(path))
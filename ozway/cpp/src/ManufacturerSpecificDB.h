@@ -149,6 +149,8 @@ namespace OpenZWave
 
 			private:
 				void LoadConfigFileRevision(ProductDescriptor *product);
+				bool LoadProductBundle();
+				void InvalidateBundleFile(string const& _file);
 				ManufacturerSpecificDB();
 				~ManufacturerSpecificDB();
 
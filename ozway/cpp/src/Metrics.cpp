@@ -0,0 +1,476 @@
+//-----------------------------------------------------------------------------
+//
+//	Metrics.cpp
+//
+//	Registry of counters, gauges and histograms, exported in the Prometheus
+//	text format
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#if !defined WIN32 && !defined WINRT
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#include "Metrics.h"
+#include "Options.h"
+#include "Utils.h"
+#include "platform/Event.h"
+#include "platform/Log.h"
+#include "platform/Mutex.h"
+#include "platform/Thread.h"
+
+namespace OpenZWave
+{
+	namespace Internal
+	{
+
+		Metrics* Metrics::s_instance = NULL;
+
+//-----------------------------------------------------------------------------
+// <Histogram::Histogram>
+// Constructor
+//-----------------------------------------------------------------------------
+		Histogram::Histogram(vector<uint32> const& _bounds) :
+				m_bounds(_bounds), m_buckets(new std::atomic<uint64>[_bounds.size() + 1]), m_sum(0)
+		{
+			for (size_t i = 0; i <= m_bounds.size(); ++i)
+			{
+				m_buckets[i] = 0;
+			}
+		}
+
+//-----------------------------------------------------------------------------
+// <Histogram::~Histogram>
+// Destructor
+//-----------------------------------------------------------------------------
+		Histogram::~Histogram()
+		{
+			delete[] m_buckets;
+		}
+
+//-----------------------------------------------------------------------------
+// <Histogram::Observe>
+// Count a value in its bucket
+//-----------------------------------------------------------------------------
+		void Histogram::Observe(uint32 const _value)
+		{
+			size_t i = 0;
+			while (i < m_bounds.size() && _value > m_bounds[i])
+			{
+				++i;
+			}
+			m_buckets[i].fetch_add(1, std::memory_order_relaxed);
+			m_sum.fetch_add(_value, std::memory_order_relaxed);
+		}
+
+//-----------------------------------------------------------------------------
+// <Metrics::Create>
+// Static creation of the singleton.  Starts exporting if the MetricsExport option is set
+//-----------------------------------------------------------------------------
+		Metrics* Metrics::Create()
+		{
+			if (s_instance == NULL)
+			{
+				s_instance = new Metrics();
+
+				Options::Get()->GetOptionAsString(Options::OptionKey_MetricsExport, &s_instance->m_exportPath);
+				Options::Get()->GetOptionAsInt(Options::OptionKey_MetricsExportInterval, &s_instance->m_exportInterval);
+				if (s_instance->m_exportInterval < 1000)
+				{
+					s_instance->m_exportInterval = 1000;
+				}
+				if (!s_instance->m_exportPath.empty())
+				{
+					s_instance->m_exportThread = new Platform::Thread("metrics");
+					s_instance->m_exportThread->Start(Metrics::ExportThreadEntryPoint, s_instance);
+				}
+			}
+			return s_instance;
+		}
+
+//-----------------------------------------------------------------------------
+// <Metrics::Destroy>
+// Static method to destroy the singleton
+//-----------------------------------------------------------------------------
+		void Metrics::Destroy()
+		{
+			delete s_instance;
+			s_instance = NULL;
+		}
+
+//-----------------------------------------------------------------------------
+// <Metrics::Metrics>
+// Constructor
+//-----------------------------------------------------------------------------
+		Metrics::Metrics() :
+				m_mutex(new Platform::Mutex("metrics")), m_exportThread(NULL), m_exportInterval(10000)
+		{
+		}
+
+//-----------------------------------------------------------------------------
+// <Metrics::~Metrics>
+// Destructor
+//-----------------------------------------------------------------------------
+		Metrics::~Metrics()
+		{
+			if (m_exportThread)
+			{
+				m_exportThread->Stop();
+				m_exportThread->Release();
+			}
+			for (vector<Family>::iterator fit = m_families.begin(); fit != m_families.end(); ++fit)
+			{
+				for (vector<Series>::iterator sit = fit->m_series.begin(); sit != fit->m_series.end(); ++sit)
+				{
+					delete sit->m_histogram;
+				}
+			}
+			m_mutex->Release();
+		}
+
+//-----------------------------------------------------------------------------
+// <Metrics::Add>
+// Add a series to its family, creating the family if this is the first one
+//-----------------------------------------------------------------------------
+		bool Metrics::Add(string const& _name, string const& _help, Type const _type, Series const& _series)
+		{
+			LockGuard LG(m_mutex);
+			for (vector<Family>::iterator it = m_families.begin(); it != m_families.end(); ++it)
+			{
+				if (it->m_name == _name)
+				{
+					if (it->m_type != _type)
+					{
+						Log::Write(LogLevel_Error, "Metric %s has already been added with a different type", _name.c_str());
+						return false;
+					}
+					it->m_series.push_back(_series);
+					return true;
+				}
+			}
+			Family family;
+			family.m_name = _name;
+			family.m_help = _help;
+			family.m_type = _type;
+			family.m_series.push_back(_series);
+			m_families.push_back(family);
+			return true;
+		}
+
+//-----------------------------------------------------------------------------
+// <Metrics::AddCounter>
+// Add a counter
+//-----------------------------------------------------------------------------
+		void Metrics::AddCounter(void const* _owner, string const& _name, string const& _help, string const& _labels, std::atomic<uint32> const* _value)
+		{
+			Series series = { _owner, _labels, _value, NULL, NULL, NULL };
+			Add(_name, _help, Type_Counter, series);
+		}
+
+//-----------------------------------------------------------------------------
+// <Metrics::AddGauge>
+// Add a gauge
+//-----------------------------------------------------------------------------
+		void Metrics::AddGauge(void const* _owner, string const& _name, string const& _help, string const& _labels, pfnGauge_t _gauge, void* _context)
+		{
+			Series series = { _owner, _labels, NULL, _gauge, _context, NULL };
+			Add(_name, _help, Type_Gauge, series);
+		}
+
+//-----------------------------------------------------------------------------
+// <Metrics::AddHistogram>
+// Add a histogram
+//-----------------------------------------------------------------------------
+		Histogram* Metrics::AddHistogram(void const* _owner, string const& _name, string const& _help, string const& _labels, vector<uint32> const& _bounds)
+		{
+			Histogram* histogram = new Histogram(_bounds);
+			Series series = { _owner, _labels, NULL, NULL, NULL, histogram };
+			if (!Add(_name, _help, Type_Histogram, series))
+			{
+				delete histogram;
+				return NULL;
+			}
+			return histogram;
+		}
+
+//-----------------------------------------------------------------------------
+// <Metrics::Remove>
+// Remove an owner's series
+//-----------------------------------------------------------------------------
+		void Metrics::Remove(void const* _owner)
+		{
+			LockGuard LG(m_mutex);
+			for (vector<Family>::iterator fit = m_families.begin(); fit != m_families.end(); ++fit)
+			{
+				vector<Series>::iterator sit = fit->m_series.begin();
+				while (sit != fit->m_series.end())
+				{
+					if (sit->m_owner == _owner)
+					{
+						delete sit->m_histogram;
+						sit = fit->m_series.erase(sit);
+					}
+					else
+					{
+						++sit;
+					}
+				}
+			}
+		}
+
+//-----------------------------------------------------------------------------
+// <Metrics::Label>
+// Format a label
+//-----------------------------------------------------------------------------
+		string Metrics::Label(string const& _name, string const& _value)
+		{
+			string label = _name + "=\"";
+			for (string::const_iterator it = _value.begin(); it != _value.end(); ++it)
+			{
+				if (*it == '\\' || *it == '"')
+				{
+					label += '\\';
+					label += *it;
+				}
+				else if (*it == '\n')
+				{
+					label += "\\n";
+				}
+				else
+				{
+					label += *it;
+				}
+			}
+			return label + "\"";
+		}
+
+//-----------------------------------------------------------------------------
+// <Metrics::Export>
+// Format every series in the Prometheus text format
+//-----------------------------------------------------------------------------
+		string Metrics::Export()
+		{
+			string text;
+			char buf[64];
+			LockGuard LG(m_mutex);
+			for (vector<Family>::iterator fit = m_families.begin(); fit != m_families.end(); ++fit)
+			{
+				if (fit->m_series.empty())
+				{
+					continue;
+				}
+				static char const* const c_typeNames[] = { "counter", "gauge", "histogram" };
+				text += "# HELP " + fit->m_name + " " + fit->m_help + "\n";
+				text += "# TYPE " + fit->m_name + " " + c_typeNames[fit->m_type] + "\n";
+
+				for (vector<Series>::iterator sit = fit->m_series.begin(); sit != fit->m_series.end(); ++sit)
+				{
+					string labels = sit->m_labels.empty() ? "" : "{" + sit->m_labels + "}";
+					switch (fit->m_type)
+					{
+						case Type_Counter:
+						{
+							snprintf(buf, sizeof(buf), " %u\n", (uint32) *sit->m_counter);
+							text += fit->m_name + labels + buf;
+							break;
+						}
+						case Type_Gauge:
+						{
+							snprintf(buf, sizeof(buf), " %lld\n", (long long) sit->m_gauge(sit->m_context));
+							text += fit->m_name + labels + buf;
+							break;
+						}
+						case Type_Histogram:
+						{
+							Histogram const* histogram = sit->m_histogram;
+							string prefix = sit->m_labels.empty() ? "{" : "{" + sit->m_labels + ",";
+							uint64 count = 0;
+							for (size_t i = 0; i <= histogram->m_bounds.size(); ++i)
+							{
+								count += histogram->m_buckets[i].load(std::memory_order_relaxed);
+								if (i < histogram->m_bounds.size())
+								{
+									snprintf(buf, sizeof(buf), "le=\"%u\"} %llu\n", histogram->m_bounds[i], (unsigned long long) count);
+								}
+								else
+								{
+									snprintf(buf, sizeof(buf), "le=\"+Inf\"} %llu\n", (unsigned long long) count);
+								}
+								text += fit->m_name + "_bucket" + prefix + buf;
+							}
+							snprintf(buf, sizeof(buf), " %llu\n", (unsigned long long) histogram->m_sum.load(std::memory_order_relaxed));
+							text += fit->m_name + "_sum" + labels + buf;
+							snprintf(buf, sizeof(buf), " %llu\n", (unsigned long long) count);
+							text += fit->m_name + "_count" + labels + buf;
+							break;
+						}
+					}
+				}
+			}
+			return text;
+		}
+
+//-----------------------------------------------------------------------------
+// <Metrics::ExportThreadEntryPoint>
+// Entry point of the export thread
+//-----------------------------------------------------------------------------
+		void Metrics::ExportThreadEntryPoint(Platform::Event* _exitEvent, void* _context)
+		{
+			Metrics* metrics = (Metrics*) _context;
+			if (metrics)
+			{
+				metrics->ExportThreadProc(_exitEvent);
+			}
+		}
+
+//-----------------------------------------------------------------------------
+// <Metrics::ExportThreadProc>
+// Export until told to exit
+//-----------------------------------------------------------------------------
+		void Metrics::ExportThreadProc(Platform::Event* _exitEvent)
+		{
+			if (m_exportPath.compare(0, 5, "unix:") == 0)
+			{
+				ExportToSocket(_exitEvent);
+				return;
+			}
+
+			Log::Write(LogLevel_Info, "Exporting metrics to %s every %d ms", m_exportPath.c_str(), m_exportInterval);
+			bool ok = true;
+			do
+			{
+				// only log the first of a run of failures
+				bool written = ExportToFile();
+				if (!written && ok)
+				{
+					Log::Write(LogLevel_Warning, "Failed to export metrics to %s", m_exportPath.c_str());
+				}
+				ok = written;
+			} while (Platform::Wait::Single(_exitEvent, m_exportInterval) < 0);
+		}
+
+//-----------------------------------------------------------------------------
+// <Metrics::ExportToFile>
+// Write the metrics to a temporary file and move it into place, so that a
+// collector never reads half a file
+//-----------------------------------------------------------------------------
+		bool Metrics::ExportToFile()
+		{
+			string text = Export();
+			string tmp = m_exportPath + ".tmp";
+			FILE* file = fopen(tmp.c_str(), "w");
+			if (!file)
+			{
+				return false;
+			}
+			bool ok = (fwrite(text.data(), 1, text.size(), file) == text.size());
+			ok = (fclose(file) == 0) && ok;
+#if defined WIN32 || defined WINRT
+			// rename does not replace an existing file here
+			remove(m_exportPath.c_str());
+#endif
+			return ok && (rename(tmp.c_str(), m_exportPath.c_str()) == 0);
+		}
+
+//-----------------------------------------------------------------------------
+// <Metrics::ExportToSocket>
+// Listen on a local socket, and send the metrics to each connection
+//-----------------------------------------------------------------------------
+		void Metrics::ExportToSocket(Platform::Event* _exitEvent)
+		{
+#if !defined WIN32 && !defined WINRT
+			string path = m_exportPath.substr(5);
+			struct sockaddr_un addr;
+			memset(&addr, 0, sizeof(addr));
+			addr.sun_family = AF_UNIX;
+			if (path.empty() || path.size() >= sizeof(addr.sun_path))
+			{
+				Log::Write(LogLevel_Error, "Invalid metrics socket path %s", path.c_str());
+				return;
+			}
+			strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+			int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (fd < 0)
+			{
+				Log::Write(LogLevel_Error, "Failed to create the metrics socket: %s", strerror(errno));
+				return;
+			}
+			// remove the socket left behind by a previous run
+			unlink(path.c_str());
+			if (bind(fd, (struct sockaddr*) &addr, sizeof(addr)) != 0 || listen(fd, 4) != 0)
+			{
+				Log::Write(LogLevel_Error, "Failed to listen for metrics on %s: %s", path.c_str(), strerror(errno));
+				close(fd);
+				return;
+			}
+			Log::Write(LogLevel_Info, "Serving metrics on %s", path.c_str());
+
+			// accept does not wake up for the exit event, so poll with a short timeout
+			while (Platform::Wait::Single(_exitEvent, Platform::Wait::Timeout_Immediate) < 0)
+			{
+				struct pollfd pfd;
+				pfd.fd = fd;
+				pfd.events = POLLIN;
+				pfd.revents = 0;
+				if (poll(&pfd, 1, 250) <= 0)
+				{
+					continue;
+				}
+				int client = accept(fd, NULL, NULL);
+				if (client < 0)
+				{
+					continue;
+				}
+				string text = Export();
+				size_t sent = 0;
+				while (sent < text.size())
+				{
+#ifdef MSG_NOSIGNAL
+					ssize_t res = send(client, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+#else
+					ssize_t res = send(client, text.data() + sent, text.size() - sent, 0);
+#endif
+					if (res <= 0)
+					{
+						break;
+					}
+					sent += (size_t) res;
+				}
+				close(client);
+			}
+
+			close(fd);
+			unlink(path.c_str());
+#else
+			Log::Write(LogLevel_Warning, "Exporting metrics to a local socket is not supported on this platform");
+#endif
+		}
+	} // namespace Internal
+} // namespace OpenZWave
@@ -0,0 +1,178 @@
+//-----------------------------------------------------------------------------
+//
+//	Metrics.h
+//
+//	Registry of counters, gauges and histograms, exported in the Prometheus
+//	text format
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef _Metrics_H
+#define _Metrics_H
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include "Defs.h"
+
+namespace OpenZWave
+{
+	namespace Internal
+	{
+		namespace Platform
+		{
+			class Event;
+			class Mutex;
+			class Thread;
+		}
+
+		/** \brief A histogram of values (usually times in ms) in fixed buckets.
+		 *
+		 * Observe only uses relaxed atomics, so it can be called from any thread.
+		 */
+		class Histogram
+		{
+			public:
+				/**
+				 * \param _bounds the upper bound of each bucket, in increasing order.  Values above
+				 * the last bound are only counted in the +Inf bucket.
+				 */
+				Histogram(vector<uint32> const& _bounds);
+				~Histogram();
+
+				void Observe(uint32 const _value);
+
+			private:
+				Histogram(Histogram const&);					// prevent copy
+				Histogram& operator =(Histogram const&);		// prevent assignment
+
+				friend class Metrics;
+
+				vector<uint32> m_bounds;
+				std::atomic<uint64>* m_buckets;					// Not cumulative.  One more than m_bounds, for +Inf.
+				std::atomic<uint64> m_sum;
+		};
+
+		/** \brief Registry of the library's metrics.
+		 *
+		 * Every metric belongs to a family, which has a name, a help text and a type.  Each
+		 * owner (usually a Driver) adds its own series to a family, with labels that tell the
+		 * owners apart, and removes them all again when it goes away.  The values themselves
+		 * stay where they are: counters are atomics owned by the caller, and gauges are read
+		 * through a callback, so updating a metric costs no more than it did before.
+		 *
+		 * If the MetricsExport option is set, the metrics are also exported in the Prometheus
+		 * text format, either rewritten to a file every MetricsExportInterval ms (for the
+		 * textfile collector), or served to anything that connects to a local socket when the
+		 * option is "unix:" followed by the socket path.
+		 */
+		class Metrics
+		{
+			public:
+				static Metrics* Create();
+				static Metrics* Get()
+				{
+					return s_instance;
+				}
+				static void Destroy();
+
+				typedef int64 (*pfnGauge_t)(void* _context);
+
+				/**
+				 * Add a counter.
+				 * \param _owner identifies the series, for Remove
+				 * \param _name the family name, which should end in _total
+				 * \param _help describes the family
+				 * \param _labels the labels of this series, eg controller="/dev/ttyACM0".  See Label.
+				 * \param _value the counter, which must outlive the series
+				 */
+				void AddCounter(void const* _owner, string const& _name, string const& _help, string const& _labels, std::atomic<uint32> const* _value);
+				/**
+				 * Add a gauge, which is read by calling _gauge(_context) on each export.
+				 */
+				void AddGauge(void const* _owner, string const& _name, string const& _help, string const& _labels, pfnGauge_t _gauge, void* _context);
+				/**
+				 * Add a histogram.  The registry owns it, and deletes it in Remove.
+				 * \return the histogram, or NULL if _name is already a different type of metric
+				 */
+				Histogram* AddHistogram(void const* _owner, string const& _name, string const& _help, string const& _labels, vector<uint32> const& _bounds);
+				/**
+				 * Remove every series added by _owner.
+				 */
+				void Remove(void const* _owner);
+
+				/**
+				 * Format a label, escaping the value as the text format requires.
+				 */
+				static string Label(string const& _name, string const& _value);
+
+				/**
+				 * All the metrics in the Prometheus text format.
+				 */
+				string Export();
+
+			private:
+				Metrics();
+				~Metrics();
+
+				enum Type
+				{
+					Type_Counter,
+					Type_Gauge,
+					Type_Histogram
+				};
+				struct Series
+				{
+						void const* m_owner;
+						string m_labels;
+						std::atomic<uint32> const* m_counter;
+						pfnGauge_t m_gauge;
+						void* m_context;
+						Histogram* m_histogram;
+				};
+				struct Family
+				{
+						string m_name;
+						string m_help;
+						Type m_type;
+						vector<Series> m_series;
+				};
+				bool Add(string const& _name, string const& _help, Type const _type, Series const& _series);
+
+				static void ExportThreadEntryPoint(Platform::Event* _exitEvent, void* _context);
+				void ExportThreadProc(Platform::Event* _exitEvent);
+				bool ExportToFile();
+				void ExportToSocket(Platform::Event* _exitEvent);
+
+				Platform::Mutex* m_mutex;
+				vector<Family> m_families;						// In the order they were first added
+				Platform::Thread* m_exportThread;
+				string m_exportPath;
+				int32 m_exportInterval;
+
+				static Metrics* s_instance;
+		};
+	} // namespace Internal
+} // namespace OpenZWave
+
+#endif
@@ -51,7 +51,7 @@ namespace OpenZWave
 				uint8 const _expectedReply,			// = 0
 				uint8 const _expectedCommandClassId	// = 0
 				) :
-				m_logText(_logText), m_bFinal(false), m_bCallbackRequired(_bCallbackRequired), m_callbackId(0), m_expectedReply(0), m_expectedCommandClassId(_expectedCommandClassId), m_length(4), m_targetNodeId(_targetNodeId), m_sendAttempts(0), m_maxSendAttempts( MAX_TRIES), m_instance(1), m_endPoint(0), m_flags(0), m_encrypted(false), m_noncerecvd(false), m_homeId(0)
+				m_logText(_logText), m_bFinal(false), m_bCallbackRequired(_bCallbackRequired), m_callbackId(0), m_expectedReply(0), m_expectedCommandClassId(_expectedCommandClassId), m_length(4), m_hash(0), m_targetNodeId(_targetNodeId), m_sendAttempts(0), m_maxSendAttempts( MAX_TRIES), m_instance(1), m_endPoint(0), m_flags(0), m_encrypted(false), m_noncerecvd(false), m_homeId(0)
 		{
 			if (_bReplyRequired)
 			{
@@ -168,6 +168,14 @@ namespace OpenZWave
 			}
 			m_buffer[m_length++] = checksum;
 
+			// FNV-1a over the bytes operator== compares
+			uint8 length = m_length - (m_bCallbackRequired ? 2 : 1);
+			m_hash = 2166136261u;
+			for (uint32 i = 0; i < length; ++i)
+			{
+				m_hash = (m_hash ^ m_buffer[i]) * 16777619u;
+			}
+
 			m_bFinal = true;
 		}
 
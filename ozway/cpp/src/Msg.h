@@ -169,9 +169,17 @@ namespace OpenZWave
 					return (m_bFinal && (m_length == 11) && (m_buffer[3] == 0x13) && (m_buffer[6] == 0x00) && (m_buffer[7] == 0x00));
 				}
 
+				/**
+				 * \brief A hash of the finalized frame, ignoring the callback Id and checksum, so that equal messages have equal hashes.
+				 */
+				uint32 GetHash() const
+				{
+					return m_hash;
+				}
+
 				bool operator ==(Msg const& _other) const
 				{
-					if (m_bFinal && _other.m_bFinal)
+					if (m_bFinal && _other.m_bFinal && (m_hash == _other.m_hash) && (m_length == _other.m_length))
 					{
 						// Do not include the callback Id or checksum in the comparison.
 						uint8 length = m_length - (m_bCallbackRequired ? 2 : 1);
@@ -180,6 +188,20 @@ namespace OpenZWave
 
 					return false;
 				}
+				/**
+				 * \brief For a FUNC_ID_ZW_SEND_DATA message, the command (with any Multi Channel encapsulation) that is sent to the node.
+				 * \param o_length receives the length of the command
+				 * \return the command, or NULL if this message does not send one.
+				 */
+				uint8 const* GetPayload(uint8* o_length) const
+				{
+					if (m_bFinal && (m_buffer[3] == FUNC_ID_ZW_SEND_DATA))
+					{
+						*o_length = m_buffer[5];
+						return &m_buffer[6];
+					}
+					return NULL;
+				}
 				uint8 GetSendingCommandClass()
 				{
 					if (m_buffer[3] == 0x13)
@@ -233,6 +255,7 @@ namespace OpenZWave
 				uint8 m_expectedCommandClassId;
 				uint8 m_length;
 				uint8 m_buffer[256];
+				uint32 m_hash;					// set by Finalize (see GetHash)
 				uint8 e_buffer[256];
 
 				uint8 m_targetNodeId;
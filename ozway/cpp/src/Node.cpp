@@ -35,6 +35,7 @@
 #include "Driver.h"
 #include "Localization.h"
 #include "ManufacturerSpecificDB.h"
+#include "ConfigBundle.h"
 #include "Notification.h"
 #include "Msg.h"
 #include "platform/Log.h"
@@ -98,7 +99,7 @@ static char const* c_queryStageNames[] =
 // Constructor
 //-----------------------------------------------------------------------------
 Node::Node(uint32 const _homeId, uint8 const _nodeId) :
-		m_queryStage(QueryStage_None), m_queryPending(false), m_queryConfiguration(false), m_queryRetries(0), m_protocolInfoReceived(false), m_basicprotocolInfoReceived(false), m_nodeInfoReceived(false), m_nodePlusInfoReceived(false), m_manufacturerSpecificClassReceived(false), m_nodeInfoSupported(true), m_refreshonNodeInfoFrame(true), m_nodeAlive(true),	// assome live node
+		m_mutex(new Internal::Platform::Mutex("node")), m_queryStage(QueryStage_None), m_queryPending(false), m_queryConfiguration(false), m_queryRetries(0), m_protocolInfoReceived(false), m_basicprotocolInfoReceived(false), m_nodeInfoReceived(false), m_nodePlusInfoReceived(false), m_manufacturerSpecificClassReceived(false), m_nodeInfoSupported(true), m_refreshonNodeInfoFrame(true), m_nodeAlive(true),	// assome live node
 		m_listening(true),	// assume we start out listening
 		m_frequentListening(false), m_beaming(false), m_routing(false), m_maxBaudRate(0), m_version(0), m_security(false), m_homeId(_homeId), m_nodeId(_nodeId), m_basic(0), m_generic(0), m_specific(0), m_type(""), m_addingNode(false), m_manufacturerName(""), m_productName(""), m_nodeName(""), m_location(""), m_manufacturerId(0), m_productType(0), m_productId(0), m_deviceType(0), m_role(0), m_nodeType(0), m_secured(false), m_nodeCache( NULL), m_Product( NULL), m_fileConfigRevision(0), m_loadedConfigRevision(
 				0), m_latestConfigRevision(0), m_values(new Internal::VC::ValueStore()), m_sentCnt(0), m_sentFailed(0), m_retries(0), m_receivedCnt(0), m_receivedDups(0), m_receivedUnsolicited(0), m_lastRequestRTT(0), m_lastResponseRTT(0), m_averageRequestRTT(0), m_averageResponseRTT(0), m_quality(0), m_lastReceivedMessage(), m_errors(0), m_txStatusReportSupported(false), m_txTime(0), m_hops(0), m_ackChannel(0), m_lastTxChannel(0), m_routeScheme((TXSTATUS_ROUTING_SCHEME) 0), m_routeUsed
@@ -165,6 +166,7 @@ Node::~Node()
 		m_buttonMap.erase(it);
 	}
 	delete m_nodeCache;
+	m_mutex->Release();
 }
 
 //-----------------------------------------------------------------------------
@@ -1979,7 +1981,7 @@ void Node::ApplicationCommandHandler(uint8 const* _data, bool encrypted
 		{
 			Log::Write(LogLevel_Warning, m_nodeId, "Received a Clear Text Message for the CommandClass %s which is Secured", pCommandClass->GetCommandClassName().c_str());
 			bool drop = true;
-			Options::Get()->GetOptionAsBool("EnforceSecureReception", &drop);
+			Options::Get()->GetOptionAsBool(Options::OptionKey_EnforceSecureReception, &drop);
 			if (drop)
 			{
 				Log::Write(LogLevel_Warning, m_nodeId, "   Dropping Message");
@@ -2856,7 +2858,7 @@ void Node::RemoveAssociation(uint8 const _groupIdx, uint8 const _targetNodeId, u
 void Node::AutoAssociate()
 {
 	bool autoAssociate = false;
-	Options::Get()->GetOptionAsBool("Associate", &autoAssociate);
+	Options::Get()->GetOptionAsBool(Options::OptionKey_Associate, &autoAssociate);
 	if (autoAssociate)
 	{
 		// Try to automatically associate with any groups that have been flagged.
@@ -3249,13 +3251,10 @@ bool Node::AddMandatoryCommandClasses(uint8 const* _commandClasses)
 void Node::ReadDeviceClasses()
 {
 	// Load the XML document that contains the device class information
-	string configPath;
-	Options::Get()->GetOptionAsString("ConfigPath", &configPath);
-
-	string filename = configPath + string("device_classes.xml");
+	string filename;
 
 	TiXmlDocument doc;
-	if (!doc.LoadFile(filename.c_str(), TIXML_ENCODING_UTF8))
+	if (!Internal::ConfigBundle::LoadDocument("device_classes.xml", &doc, &filename))
 	{
 		Log::Write(LogLevel_Info, "Failed to load device_classes.xml");
 		Log::Write(LogLevel_Info, "Check that the config path provided when creating the Manager points to the correct location.");
@@ -3361,8 +3360,36 @@ void Node::GetNodeStatistics(NodeData* _data)
 		ccData.m_commandClassId = it->second->GetCommandClassId();
 		ccData.m_sentCnt = it->second->GetSentCnt();
 		ccData.m_receivedCnt = it->second->GetReceivedCnt();
+		if (LatencyHistogram const* latency = it->second->GetLatency())
+		{
+			for (int i = 0; i < Latency_Count; ++i)
+			{
+				ccData.m_latency[i] = latency[i];
+			}
+		}
 		_data->m_ccData.push_back(ccData);
 	}
+	for (int i = 0; i < Latency_Count; ++i)
+	{
+		_data->m_latency[i] = m_latency[i];
+	}
+}
+
+//-----------------------------------------------------------------------------
+// <Node::RecordLatency>
+// Count a latency in the node's histogram and the command class's
+//-----------------------------------------------------------------------------
+void Node::RecordLatency(Latency const _kind, uint8 const _commandClassId, uint32 const _ms)
+{
+	if (_kind >= Latency_Count)
+	{
+		return;
+	}
+	m_latency[_kind].Record(_ms);
+	if (Internal::CC::CommandClass* cc = GetCommandClass(_commandClassId))
+	{
+		cc->RecordLatency(_kind, _ms);
+	}
 }
 
 //-----------------------------------------------------------------------------
@@ -38,6 +38,7 @@
 #include "Msg.h"
 #include "platform/TimeStamp.h"
 #include "Group.h"
+#include "LatencyHistogram.h"
 
 class TiXmlElement;
 class TiXmlNode;
@@ -71,6 +72,7 @@ namespace OpenZWave
 		}
 		class ProductDescriptor;
 		class ManufacturerSpecificDB;
+		class NodeLocks;
 	}
 	class Driver;
 	class Group;
@@ -97,6 +99,7 @@ namespace OpenZWave
 			friend class Internal::CC::Version;
 			friend class Internal::CC::ZWavePlusInfo;
 			friend class Internal::ManufacturerSpecificDB;
+			friend class Internal::NodeLocks;
 
 			//-----------------------------------------------------------------------------
 			// Construction
@@ -118,6 +121,8 @@ namespace OpenZWave
 			 */
 			Driver* GetDriver() const;
 
+			Internal::Platform::Mutex* m_mutex;				// Serializes access to this node's data.  Taken through Internal::NodeLockGuard
+
 			//-----------------------------------------------------------------------------
 			// Initialization
 			//-----------------------------------------------------------------------------
@@ -776,11 +781,21 @@ namespace OpenZWave
 			//	Statistics
 			//-----------------------------------------------------------------------------
 		public:
+			/** The latencies that are kept as histograms, per node and per command class */
+			enum Latency
+			{
+				Latency_Ack = 0,					// Request sent until the node ACKed it
+				Latency_Report,						// Request sent until the node's report arrived
+				Latency_Confirmed,					// Value set until Z-Way confirmed the set
+				Latency_Count
+			};
+
 			struct CommandClassData
 			{
 					uint8 m_commandClassId;
 					uint32 m_sentCnt;
 					uint32 m_receivedCnt;
+					LatencyHistogram m_latency[Latency_Count];
 			};
 
 			struct NodeData
@@ -816,8 +831,21 @@ namespace OpenZWave
 					uint8 m_routeTries;
 					uint8 m_lastFailedLinkFrom;
 					uint8 m_lastFailedLinkTo;
+					uint32 m_queueDepth;				// Messages waiting to be sent to the node
+					uint32 m_averageQueueWait;			// ms messages for the node have waited in the send queues
+					uint32 m_maxQueueWait;				// Longest ms a message for the node has waited in the send queues
+					uint32 m_notificationBacklog;		// Notifications waiting to be delivered (NotificationThreads option only)
+					uint32 m_maxNotificationBacklog;	// Most notifications that have been waiting at once
+					uint32 m_averageNotificationDelay;	// ms notifications have waited to be delivered
+					uint32 m_maxNotificationDelay;		// Longest ms a notification has waited to be delivered
+					LatencyHistogram m_latency[Latency_Count];	// See Latency.  GetPercentile(99) gives the p99.
 			};
 
+			/**
+			 * Count a latency in the node's histogram, and in the command class's if the node has it.
+			 */
+			void RecordLatency(Latency const _kind, uint8 const _commandClassId, uint32 const _ms);
+
 		private:
 			void GetNodeStatistics(NodeData* _data);
 
@@ -852,6 +880,7 @@ namespace OpenZWave
 			uint8 m_routeTries;					// The number of attempts to route the last frame
 			uint8 m_lastFailedLinkFrom;			// The last failed link from
 			uint8 m_lastFailedLinkTo;			// The last failed link to
+			LatencyHistogram m_latency[Latency_Count];	// Latencies of the node as a whole
 
 			//-----------------------------------------------------------------------------
 			//	Encryption Related
@@ -0,0 +1,193 @@
+//-----------------------------------------------------------------------------
+//
+//	NodeLocks.cpp
+//
+//	The locks on the node list and on the individual nodes
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#include "NodeLocks.h"
+#include "platform/Event.h"
+#include "platform/Log.h"
+#include "platform/Mutex.h"
+#include "platform/Wait.h"
+
+namespace OpenZWave
+{
+	namespace Internal
+	{
+		// The single node lock taken by this thread, and how many times it holds it
+		static thread_local Platform::Mutex* s_lockedNode = NULL;
+		static thread_local int32 s_nodeLocks = 0;
+		// How many LockNodes calls this thread holds
+		static thread_local int32 s_allNodesLocks = 0;
+
+//-----------------------------------------------------------------------------
+// <NodeLocks::NodeLocks>
+// Constructor
+//-----------------------------------------------------------------------------
+		NodeLocks::NodeLocks(Platform::Mutex* _listMutex) :
+				m_listMutex(_listMutex), m_nodeLocks(0), m_waiting(false), m_unlockedEvent(new Platform::Event()), m_allLocked(0)
+		{
+		}
+
+//-----------------------------------------------------------------------------
+// <NodeLocks::~NodeLocks>
+// Destructor
+//-----------------------------------------------------------------------------
+		NodeLocks::~NodeLocks()
+		{
+			m_unlockedEvent->Release();
+		}
+
+//-----------------------------------------------------------------------------
+// <NodeLocks::HoldsSingleNode>
+// Does this thread hold a single node, rather than all of them
+//-----------------------------------------------------------------------------
+		bool NodeLocks::HoldsSingleNode()
+		{
+			return (s_nodeLocks > 0) && (s_allNodesLocks == 0);
+		}
+
+//-----------------------------------------------------------------------------
+// <NodeLocks::LockList>
+// Lock the node list while LockNode looks a node up.  Nodes cannot be removed
+// while this thread holds one, so then the list is left alone, which also keeps
+// us clear of a thread waiting in LockNodes with the list locked.
+//-----------------------------------------------------------------------------
+		bool NodeLocks::LockList()
+		{
+			if (s_nodeLocks > 0)
+			{
+				return false;
+			}
+			m_listMutex->Lock();
+			return true;
+		}
+
+//-----------------------------------------------------------------------------
+// <NodeLocks::Acquire>
+// Lock the mutex of the node LockNode found, and release the list
+//-----------------------------------------------------------------------------
+		Platform::Mutex* NodeLocks::Acquire(uint8 const _nodeId, Platform::Mutex* _mutex, bool const _listLocked, bool* o_refused)
+		{
+			*o_refused = (_mutex != NULL) && !_listLocked && (_mutex != s_lockedNode) && (s_allNodesLocks == 0);
+			if (*o_refused)
+			{
+				// Waiting for it could deadlock with a thread that holds it and wants ours
+				Log::Write(LogLevel_Error, _nodeId, "Node %d was requested while this thread holds the lock of another node", _nodeId);
+				return NULL;
+			}
+			if (_listLocked)
+			{
+				if (_mutex != NULL)
+				{
+					// LockNodes now has to wait for us
+					m_nodeLocks++;
+					s_lockedNode = _mutex;
+				}
+				m_listMutex->Unlock();
+			}
+			if (_mutex != NULL)
+			{
+				s_nodeLocks++;
+				_mutex->Lock();
+			}
+			return _mutex;
+		}
+
+//-----------------------------------------------------------------------------
+// <NodeLocks::UnlockNode>
+// Release a lock taken by LockNode
+//-----------------------------------------------------------------------------
+		bool NodeLocks::UnlockNode(Platform::Mutex* _mutex)
+		{
+			if (_mutex == NULL)
+			{
+				return false;
+			}
+			_mutex->Unlock();
+			if (--s_nodeLocks > 0)
+			{
+				return false;
+			}
+			s_lockedNode = NULL;
+			m_nodeLocks--;
+			if (m_waiting)
+			{
+				m_unlockedEvent->Set();
+			}
+			return true;
+		}
+
+//-----------------------------------------------------------------------------
+// <NodeLocks::LockNodes>
+// Lock the node list and every node.  Holding the list mutex stops anybody
+// taking a new node lock, then we wait for the threads holding one to finish.
+// Fails if this thread holds a single node, as that wait could never end.
+//-----------------------------------------------------------------------------
+		bool NodeLocks::LockNodes()
+		{
+			if (HoldsSingleNode())
+			{
+				// We would wait for the other threads while holding a node they may be waiting for
+				Log::Write(LogLevel_Error, "All the nodes were requested while this thread holds the lock of a single node");
+				return false;
+			}
+			m_listMutex->Lock();
+			s_allNodesLocks++;
+			if (m_allLocked++ > 0)
+			{
+				// we already hold them
+				return true;
+			}
+			int32 own = (s_nodeLocks > 0) ? 1 : 0;
+			if (m_nodeLocks <= own)
+			{
+				return true;
+			}
+			m_waiting = true;
+			while (true)
+			{
+				m_unlockedEvent->Reset();
+				if (m_nodeLocks <= own)
+				{
+					break;
+				}
+				Platform::Wait::Single(m_unlockedEvent);
+			}
+			m_waiting = false;
+			return true;
+		}
+
+//-----------------------------------------------------------------------------
+// <NodeLocks::UnlockNodes>
+// Release a lock taken by LockNodes
+//-----------------------------------------------------------------------------
+		void NodeLocks::UnlockNodes()
+		{
+			m_allLocked--;
+			s_allNodesLocks--;
+			m_listMutex->Unlock();
+		}
+	} // namespace Internal
+} // namespace OpenZWave
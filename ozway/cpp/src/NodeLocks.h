@@ -0,0 +1,114 @@
+//-----------------------------------------------------------------------------
+//
+//	NodeLocks.h
+//
+//	The locks on the node list and on the individual nodes
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef _NodeLocks_H
+#define _NodeLocks_H
+
+#include <atomic>
+
+#include "Defs.h"
+
+namespace OpenZWave
+{
+	namespace Internal
+	{
+		namespace Platform
+		{
+			class Event;
+			class Mutex;
+		}
+
+		/** \brief The locking behind Internal::NodeLockGuard and Internal::NodesLockGuard.
+		 *
+		 * Code that works on a single node takes only that node's mutex, so that requests for
+		 * different nodes can run in parallel.  Code that walks the node list, adds or removes
+		 * nodes, or touches several nodes at once takes the list mutex, then waits for the
+		 * threads holding single nodes to release them.
+		 *
+		 * So that no two threads can end up waiting for each other, a thread that holds a single
+		 * node may not lock a second one nor go on to lock all of them.  Both requests fail, and
+		 * work that needs them has to wait until the single node is released.
+		 */
+		class NodeLocks
+		{
+			public:
+				/**
+				 * Constructor.
+				 * \param _listMutex the mutex that guards the node list.  The caller releases it.
+				 */
+				NodeLocks(Platform::Mutex* _listMutex);
+				~NodeLocks();
+
+				/**
+				 * Lock a single node.
+				 * \param _nodes the node list.  T::m_mutex serializes access to each node.
+				 * \param o_mutex receives the mutex to pass to UnlockNode
+				 * \param o_refused receives true if the node exists, but this thread holds the lock of a different one
+				 * \return the node, or NULL if there is no such node or the lock was refused
+				 */
+				template<class T> T* LockNode(T* const* _nodes, uint8 const _nodeId, Platform::Mutex** o_mutex, bool* o_refused)
+				{
+					bool listLocked = LockList();
+					T* node = _nodes[_nodeId];
+					*o_mutex = Acquire(_nodeId, (node != NULL) ? node->m_mutex : NULL, listLocked, o_refused);
+					return (*o_mutex != NULL) ? node : NULL;
+				}
+
+				/**
+				 * Release a lock taken by LockNode.
+				 * \return true if this thread no longer holds any single node
+				 */
+				bool UnlockNode(Platform::Mutex* _mutex);
+
+				/**
+				 * Lock the node list and every node.
+				 * \return false, without locking anything, if this thread holds the lock of a single node
+				 */
+				bool LockNodes();
+				/** Release a lock taken by LockNodes */
+				void UnlockNodes();
+
+				/** Does this thread hold a single node, rather than all of them */
+				static bool HoldsSingleNode();
+
+			private:
+				NodeLocks(NodeLocks const&);					// prevent copy
+				NodeLocks& operator =(NodeLocks const&);		// prevent assignment
+
+				bool LockList();
+				Platform::Mutex* Acquire(uint8 const _nodeId, Platform::Mutex* _mutex, bool const _listLocked, bool* o_refused);
+
+				Platform::Mutex* m_listMutex;
+				std::atomic<int32> m_nodeLocks;					// Threads holding single node locks
+				std::atomic<bool> m_waiting;					// A thread wants all the nodes and is waiting for the single node locks to be released
+				Platform::Event* m_unlockedEvent;				// Set when a thread releases its last single node lock while m_waiting
+				uint32 m_allLocked;								// Depth of LockNodes calls by the owner of m_listMutex
+		};
+	} // namespace Internal
+} // namespace OpenZWave
+
+#endif // _NodeLocks_H
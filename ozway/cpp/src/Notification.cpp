@@ -314,6 +314,13 @@ string Notification::GetAsString() const
 					break;
 				case Alert_ApplicationStatus_Rejected:
 					str = "Application Status: Command Rejected";
+					break;
+				case Alert_NotificationOverload:
+					str = "Notification backlog overloaded, low priority notifications are being dropped";
+					break;
+				case Alert_NotificationOverloadCleared:
+					str = "Notification backlog recovered";
+					break;
 			}
 			break;
 		case Type_ManufacturerSpecificDBReady:
@@ -157,6 +157,8 @@ namespace OpenZWave
 				Alert_ApplicationStatus_Retry, /**< Application Status CC returned a Retry Later Message */
 				Alert_ApplicationStatus_Queued, /**< Command Has been Queued for later execution */
 				Alert_ApplicationStatus_Rejected, /**< Command has been rejected */
+				Alert_NotificationOverload, /**< The notification backlog passed the NotificationHighWatermark option.  Low priority notifications are being shed until it falls to NotificationLowWatermark. */
+				Alert_NotificationOverloadCleared, /**< The notification backlog fell to the NotificationLowWatermark option.  All notifications are delivered again. */
 			};
 
 			/**
@@ -29,6 +29,7 @@
 #include <string.h>
 
 #include "tinyxml.h"
+#include "ConfigBundle.h"
 #include "Options.h"
 #include "Utils.h"
 #include "platform/Log.h"
@@ -49,12 +50,9 @@ namespace OpenZWave
 		void NotificationCCTypes::ReadXML()
 		{
 			// Parse the Z-Wave manufacturer and product XML file.
-			string configPath;
-			Options::Get()->GetOptionAsString("ConfigPath", &configPath);
-
-			string path = configPath + "NotificationCCTypes.xml";
+			string path;
 			TiXmlDocument* pDoc = new TiXmlDocument();
-			if (!pDoc->LoadFile(path.c_str(), TIXML_ENCODING_UTF8))
+			if (!ConfigBundle::LoadDocument("NotificationCCTypes.xml", pDoc, &path))
 			{
 				delete pDoc;
 				Log::Write(LogLevel_Warning, "Unable to load NotificationCCTypes file %s", path.c_str());
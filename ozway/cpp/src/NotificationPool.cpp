@@ -0,0 +1,284 @@
+//-----------------------------------------------------------------------------
+//
+//	NotificationPool.cpp
+//
+//	Delivers notifications to the watchers on a pool of threads
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#include "NotificationPool.h"
+#include "Driver.h"
+#include "Notification.h"
+#include "Utils.h"
+#include "platform/Event.h"
+#include "platform/Log.h"
+#include "platform/Mutex.h"
+#include "platform/Thread.h"
+
+namespace OpenZWave
+{
+	namespace Internal
+	{
+
+//-----------------------------------------------------------------------------
+// <NotificationPool::NotificationPool>
+// Constructor
+//-----------------------------------------------------------------------------
+		NotificationPool::NotificationPool(Driver* _driver, uint32 const _threads) :
+				m_driver(_driver), m_mutex(new Platform::Mutex("notificationpool")), m_readyEvent(new Platform::Event()), m_idleEvent(new Platform::Event()), m_pending(0), m_active(0), m_barrierState(Barrier_None)
+		{
+			m_idleEvent->Set();
+			for (uint32 i = 0; i < _threads; ++i)
+			{
+				Platform::Thread* thread = new Platform::Thread("notify" + intToString(i));
+				m_threads.push_back(thread);
+				thread->Start(NotificationPool::WorkerEntryPoint, this);
+			}
+			Log::Write(LogLevel_Info, "Delivering notifications on %d threads", _threads);
+		}
+
+//-----------------------------------------------------------------------------
+// <NotificationPool::~NotificationPool>
+// Destructor
+//-----------------------------------------------------------------------------
+		NotificationPool::~NotificationPool()
+		{
+			Flush();
+			for (vector<Platform::Thread*>::iterator it = m_threads.begin(); it != m_threads.end(); ++it)
+			{
+				(*it)->Stop();
+				(*it)->Release();
+			}
+			m_idleEvent->Release();
+			m_readyEvent->Release();
+			m_mutex->Release();
+		}
+
+//-----------------------------------------------------------------------------
+// <NotificationPool::Queue>
+// Add a notification to the end of its node's strand, or hold it back
+// behind a driver-wide notification that has not been delivered yet
+//-----------------------------------------------------------------------------
+		void NotificationPool::Queue(Notification* _notification)
+		{
+			Entry entry;
+			entry.m_notification = _notification;
+			entry.m_queued = Platform::TimeStamp() - m_epoch;
+
+			LockGuard LG(m_mutex);
+			if (m_pending++ == 0)
+			{
+				m_idleEvent->Reset();
+			}
+			if (m_barrierState != Barrier_None)
+			{
+				m_held.push_back(entry);
+				return;
+			}
+			if (IsBarrier(entry))
+			{
+				// Not flushed here, as watchers can raise notifications through the Manager
+				m_barrier = entry;
+				m_barrierState = Barrier_Waiting;
+				ReleaseBarrier();
+				return;
+			}
+			Dispatch(entry);
+		}
+
+//-----------------------------------------------------------------------------
+// <NotificationPool::IsBarrier>
+// Is the notification about the whole driver rather than a node
+//-----------------------------------------------------------------------------
+		bool NotificationPool::IsBarrier(Entry const& _entry)
+		{
+			uint8 nodeId = _entry.m_notification->GetNodeId();
+			return (nodeId == 0) || (nodeId == 0xff);
+		}
+
+//-----------------------------------------------------------------------------
+// <NotificationPool::Dispatch>
+// Add a notification to the end of its node's strand.  m_mutex must be held.
+//-----------------------------------------------------------------------------
+		void NotificationPool::Dispatch(Entry const& _entry)
+		{
+			uint8 nodeId = _entry.m_notification->GetNodeId();
+			Strand& strand = m_strands[nodeId];
+			strand.m_queue.push_back(_entry);
+			if (strand.m_queue.size() > strand.m_maxDepth)
+			{
+				strand.m_maxDepth = (uint32) strand.m_queue.size();
+			}
+			if (!strand.m_running && strand.m_queue.size() == 1)
+			{
+				m_ready.push_back(nodeId);
+				m_readyEvent->Set();
+			}
+			m_active++;
+		}
+
+//-----------------------------------------------------------------------------
+// <NotificationPool::ReleaseBarrier>
+// Once the strands have drained, deliver the waiting barrier, and once that
+// has been delivered, the notifications held behind it, up to the next
+// barrier.  m_mutex must be held.
+//-----------------------------------------------------------------------------
+		void NotificationPool::ReleaseBarrier()
+		{
+			while ((m_active == 0) && (m_barrierState != Barrier_None))
+			{
+				if (m_barrierState == Barrier_Waiting)
+				{
+					Dispatch(m_barrier);
+					m_barrierState = Barrier_Dispatched;
+					return;
+				}
+
+				// The barrier has been delivered
+				m_barrierState = Barrier_None;
+				while (!m_held.empty())
+				{
+					Entry entry = m_held.front();
+					m_held.pop_front();
+					if (IsBarrier(entry))
+					{
+						m_barrier = entry;
+						m_barrierState = Barrier_Waiting;
+						break;
+					}
+					Dispatch(entry);
+				}
+			}
+		}
+
+//-----------------------------------------------------------------------------
+// <NotificationPool::Flush>
+// Wait until the threads have caught up
+//-----------------------------------------------------------------------------
+		void NotificationPool::Flush()
+		{
+			Platform::Wait::Single(m_idleEvent);
+		}
+
+//-----------------------------------------------------------------------------
+// <NotificationPool::WorkerEntryPoint>
+// Entry point of the worker threads
+//-----------------------------------------------------------------------------
+		void NotificationPool::WorkerEntryPoint(Platform::Event* _exitEvent, void* _context)
+		{
+			NotificationPool* pool = (NotificationPool*) _context;
+			if (pool)
+			{
+				pool->WorkerProc(_exitEvent);
+			}
+		}
+
+//-----------------------------------------------------------------------------
+// <NotificationPool::WorkerProc>
+// Deliver notifications until told to exit
+//-----------------------------------------------------------------------------
+		void NotificationPool::WorkerProc(Platform::Event* _exitEvent)
+		{
+			Platform::Wait* waitObjects[2];
+			waitObjects[0] = _exitEvent;			// Thread must exit.
+			waitObjects[1] = m_readyEvent;			// A strand has notifications waiting
+			while (Platform::Wait::Multiple(waitObjects, 2, Platform::Wait::Timeout_Infinite) != 0)
+			{
+				DeliverNext();
+			}
+		}
+
+//-----------------------------------------------------------------------------
+// <NotificationPool::DeliverNext>
+// Deliver the next notification of the strand at the front of the ready list.
+// The strand goes to the back of the list afterwards, so that one busy node
+// cannot keep a thread to itself.
+//-----------------------------------------------------------------------------
+		void NotificationPool::DeliverNext()
+		{
+			uint8 nodeId;
+			Notification* notification;
+			{
+				LockGuard LG(m_mutex);
+				if (m_ready.empty())
+				{
+					// another thread got there first
+					m_readyEvent->Reset();
+					return;
+				}
+				nodeId = m_ready.front();
+				m_ready.pop_front();
+				if (m_ready.empty())
+				{
+					m_readyEvent->Reset();
+				}
+
+				Strand& strand = m_strands[nodeId];
+				Entry const& entry = strand.m_queue.front();
+				notification = entry.m_notification;
+				uint32 delay = (uint32) ((Platform::TimeStamp() - m_epoch) - entry.m_queued);
+				strand.m_delayTotal += delay;
+				if (delay > strand.m_delayMax)
+				{
+					strand.m_delayMax = delay;
+				}
+				strand.m_queue.pop_front();
+				strand.m_running = true;
+				strand.m_delivered++;
+			}
+
+			m_driver->DeliverNotification(notification, true);
+
+			LockGuard LG(m_mutex);
+			Strand& strand = m_strands[nodeId];
+			strand.m_running = false;
+			if (!strand.m_queue.empty())
+			{
+				m_ready.push_back(nodeId);
+				m_readyEvent->Set();
+			}
+			if (--m_pending == 0)
+			{
+				m_idleEvent->Set();
+			}
+			if (--m_active == 0)
+			{
+				ReleaseBarrier();
+			}
+		}
+
+//-----------------------------------------------------------------------------
+// <NotificationPool::GetStrandStatistics>
+// Backlog statistics for a node's strand
+//-----------------------------------------------------------------------------
+		void NotificationPool::GetStrandStatistics(uint8 const _nodeId, uint32* o_depth, uint32* o_maxDepth, uint32* o_delivered, uint32* o_delayAvg, uint32* o_delayMax)
+		{
+			LockGuard LG(m_mutex);
+			Strand const& strand = m_strands[_nodeId];
+			*o_depth = (uint32) strand.m_queue.size();
+			*o_maxDepth = strand.m_maxDepth;
+			*o_delivered = strand.m_delivered;
+			*o_delayAvg = strand.m_delivered ? (uint32) (strand.m_delayTotal / strand.m_delivered) : 0;
+			*o_delayMax = strand.m_delayMax;
+		}
+	} // namespace Internal
+} // namespace OpenZWave
@@ -0,0 +1,144 @@
+//-----------------------------------------------------------------------------
+//
+//	NotificationPool.h
+//
+//	Delivers notifications to the watchers on a pool of threads
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#ifndef _NotificationPool_H
+#define _NotificationPool_H
+
+#include <list>
+#include <deque>
+#include <vector>
+
+#include "Defs.h"
+#include "platform/TimeStamp.h"
+
+namespace OpenZWave
+{
+	class Driver;
+	class Notification;
+
+	namespace Internal
+	{
+		namespace Platform
+		{
+			class Event;
+			class Mutex;
+			class Thread;
+		}
+
+		/** \brief Delivers a driver's notifications on a pool of threads.
+		 *
+		 * Each node has its own strand.  Notifications for the same node are delivered
+		 * one at a time, in the order they were queued, while the notifications for
+		 * different nodes are delivered in parallel.  A watcher that is slow to handle
+		 * one node's notifications therefore only holds up that node.
+		 *
+		 * Notifications for node 0 or 0xff are about the whole driver (DriverReady,
+		 * AllNodesQueried and the like), and act as barriers.  One is delivered only
+		 * once everything queued before it has been delivered, and nothing queued
+		 * after it is delivered until it has been.
+		 *
+		 * Only used when the NotificationThreads option is set.  Otherwise the driver
+		 * calls the watchers itself, as before.
+		 */
+		class NotificationPool
+		{
+			public:
+				NotificationPool(Driver* _driver, uint32 const _threads);
+				/** Delivers anything still queued, then stops the threads */
+				~NotificationPool();
+
+				/** Queue a notification for delivery.  The pool takes ownership of it. */
+				void Queue(Notification* _notification);
+				/** Wait until everything queued so far has been delivered.  Must not be called from a watcher. */
+				void Flush();
+
+				/**
+				 * Backlog statistics for a node's strand.
+				 * \param o_depth receives the number of notifications waiting
+				 * \param o_maxDepth receives the most that have been waiting at once
+				 * \param o_delivered receives the number of notifications delivered
+				 * \param o_delayAvg receives the average time they waited to be delivered, in ms
+				 * \param o_delayMax receives the longest time one waited to be delivered, in ms
+				 */
+				void GetStrandStatistics(uint8 const _nodeId, uint32* o_depth, uint32* o_maxDepth, uint32* o_delivered, uint32* o_delayAvg, uint32* o_delayMax);
+
+			private:
+				NotificationPool(NotificationPool const&);					// prevent copy
+				NotificationPool& operator =(NotificationPool const&);		// prevent assignment
+
+				static void WorkerEntryPoint(Platform::Event* _exitEvent, void* _context);
+				void WorkerProc(Platform::Event* _exitEvent);
+				void DeliverNext();
+
+				struct Entry
+				{
+						Notification* m_notification;
+						int32 m_queued;					// when it was queued, in ms since m_epoch
+				};
+				struct Strand
+				{
+						Strand() :
+								m_running(false), m_maxDepth(0), m_delivered(0), m_delayTotal(0), m_delayMax(0)
+						{
+						}
+						list<Entry> m_queue;
+						bool m_running;					// a thread is delivering one of this strand's notifications
+						uint32 m_maxDepth;
+						uint32 m_delivered;
+						uint64 m_delayTotal;
+						uint32 m_delayMax;
+				};
+
+				static bool IsBarrier(Entry const& _entry);
+				void Dispatch(Entry const& _entry);
+				void ReleaseBarrier();
+
+				enum BarrierState
+				{
+					Barrier_None = 0,					// No barrier queued
+					Barrier_Waiting,					// m_barrier waits for the strands to drain
+					Barrier_Dispatched					// m_barrier is in its strand, everything else waits in m_held
+				};
+
+				Driver* m_driver;
+				Platform::Mutex* m_mutex;
+				Platform::Event* m_readyEvent;			// Set while m_ready is not empty
+				Platform::Event* m_idleEvent;			// Set while nothing is queued or being delivered
+				vector<Platform::Thread*> m_threads;
+				Strand m_strands[256];					// by node id
+				deque<uint8> m_ready;					// Strands with notifications waiting that no thread is delivering
+				uint32 m_pending;						// Notifications queued or being delivered
+				uint32 m_active;						// Notifications in the strands or being delivered
+				BarrierState m_barrierState;
+				Entry m_barrier;						// The driver-wide notification all the strands must deliver up to
+				list<Entry> m_held;						// Queued after m_barrier, and held until it has been delivered
+				Platform::TimeStamp m_epoch;
+		};
+	} // namespace Internal
+} // namespace OpenZWave
+
+#endif
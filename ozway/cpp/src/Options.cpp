@@ -27,6 +27,8 @@
 
 #include <algorithm>
 #include <string>
+#include <vector>
+#include <stdlib.h>
 
 #include "Defs.h"
 #include "Options.h"
@@ -40,6 +42,11 @@ using namespace OpenZWave;
 
 Options* Options::s_instance = NULL;
 
+// Option names, in OptionKey order
+static char const* c_optionKeyNames[] =
+{ "ConfigPath", "UserPath", "ConfigBundle", "Logging", "LogFileName", "AppendLogFile", "ConsoleOutput", "SaveLogLevel", "QueueLogLevel", "DumpTriggerLevel", "Associate", "Exclude", "Include", "NotifyTransactions", "Interface", "SaveConfiguration", "DriverMaxAttempts", "PollInterval", "IntervalBetweenPolls", "AdaptivePolling", "AdaptivePollCeiling", "SuppressValueRefresh", "PerformReturnRoutes", "NetworkKey", "RefreshAllUserCodes", "RetryTimeout", "EnableSIS", "AssumeAwake", "NotifyOnDriverUnload", "NotificationThreads", "LockProfiling", "SecurityStrategy", "CustomSecuredCC", "EnforceSecureReception", "AutoUpdateConfigFile", "ReloadAfterUpdate", "Language", "FlattenLocalization", "IncludeInstanceLabel", "ThreadAffinity", "ThreadScheduling", "NotificationHighWatermark", "NotificationLowWatermark", "MetricsExport", "MetricsExportInterval", "ThreadTerminateTimeout" };
+static_assert(sizeof(c_optionKeyNames) / sizeof(c_optionKeyNames[0]) == Options::OptionKey_Count, "c_optionKeyNames must name every OptionKey, in order");
+
 //-----------------------------------------------------------------------------
 // <Options::Create>
 // Static method to create an Options object
@@ -97,6 +104,7 @@ Options* Options::Create(string const& _configPath, string const& _userPath, str
 		// Add the default options
 		s_instance->AddOptionString("ConfigPath", configPath, false);	// Path to the OpenZWave config folder.
 		s_instance->AddOptionString("UserPath", userPath, false);	// Path to the user's data folder.
+		s_instance->AddOptionString("ConfigBundle", "ozwconfig.bundle", false);	// Precompiled device database, relative to ConfigPath. Empty to always parse the XML config files.
 
 		s_instance->AddOptionBool("Logging", true);						// Enable logging of library activity.
 		s_instance->AddOptionString("LogFileName", "OZW_Log.txt", false);	// Name of the log file (can be changed via Log::SetLogFileName)
@@ -117,6 +125,8 @@ Options* Options::Create(string const& _configPath, string const& _userPath, str
 		s_instance->AddOptionInt("PollInterval", 30000);						// 30 seconds (can easily poll 30 values in this time; ~120 values is the effective limit for 30 seconds)
 		s_instance->AddOptionBool("IntervalBetweenPolls", false);					// if false, try to execute the entire poll list within the PollInterval time frame
 																					// if true, wait for PollInterval milliseconds between polls
+		s_instance->AddOptionBool("AdaptivePolling", false);					// if true, skip polls of values that have reported recently, and poll values that do not change less often
+		s_instance->AddOptionInt("AdaptivePollCeiling", 16);					// with AdaptivePolling, the most a value's poll period can grow, as a multiple of its normal period
 		s_instance->AddOptionBool("SuppressValueRefresh", false);					// if true, notifications for refreshed (but unchanged) values will not be sent
 		s_instance->AddOptionBool("PerformReturnRoutes", false);					// if true, return routes will be updated
 		s_instance->AddOptionString("NetworkKey", string(""), false);
@@ -125,13 +135,22 @@ Options* Options::Create(string const& _configPath, string const& _userPath, str
 		s_instance->AddOptionBool("EnableSIS", true);						// Automatically become a SUC if there is no SUC on the network.
 		s_instance->AddOptionBool("AssumeAwake", true);						// Assume Devices that Support the Wakeup CC are awake when we first query them....
 		s_instance->AddOptionBool("NotifyOnDriverUnload", false);						// Should we send the Node/Value Notifications on Driver Unloading - Read comments in Driver::~Driver() method about possible race conditions
+		s_instance->AddOptionInt("NotificationThreads", 0);						// if > 0, deliver notifications on this many threads, in order for each node but in parallel across nodes
+		s_instance->AddOptionBool("LockProfiling", false);						// collect wait and hold times for the named mutexes.  See Manager::LogLockStatistics
 		s_instance->AddOptionString("SecurityStrategy", "SUPPORTED", false);		// Should we encrypt CC's that are available via both clear text and Security CC?
 		s_instance->AddOptionString("CustomSecuredCC", "0x62,0x4c,0x63", false);	// What List of Custom CC should we always encrypt if SecurityStrategy is CUSTOM
 		s_instance->AddOptionBool("EnforceSecureReception", true);						// if we recieve a clear text message for a CC that is Secured, should we drop the message
 		s_instance->AddOptionBool("AutoUpdateConfigFile", true);						// if we should automatically update config files for devices if they are out of date
 		s_instance->AddOptionString("ReloadAfterUpdate", "AWAKE", false);			// Should we automatically Reload Nodes after a update
 		s_instance->AddOptionString("Language", "", false);			// Language we should use
+		s_instance->AddOptionBool("FlattenLocalization", true);			// Keep only the selected Language, resolved into flat lookup tables
 		s_instance->AddOptionBool("IncludeInstanceLabel", true);						// Should we include the Instance Label in Value Labels on MultiInstance Devices
+		s_instance->AddOptionString("ThreadAffinity", "", false);			// CPUs to run threads on, by thread name, eg "driver=0;poll=1-2;notify*=2,3"
+		s_instance->AddOptionString("ThreadScheduling", "", false);			// Scheduling policy and priority of threads, by thread name, eg "driver=fifo:10;poll=idle"
+		s_instance->AddOptionInt("NotificationHighWatermark", 0);			// if > 0, once this many notifications are waiting, drop ValueRefreshed and repeated NodeEvent notifications
+		s_instance->AddOptionInt("NotificationLowWatermark", 0);			// stop dropping notifications once the backlog is down to this many.  0 for half the high watermark
+		s_instance->AddOptionString("MetricsExport", "", false);			// write the metrics in the Prometheus text format to this file, or serve them on a local socket if it starts with "unix:"
+		s_instance->AddOptionInt("MetricsExportInterval", 10000);			// how often to rewrite the MetricsExport file, in ms
 #if defined WINRT
 				s_instance->AddOptionInt( "ThreadTerminateTimeout", -1);						// Since threads cannot be terminated in WinRT, Thread::Terminate will simply wait for them to exit on there own
 #endif
@@ -176,6 +195,7 @@ Options* Options::Get()
 Options::Options(string const& _configPath, string const& _userPath, string const& _commandLine) :
 		m_xml("options.xml"), m_commandLine(_commandLine), m_SystemPath(_configPath), m_LocalPath(_userPath), m_locked(false)
 {
+	memset(m_keys, 0, sizeof(m_keys));
 }
 
 //-----------------------------------------------------------------------------
@@ -311,6 +331,57 @@ bool Options::GetOptionAsString(string const& _name, string* o_value)
 	return false;
 }
 
+//-----------------------------------------------------------------------------
+// <Options::GetOptionAsBool>
+// Get the value of a boolean option by key.
+//-----------------------------------------------------------------------------
+bool Options::GetOptionAsBool(OptionKey const _key, bool* o_value)
+{
+	Option* option = Find(_key);
+	if (o_value && option && (OptionType_Bool == option->m_type))
+	{
+		*o_value = option->m_valueBool;
+		return true;
+	}
+
+	Log::Write(LogLevel_Warning, "Specified option [%s] was not found.", (_key < OptionKey_Count) ? c_optionKeyNames[_key] : "");
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+// <Options::GetOptionAsInt>
+// Get the value of an integer option by key.
+//-----------------------------------------------------------------------------
+bool Options::GetOptionAsInt(OptionKey const _key, int32* o_value)
+{
+	Option* option = Find(_key);
+	if (o_value && option && (OptionType_Int == option->m_type))
+	{
+		*o_value = option->m_valueInt;
+		return true;
+	}
+
+	Log::Write(LogLevel_Warning, "Specified option [%s] was not found.", (_key < OptionKey_Count) ? c_optionKeyNames[_key] : "");
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+// <Options::GetOptionAsString>
+// Get the value of a string option by key.
+//-----------------------------------------------------------------------------
+bool Options::GetOptionAsString(OptionKey const _key, string* o_value)
+{
+	Option* option = Find(_key);
+	if (o_value && option && (OptionType_String == option->m_type))
+	{
+		*o_value = option->m_valueString;
+		return true;
+	}
+
+	Log::Write(LogLevel_Warning, "Specified option [%s] was not found.", (_key < OptionKey_Count) ? c_optionKeyNames[_key] : "");
+	return false;
+}
+
 //-----------------------------------------------------------------------------
 // <Options::GetOptionType>
 // Get the type of value stored in an option.
@@ -344,6 +415,7 @@ bool Options::Lock()
 	ParseOptionsXML(m_LocalPath + m_xml);
 	ParseOptionsString(m_commandLine);
 	m_locked = true;
+	ResolveKeys();
 
 	/* Log our Configured Options */
 	map<string, Option*>::iterator it;
@@ -467,20 +539,19 @@ bool Options::ParseOptionsString(string const& _commandLine)
 //-----------------------------------------------------------------------------
 bool Options::ParseOptionsXML(string const& _filename)
 {
-	TiXmlDocument doc;
-	if (!doc.LoadFile(_filename.c_str(), TIXML_ENCODING_UTF8))
+	TiXmlStreamReader reader;
+	if (!reader.LoadFile(_filename.c_str(), TIXML_ENCODING_UTF8))
 	{
-		Log::Write(LogLevel_Warning, "Failed to Parse %s: %s", _filename.c_str(), doc.ErrorDesc());
+		Log::Write(LogLevel_Warning, "Failed to Parse %s: %s", _filename.c_str(), reader.ErrorDesc());
 		return false;
 	}
-	doc.SetUserData((void *) _filename.c_str());
+	reader.Document()->SetUserData((void *) _filename.c_str());
 	Log::Write(LogLevel_Info, "Reading %s for Options", _filename.c_str());
 
-	TiXmlElement const* optionsElement = doc.RootElement();
-
-	// Read the options
-	TiXmlElement const* optionElement = optionsElement->FirstChildElement();
-	while (optionElement)
+	// Read the options.  They are only applied once the whole file has parsed, so that
+	// a malformed file is rejected as a whole, as it was when it was loaded as a document.
+	vector<pair<Option*, string> > values;
+	while (TiXmlElement const* optionElement = reader.NextElement())
 	{
 		char const* str = optionElement->Value();
 		if (str && !strcmp(str, "Option"))
@@ -494,16 +565,23 @@ bool Options::ParseOptionsXML(string const& _filename)
 					char const* value = optionElement->Attribute("value");
 					if (value)
 					{
-						// Set the value
-						option->SetValueFromString(value);
+						values.push_back(pair<Option*, string>(option, value));
 					}
 				}
 			}
 		}
-
-		optionElement = optionElement->NextSiblingElement();
+	}
+	if (reader.Error())
+	{
+		Log::Write(LogLevel_Warning, "Failed to Parse %s at line %d: %s", _filename.c_str(), reader.ErrorRow(), reader.ErrorDesc());
+		return false;
 	}
 
+	// Set the values
+	for (vector<pair<Option*, string> >::iterator it = values.begin(); it != values.end(); ++it)
+	{
+		it->first->SetValueFromString(it->second);
+	}
 	return true;
 }
 
@@ -545,6 +623,73 @@ Options::Option* Options::Find(string const& _name)
 	return NULL;
 }
 
+//-----------------------------------------------------------------------------
+// <Options::Find>
+// Find an option by key
+//-----------------------------------------------------------------------------
+Options::Option* Options::Find(OptionKey const _key)
+{
+	if (_key >= OptionKey_Count)
+	{
+		return NULL;
+	}
+	if (m_locked)
+	{
+		return m_keys[_key];
+	}
+	// options can still be added, so the keys are not resolved yet
+	return Find(c_optionKeyNames[_key]);
+}
+
+//-----------------------------------------------------------------------------
+// <Options::ResolveKeys>
+// Resolve the option keys, and parse the options that are read as lists
+//-----------------------------------------------------------------------------
+void Options::ResolveKeys()
+{
+	for (int i = 0; i < OptionKey_Count; i++)
+	{
+		m_keys[i] = Find(string(c_optionKeyNames[i]));
+	}
+
+	m_customSecuredCC.reset();
+	Option* option = m_keys[OptionKey_CustomSecuredCC];
+	if (option && (OptionType_String == option->m_type))
+	{
+		std::vector<std::string> ccs;
+		Internal::split(ccs, option->m_valueString, ",");
+		for (std::vector<std::string>::iterator it = ccs.begin(); it != ccs.end(); ++it)
+		{
+			char* end;
+			string cc = Internal::trim(*it);
+			long id = strtol(cc.c_str(), &end, 16);
+			if (cc.empty() || *end != '\0' || id < 0 || id > 0xFF)
+			{
+				Log::Write(LogLevel_Warning, "CustomSecuredCC: Ignoring invalid Command Class %s", cc.c_str());
+				continue;
+			}
+			m_customSecuredCC.set((size_t) id);
+		}
+	}
+
+	// SUPPORTED encrypts everything the node supports securely, CUSTOM only the listed
+	// command classes, and anything else (ESSENTIAL) nothing more than it must
+	m_securedCC.reset();
+	option = m_keys[OptionKey_SecurityStrategy];
+	if (option && (OptionType_String == option->m_type))
+	{
+		string strategy = Internal::ToUpper(option->m_valueString);
+		if (strategy == "SUPPORTED")
+		{
+			m_securedCC.set();
+		}
+		else if (strategy == "CUSTOM")
+		{
+			m_securedCC = m_customSecuredCC;
+		}
+	}
+}
+
 //-----------------------------------------------------------------------------
 // <Options::Option::SetValueFromString>
 // Find an option by name
@@ -31,6 +31,7 @@
 #include <string>
 #include <cstring>
 #include <map>
+#include <bitset>
 
 #include "Defs.h"
 
@@ -74,6 +75,63 @@ namespace OpenZWave
 				OptionType_String
 			};
 
+			/**
+			 * Keys for the options added by Options::Create.
+			 * Each key is resolved to its option once, when the options are locked, so
+			 * reading an option by key is an array lookup rather than a search by name.
+			 * \see GetOptionAsBool, GetOptionAsInt, GetOptionAsString
+			 */
+			enum OptionKey
+			{
+				OptionKey_ConfigPath = 0,
+				OptionKey_UserPath,
+				OptionKey_ConfigBundle,
+				OptionKey_Logging,
+				OptionKey_LogFileName,
+				OptionKey_AppendLogFile,
+				OptionKey_ConsoleOutput,
+				OptionKey_SaveLogLevel,
+				OptionKey_QueueLogLevel,
+				OptionKey_DumpTriggerLevel,
+				OptionKey_Associate,
+				OptionKey_Exclude,
+				OptionKey_Include,
+				OptionKey_NotifyTransactions,
+				OptionKey_Interface,
+				OptionKey_SaveConfiguration,
+				OptionKey_DriverMaxAttempts,
+				OptionKey_PollInterval,
+				OptionKey_IntervalBetweenPolls,
+				OptionKey_AdaptivePolling,
+				OptionKey_AdaptivePollCeiling,
+				OptionKey_SuppressValueRefresh,
+				OptionKey_PerformReturnRoutes,
+				OptionKey_NetworkKey,
+				OptionKey_RefreshAllUserCodes,
+				OptionKey_RetryTimeout,
+				OptionKey_EnableSIS,
+				OptionKey_AssumeAwake,
+				OptionKey_NotifyOnDriverUnload,
+				OptionKey_NotificationThreads,
+				OptionKey_LockProfiling,
+				OptionKey_SecurityStrategy,
+				OptionKey_CustomSecuredCC,
+				OptionKey_EnforceSecureReception,
+				OptionKey_AutoUpdateConfigFile,
+				OptionKey_ReloadAfterUpdate,
+				OptionKey_Language,
+				OptionKey_FlattenLocalization,
+				OptionKey_IncludeInstanceLabel,
+				OptionKey_ThreadAffinity,
+				OptionKey_ThreadScheduling,
+				OptionKey_NotificationHighWatermark,
+				OptionKey_NotificationLowWatermark,
+				OptionKey_MetricsExport,
+				OptionKey_MetricsExportInterval,
+				OptionKey_ThreadTerminateTimeout,
+				OptionKey_Count
+			};
+
 			/**
 			 * Creates an object to manage the program options.
 			 * \param _configPath a string containing the path to the OpenZWave library config
@@ -197,6 +255,57 @@ namespace OpenZWave
 			 */
 			bool GetOptionAsString(string const& _name, string* o_value);
 
+			/**
+			 * Get the value of a boolean option by key.
+			 * \param _key the key of one of the options added by Options::Create.
+			 * \param o_value a pointer to the item that will be filled with the option value.
+			 * \return true if the option value was fetched successfully
+			 * \see GetOptionAsBool
+			 */
+			bool GetOptionAsBool(OptionKey const _key, bool* o_value);
+
+			/**
+			 * Get the value of an integer option by key.
+			 * \param _key the key of one of the options added by Options::Create.
+			 * \param o_value a pointer to the item that will be filled with the option value.
+			 * \return true if the option value was fetched successfully
+			 * \see GetOptionAsInt
+			 */
+			bool GetOptionAsInt(OptionKey const _key, int32* o_value);
+
+			/**
+			 * Get the value of a string option by key.
+			 * \param _key the key of one of the options added by Options::Create.
+			 * \param o_value a pointer to the item that will be filled with the option value.
+			 * \return true if the option value was fetched successfully
+			 * \see GetOptionAsString
+			 */
+			bool GetOptionAsString(OptionKey const _key, string* o_value);
+
+			/**
+			 * Test whether a command class is listed in the CustomSecuredCC option.
+			 * The list is parsed once, when the options are locked.
+			 * \param _commandClassId the command class to test.
+			 * \return true if the command class should always be encrypted when the
+			 * SecurityStrategy option is CUSTOM.
+			 */
+			bool IsCustomSecuredCC(uint8 const _commandClassId) const
+			{
+				return m_customSecuredCC.test(_commandClassId);
+			}
+
+			/**
+			 * Test whether a command class that a node supports both in clear text and via the
+			 * Security CC should be encrypted, according to the SecurityStrategy and
+			 * CustomSecuredCC options.  Both are resolved once, when the options are locked.
+			 * \param _commandClassId the command class to test.
+			 * \return true if the command class should be encrypted.
+			 */
+			bool IsSecuredCC(uint8 const _commandClassId) const
+			{
+				return m_securedCC.test(_commandClassId);
+			}
+
 			/**
 			 * Get the type of value stored in an option.
 			 * \param _name the name of the option.  Option names are case insensitive.
@@ -243,6 +352,8 @@ namespace OpenZWave
 			bool ParseOptionsXML(string const& _filename);					// Parse an XML file containing program options.
 			Option* AddOption(string const& _name);							// check lock and create (or open existing) option
 			Option* Find(string const& _name);
+			Option* Find(OptionKey const _key);
+			void ResolveKeys();												// Resolve m_keys and cache the values parsed from option strings.
 
 			map<string, Option*> m_options;										// Map of option names to values.
 			string m_xml;											// Path to XML options file.
@@ -250,6 +361,9 @@ namespace OpenZWave
 			string m_SystemPath;
 			string m_LocalPath;
 			bool m_locked;										// If true, the options are final and AddOption can no longer be called.
+			Option* m_keys[OptionKey_Count];						// Options by key, valid once the options are locked.
+			bitset<256> m_customSecuredCC;						// Parsed CustomSecuredCC list.
+			bitset<256> m_securedCC;							// Command classes to encrypt, from SecurityStrategy and CustomSecuredCC.
 			static Options* s_instance;
 	};
 } // namespace OpenZWave
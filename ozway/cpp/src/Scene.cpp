@@ -26,10 +26,24 @@
 //-----------------------------------------------------------------------------
 
 #include <cstring>
+#include <algorithm>
 #include "Manager.h"
+#include "Driver.h"
+#include "Node.h"
+#include "Utils.h"
 #include "platform/Log.h"
+#include "platform/TimeStamp.h"
 #include "value_classes/Value.h"
 #include "value_classes/ValueID.h"
+#include "value_classes/ValueBitSet.h"
+#include "value_classes/ValueBool.h"
+#include "value_classes/ValueByte.h"
+#include "value_classes/ValueDecimal.h"
+#include "value_classes/ValueInt.h"
+#include "value_classes/ValueList.h"
+#include "value_classes/ValueRaw.h"
+#include "value_classes/ValueShort.h"
+#include "value_classes/ValueString.h"
 #include "Scene.h"
 #include "Options.h"
 
@@ -48,16 +62,18 @@ namespace OpenZWave
 		uint8 Scene::s_sceneCnt = 0;
 		Scene* Scene::s_scenes[256] =
 		{ 0 };
+		bool Scene::s_dirty = false;
 
 //-----------------------------------------------------------------------------
 // <Scene::Scene>
 // Constructor
 //-----------------------------------------------------------------------------
 		Scene::Scene(uint8 const _sceneId) :
-				m_sceneId(_sceneId), m_label("")
+				m_sceneId(_sceneId), m_label(""), m_batchValid(false)
 		{
 			s_scenes[_sceneId] = this;
 			s_sceneCnt++;
+			s_dirty = true;
 		}
 
 //-----------------------------------------------------------------------------
@@ -75,14 +91,20 @@ namespace OpenZWave
 
 			s_sceneCnt--;
 			s_scenes[m_sceneId] = NULL;
+			s_dirty = true;
 		}
 
 //-----------------------------------------------------------------------------
 // <Scene::WriteXML>
-// Write ourselves to an XML document
+// Write ourselves to an XML document, if anything has changed
 //-----------------------------------------------------------------------------
 		void Scene::WriteXML(string const& _name)
 		{
+			if (!s_dirty)
+			{
+				return;
+			}
+
 			char str[16];
 
 			// Create a new XML document to contain the driver configuration
@@ -143,11 +165,14 @@ namespace OpenZWave
 			}
 
 			string userPath;
-			Options::Get()->GetOptionAsString("UserPath", &userPath);
+			Options::Get()->GetOptionAsString(Options::OptionKey_UserPath, &userPath);
 
 			string filename = userPath + _name;
 
-			doc.SaveFile(filename.c_str());
+			if (doc.SaveFile(filename.c_str()))
+			{
+				s_dirty = false;
+			}
 		}
 
 //-----------------------------------------------------------------------------
@@ -161,17 +186,17 @@ namespace OpenZWave
 
 			// Load the XML document that contains the driver configuration
 			string userPath;
-			Options::Get()->GetOptionAsString("UserPath", &userPath);
+			Options::Get()->GetOptionAsString(Options::OptionKey_UserPath, &userPath);
 
 			string filename = userPath + "zwscene.xml";
 
-			TiXmlDocument doc;
-			if (!doc.LoadFile(filename.c_str(), TIXML_ENCODING_UTF8))
+			TiXmlStreamReader reader;
+			if (!reader.LoadFile(filename.c_str(), TIXML_ENCODING_UTF8))
 			{
 				return false;
 			}
 
-			TiXmlElement const* scenesElement = doc.RootElement();
+			TiXmlElement const* scenesElement = reader.RootElement();
 
 			// Version
 			if (TIXML_SUCCESS == scenesElement->QueryIntAttribute("version", &intVal))
@@ -188,21 +213,26 @@ namespace OpenZWave
 				return false;
 			}
 
-			TiXmlElement const* sceneElement = scenesElement->FirstChildElement();
-			while (sceneElement)
+			// The scenes are only created once the whole file has parsed.  Otherwise a truncated
+			// file would load some of them, and the next save would drop the rest.
+			struct PendingScene
 			{
-				Scene* scene = NULL;
-
-				if (TIXML_SUCCESS == sceneElement->QueryIntAttribute("id", &intVal))
-				{
-					scene = new Scene((uint8) intVal);
-				}
-
-				if (scene == NULL)
+					uint8 m_sceneId;
+					string m_label;
+					vector<SceneStorage*> m_values;
+			};
+			vector<PendingScene> scenes;
+			while (TiXmlElement const* sceneElement = reader.NextElement())
+			{
+				if (TIXML_SUCCESS != sceneElement->QueryIntAttribute("id", &intVal))
 				{
 					continue;
 				}
 
+				scenes.push_back(PendingScene());
+				PendingScene* scene = &scenes.back();
+				scene->m_sceneId = (uint8) intVal;
+
 				str = sceneElement->Attribute("label");
 				if (str)
 				{
@@ -252,8 +282,28 @@ namespace OpenZWave
 
 					valueElement = valueElement->NextSiblingElement();
 				}
-				sceneElement = sceneElement->NextSiblingElement();
 			}
+			if (reader.Error())
+			{
+				Log::Write(LogLevel_Warning, "Driver::ReadScenes - Error in %s at line %d: %s.  No scenes were loaded", filename.c_str(), reader.ErrorRow(), reader.ErrorDesc());
+				for (vector<PendingScene>::iterator it = scenes.begin(); it != scenes.end(); ++it)
+				{
+					for (vector<SceneStorage*>::iterator vt = it->m_values.begin(); vt != it->m_values.end(); ++vt)
+					{
+						delete *vt;
+					}
+				}
+				return false;
+			}
+
+			for (vector<PendingScene>::iterator it = scenes.begin(); it != scenes.end(); ++it)
+			{
+				Scene* scene = new Scene(it->m_sceneId);
+				scene->m_label = it->m_label;
+				scene->m_values = it->m_values;
+			}
+			// what we have just read does not need to be written back
+			s_dirty = false;
 			return true;
 		}
 
@@ -298,6 +348,8 @@ namespace OpenZWave
 		bool Scene::AddValue(ValueID const& _valueId, string const& _value)
 		{
 			m_values.push_back(new SceneStorage(_valueId, _value));
+			m_batchValid = false;
+			s_dirty = true;
 			return true;
 		}
 
@@ -313,6 +365,8 @@ namespace OpenZWave
 				{
 					delete *it;
 					m_values.erase(it);
+					m_batchValid = false;
+					s_dirty = true;
 					return true;
 				}
 			}
@@ -331,6 +385,8 @@ namespace OpenZWave
 				{
 					delete *it;
 					m_values.erase(it);
+					m_batchValid = false;
+					s_dirty = true;
 					goto again;
 				}
 			}
@@ -358,6 +414,8 @@ namespace OpenZWave
 						{
 							delete *it;
 							scene->m_values.erase(it);
+							scene->m_batchValid = false;
+							s_dirty = true;
 							goto again;
 						}
 					}
@@ -415,26 +473,222 @@ namespace OpenZWave
 				if ((*it)->m_id == _valueId)
 				{
 					(*it)->m_value = _value;
+					(*it)->Compile();
+					s_dirty = true;
 					return true;
 				}
 			}
 			return false;
 		}
 
+//-----------------------------------------------------------------------------
+// <Scene::SceneStorage::Compile>
+// Parse the stored string once, rather than on every activation
+//-----------------------------------------------------------------------------
+		void Scene::SceneStorage::Compile()
+		{
+			m_valid = true;
+			m_int = 0;
+			switch (m_id.GetType())
+			{
+				case ValueID::ValueType_Bool:
+				{
+					if (!strcasecmp("true", m_value.c_str()))
+					{
+						m_int = 1;
+					}
+					else if (strcasecmp("false", m_value.c_str()))
+					{
+						m_valid = false;
+					}
+					break;
+				}
+				case ValueID::ValueType_Byte:
+				{
+					uint32 val = (uint32) atoi(m_value.c_str());
+					m_int = (int32) val;
+					m_valid = (val < 256);
+					break;
+				}
+				case ValueID::ValueType_Short:
+				{
+					m_int = atoi(m_value.c_str());
+					m_valid = (m_int < 32768) && (m_int >= -32768);
+					break;
+				}
+				case ValueID::ValueType_Int:
+				{
+					m_int = atoi(m_value.c_str());
+					break;
+				}
+				case ValueID::ValueType_Schedule:
+				case ValueID::ValueType_Button:
+				{
+					m_valid = false;
+					break;
+				}
+				default:
+				{
+					// the remaining types are set from the string
+					break;
+				}
+			}
+		}
+
+//-----------------------------------------------------------------------------
+// <Scene::BuildBatch>
+// Order the values by home and node id, so each node is looked up once per activation
+//-----------------------------------------------------------------------------
+		bool Scene::BatchOrder(SceneStorage const* _a, SceneStorage const* _b)
+		{
+			if (_a->m_id.GetHomeId() != _b->m_id.GetHomeId())
+			{
+				return _a->m_id.GetHomeId() < _b->m_id.GetHomeId();
+			}
+			return _a->m_id.GetNodeId() < _b->m_id.GetNodeId();
+		}
+
+		void Scene::BuildBatch()
+		{
+			m_batch = m_values;
+			// stable, so values on the same node are still set in the order they were added
+			std::stable_sort(m_batch.begin(), m_batch.end(), BatchOrder);
+			m_batchValid = true;
+		}
+
+//-----------------------------------------------------------------------------
+// <Scene::ApplyValue>
+// Set one scene value on its node.  The caller holds the driver's node mutex
+//-----------------------------------------------------------------------------
+		bool Scene::ApplyValue(Node* _node, SceneStorage const* _ss)
+		{
+			if (!_ss->m_valid)
+			{
+				return false;
+			}
+
+			Internal::VC::Value* value = _node->GetValue(_ss->m_id);
+			if (value == NULL)
+			{
+				Log::Write(LogLevel_Warning, _ss->m_id.GetNodeId(), "Scene value (CC %d, instance %d, index %d) no longer exists", _ss->m_id.GetCommandClassId(), _ss->m_id.GetInstance(), _ss->m_id.GetIndex());
+				return false;
+			}
+
+			bool res = false;
+			switch (_ss->m_id.GetType())
+			{
+				case ValueID::ValueType_BitSet:
+				{
+					res = static_cast<Internal::VC::ValueBitSet*>(value)->SetFromString(_ss->m_value);
+					break;
+				}
+				case ValueID::ValueType_Bool:
+				{
+					res = static_cast<Internal::VC::ValueBool*>(value)->Set(_ss->m_int != 0);
+					break;
+				}
+				case ValueID::ValueType_Byte:
+				{
+					res = static_cast<Internal::VC::ValueByte*>(value)->Set((uint8) _ss->m_int);
+					break;
+				}
+				case ValueID::ValueType_Decimal:
+				{
+					res = static_cast<Internal::VC::ValueDecimal*>(value)->Set(_ss->m_value);
+					break;
+				}
+				case ValueID::ValueType_Int:
+				{
+					res = static_cast<Internal::VC::ValueInt*>(value)->Set(_ss->m_int);
+					break;
+				}
+				case ValueID::ValueType_List:
+				{
+					res = static_cast<Internal::VC::ValueList*>(value)->SetByLabel(_ss->m_value);
+					break;
+				}
+				case ValueID::ValueType_Short:
+				{
+					res = static_cast<Internal::VC::ValueShort*>(value)->Set((int16) _ss->m_int);
+					break;
+				}
+				case ValueID::ValueType_String:
+				{
+					res = static_cast<Internal::VC::ValueString*>(value)->Set(_ss->m_value);
+					break;
+				}
+				case ValueID::ValueType_Raw:
+				{
+					res = static_cast<Internal::VC::ValueRaw*>(value)->SetFromString(_ss->m_value);
+					break;
+				}
+				case ValueID::ValueType_Schedule:
+				case ValueID::ValueType_Button:
+				{
+					break;
+				}
+			}
+			value->Release();
+			return res;
+		}
+
 //-----------------------------------------------------------------------------
 // <Scene::Activate>
-// Execute scene activation by running each ValueId/value
+// Execute scene activation, taking each driver's node lock once for all of its values
 //-----------------------------------------------------------------------------
 		bool Scene::Activate()
 		{
+			Internal::Platform::TimeStamp start;
+			if (!m_batchValid)
+			{
+				BuildBatch();
+			}
+
 			bool res = true;
-			for (vector<SceneStorage*>::iterator it = m_values.begin(); it != m_values.end(); ++it)
+			size_t i = 0;
+			while (i < m_batch.size())
 			{
-				if (!Manager::Get()->SetValue((*it)->m_id, (*it)->m_value))
+				uint32 homeId = m_batch[i]->m_id.GetHomeId();
+				Driver* driver = Manager::Get()->GetDriver(homeId);
+				if (driver == NULL)
+				{
+					res = false;
+					while (i < m_batch.size() && m_batch[i]->m_id.GetHomeId() == homeId)
+					{
+						++i;
+					}
+					continue;
+				}
+
+				Internal::NodesLockGuard LG(driver);
+				if (!LG.IsLocked())
 				{
+					// this thread holds one of the driver's nodes, so none of its values can be set
 					res = false;
+					while (i < m_batch.size() && m_batch[i]->m_id.GetHomeId() == homeId)
+					{
+						++i;
+					}
+					continue;
+				}
+				while (i < m_batch.size() && m_batch[i]->m_id.GetHomeId() == homeId)
+				{
+					uint8 nodeId = m_batch[i]->m_id.GetNodeId();
+					// as with Manager::SetValue, the controller's own values cannot be set
+					Node* node = (nodeId != driver->GetControllerNodeId()) ? driver->GetNodeUnsafe(nodeId) : NULL;
+					while (i < m_batch.size() && m_batch[i]->m_id.GetHomeId() == homeId && m_batch[i]->m_id.GetNodeId() == nodeId)
+					{
+						if ((node == NULL) || !ApplyValue(node, m_batch[i]))
+						{
+							res = false;
+						}
+						++i;
+					}
 				}
 			}
+
+			Internal::Platform::TimeStamp now;
+			Log::Write(LogLevel_Info, "Scene %d activated: %d values in %d ms", m_sceneId, (int) m_batch.size(), now - start);
 			return res;
 		}
 	} // namespace Internal
@@ -37,6 +37,8 @@ class TiXmlElement;
 
 namespace OpenZWave
 {
+	class Node;
+
 	namespace Internal
 	{
 
@@ -72,6 +74,7 @@ namespace OpenZWave
 				void SetLabel(string const &_label)
 				{
 					m_label = _label;
+					s_dirty = true;
 				}
 
 				bool AddValue(ValueID const& _valueId, string const& _value);
@@ -91,18 +94,26 @@ namespace OpenZWave
 				{
 					public:
 						SceneStorage(ValueID const& _id, string const& _value) :
-								m_id(_id), m_value(_value)
+								m_id(_id), m_value(_value), m_valid(false), m_int(0)
 						{
+							Compile();
 						}
 						;
 						~SceneStorage()
 						{
 						}
 						;
+						void Compile();
 
 						ValueID const m_id;
 						string m_value;
+						bool m_valid;				// m_value can be applied to a value of this type
+						int32 m_int;				// m_value parsed for Bool, Byte, Short and Int values
 				};
+
+				void BuildBatch();
+				static bool BatchOrder(SceneStorage const* _a, SceneStorage const* _b);
+				static bool ApplyValue(Node* _node, SceneStorage const* _ss);
 				//-----------------------------------------------------------------------------
 				// Member variables
 				//-----------------------------------------------------------------------------
@@ -110,8 +121,11 @@ namespace OpenZWave
 				uint8 m_sceneId;
 				string m_label;
 				vector<SceneStorage*> m_values;
+				vector<SceneStorage*> m_batch;			// m_values ordered by home and node id, for Activate
+				bool m_batchValid;
 				static uint8 s_sceneCnt;
 				static Scene* s_scenes[256];
+				static bool s_dirty;					// scenes have changed since zwscene.xml was read or written
 		};
 	} // namespace Internal
 } //namespace OpenZWave
@@ -54,7 +54,7 @@ namespace OpenZWave
 //-----------------------------------------------------------------------------
 		TimerThread::TimerThread(Driver *_driver) :
 //m_driver( _driver ),
-				m_timerEvent(new Internal::Platform::Event()), m_timerMutex(new Internal::Platform::Mutex()), m_timerTimeout(Internal::Platform::Wait::Timeout_Infinite)
+				m_timerEvent(new Internal::Platform::Event()), m_timerMutex(new Internal::Platform::Mutex("timer")), m_timerTimeout(Internal::Platform::Wait::Timeout_Infinite)
 		{
 		}
 
@@ -66,7 +66,11 @@ namespace OpenZWave
 		{
 			{
 				LockGuard LG(m_timerMutex);
-				for (list<TimerEventEntry *>::iterator it = m_timerEventList.begin(); it != m_timerEventList.end(); ++it)
+				for (vector<TimerEventEntry *>::iterator it = m_timerHeap.begin(); it != m_timerHeap.end(); ++it)
+				{
+					delete (*it);
+				}
+				for (vector<TimerEventEntry *>::iterator it = m_timerPool.begin(); it != m_timerPool.end(); ++it)
 				{
 					delete (*it);
 				}
@@ -104,30 +108,29 @@ namespace OpenZWave
 				}
 				else
 				{
-					// Timeout or new entry to timer list.
-					m_timerTimeout = Internal::Platform::Wait::Timeout_Infinite;
-
-					// Go through all waiting actions, and see if any need to be performed.
+					// Timeout or a new earliest entry in the heap.
 					LockGuard LG(m_timerMutex);
-					list<TimerEventEntry *>::iterator it = m_timerEventList.begin();
-					while (it != m_timerEventList.end())
+					m_timerEvent->Reset();
+
+					// Perform the actions that are due, earliest first.  A callback may
+					// add or delete events, so look at the top of the heap afresh each time.
+					while (!m_timerHeap.empty())
 					{
-						int32 tr = (*it)->timestamp.TimeRemaining();
-						if (tr <= 0)
-						{
-							// Expired so perform action and remove from list.
-							Log::Write(LogLevel_Info, "Timer: delayed event");
-							TimerEventEntry *te = *(it++);
-							te->instance->TimerFireEvent(te);
-						}
-						else
+						TimerEventEntry *te = m_timerHeap[0];
+						if (te->due - GetTime() > 0)
 						{
-							// Time remaining.
-							m_timerTimeout = (m_timerTimeout == Internal::Platform::Wait::Timeout_Infinite) ? tr : std::min(m_timerTimeout, tr);
-							++it;
+							break;
 						}
+						Log::Write(LogLevel_Info, "Timer: delayed event");
+						HeapRemove(te);
+						te->heapIndex = c_firing;
+						te->instance->TimerFireEvent(te);
+						// Only now that the callback has returned can the entry be reused,
+						// whether or not it was deleted while it ran
+						PoolEvent(te);
 					}
-					m_timerEvent->Reset();
+
+					m_timerTimeout = m_timerHeap.empty() ? Internal::Platform::Wait::Timeout_Infinite : std::max(m_timerHeap[0]->due - GetTime(), (int32) 0);
 				}
 			} // while( 1 )
 		}
@@ -138,15 +141,32 @@ namespace OpenZWave
 		TimerThread::TimerEventEntry* TimerThread::TimerSetEvent(int32 _milliseconds, TimerCallback _callback, Timer *_instance, uint32 id)
 		{
 			Log::Write(LogLevel_Info, "Timer: adding event in %d ms", _milliseconds);
-			TimerEventEntry *te = new TimerEventEntry();
+			// Don't want driver thread and timer thread accessing the heap at the same time.
+			LockGuard LG(m_timerMutex);
+			TimerEventEntry *te;
+			if (m_timerPool.empty())
+			{
+				te = new TimerEventEntry();
+			}
+			else
+			{
+				te = m_timerPool.back();
+				m_timerPool.pop_back();
+			}
 			te->timestamp.SetTime(_milliseconds);
 			te->callback = _callback;
 			te->instance = _instance;
 			te->id = id;
-			// Don't want driver thread and timer thread accessing list at the same time.
-			LockGuard LG(m_timerMutex);
-			m_timerEventList.push_back(te);
-			m_timerEvent->Set();
+			te->due = GetTime() + _milliseconds;
+			m_timerHeap.push_back(te);
+			HeapSet((uint32) m_timerHeap.size() - 1, te);
+			HeapUp(te->heapIndex);
+
+			// The thread only needs waking if it is now due sooner than the thread expects
+			if (te->heapIndex == 0)
+			{
+				m_timerEvent->Set();
+			}
 			return te;
 		}
 
@@ -158,16 +178,123 @@ namespace OpenZWave
 		void TimerThread::TimerDelEvent(TimerEventEntry *te)
 		{
 			LockGuard LG(m_timerMutex);
-			list<TimerEventEntry *>::iterator it = find(m_timerEventList.begin(), m_timerEventList.end(), te);
-			if (it != m_timerEventList.end())
+			if (te->heapIndex == c_firing)
 			{
-				delete ((*it));
-				m_timerEventList.erase(it);
+				// Its callback is still running.  The thread pools it once the callback
+				// returns, so a timer set from the callback cannot be given this entry.
+				te->heapIndex = c_deleted;
+				return;
 			}
-			else
+			uint32 index = te->heapIndex;
+			if (index >= m_timerHeap.size() || m_timerHeap[index] != te)
 			{
 				Log::Write(LogLevel_Warning, "Cant Find TimerEvent to Delete in TimerDelEvent");
+				return;
+			}
+			HeapRemove(te);
+			PoolEvent(te);
+		}
+
+//-----------------------------------------------------------------------------
+// <TimerThread::PoolEvent>
+// Keep an entry that is no longer queued or firing for reuse
+//-----------------------------------------------------------------------------
+		void TimerThread::PoolEvent(TimerEventEntry *te)
+		{
+			// Drop whatever the callback had bound
+			te->heapIndex = c_notQueued;
+			te->callback = TimerCallback();
+			te->instance = NULL;
+			m_timerPool.push_back(te);
+		}
+
+//-----------------------------------------------------------------------------
+// <TimerThread::GetTime>
+// Milliseconds since m_timerEpoch
+//-----------------------------------------------------------------------------
+		int32 TimerThread::GetTime()
+		{
+			Internal::Platform::TimeStamp now;
+			int32 elapsed = now - m_timerEpoch;
+			if (elapsed > 0x40000000)
+			{
+				// move the epoch forward every 12 days or so, so the due times cannot overflow
+				for (vector<TimerEventEntry *>::iterator it = m_timerHeap.begin(); it != m_timerHeap.end(); ++it)
+				{
+					(*it)->due -= elapsed;
+				}
+				m_timerEpoch.SetTime();
+				elapsed = 0;
+			}
+			return elapsed;
+		}
+
+//-----------------------------------------------------------------------------
+// <TimerThread::HeapRemove>
+// Take an entry out of the heap
+//-----------------------------------------------------------------------------
+		void TimerThread::HeapRemove(TimerEventEntry *te)
+		{
+			// Move the last entry into the hole, and restore the heap order around it
+			uint32 index = te->heapIndex;
+			TimerEventEntry *last = m_timerHeap.back();
+			m_timerHeap.pop_back();
+			if (last != te)
+			{
+				HeapSet(index, last);
+				HeapUp(index);
+				HeapDown(last->heapIndex);
 			}
+			te->heapIndex = c_notQueued;
+		}
+
+//-----------------------------------------------------------------------------
+// <TimerThread::HeapUp>
+// Move an entry towards the top of the heap until its parent is due no later
+//-----------------------------------------------------------------------------
+		void TimerThread::HeapUp(uint32 _index)
+		{
+			TimerEventEntry *te = m_timerHeap[_index];
+			while (_index > 0)
+			{
+				uint32 parent = (_index - 1) / 2;
+				if (m_timerHeap[parent]->due - te->due <= 0)
+				{
+					break;
+				}
+				HeapSet(_index, m_timerHeap[parent]);
+				_index = parent;
+			}
+			HeapSet(_index, te);
+		}
+
+//-----------------------------------------------------------------------------
+// <TimerThread::HeapDown>
+// Move an entry towards the bottom of the heap until its children are due no sooner
+//-----------------------------------------------------------------------------
+		void TimerThread::HeapDown(uint32 _index)
+		{
+			TimerEventEntry *te = m_timerHeap[_index];
+			uint32 size = (uint32) m_timerHeap.size();
+			while (true)
+			{
+				uint32 child = 2 * _index + 1;
+				if (child >= size)
+				{
+					break;
+				}
+				if (child + 1 < size && m_timerHeap[child + 1]->due - m_timerHeap[child]->due < 0)
+				{
+					++child;
+				}
+				if (te->due - m_timerHeap[child]->due <= 0)
+				{
+					break;
+				}
+				HeapSet(_index, m_timerHeap[child]);
+				_index = child;
+			}
+			HeapSet(_index, te);
 		}
 
 //-----------------------------------------------------------------------------
@@ -315,7 +442,13 @@ namespace OpenZWave
 		void Timer::TimerFireEvent(TimerThread::TimerEventEntry *te)
 		{
 			te->callback(te->id);
-			TimerDelEvent(te);
+			// The callback may have deleted the event itself, perhaps to set it again
+			list<TimerThread::TimerEventEntry *>::iterator it = find(m_timerEventList.begin(), m_timerEventList.end(), te);
+			if ((it != m_timerEventList.end()) && m_driver)
+			{
+				m_driver->GetTimer()->TimerDelEvent(te);
+				m_timerEventList.erase(it);
+			}
 		}
 	} // namespace Internal
 } // namespace OpenZWave
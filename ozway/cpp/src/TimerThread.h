@@ -38,6 +38,9 @@ using std::tr1::bind;
 using std::tr1::function;
 #endif
 
+#include <list>
+#include <vector>
+
 #include "Defs.h"
 #include "platform/Event.h"
 #include "platform/Mutex.h"
@@ -55,6 +58,7 @@ namespace OpenZWave
 		class OPENZWAVE_EXPORT TimerThread
 		{
 				friend class Timer;
+				friend class TimerThreadTest;
 				//-----------------------------------------------------------------------------
 				//  Timer based actions
 				//-----------------------------------------------------------------------------
@@ -78,6 +82,8 @@ namespace OpenZWave
 						Internal::Platform::TimeStamp timestamp;
 						TimerCallback callback;
 						uint32 id;
+						int32 due;					// ms since m_timerEpoch
+						uint32 heapIndex;			// Position in m_timerHeap, c_firing or c_notQueued
 				};
 
 				/**
@@ -110,8 +116,29 @@ namespace OpenZWave
 				 */
 				void TimerThreadProc(Internal::Platform::Event* _exitEvent);
 
-				/** A list of upcoming timer events */
-				list<TimerEventEntry *> m_timerEventList;
+				/**
+				 * Milliseconds since m_timerEpoch
+				 */
+				int32 GetTime();
+				void PoolEvent(TimerEventEntry* _te);
+				void HeapRemove(TimerEventEntry* _te);
+				void HeapUp(uint32 _index);
+				void HeapDown(uint32 _index);
+				void HeapSet(uint32 _index, TimerEventEntry* _te)
+				{
+					m_timerHeap[_index] = _te;
+					_te->heapIndex = _index;
+				}
+
+				static uint32 const c_notQueued = 0xffffffff;		// in m_timerPool
+				static uint32 const c_firing = 0xfffffffe;			// its callback is running
+				static uint32 const c_deleted = 0xfffffffd;			// its callback is running, and it has been deleted
+
+				/** The upcoming timer events, as a binary heap with the earliest first */
+				vector<TimerEventEntry *> m_timerHeap;
+				/** Entries that have fired or been deleted, ready to be reused */
+				vector<TimerEventEntry *> m_timerPool;
+				Internal::Platform::TimeStamp m_timerEpoch;
 
 				Internal::Platform::Event* m_timerEvent;   // Event to signal new timed action requested
 				Internal::Platform::Mutex* m_timerMutex;   // Serialize access to class members
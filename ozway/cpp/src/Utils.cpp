@@ -27,6 +27,7 @@
 
 #include "Defs.h"
 #include "Utils.h"
+#include "Options.h"
 #include <functional>
 
 namespace OpenZWave
@@ -204,6 +205,11 @@ namespace OpenZWave
 					}
 			}
 		}
+
+		SecurityStrategy ShouldSecureCommandClass(uint8 const _commandClassId)
+		{
+			return Options::Get()->IsSecuredCC(_commandClassId) ? SecurityStrategy_Supported : SecurityStrategy_Essential;
+		}
 	} // namespace Internal
 } // namespace OpenZWave
 
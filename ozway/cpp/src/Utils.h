@@ -156,6 +156,20 @@ namespace OpenZWave
 
 		const char* rssi_to_string(uint8 _data);
 
+		enum SecurityStrategy
+		{
+			SecurityStrategy_Essential = 0,
+			SecurityStrategy_Supported
+		};
+
+		/**
+		 * Decide, from the SecurityStrategy and CustomSecuredCC options, whether a command
+		 * class that a node supports both in clear text and via the Security CC should be encrypted.
+		 * \param _commandClassId the command class.
+		 * \return SecurityStrategy_Supported if the command class should be encrypted.
+		 */
+		SecurityStrategy ShouldSecureCommandClass(uint8 const _commandClassId);
+
 #ifndef WIN32
 #ifndef WINRT
 #ifdef DEBUG
@@ -60,7 +60,7 @@ namespace OpenZWave
 // Constructor
 //-----------------------------------------------------------------------------
 			CommandClass::CommandClass(uint32 const _homeId, uint8 const _nodeId) :
-					m_com(CompatOptionType_Compatibility, this), m_dom(CompatOptionType_Discovery, this), m_homeId(_homeId), m_nodeId(_nodeId), m_SecureSupport(true), m_sentCnt(0), m_receivedCnt(0)
+					m_com(CompatOptionType_Compatibility, this), m_dom(CompatOptionType_Discovery, this), m_homeId(_homeId), m_nodeId(_nodeId), m_SecureSupport(true), m_sentCnt(0), m_receivedCnt(0), m_latency(NULL)
 			{
 				m_com.EnableFlag(COMPAT_FLAG_GETSUPPORTED, true);
 				m_com.EnableFlag(COMPAT_FLAG_OVERRIDEPRECISION, 0);
@@ -106,7 +106,7 @@ namespace OpenZWave
 					}
 					m_RefreshClassValues.clear();
 				}
-
+				delete[] m_latency;
 			}
 
 //-----------------------------------------------------------------------------
@@ -803,6 +803,23 @@ namespace OpenZWave
 				}
 			}
 
+//-----------------------------------------------------------------------------
+// <CommandClass::RecordLatency>
+// Count a latency of a request for this command class
+//-----------------------------------------------------------------------------
+			void CommandClass::RecordLatency(Node::Latency const _kind, uint32 const _ms)
+			{
+				if (_kind >= Node::Latency_Count)
+				{
+					return;
+				}
+				if (!m_latency)
+				{
+					m_latency = new LatencyHistogram[Node::Latency_Count];
+				}
+				m_latency[_kind].Record(_ms);
+			}
+
 			bool CommandClass::HandleIncomingMsg(uint8 const* _data, uint32 const _length, uint32 const _instance)
 			{
 				Log::Write(LogLevel_Warning, GetNodeId(), "Routing HandleIncomingMsg to HandleMsg - Please Report: %s ", GetCommandClassName().c_str());
@@ -282,10 +282,17 @@ namespace OpenZWave
 					{
 						m_receivedCnt++;
 					}
+					void RecordLatency(Node::Latency const _kind, uint32 const _ms);
+					/** The latency histograms, indexed by Node::Latency, or NULL if nothing has been recorded yet */
+					LatencyHistogram const* GetLatency() const
+					{
+						return m_latency;
+					}
 
 				private:
 					uint32 m_sentCnt;				// Number of messages sent from this command class.
 					uint32 m_receivedCnt;				// Number of messages received from this commandclass.
+					LatencyHistogram* m_latency;			// Allocated on first use, as most command classes never see a request
 
 			};
 //@}
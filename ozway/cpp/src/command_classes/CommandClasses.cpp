@@ -245,7 +245,7 @@ namespace OpenZWave
 				// Now all the command classes have been registered, we can modify the
 				// supported command classes array according to the program options.
 				string str;
-				Options::Get()->GetOptionAsString("Include", &str);
+				Options::Get()->GetOptionAsString(Options::OptionKey_Include, &str);
 				if (str != "")
 				{
 					// The include list has entries, so we assume that it is a
@@ -256,7 +256,7 @@ namespace OpenZWave
 				}
 
 				// Apply the excluded command class option
-				Options::Get()->GetOptionAsString("Exclude", &str);
+				Options::Get()->GetOptionAsString(Options::OptionKey_Exclude, &str);
 				if (str != "")
 				{
 					cc.ParseCommandClassOption(str, false);
@@ -215,7 +215,7 @@ namespace OpenZWave
 						}
 					}
 					i = m_nodeId == -1 ? 0 : m_nodeId + 1;
-					LockGuard LG(GetDriver()->m_nodeMutex);
+					NodesLockGuard LG(GetDriver());
 					while (i < 256)
 					{
 						if (GetDriver()->m_nodes[i])
@@ -36,6 +36,7 @@
 #include "Manager.h"
 #include "Driver.h"
 #include "ManufacturerSpecificDB.h"
+#include "ConfigBundle.h"
 #include "Notification.h"
 #include "platform/Log.h"
 
@@ -274,14 +275,11 @@ namespace OpenZWave
 				if (GetNodeUnsafe()->getConfigPath().size() == 0)
 					return false;
 
-				string configPath;
-				Options::Get()->GetOptionAsString("ConfigPath", &configPath);
-
-				string filename = configPath + GetNodeUnsafe()->getConfigPath();
+				string filename;
 
 				TiXmlDocument* doc = new TiXmlDocument();
-				Log::Write(LogLevel_Info, GetNodeId(), "  Opening config param file %s", filename.c_str());
-				if (!doc->LoadFile(filename.c_str(), TIXML_ENCODING_UTF8))
+				Log::Write(LogLevel_Info, GetNodeId(), "  Opening config param file %s", GetNodeUnsafe()->getConfigPath().c_str());
+				if (!Internal::ConfigBundle::LoadDocument(GetNodeUnsafe()->getConfigPath(), doc, &filename))
 				{
 					delete doc;
 					Log::Write(LogLevel_Info, GetNodeId(), "Unable to find or load Config Param file %s", filename.c_str());
@@ -63,7 +63,7 @@ namespace OpenZWave
 				m_com.EnableFlag(COMPAT_FLAG_UC_EXPOSERAWVALUE, false);
 				m_dom.EnableFlag(STATE_FLAG_USERCODE_COUNT, 0);
 				SetStaticRequest(StaticRequest_Values);
-				Options::Get()->GetOptionAsBool("RefreshAllUserCodes", &m_refreshUserCodes);
+				Options::Get()->GetOptionAsBool(Options::OptionKey_RefreshAllUserCodes, &m_refreshUserCodes);
 
 			}
 
@@ -247,7 +247,7 @@ namespace OpenZWave
 							{
 								m_queryAll = false;
 								/* we might have reset this as part of the RefreshValues Button Value */
-								Options::Get()->GetOptionAsBool("RefreshAllUserCodes", &m_refreshUserCodes);
+								Options::Get()->GetOptionAsBool(Options::OptionKey_RefreshAllUserCodes, &m_refreshUserCodes);
 							}
 						}
 						else
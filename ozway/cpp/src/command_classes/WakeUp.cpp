@@ -59,15 +59,37 @@ namespace OpenZWave
 				WakeUpCmd_IntervalCapabilitiesReport = 0x0A
 			};
 
+			// Sets for which only the most recent one queued for a sleeping device needs to be sent
+			struct ReplaceableSet
+			{
+					uint8 m_commandClassId;
+					uint8 m_command;
+					uint8 m_indexBytes;			// parameter bytes that say which value is set
+			};
+			static ReplaceableSet const c_replaceableSets[] =
+			{
+				{ 0x20, 0x01, 0 },		// Basic Set
+				{ 0x25, 0x01, 0 },		// Switch Binary Set
+				{ 0x26, 0x01, 0 },		// Switch Multilevel Set
+				{ 0x33, 0x05, 0 },		// Switch Color Set
+				{ 0x40, 0x01, 0 },		// Thermostat Mode Set
+				{ 0x43, 0x01, 1 },		// Thermostat Setpoint Set (setpoint type)
+				{ 0x44, 0x01, 0 },		// Thermostat Fan Mode Set
+				{ 0x63, 0x01, 1 },		// User Code Set (user identifier)
+				{ 0x70, 0x04, 1 },		// Configuration Set (parameter number)
+				{ 0x75, 0x01, 0 },		// Protection Set
+				{ 0x84, WakeUpCmd_IntervalSet, 0 }
+			};
+
 //-----------------------------------------------------------------------------
 // <WakeUp::WakeUp>
 // Constructor
 //-----------------------------------------------------------------------------
 			WakeUp::WakeUp(uint32 const _homeId, uint8 const _nodeId) :
-					CommandClass(_homeId, _nodeId), m_mutex(new Internal::Platform::Mutex()), m_awake(true), m_pollRequired(false)
+					CommandClass(_homeId, _nodeId), m_mutex(new Internal::Platform::Mutex("wakeup")), m_awake(true), m_pollRequired(false)
 			{
 				Timer::SetDriver(GetDriver());
-				Options::Get()->GetOptionAsBool("AssumeAwake", &m_awake);
+				Options::Get()->GetOptionAsBool(Options::OptionKey_AssumeAwake, &m_awake);
 				m_com.EnableFlag(COMPAT_FLAG_WAKEUP_DELAYNMI, 0);
 				SetStaticRequest(StaticRequest_Values);
 			}
@@ -79,18 +101,13 @@ namespace OpenZWave
 			WakeUp::~WakeUp()
 			{
 				m_mutex->Release();
-				while (!m_pendingQueue.empty())
+				for (int i = 0; i < Driver::MsgQueue_Count; ++i)
 				{
-					Driver::MsgQueueItem const& item = m_pendingQueue.front();
-					if (Driver::MsgQueueCmd_SendMsg == item.m_command)
+					while (!m_pendingQueue[i].empty())
 					{
-						delete item.m_msg;
+						DeleteItem(m_pendingQueue[i].front());
+						m_pendingQueue[i].pop_front();
 					}
-					else if (Driver::MsgQueueCmd_Controller == item.m_command)
-					{
-						delete item.m_cci;
-					}
-					m_pendingQueue.pop_front();
 				}
 			}
 
@@ -351,46 +368,137 @@ namespace OpenZWave
 				}
 			}
 
+//-----------------------------------------------------------------------------
+// <WakeUp::GetPendingKey>
+// Identify what a message asks of the device.  Messages with the same key
+// replace each other in the pending queue.
+//-----------------------------------------------------------------------------
+			string WakeUp::GetPendingKey(Driver::MsgQueueItem const& _item)
+			{
+				if (Driver::MsgQueueCmd_QueryStageComplete == _item.m_command)
+				{
+					return string(1, 'q') + (char) _item.m_queryStage;
+				}
+				if (Driver::MsgQueueCmd_ReloadNode == _item.m_command)
+				{
+					return "r";
+				}
+				uint8 length;
+				uint8 const* payload = (Driver::MsgQueueCmd_SendMsg == _item.m_command) ? _item.m_msg->GetPayload(&length) : NULL;
+				if (!payload || length < 2)
+				{
+					// compared in full instead
+					return "";
+				}
+
+				// Skip over any Multi Channel encapsulation, although it remains part of the key
+				uint8 header = 0;
+				if (payload[0] == 0x60 && payload[1] == 0x0d && length >= 6)
+				{
+					header = 4;
+				}
+				else if (payload[0] == 0x60 && payload[1] == 0x06 && length >= 5)
+				{
+					header = 3;
+				}
+
+				// Only the last of these needs to be sent.  The number of leading parameter
+				// bytes that identify what is being set are part of the key.
+				for (uint32 i = 0; i < sizeof(c_replaceableSets) / sizeof(c_replaceableSets[0]); ++i)
+				{
+					if (c_replaceableSets[i].m_commandClassId == payload[header] && c_replaceableSets[i].m_command == payload[header + 1])
+					{
+						uint32 keyLength = header + 2 + c_replaceableSets[i].m_indexBytes;
+						if (keyLength <= length)
+						{
+							return string(1, 's') + string((char const*) payload, keyLength);
+						}
+					}
+				}
+
+				// Anything else (gets in particular) only replaces an identical copy
+				return string(1, 'm') + string((char const*) payload, length);
+			}
+
+//-----------------------------------------------------------------------------
+// <WakeUp::DeleteItem>
+// Free a queue item that will not be sent
+//-----------------------------------------------------------------------------
+			void WakeUp::DeleteItem(Driver::MsgQueueItem const& _item)
+			{
+				if (Driver::MsgQueueCmd_SendMsg == _item.m_command)
+				{
+					delete _item.m_msg;
+				}
+				else if (Driver::MsgQueueCmd_Controller == _item.m_command)
+				{
+					delete _item.m_cci;
+				}
+			}
+
 //-----------------------------------------------------------------------------
 // <WakeUp::QueueMsg>
 // Add a Z-Wave message to the queue
 //-----------------------------------------------------------------------------
-			void WakeUp::QueueMsg(Driver::MsgQueueItem const& _item)
+			void WakeUp::QueueMsg(Driver::MsgQueueItem const& _item, Driver::MsgQueue const _queue	// = Driver::MsgQueue_WakeUp
+					)
 			{
 				m_mutex->Lock();
 
-				// See if there is already a copy of this message in the queue.  If so,
+				// See if there is already a message in the queue for the same thing.  If so,
 				// we delete it.  This is to prevent duplicates building up if the
-				// device does not wake up very often.  Deleting the original and
-				// adding the copy to the end avoids problems with the order of
-				// commands such as on and off.
-				list<Driver::MsgQueueItem>::iterator it = m_pendingQueue.begin();
-				while (it != m_pendingQueue.end())
+				// device does not wake up very often, and means only the latest set of
+				// a value is sent.  Deleting the original and adding the copy to the end
+				// avoids problems with the order of commands such as on and off.
+				Driver::MsgQueue queue = _queue;
+				string key = GetPendingKey(_item);
+				if (!key.empty())
 				{
-					Driver::MsgQueueItem const& item = *it;
-					if (item == _item)
+					map<string, PendingRef>::iterator pit = m_pendingIndex.find(key);
+					if (pit != m_pendingIndex.end())
 					{
-						// Duplicate found
-						if (Driver::MsgQueueCmd_SendMsg == item.m_command)
-						{
-							delete item.m_msg;
-						}
-						else if (Driver::MsgQueueCmd_Controller == item.m_command)
-						{
-							delete item.m_cci;
-						}
-						m_pendingQueue.erase(it++);
+						Log::Write(LogLevel_Detail, GetNodeId(), "Replacing a pending message for the same request");
+						GetDriver()->m_duplicateReplaced++;
+						// the replacement is sent no later than the original would have been
+						queue = min(queue, pit->second.m_queue);
+						DeleteItem(*pit->second.m_it);
+						m_pendingQueue[pit->second.m_queue].erase(pit->second.m_it);
+						m_pendingIndex.erase(pit);
 					}
-					else
+				}
+				else
+				{
+					for (int i = 0; i < Driver::MsgQueue_Count; ++i)
 					{
-						++it;
+						list<Driver::MsgQueueItem>::iterator it = m_pendingQueue[i].begin();
+						while (it != m_pendingQueue[i].end())
+						{
+							if (*it == _item)
+							{
+								// Duplicate found
+								queue = min(queue, (Driver::MsgQueue) i);
+								GetDriver()->m_duplicateReplaced++;
+								DeleteItem(*it);
+								it = m_pendingQueue[i].erase(it);
+							}
+							else
+							{
+								++it;
+							}
+						}
 					}
 				}
 				/* make sure the SendAttempts is reset to 0 */
 				if (_item.m_command == Driver::MsgQueueCmd_SendMsg)
 					_item.m_msg->SetSendAttempts(0);
 
-				m_pendingQueue.push_back(_item);
+				m_pendingQueue[queue].push_back(_item);
+				if (!key.empty())
+				{
+					PendingRef& ref = m_pendingIndex[key];
+					ref.m_queue = queue;
+					ref.m_it = --m_pendingQueue[queue].end();
+				}
 				m_mutex->Unlock();
 			}
 
@@ -403,30 +511,35 @@ namespace OpenZWave
 				m_awake = true;
 				bool reloading = false;
 				m_mutex->Lock();
-				list<Driver::MsgQueueItem>::iterator it = m_pendingQueue.begin();
-				while (it != m_pendingQueue.end())
+				// User commands go first, and polls last
+				for (int i = 0; i < Driver::MsgQueue_Count; ++i)
 				{
-					Driver::MsgQueueItem const& item = *it;
-					if (Driver::MsgQueueCmd_SendMsg == item.m_command)
-					{
-						GetDriver()->SendMsg(item.m_msg, Driver::MsgQueue_WakeUp);
-					}
-					else if (Driver::MsgQueueCmd_QueryStageComplete == item.m_command)
-					{
-						GetDriver()->SendQueryStageComplete(item.m_nodeId, item.m_queryStage);
-					}
-					else if (Driver::MsgQueueCmd_Controller == item.m_command)
+					list<Driver::MsgQueueItem>::iterator it = m_pendingQueue[i].begin();
+					while (it != m_pendingQueue[i].end())
 					{
-						GetDriver()->BeginControllerCommand(item.m_cci->m_controllerCommand, item.m_cci->m_controllerCallback, item.m_cci->m_controllerCallbackContext, item.m_cci->m_highPower, item.m_cci->m_controllerCommandNode, item.m_cci->m_controllerCommandArg);
-						delete item.m_cci;
-					}
-					else if (Driver::MsgQueueCmd_ReloadNode == item.m_command)
-					{
-						GetDriver()->ReloadNode(item.m_nodeId);
-						reloading = true;
+						Driver::MsgQueueItem const& item = *it;
+						if (Driver::MsgQueueCmd_SendMsg == item.m_command)
+						{
+							GetDriver()->SendMsg(item.m_msg, Driver::MsgQueue_WakeUp);
+						}
+						else if (Driver::MsgQueueCmd_QueryStageComplete == item.m_command)
+						{
+							GetDriver()->SendQueryStageComplete(item.m_nodeId, item.m_queryStage);
+						}
+						else if (Driver::MsgQueueCmd_Controller == item.m_command)
+						{
+							GetDriver()->BeginControllerCommand(item.m_cci->m_controllerCommand, item.m_cci->m_controllerCallback, item.m_cci->m_controllerCallbackContext, item.m_cci->m_highPower, item.m_cci->m_controllerCommandNode, item.m_cci->m_controllerCommandArg);
+							delete item.m_cci;
+						}
+						else if (Driver::MsgQueueCmd_ReloadNode == item.m_command)
+						{
+							GetDriver()->ReloadNode(item.m_nodeId);
+							reloading = true;
+						}
+						it = m_pendingQueue[i].erase(it);
 					}
-					it = m_pendingQueue.erase(it);
 				}
+				m_pendingIndex.clear();
 				m_mutex->Unlock();
 
 				// Send the device back to sleep, unless we have outstanding queries.
@@ -29,6 +29,7 @@
 #define _WakeUp_H
 
 #include <list>
+#include <map>
 #include "command_classes/CommandClass.h"
 #include "Driver.h"
 #include "TimerThread.h"
@@ -67,7 +68,14 @@ namespace OpenZWave
 					}
 
 					void Init();	// Starts the process of requesting node state from a sleeping device.
-					void QueueMsg(Driver::MsgQueueItem const& _item);
+					/**
+					 * \brief Hold a message until the device wakes up.
+					 * A request for the same thing as one that is already pending replaces it, so
+					 * only the latest set of a value and a single get of it are sent.
+					 * \param _item the message
+					 * \param _queue the queue the message would have been sent from, which sets its priority
+					 */
+					void QueueMsg(Driver::MsgQueueItem const& _item, Driver::MsgQueue const _queue = Driver::MsgQueue_WakeUp);
 
 					/** \brief Send all pending messages followed by a no more information message. */
 					void SendPending();
@@ -110,9 +118,18 @@ namespace OpenZWave
 
 				private:
 					WakeUp(uint32 const _homeId, uint8 const _nodeId);
+					static string GetPendingKey(Driver::MsgQueueItem const& _item);
+					void DeleteItem(Driver::MsgQueueItem const& _item);
+
+					struct PendingRef
+					{
+							Driver::MsgQueue m_queue;
+							list<Driver::MsgQueueItem>::iterator m_it;
+					};
 
 					Internal::Platform::Mutex* m_mutex;			// Serialize access to the pending queue
-					list<Driver::MsgQueueItem> m_pendingQueue;		// Messages waiting to be sent when the device wakes up
+					list<Driver::MsgQueueItem> m_pendingQueue[Driver::MsgQueue_Count];		// Messages waiting to be sent when the device wakes up, by the queue they were sent from
+					map<string, PendingRef> m_pendingIndex;			// Pending messages by what they request (see GetPendingKey)
 					bool m_awake;
 					bool m_pollRequired;
 			};
@@ -155,6 +155,43 @@ namespace OpenZWave
 				return false;
 			}
 
+			/**
+			 * FileMap. Map a File read-only into memory
+			 * \param string. file name
+			 * \return Bool value indicating success.
+			 */
+			bool FileOps::FileMap(const string &_fileName, uint8 const** o_data, size_t* o_size)
+			{
+				if (s_instance != NULL)
+				{
+					return s_instance->m_pImpl->FileMap(_fileName, o_data, o_size);
+				}
+				return false;
+			}
+
+			/**
+			 * FileUnmap. Release a mapping obtained from FileMap
+			 */
+			void FileOps::FileUnmap(uint8 const* _data, size_t _size)
+			{
+				if (s_instance != NULL)
+				{
+					s_instance->m_pImpl->FileUnmap(_data, _size);
+				}
+			}
+
+			/**
+			 * FileStat. Get the modification time and size of a File
+			 */
+			bool FileOps::FileStat(const string &_fileName, uint64* o_mtime, uint64* o_size)
+			{
+				if (s_instance != NULL)
+				{
+					return s_instance->m_pImpl->FileStat(_fileName, o_mtime, o_size);
+				}
+				return false;
+			}
+
 //-----------------------------------------------------------------------------
 //	<FileOps::FileOps>
 //	Constructor
@@ -102,6 +102,32 @@ namespace OpenZWave
 					 */
 					static bool FolderCreate(const string &_folderName);
 
+					/**
+					 * FileMap. Map a File read-only into memory
+					 * \param string. file name
+					 * \param o_data. receives a pointer to the start of the mapped file
+					 * \param o_size. receives the size of the mapped file in bytes
+					 * \return Bool value indicating success.
+					 * \see FileUnmap
+					 */
+					static bool FileMap(const string &_fileName, uint8 const** o_data, size_t* o_size);
+
+					/**
+					 * FileUnmap. Release a mapping obtained from FileMap
+					 * \param _data. pointer returned by FileMap
+					 * \param _size. size returned by FileMap
+					 */
+					static void FileUnmap(uint8 const* _data, size_t _size);
+
+					/**
+					 * FileStat. Get the modification time and size of a File
+					 * \param string. file name
+					 * \param o_mtime. receives the modification time, in seconds since the epoch
+					 * \param o_size. receives the size of the file in bytes
+					 * \return Bool value indicating the file exists.
+					 */
+					static bool FileStat(const string &_fileName, uint64* o_mtime, uint64* o_size);
+
 				private:
 					FileOps();
 					~FileOps();
@@ -25,8 +25,16 @@
 //	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
 //
 //-----------------------------------------------------------------------------
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <algorithm>
+
 #include "Defs.h"
 #include "platform/Mutex.h"
+#include "platform/Log.h"
+#include "platform/Thread.h"
 
 #ifdef WIN32
 #include "platform/windows/MutexImpl.h"	// Platform-specific implementation of a mutex
@@ -42,14 +50,60 @@ namespace OpenZWave
 	{
 		namespace Platform
 		{
+			struct Mutex::Profile
+			{
+					Profile() :
+							m_instances(0), m_locks(0), m_contended(0), m_waitTotal(0), m_waitMax(0), m_holdMax(0)
+					{
+					}
+					std::atomic<uint32> m_instances;
+					std::atomic<uint32> m_locks;
+					std::atomic<uint32> m_contended;
+					std::atomic<uint64> m_waitTotal;
+					std::atomic<uint32> m_waitMax;
+					std::atomic<uint32> m_holdMax;
+					string m_holdMaxThread;			// Guarded by ProfilesMutex
+			};
+
+			static std::atomic<bool> s_profiling(false);
+
+			// The profiles live until the process exits, so that mutexes can be
+			// created and destroyed at any time, including during static destruction
+			static std::mutex& ProfilesMutex()
+			{
+				static std::mutex* s_mutex = new std::mutex();
+				return *s_mutex;
+			}
+
+			static map<string, Mutex::Profile*>& Profiles()
+			{
+				static map<string, Mutex::Profile*>* s_profiles = new map<string, Mutex::Profile*>();
+				return *s_profiles;
+			}
+
+			static inline uint64 Now()
+			{
+				return (uint64) std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+			}
 
 //-----------------------------------------------------------------------------
 //	<Mutex::Mutex>
 //	Constructor
 //-----------------------------------------------------------------------------
-			Mutex::Mutex() :
-					m_pImpl(new MutexImpl())
+			Mutex::Mutex(char const* _name) :
+					m_pImpl(new MutexImpl()), m_profile(NULL), m_depth(0), m_holdStart(0)
 			{
+				if (_name != NULL)
+				{
+					std::lock_guard<std::mutex> lock(ProfilesMutex());
+					Profile*& profile = Profiles()[_name];
+					if (profile == NULL)
+					{
+						profile = new Profile();
+					}
+					profile->m_instances++;
+					m_profile = profile;
+				}
 			}
 
 //-----------------------------------------------------------------------------
@@ -68,7 +122,42 @@ namespace OpenZWave
 			bool Mutex::Lock(bool const _bWait // = true;
 					)
 			{
-				return m_pImpl->Lock(_bWait);
+				if ((m_profile == NULL) || !s_profiling.load(std::memory_order_relaxed))
+				{
+					return m_pImpl->Lock(_bWait);
+				}
+
+				// Try for it first, so that we know whether we had to wait
+				uint32 wait = 0;
+				bool contended = false;
+				if (!m_pImpl->Lock(false))
+				{
+					if (!_bWait)
+					{
+						return false;
+					}
+					uint64 start = Now();
+					m_pImpl->Lock(true);
+					wait = (uint32) std::min(Now() - start, (uint64) UINT32_MAX);
+					contended = true;
+				}
+
+				// We hold the lock now, so the depth and hold time are ours to update
+				if (m_depth++ == 0)
+				{
+					m_holdStart = Now();
+					m_profile->m_locks++;
+					if (contended)
+					{
+						m_profile->m_contended++;
+						m_profile->m_waitTotal += wait;
+						uint32 max = m_profile->m_waitMax.load(std::memory_order_relaxed);
+						while (wait > max && !m_profile->m_waitMax.compare_exchange_weak(max, wait))
+						{
+						}
+					}
+				}
+				return true;
 			}
 
 //-----------------------------------------------------------------------------
@@ -77,6 +166,21 @@ namespace OpenZWave
 //-----------------------------------------------------------------------------
 			void Mutex::Unlock()
 			{
+				// m_depth stays 0 for mutexes locked while profiling was off
+				if ((m_depth > 0) && (--m_depth == 0))
+				{
+					uint32 hold = (uint32) std::min(Now() - m_holdStart, (uint64) UINT32_MAX);
+					if (hold > m_profile->m_holdMax.load(std::memory_order_relaxed))
+					{
+						std::lock_guard<std::mutex> lock(ProfilesMutex());
+						if (hold > m_profile->m_holdMax)
+						{
+							m_profile->m_holdMax = hold;
+							m_profile->m_holdMaxThread = Thread::GetCurrentName();
+						}
+					}
+				}
+
 				m_pImpl->Unlock();
 
 				if (IsSignalled())
@@ -94,6 +198,79 @@ namespace OpenZWave
 			{
 				return m_pImpl->IsSignalled();
 			}
+
+//-----------------------------------------------------------------------------
+//	<Mutex::EnableProfiling>
+//	Start or stop collecting lock statistics
+//-----------------------------------------------------------------------------
+			void Mutex::EnableProfiling(bool const _enable)
+			{
+				s_profiling = _enable;
+			}
+
+//-----------------------------------------------------------------------------
+//	<Mutex::IsProfiling>
+//	Are lock statistics being collected
+//-----------------------------------------------------------------------------
+			bool Mutex::IsProfiling()
+			{
+				return s_profiling;
+			}
+
+//-----------------------------------------------------------------------------
+//	<Mutex::GetStatistics>
+//	Copy out the lock statistics of every named mutex
+//-----------------------------------------------------------------------------
+			void Mutex::GetStatistics(vector<Statistics>* o_statistics)
+			{
+				o_statistics->clear();
+				std::lock_guard<std::mutex> lock(ProfilesMutex());
+				for (map<string, Profile*>::const_iterator it = Profiles().begin(); it != Profiles().end(); ++it)
+				{
+					Profile const* profile = it->second;
+					Statistics data;
+					data.m_name = it->first;
+					data.m_instances = profile->m_instances;
+					data.m_locks = profile->m_locks;
+					data.m_contended = profile->m_contended;
+					data.m_waitTotal = profile->m_waitTotal;
+					data.m_waitMax = profile->m_waitMax;
+					data.m_holdMax = profile->m_holdMax;
+					data.m_holdMaxThread = profile->m_holdMaxThread;
+					o_statistics->push_back(data);
+				}
+			}
+
+			static bool MoreContended(Mutex::Statistics const& _a, Mutex::Statistics const& _b)
+			{
+				return _a.m_waitTotal > _b.m_waitTotal;
+			}
+
+//-----------------------------------------------------------------------------
+//	<Mutex::LogStatistics>
+//	Write the lock statistics to the log
+//-----------------------------------------------------------------------------
+			void Mutex::LogStatistics()
+			{
+				if (!IsProfiling())
+				{
+					Log::Write(LogLevel_Always, "Lock profiling is off.  Set the LockProfiling option to collect lock statistics");
+					return;
+				}
+
+				vector<Statistics> statistics;
+				GetStatistics(&statistics);
+				std::sort(statistics.begin(), statistics.end(), MoreContended);
+
+				Log::Write(LogLevel_Always, "***************************************************************************");
+				Log::Write(LogLevel_Always, "*************************  Lock Statistics (us)  **************************");
+				Log::Write(LogLevel_Always, "%-16s %5s %10s %10s %12s %10s %10s  %s", "Lock", "Count", "Locks", "Contended", "Wait Total", "Wait Max", "Hold Max", "Held By");
+				for (vector<Statistics>::const_iterator it = statistics.begin(); it != statistics.end(); ++it)
+				{
+					Log::Write(LogLevel_Always, "%-16s %5d %10u %10u %12llu %10u %10u  %s", it->m_name.c_str(), it->m_instances, it->m_locks, it->m_contended, (unsigned long long) it->m_waitTotal, it->m_waitMax, it->m_holdMax, it->m_holdMaxThread.empty() ? "application" : it->m_holdMaxThread.c_str());
+				}
+				Log::Write(LogLevel_Always, "***************************************************************************");
+			}
 		} // namespace Platform
 	} // namespace Internal
 } // namespace OpenZWave
@@ -28,6 +28,9 @@
 #ifndef _Mutex_H
 #define _Mutex_H
 
+#include <string>
+#include <vector>
+
 #include "platform/Wait.h"
 
 namespace OpenZWave
@@ -47,8 +50,11 @@ namespace OpenZWave
 					/**
 					 * Constructor.
 					 * Creates a mutex object that can be used to serialize access to a shared resource.
+					 * \param _name Name the mutex is profiled under.  Mutexes with the same name are
+					 * counted together.  Unnamed mutexes are not profiled.
+					 * \see EnableProfiling
 					 */
-					Mutex();
+					Mutex(char const* _name = NULL);
 
 					/**
 					 * Lock the mutex.
@@ -72,6 +78,40 @@ namespace OpenZWave
 					 * Used by the Wait class to test whether the mutex is free.
 					 */
 					virtual bool IsSignalled();
+
+					/**
+					 * Lock statistics for the mutexes sharing a name.  Times are in microseconds.
+					 */
+					struct Statistics
+					{
+						public:
+							string m_name;
+							uint32 m_instances;				// Number of mutexes created with this name
+							uint32 m_locks;					// Number of times one was locked (not counting recursive locks)
+							uint32 m_contended;				// Number of those where it was held by another thread
+							uint64 m_waitTotal;				// Total time spent waiting for it
+							uint32 m_waitMax;				// Longest wait
+							uint32 m_holdMax;				// Longest time one was held
+							string m_holdMaxThread;			// Name of the thread that held it that long
+					};
+
+					struct Profile;
+
+					/**
+					 * Start or stop collecting lock statistics.  Off unless the LockProfiling option is set.
+					 */
+					static void EnableProfiling(bool const _enable);
+					static bool IsProfiling();
+
+					/**
+					 * Get the lock statistics of every named mutex.
+					 */
+					static void GetStatistics(vector<Statistics>* o_statistics);
+
+					/**
+					 * Write the lock statistics to the log, most contended first.
+					 */
+					static void LogStatistics();
 				protected:
 
 					/**
@@ -85,6 +125,10 @@ namespace OpenZWave
 					Mutex& operator =(Mutex const&);		// prevent assignment
 
 					MutexImpl* m_pImpl;					// Pointer to an object that encapsulates the platform-specific implementation of a mutex.
+
+					Profile* m_profile;					// Where the statistics for this mutex's name are collected, or NULL if it has no name
+					int32 m_depth;						// Recursive locks held while profiling.  Only touched by the owner
+					uint64 m_holdStart;					// When the owner took the lock, in microseconds
 			};
 		} // namespace Platform
 	} // namespace Internal
@@ -26,7 +26,6 @@
 //
 //-----------------------------------------------------------------------------
 #include "platform/Stream.h"
-#include "platform/Mutex.h"
 #include "platform/Log.h"
 
 #include <string.h>
@@ -45,10 +44,15 @@ namespace OpenZWave
 //	Constructor
 //-----------------------------------------------------------------------------
 			Stream::Stream(uint32 _bufferSize) :
-					m_bufferSize(_bufferSize), m_signalSize(1), m_dataSize(0), m_head(0), m_tail(0), m_mutex(new Mutex())
+					m_bufferSize(_bufferSize), m_mask(1), m_signalSize(1), m_head(0), m_tail(0)
 			{
-				m_buffer = new uint8[m_bufferSize];
-				memset(m_buffer, 0x00, m_bufferSize);
+				while (m_mask < m_bufferSize)
+				{
+					m_mask <<= 1;
+				}
+				m_buffer = new uint8[m_mask];
+				memset(m_buffer, 0x00, m_mask);
+				m_mask -= 1;
 			}
 
 //-----------------------------------------------------------------------------
@@ -57,7 +61,6 @@ namespace OpenZWave
 //-----------------------------------------------------------------------------
 			Stream::~Stream()
 			{
-				m_mutex->Release();
 				delete[] m_buffer;
 			}
 
@@ -81,35 +84,29 @@ namespace OpenZWave
 //-----------------------------------------------------------------------------
 			bool Stream::Get(uint8* _buffer, uint32 _size)
 			{
-				if (m_dataSize < _size)
+				uint32 tail = m_tail.load(std::memory_order_relaxed);
+				uint32 head = m_head.load(std::memory_order_acquire);
+				if ((head - tail) < _size)
 				{
 					// There is not enough data in the buffer to fulfill the request
 					Log::Write(LogLevel_Error, "ERROR: Not enough data in stream buffer");
 					return false;
 				}
 
-				m_mutex->Lock();
-				if ((m_tail + _size) > m_bufferSize)
+				// Copy out in at most two blocks, the second one after wrapping around
+				uint32 offset = tail & m_mask;
+				uint32 block1 = m_mask + 1 - offset;
+				if (block1 > _size)
 				{
-					// We will have to wrap around
-					uint32 block1 = m_bufferSize - m_tail;
-					uint32 block2 = _size - block1;
-
-					memcpy(_buffer, &m_buffer[m_tail], block1);
-					memcpy(&_buffer[block1], m_buffer, block2);
-					m_tail = block2;
-				}
-				else
-				{
-					// Requested data is in a contiguous block
-					memcpy(_buffer, &m_buffer[m_tail], _size);
-					m_tail += _size;
+					block1 = _size;
 				}
+				memcpy(_buffer, &m_buffer[offset], block1);
+				memcpy(&_buffer[block1], m_buffer, _size - block1);
 
-				LogData(_buffer, _size, "      Read (buffer->application): ");
+				// The writer may reuse the space as soon as it sees the new tail
+				m_tail.store(tail + _size, std::memory_order_release);
 
-				m_dataSize -= _size;
-				m_mutex->Unlock();
+				LogData(_buffer, _size, "      Read (buffer->application): ");
 				return true;
 			}
 
@@ -119,44 +116,42 @@ namespace OpenZWave
 //-----------------------------------------------------------------------------
 			bool Stream::Put(uint8* _buffer, uint32 _size)
 			{
-				if ((m_bufferSize - m_dataSize) < _size)
+				uint32 head = m_head.load(std::memory_order_relaxed);
+				uint32 tail = m_tail.load(std::memory_order_acquire);
+				if ((m_bufferSize - (head - tail)) < _size)
 				{
 					// There is not enough space left in the buffer for the data
 					Log::Write(LogLevel_Error, "ERROR: Not enough space in stream buffer");
 					return false;
 				}
 
-				m_mutex->Lock();
-				if ((m_head + _size) > m_bufferSize)
+				LogData(_buffer, _size, "      Read (controller->buffer):  ");
+
+				// Copy in at most two blocks, the second one after wrapping around
+				uint32 offset = head & m_mask;
+				uint32 block1 = m_mask + 1 - offset;
+				if (block1 > _size)
 				{
-					// We will have to wrap around
-					uint32 block1 = m_bufferSize - m_head;
-					uint32 block2 = _size - block1;
-
-					memcpy(&m_buffer[m_head], _buffer, block1);
-					memcpy(m_buffer, &_buffer[block1], block2);
-					uint8 * logpos = m_buffer + m_head;
-					m_head = block2;
-					LogData(logpos, block1, "      Read (controller->buffer):  ");
-					LogData(m_buffer, block2, "      Read (controller->buffer):  ");
+					block1 = _size;
 				}
-				else
-				{
-					// There is enough space before we reach the end of the buffer
-					memcpy(&m_buffer[m_head], _buffer, _size);
-					m_head += _size;
-					LogData(m_buffer + m_head - _size, _size, "      Read (controller->buffer):  ");
-				}
-
-				m_dataSize += _size;
-
-				if (IsSignalled())
+				memcpy(&m_buffer[offset], _buffer, block1);
+				memcpy(m_buffer, &_buffer[block1], _size - block1);
+
+				// Publish the data.  This and the loads below are sequentially consistent so that a
+				// reader which sets the threshold or starts waiting either sees the new head itself,
+				// or we see its threshold, its tail and (in Notify) that it is waiting.
+				head += _size;
+				m_head.store(head);
+
+				// Only notify when this Put takes the amount of data from below the threshold to at
+				// or above it.  While the reader waits its tail cannot move, so no crossing is missed.
+				uint32 dataSize = head - m_tail.load();
+				uint32 signalSize = m_signalSize.load();
+				if (dataSize >= signalSize && (dataSize - _size) < signalSize)
 				{
 					// We now have more data than we are waiting for, so notify the watchers
 					Notify();
 				}
-
-				m_mutex->Unlock();
 				return true;
 			}
 
@@ -166,9 +161,8 @@ namespace OpenZWave
 //-----------------------------------------------------------------------------
 			void Stream::Purge()
 			{
-				m_tail = 0;
-				m_head = 0;
-				m_dataSize = 0;
+				// Discard everything the writer has published so far
+				m_tail = m_head.load();
 			}
 
 //-----------------------------------------------------------------------------
@@ -177,7 +171,7 @@ namespace OpenZWave
 //-----------------------------------------------------------------------------
 			bool Stream::IsSignalled()
 			{
-				return (m_dataSize >= m_signalSize);
+				return ((m_head - m_tail) >= m_signalSize);
 			}
 
 //-----------------------------------------------------------------------------
@@ -31,6 +31,7 @@
 #include "Defs.h"
 #include "platform/Wait.h"
 
+#include <atomic>
 #include <string>
 
 namespace OpenZWave
@@ -39,14 +40,17 @@ namespace OpenZWave
 	{
 		namespace Platform
 		{
-			class Mutex;
-
 			/** \brief Platform-independent definition of a circular buffer.
 			 * \ingroup Platform
+			 *
+			 * The buffer is lock free, and is only safe with a single writer and a single reader.
+			 * One thread calls Put, another calls Get, SetSignalThreshold and Purge.  Waiters are
+			 * only notified when a Put takes the amount of data up past the signal threshold.
 			 */
 			class Stream: public Wait
 			{
 					friend class Wait;
+					friend class StreamTest;
 
 				public:
 					/**
@@ -57,6 +61,7 @@ namespace OpenZWave
 
 					/**
 					 * Set the number of bytes the buffer must contain before it becomes signalled.
+					 * Only to be called by the reader.
 					 * Once the threshold is set, the application can use Wait::Single or Wait::Multiple
 					 * to wait until the buffer has been filled with the desired amount of data.
 					 * \param _size the amount of data in bytes that the buffer must contain for it to become signalled.
@@ -93,11 +98,11 @@ namespace OpenZWave
 					 */
 					uint32 GetDataSize() const
 					{
-						return m_dataSize;
+						return m_head - m_tail;
 					}
 
 					/**
-					 * Empties the stream bytes held in the buffer.  
+					 * Empties the stream bytes held in the buffer.  Only to be called by the reader.
 					 * This is called when the library gets out of sync with the controller and sends a "NAK" 
 					 * to the controller.
 					 */
@@ -127,13 +132,15 @@ namespace OpenZWave
 					Stream(Stream const&);					// prevent copy
 					Stream& operator =(Stream const&);		// prevent assignment
 
+					// m_head and m_tail count every byte ever written and read, and are only masked
+					// to index the buffer, so that head - tail is the amount of data even after they wrap
 					uint8* m_buffer;
-					uint32 m_bufferSize;
-					uint32 m_signalSize;
-					uint32 m_dataSize;
-					uint32 m_head;
-					uint32 m_tail;
-					Mutex* m_mutex;
+					uint32 m_bufferSize;					// Capacity, as given to the constructor
+					uint32 m_mask;							// The buffer itself is rounded up to a power of two
+					std::atomic<uint32> m_signalSize;
+					std::atomic<uint32> m_head;				// Only written by Put
+					uint8 m_padding[64];					// Keep the writer's and the reader's counters in separate cache lines
+					std::atomic<uint32> m_tail;				// Only written by Get and Purge
 			};
 		} // namespace Platform
 	} // namespace Internal
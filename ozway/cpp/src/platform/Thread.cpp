@@ -25,8 +25,14 @@
 //	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
 //
 //-----------------------------------------------------------------------------
+#include <stdlib.h>
+#include <map>
+#include <mutex>
+#include <set>
+
 #include "Defs.h"
 #include "platform/Event.h"
+#include "platform/Log.h"
 #include "platform/Thread.h"
 
 #ifdef WIN32
@@ -43,15 +49,189 @@ namespace OpenZWave
 	{
 		namespace Platform
 		{
+			namespace
+			{
+				struct Placement
+				{
+						Placement() :
+								m_affinity(0), m_policy(Thread::Policy_Default), m_priority(0)
+						{
+						}
+						uint64 m_affinity;
+						Thread::Policy m_policy;
+						int32 m_priority;
+				};
+
+				// Threads and placements are shared by every driver, and live until the process exits
+				std::mutex& ThreadsMutex()
+				{
+					static std::mutex* s_mutex = new std::mutex();
+					return *s_mutex;
+				}
+
+				set<Thread*>& Threads()
+				{
+					static set<Thread*>* s_threads = new set<Thread*>();
+					return *s_threads;
+				}
+
+				map<string, Placement>& Placements()
+				{
+					static map<string, Placement>* s_placements = new map<string, Placement>();
+					return *s_placements;
+				}
+
+				thread_local Thread* s_current = NULL;
+
+				// Split "name=value;name=value" into its pairs
+				vector<pair<string, string> > SplitPlacement(string const& _option)
+				{
+					vector<pair<string, string> > entries;
+					size_t pos = 0;
+					while (pos < _option.size())
+					{
+						size_t end = _option.find(';', pos);
+						if (end == string::npos)
+						{
+							end = _option.size();
+						}
+						string entry = _option.substr(pos, end - pos);
+						size_t eq = entry.find('=');
+						if (eq != string::npos && eq > 0)
+						{
+							entries.push_back(make_pair(entry.substr(0, eq), entry.substr(eq + 1)));
+						}
+						else if (!entry.empty())
+						{
+							Log::Write(LogLevel_Warning, "Ignoring thread placement \"%s\", expected name=value", entry.c_str());
+						}
+						pos = end + 1;
+					}
+					return entries;
+				}
+
+				// Parse a list of CPUs such as "0,2-3" into a mask
+				uint64 ParseCpus(string const& _cpus)
+				{
+					uint64 mask = 0;
+					char const* p = _cpus.c_str();
+					while (*p)
+					{
+						char* end;
+						long first = strtol(p, &end, 10);
+						if (end == p || first < 0 || first > 63)
+						{
+							return 0;
+						}
+						long last = first;
+						p = end;
+						if (*p == '-')
+						{
+							last = strtol(p + 1, &end, 10);
+							if (end == p + 1 || last < first || last > 63)
+							{
+								return 0;
+							}
+							p = end;
+						}
+						for (long cpu = first; cpu <= last; ++cpu)
+						{
+							mask |= ((uint64) 1) << cpu;
+						}
+						if (*p == ',')
+						{
+							++p;
+						}
+						else if (*p)
+						{
+							return 0;
+						}
+					}
+					return mask;
+				}
+
+				// Parse a policy such as "fifo:10"
+				bool ParsePolicy(string const& _policy, Thread::Policy* o_policy, int32* o_priority)
+				{
+					string name = _policy;
+					*o_priority = 0;
+					size_t colon = _policy.find(':');
+					if (colon != string::npos)
+					{
+						name = _policy.substr(0, colon);
+						*o_priority = atoi(_policy.c_str() + colon + 1);
+					}
+					if (name == "other")
+						*o_policy = Thread::Policy_Other;
+					else if (name == "batch")
+						*o_policy = Thread::Policy_Batch;
+					else if (name == "idle")
+						*o_policy = Thread::Policy_Idle;
+					else if (name == "fifo")
+						*o_policy = Thread::Policy_Fifo;
+					else if (name == "rr")
+						*o_policy = Thread::Policy_RoundRobin;
+					else
+						return false;
+					return true;
+				}
+
+				// The placement for a thread name.  An exact match wins over a prefix.
+				// Must hold ThreadsMutex.
+				Placement FindPlacement(string const& _name)
+				{
+					map<string, Placement>::const_iterator it = Placements().find(_name);
+					if (it != Placements().end())
+					{
+						return it->second;
+					}
+					for (it = Placements().begin(); it != Placements().end(); ++it)
+					{
+						string const& pattern = it->first;
+						if (!pattern.empty() && pattern[pattern.size() - 1] == '*' && _name.compare(0, pattern.size() - 1, pattern, 0, pattern.size() - 1) == 0)
+						{
+							return it->second;
+						}
+					}
+					return Placement();
+				}
+
+				char const* PolicyName(Thread::Policy _policy)
+				{
+					switch (_policy)
+					{
+						case Thread::Policy_Other:
+							return "other";
+						case Thread::Policy_Batch:
+							return "batch";
+						case Thread::Policy_Idle:
+							return "idle";
+						case Thread::Policy_Fifo:
+							return "fifo";
+						case Thread::Policy_RoundRobin:
+							return "rr";
+						default:
+							return "-";
+					}
+				}
+			}
 
 //-----------------------------------------------------------------------------
 //	<Thread::Thread>
 //	Constructor
 //-----------------------------------------------------------------------------
-			Thread::Thread(string const& _name)
+			Thread::Thread(string const& _name) :
+					m_name(_name), m_affinity(0), m_policy(Policy_Default), m_priority(0), m_wakeups(0)
 			{
 				m_exitEvent = new Event();
 				m_pImpl = new ThreadImpl(this, _name);
+
+				std::lock_guard<std::mutex> lock(ThreadsMutex());
+				Placement placement = FindPlacement(_name);
+				m_affinity = placement.m_affinity;
+				m_policy = placement.m_policy;
+				m_priority = placement.m_priority;
+				Threads().insert(this);
 			}
 
 //-----------------------------------------------------------------------------
@@ -60,6 +240,10 @@ namespace OpenZWave
 //-----------------------------------------------------------------------------
 			Thread::~Thread()
 			{
+				{
+					std::lock_guard<std::mutex> lock(ThreadsMutex());
+					Threads().erase(this);
+				}
 				delete m_pImpl;
 				m_exitEvent->Release();
 			}
@@ -98,7 +282,8 @@ namespace OpenZWave
 //-----------------------------------------------------------------------------
 			void Thread::Sleep(uint32 _milliseconds)
 			{
-				return (m_pImpl->Sleep(_milliseconds));
+				m_pImpl->Sleep(_milliseconds);
+				CountWakeup();
 			}
 
 //-----------------------------------------------------------------------------
@@ -109,7 +294,117 @@ namespace OpenZWave
 			{
 				return m_pImpl->IsSignalled();
 			}
+
+//-----------------------------------------------------------------------------
+//	<Thread::Running>
+//	Called on the new thread before its function is run
+//-----------------------------------------------------------------------------
+			void Thread::Running()
+			{
+				s_current = this;
+				if (m_affinity != 0 || m_policy != Policy_Default)
+				{
+					if (m_pImpl->SetPlacement(m_affinity, m_policy, m_priority))
+					{
+						Log::Write(LogLevel_Info, "Thread %s running on CPUs 0x%llx with policy %s, priority %d", m_name.c_str(), (unsigned long long) m_affinity, PolicyName(m_policy), m_priority);
+					}
+				}
+			}
+
+//-----------------------------------------------------------------------------
+//	<Thread::GetCurrentName>
+//	Name of the calling thread
+//-----------------------------------------------------------------------------
+			string const& Thread::GetCurrentName()
+			{
+				static string const s_none;
+				return s_current ? s_current->m_name : s_none;
+			}
+
+//-----------------------------------------------------------------------------
+//	<Thread::CountWakeup>
+//	The calling thread has stopped waiting
+//-----------------------------------------------------------------------------
+			void Thread::CountWakeup()
+			{
+				if (s_current)
+				{
+					s_current->m_wakeups.fetch_add(1, std::memory_order_relaxed);
+				}
+			}
+
+//-----------------------------------------------------------------------------
+//	<Thread::SetPlacement>
+//	Parse the ThreadAffinity and ThreadScheduling options
+//-----------------------------------------------------------------------------
+			void Thread::SetPlacement(string const& _affinity, string const& _scheduling)
+			{
+				map<string, Placement> placements;
+				vector<pair<string, string> > entries = SplitPlacement(_affinity);
+				for (vector<pair<string, string> >::const_iterator it = entries.begin(); it != entries.end(); ++it)
+				{
+					uint64 mask = ParseCpus(it->second);
+					if (mask == 0)
+					{
+						Log::Write(LogLevel_Warning, "Ignoring affinity \"%s\" for thread %s, expected a list of CPUs such as 0,2-3", it->second.c_str(), it->first.c_str());
+						continue;
+					}
+					placements[it->first].m_affinity = mask;
+				}
+				entries = SplitPlacement(_scheduling);
+				for (vector<pair<string, string> >::const_iterator it = entries.begin(); it != entries.end(); ++it)
+				{
+					Placement& placement = placements[it->first];
+					if (!ParsePolicy(it->second, &placement.m_policy, &placement.m_priority))
+					{
+						Log::Write(LogLevel_Warning, "Ignoring scheduling \"%s\" for thread %s, expected other, batch, idle, fifo:<priority> or rr:<priority>", it->second.c_str(), it->first.c_str());
+					}
+				}
+
+				std::lock_guard<std::mutex> lock(ThreadsMutex());
+				Placements().swap(placements);
+			}
+
+//-----------------------------------------------------------------------------
+//	<Thread::GetStatistics>
+//	Get the accounting of every thread
+//-----------------------------------------------------------------------------
+			void Thread::GetStatistics(vector<Statistics>* o_statistics)
+			{
+				o_statistics->clear();
+				std::lock_guard<std::mutex> lock(ThreadsMutex());
+				for (set<Thread*>::const_iterator it = Threads().begin(); it != Threads().end(); ++it)
+				{
+					Thread* thread = *it;
+					Statistics data;
+					data.m_name = thread->m_name;
+					data.m_affinity = thread->m_affinity;
+					data.m_policy = thread->m_policy;
+					data.m_priority = thread->m_priority;
+					data.m_cpuTime = thread->m_pImpl->GetCpuTime();
+					data.m_wakeups = thread->m_wakeups;
+					o_statistics->push_back(data);
+				}
+			}
+
+//-----------------------------------------------------------------------------
+//	<Thread::LogStatistics>
+//	Write the thread accounting to the log
+//-----------------------------------------------------------------------------
+			void Thread::LogStatistics()
+			{
+				vector<Statistics> statistics;
+				GetStatistics(&statistics);
+
+				Log::Write(LogLevel_Always, "***************************************************************************");
+				Log::Write(LogLevel_Always, "****************************  Thread Statistics  **************************");
+				Log::Write(LogLevel_Always, "%-16s %18s %-6s %8s %14s %10s", "Thread", "CPUs", "Policy", "Priority", "CPU Time (ms)", "Wakeups");
+				for (vector<Statistics>::const_iterator it = statistics.begin(); it != statistics.end(); ++it)
+				{
+					Log::Write(LogLevel_Always, "%-16s %18llx %-6s %8d %14llu %10u", it->m_name.c_str(), (unsigned long long) it->m_affinity, PolicyName(it->m_policy), it->m_priority, (unsigned long long) (it->m_cpuTime / 1000), it->m_wakeups);
+				}
+				Log::Write(LogLevel_Always, "***************************************************************************");
+			}
 		} // namespace Platform
 	} // namespace Internal
 } // namespace OpenZWave
-
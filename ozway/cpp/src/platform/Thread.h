@@ -29,6 +29,8 @@
 #define _Thread_H
 
 #include <string>
+#include <vector>
+#include <atomic>
 #include "Defs.h"
 #include "platform/Wait.h"
 
@@ -49,6 +51,34 @@ namespace OpenZWave
 				public:
 					typedef void (*pfnThreadProc_t)(Event* _exitEvent, void* _context);
 
+					/**
+					 * Scheduling policies that can be given to a thread.  Not every platform
+					 * supports all of them.
+					 */
+					enum Policy
+					{
+						Policy_Default = 0,			/**< Leave it as it was created */
+						Policy_Other,				/**< Normal time sharing */
+						Policy_Batch,				/**< Time sharing, for work that is not interactive */
+						Policy_Idle,				/**< Only run when nothing else wants the CPU */
+						Policy_Fifo,				/**< Real time, first in first out at the given priority */
+						Policy_RoundRobin			/**< Real time, round robin at the given priority */
+					};
+
+					/**
+					 * Accounting for a thread.
+					 */
+					struct Statistics
+					{
+						public:
+							string m_name;
+							uint64 m_affinity;			// Mask of the CPUs it was asked to run on, or 0 for any
+							Policy m_policy;
+							int32 m_priority;
+							uint64 m_cpuTime;			// CPU time used, in microseconds
+							uint32 m_wakeups;			// Number of times it returned from a wait or sleep
+					};
+
 					/**
 					 * Constructor.
 					 * Creates a thread object that can be used to serialize access to a shared resource.
@@ -83,6 +113,37 @@ namespace OpenZWave
 					 */
 					void Sleep(uint32 _millisecs);
 
+					/**
+					 * Name of the calling thread.
+					 * \return The name given to the Thread running the caller, or an empty string
+					 * if it was not started through this class.
+					 */
+					static string const& GetCurrentName();
+
+					/**
+					 * Set where threads run, by name.  Applies to threads started from now on.
+					 * A name ending in * matches every thread whose name starts with the rest.
+					 * \param _affinity CPUs for each thread, eg "driver=0;poll=1-2;notify*=2,3"
+					 * \param _scheduling Policy and priority for each thread, eg "driver=fifo:10;poll=idle".
+					 * The policies are other, batch, idle, fifo and rr.
+					 */
+					static void SetPlacement(string const& _affinity, string const& _scheduling);
+
+					/**
+					 * Get the accounting of every thread that has not been destroyed.
+					 */
+					static void GetStatistics(vector<Statistics>* o_statistics);
+
+					/**
+					 * Write the thread accounting to the log.
+					 */
+					static void LogStatistics();
+
+					/**
+					 * Called by the Wait class when the calling thread stops waiting.
+					 */
+					static void CountWakeup();
+
 				protected:
 					/**
 					 * Used by the Wait class to test whether the thread has been completed.
@@ -96,8 +157,17 @@ namespace OpenZWave
 					virtual ~Thread();
 
 				private:
+					friend class ThreadImpl;
+
+					void Running();
+
 					ThreadImpl* m_pImpl;	// Pointer to an object that encapsulates the platform-specific implementation of a thread.
 					Event* m_exitEvent;
+					string m_name;
+					uint64 m_affinity;
+					Policy m_policy;
+					int32 m_priority;
+					std::atomic<uint32> m_wakeups;
 			};
 		} // namespace Platform
 	} // namespace Internal
@@ -96,7 +96,7 @@ namespace OpenZWave
 //-----------------------------------------------------------------------------
 			int32 TimeStamp::operator-(TimeStamp const& _other)
 			{
-				return (int32) (m_pImpl - _other.m_pImpl);
+				return (int32) (*m_pImpl - *_other.m_pImpl);
 			}
 		} // namespace Platform
 	} // namespace Internal
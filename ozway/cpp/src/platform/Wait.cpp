@@ -30,6 +30,7 @@
 #include "platform/Wait.h"
 #include "platform/Event.h"
 #include "platform/Log.h"
+#include "platform/Thread.h"
 
 #ifdef WIN32
 #include "platform/windows/WaitImpl.h"	// Platform-specific implementation of a Wait object
@@ -115,6 +116,15 @@ namespace OpenZWave
 			{
 				uint32 i;
 
+#ifdef OZW_WAIT_EPOLL
+				int32 result;
+				if (WaitImpl::Multiple(_objects, _numObjects, _timeout, &result))
+				{
+					Thread::CountWakeup();
+					return result;
+				}
+#endif
+
 				// Create an event that will be set when any of the objects in the list becomes signalled.
 				Event* waitEvent = new Event();
 
@@ -153,6 +163,7 @@ namespace OpenZWave
 
 				// We're done with the event now
 				waitEvent->Release();
+				Thread::CountWakeup();
 				return res;
 			}
 
@@ -76,6 +76,17 @@ namespace OpenZWave
 //-----------------------------------------------------------------------------
 			void EventImpl::Set()
 			{
+				if (m_manualReset)
+				{
+					// Waiters count themselves before testing the flag, so if there are none
+					// now, any that arrive will see the event is set.
+					m_isSignaled = true;
+					if (m_waitingThreads == 0)
+					{
+						return;
+					}
+				}
+
 				int err = pthread_mutex_lock(&m_lock);
 				if (err != 0)
 				{
@@ -122,19 +133,7 @@ namespace OpenZWave
 //-----------------------------------------------------------------------------
 			void EventImpl::Reset()
 			{
-				int err = pthread_mutex_lock(&m_lock);
-				if (err != 0)
-				{
-					fprintf(stderr, "EventImpl::Reset lock error %d (%d)\n", errno, err);
-					assert(0);
-				}
 				m_isSignaled = false;
-				err = pthread_mutex_unlock(&m_lock);
-				if (err != 0)
-				{
-					fprintf(stderr, "EventImpl::Reset unlock error %d (%d)\n", errno, err);
-					assert(0);
-				}
 			}
 
 //-----------------------------------------------------------------------------
@@ -155,12 +154,20 @@ namespace OpenZWave
 			{
 				bool result = true;
 
+				// Nothing to wait for if a manual reset event is already set
+				if (m_manualReset && m_isSignaled)
+				{
+					return true;
+				}
+
 				int err = pthread_mutex_lock(&m_lock);
 				if (err != 0)
 				{
 					fprintf(stderr, "EventImpl::Wait lock error %d (%d)\n", errno, err);
 					assert(0);
 				}
+				// Count ourselves before testing the flag (see Set)
+				++m_waitingThreads;
 				if (m_isSignaled)
 				{
 					if (!m_manualReset)
@@ -170,7 +177,6 @@ namespace OpenZWave
 				}
 				else
 				{
-					++m_waitingThreads;
 					if (_timeout == 0)
 					{
 						result = m_isSignaled;
@@ -240,8 +246,8 @@ namespace OpenZWave
 							}
 						}
 					}
-					--m_waitingThreads;
 				}
+				--m_waitingThreads;
 
 				err = pthread_mutex_unlock(&m_lock);
 				if (err != 0)
@@ -30,6 +30,7 @@
 
 #include <pthread.h>
 #include <errno.h>
+#include <atomic>
 
 namespace OpenZWave
 {
@@ -57,8 +58,8 @@ namespace OpenZWave
 					pthread_mutex_t m_lock;
 					pthread_cond_t m_condition;
 					bool m_manualReset;
-					bool m_isSignaled;
-					unsigned int m_waitingThreads;
+					std::atomic<bool> m_isSignaled;				// Set, Reset and IsSignalled do not need the lock
+					std::atomic<unsigned int> m_waitingThreads;	// Set only takes the lock to wake these
 			};
 		} // namespace Platform
 	} // namespace Internal
@@ -28,6 +28,7 @@
 
 #include <dirent.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <unistd.h>
 #include <fcntl.h>
 #include <libgen.h>
@@ -174,6 +175,52 @@ namespace OpenZWave
 				Log::Write(LogLevel_Warning, "Create Directory Failed: %s - %s", _dirname.c_str(), strerror(errno));
 				return false;
 			}
+
+			bool FileOpsImpl::FileMap(const string _filename, uint8 const** o_data, size_t* o_size)
+			{
+				int fd = open(_filename.c_str(), O_RDONLY);
+				if (fd < 0)
+				{
+					return false;
+				}
+				struct stat st;
+				if (fstat(fd, &st) != 0 || st.st_size <= 0)
+				{
+					close(fd);
+					return false;
+				}
+				void *data = mmap(NULL, (size_t) st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+				/* the mapping stays valid after the descriptor is closed */
+				close(fd);
+				if (data == MAP_FAILED)
+				{
+					Log::Write(LogLevel_Warning, "Mapping File Failed: %s - %s", _filename.c_str(), strerror(errno));
+					return false;
+				}
+				*o_data = (uint8 const*) data;
+				*o_size = (size_t) st.st_size;
+				return true;
+			}
+
+			void FileOpsImpl::FileUnmap(uint8 const* _data, size_t _size)
+			{
+				if (_data != NULL)
+				{
+					munmap((void *) _data, _size);
+				}
+			}
+
+			bool FileOpsImpl::FileStat(const string _filename, uint64* o_mtime, uint64* o_size)
+			{
+				struct stat st;
+				if (stat(_filename.c_str(), &st) != 0)
+				{
+					return false;
+				}
+				*o_mtime = (uint64) st.st_mtime;
+				*o_size = (uint64) st.st_size;
+				return true;
+			}
 		} // namespace Platform
 	} // namespace Internal
 } // namespace OpenZWave
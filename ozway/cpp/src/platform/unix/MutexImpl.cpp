@@ -33,13 +33,172 @@
 #include <stdio.h>
 #include <errno.h>
 
+#ifdef OZW_MUTEX_FUTEX
+#include <algorithm>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
+
 namespace OpenZWave
 {
 	namespace Internal
 	{
 		namespace Platform
 		{
+#ifdef OZW_MUTEX_FUTEX
+			// The most times Lock will check the lock before going to sleep
+			static int32 const c_maxSpin = 100;
+
+			static inline void CpuRelax()
+			{
+#if defined(__i386__) || defined(__x86_64__)
+				__builtin_ia32_pause();
+#elif defined(__arm__) || defined(__aarch64__)
+				__asm__ __volatile__("yield");
+#endif
+			}
+
+//-----------------------------------------------------------------------------
+//	<MutexImpl::MutexImpl>
+//	Constructor
+//-----------------------------------------------------------------------------
+			MutexImpl::MutexImpl() :
+					m_lockCount(0), m_state(0), m_owner(0), m_spin(c_maxSpin / 2)
+			{
+			}
+
+//-----------------------------------------------------------------------------
+//	<MutexImpl::~MutexImpl>
+//	Destructor
+//-----------------------------------------------------------------------------
+			MutexImpl::~MutexImpl()
+			{
+				if (m_state.load() != 0)
+				{
+					Log::Write(LogLevel_Error, "MutexImpl:~MutexImpl: - Destroying a Locked Mutex: %d", m_lockCount);
+				}
+			}
+
+//-----------------------------------------------------------------------------
+//	<MutexImpl::GetThreadId>
+//	Kernel id of the calling thread
+//-----------------------------------------------------------------------------
+			int32 MutexImpl::GetThreadId()
+			{
+				static thread_local int32 s_tid = 0;
+				if (s_tid == 0)
+				{
+					s_tid = (int32) syscall(SYS_gettid);
+				}
+				return s_tid;
+			}
+
+//-----------------------------------------------------------------------------
+//	<MutexImpl::Lock>
+//	Lock the mutex
+//-----------------------------------------------------------------------------
+			bool MutexImpl::Lock(bool const _bWait)
+			{
+				int32 self = GetThreadId();
+				if (m_owner.load(std::memory_order_relaxed) == self)
+				{
+					// We already hold it
+					++m_lockCount;
+					return true;
+				}
+
+				int32 c = 0;
+				if (!m_state.compare_exchange_strong(c, 1, std::memory_order_acquire))
+				{
+					if (!_bWait)
+					{
+						// Returns immediately, even if the lock was not available.
+						return false;
+					}
+
+					// The locks are mostly held for a short time, so spin for a while first.
+					// The limit adapts to how long recent spins took to succeed.
+					int32 limit = std::min(m_spin * 2 + 10, c_maxSpin);
+					int32 spins = 0;
+					bool locked = false;
+					while (spins < limit && c == 1)
+					{
+						CpuRelax();
+						++spins;
+						c = 0;
+						if (m_state.compare_exchange_weak(c, 1, std::memory_order_acquire))
+						{
+							locked = true;
+							break;
+						}
+					}
+					if (!locked)
+					{
+						Wait();
+					}
+					// we hold the lock, so this is safe to update
+					m_spin += (spins - m_spin) / 8;
+				}
+
+				m_owner.store(self, std::memory_order_relaxed);
+				m_lockCount = 1;
+				return true;
+			}
+
+//-----------------------------------------------------------------------------
+//	<MutexImpl::Wait>
+//	Sleep until the lock can be taken
+//-----------------------------------------------------------------------------
+			void MutexImpl::Wait()
+			{
+				// Mark the lock as contended, so the owner knows to wake us when it unlocks
+				int32 c = m_state.exchange(2, std::memory_order_acquire);
+				while (c != 0)
+				{
+					if (syscall(SYS_futex, (int*) &m_state, FUTEX_WAIT_PRIVATE, 2, NULL, NULL, 0) != 0 && errno != EAGAIN && errno != EINTR)
+					{
+						Log::Write(LogLevel_Error, "MutexImpl::Lock futex wait failed with error: %d", errno);
+					}
+					c = m_state.exchange(2, std::memory_order_acquire);
+				}
+			}
+
+//-----------------------------------------------------------------------------
+//	<MutexImpl::Unlock>
+//	Release our lock on the mutex
+//-----------------------------------------------------------------------------
+			void MutexImpl::Unlock()
+			{
+				if (m_owner.load(std::memory_order_relaxed) != GetThreadId() || m_lockCount <= 0)
+				{
+					// No locks - we have a mismatched lock/release pair
+					Log::Write(LogLevel_Error, "MutexImpl:Unlock - MisMatched Lock/Release Pair: %d", m_lockCount);
+					return;
+				}
+				if (--m_lockCount > 0)
+				{
+					return;
+				}
 
+				m_owner.store(0, std::memory_order_relaxed);
+				if (m_state.exchange(0, std::memory_order_release) == 2)
+				{
+					// Someone may be asleep waiting for it
+					syscall(SYS_futex, (int*) &m_state, FUTEX_WAKE_PRIVATE, 1, NULL, NULL, 0);
+				}
+			}
+
+//-----------------------------------------------------------------------------
+//	<MutexImpl::IsSignalled>
+//	Test whether the mutex is free
+//-----------------------------------------------------------------------------
+			bool MutexImpl::IsSignalled()
+			{
+				return (0 == m_state.load());
+			}
+#else
 //-----------------------------------------------------------------------------
 //	<MutexImpl::MutexImpl>
 //	Constructor
@@ -140,6 +299,7 @@ namespace OpenZWave
 			{
 				return (0 == m_lockCount);
 			}
+#endif
 		} // namespace Platform
 	} // namespace Internal
 } // namespace OpenZWave
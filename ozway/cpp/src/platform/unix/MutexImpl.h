@@ -31,6 +31,12 @@
 #include <stdio.h>
 #include <pthread.h>
 
+#ifdef __linux__
+// Lock with atomics, spinning briefly before sleeping on a futex
+#define OZW_MUTEX_FUTEX
+#include <atomic>
+#endif
+
 namespace OpenZWave
 {
 	namespace Internal
@@ -51,7 +57,16 @@ namespace OpenZWave
 					bool IsSignalled();
 
 					int32 m_lockCount;				// Keep track of the locks (there can be more than one if they occur on the same thread.
+#ifdef OZW_MUTEX_FUTEX
+					static int32 GetThreadId();
+					void Wait();
+
+					std::atomic<int32> m_state;		// 0 if free, 1 if locked, 2 if locked and a thread may be sleeping on it
+					std::atomic<int32> m_owner;		// Thread id of the owner, or 0
+					int32 m_spin;					// How long it has recently been worth spinning for the lock
+#else
 					pthread_mutex_t m_criticalSection;
+#endif
 			};
 		} // namespace Platform
 	} // namespace Internal
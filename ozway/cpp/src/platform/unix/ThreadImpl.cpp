@@ -26,8 +26,12 @@
 //
 //-----------------------------------------------------------------------------
 #include <unistd.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
 #include "Defs.h"
 #include "platform/Event.h"
+#include "platform/Log.h"
 #include "platform/Thread.h"
 #include "ThreadImpl.h"
 
@@ -49,7 +53,7 @@ namespace OpenZWave
 			ThreadImpl::ThreadImpl(Thread* _owner, string const& _tname) :
 					m_owner(_owner),
 //	m_hThread( NULL ),  /* p_thread_t isn't a pointer in Linux, so can't do this */
-					m_bIsRunning(false), m_name(_tname)
+					m_bIsRunning(false), m_name(_tname), m_cpuTime(0)
 			{
 			}
 
@@ -132,6 +136,97 @@ namespace OpenZWave
 				usleep(_millisecs * 1000);
 			}
 
+//-----------------------------------------------------------------------------
+//	<ThreadImpl::SetPlacement>
+//	Set the CPUs and scheduling of the calling thread, which is this one
+//-----------------------------------------------------------------------------
+			bool ThreadImpl::SetPlacement(uint64 const _affinity, Thread::Policy const _policy, int32 const _priority)
+			{
+				bool res = true;
+				if (_affinity != 0)
+				{
+#ifdef __linux__
+					cpu_set_t cpus;
+					CPU_ZERO(&cpus);
+					for (int cpu = 0; cpu < 64; ++cpu)
+					{
+						if (_affinity & (((uint64) 1) << cpu))
+						{
+							CPU_SET(cpu, &cpus);
+						}
+					}
+					int err = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+					if (err != 0)
+					{
+						Log::Write(LogLevel_Warning, "Unable to set the CPU affinity of thread %s: %s", m_name.c_str(), strerror(err));
+						res = false;
+					}
+#else
+					Log::Write(LogLevel_Warning, "CPU affinity is not supported on this platform, thread %s can run on any CPU", m_name.c_str());
+					res = false;
+#endif
+				}
+
+				if (_policy != Thread::Policy_Default)
+				{
+					int policy = SCHED_OTHER;
+					switch (_policy)
+					{
+						case Thread::Policy_Fifo:
+							policy = SCHED_FIFO;
+							break;
+						case Thread::Policy_RoundRobin:
+							policy = SCHED_RR;
+							break;
+#ifdef SCHED_BATCH
+						case Thread::Policy_Batch:
+							policy = SCHED_BATCH;
+							break;
+#endif
+#ifdef SCHED_IDLE
+						case Thread::Policy_Idle:
+							policy = SCHED_IDLE;
+							break;
+#endif
+						default:
+							break;
+					}
+					struct sched_param param;
+					memset(&param, 0, sizeof(param));
+					// only the real time policies take a priority
+					if (policy == SCHED_FIFO || policy == SCHED_RR)
+					{
+						param.sched_priority = _priority;
+					}
+					int err = pthread_setschedparam(pthread_self(), policy, &param);
+					if (err != 0)
+					{
+						// real time policies usually need CAP_SYS_NICE
+						Log::Write(LogLevel_Warning, "Unable to set the scheduling policy of thread %s: %s", m_name.c_str(), strerror(err));
+						res = false;
+					}
+				}
+				return res;
+			}
+
+//-----------------------------------------------------------------------------
+//	<ThreadImpl::GetCpuTime>
+//	CPU time used by the thread, in microseconds
+//-----------------------------------------------------------------------------
+			uint64 ThreadImpl::GetCpuTime()
+			{
+				if (m_bIsRunning)
+				{
+					clockid_t clock;
+					struct timespec ts;
+					if (pthread_getcpuclockid(m_hThread, &clock) == 0 && clock_gettime(clock, &ts) == 0)
+					{
+						return (uint64) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+					}
+				}
+				return m_cpuTime;
+			}
+
 //-----------------------------------------------------------------------------
 //	<ThreadImpl::IsSignalled>
 //	Test whether the thread has completed
@@ -163,7 +258,14 @@ namespace OpenZWave
 			void ThreadImpl::Run()
 			{
 				m_bIsRunning = true;
+				m_owner->Running();
 				m_pfnThreadProc(m_exitEvent, m_pContext);
+
+				struct timespec ts;
+				if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+				{
+					m_cpuTime = (uint64) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+				}
 				m_bIsRunning = false;
 
 				// Let any watchers know that the thread has finished running
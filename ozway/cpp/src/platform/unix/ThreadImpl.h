@@ -32,6 +32,7 @@
 #include <signal.h>
 #include <pthread.h>
 #include <string>
+#include <atomic>
 
 namespace OpenZWave
 {
@@ -55,6 +56,8 @@ namespace OpenZWave
 					void Sleep(uint32 _millisecs);
 					bool IsSignalled();
 					bool Terminate();
+					bool SetPlacement(uint64 const _affinity, Thread::Policy const _policy, int32 const _priority);
+					uint64 GetCpuTime();
 
 					void Run();
 					static void* ThreadProc(void *parg);
@@ -66,6 +69,7 @@ namespace OpenZWave
 					void* m_pContext;
 					bool m_bIsRunning;
 					string m_name;
+					std::atomic<uint64> m_cpuTime;	// CPU time used, in microseconds, once the thread has finished
 			};
 		} // namespace Platform
 	} // namespace Internal
@@ -34,6 +34,14 @@
 #include <errno.h>
 #include <string.h>
 
+#ifdef OZW_WAIT_EPOLL
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
 namespace OpenZWave
 {
 	namespace Internal
@@ -46,13 +54,20 @@ namespace OpenZWave
 //	Constructor
 //-----------------------------------------------------------------------------
 			WaitImpl::WaitImpl(Wait* _owner) :
-					m_owner(_owner)
+					m_watcherCount(0), m_owner(_owner)
 			{
 				pthread_mutexattr_t ma;
 				pthread_mutexattr_init(&ma);
 				pthread_mutexattr_settype(&ma, PTHREAD_MUTEX_RECURSIVE);
 				pthread_mutex_init(&m_criticalSection, &ma);
 				pthread_mutexattr_destroy(&ma);
+#ifdef OZW_WAIT_EPOLL
+				// Most objects are never waited on with Wait::Multiple, so the eventfd is made on demand
+				static std::atomic<uint64> s_serial(0);
+				m_fd = -1;
+				m_serial = ++s_serial;
+				m_epollWaiters = 0;
+#endif
 			}
 
 //-----------------------------------------------------------------------------
@@ -62,6 +77,12 @@ namespace OpenZWave
 			WaitImpl::~WaitImpl()
 			{
 				pthread_mutex_destroy(&m_criticalSection);
+#ifdef OZW_WAIT_EPOLL
+				if (m_fd >= 0)
+				{
+					close(m_fd);
+				}
+#endif
 			}
 
 //-----------------------------------------------------------------------------
@@ -82,6 +103,7 @@ namespace OpenZWave
 					assert(0);
 				}
 				m_watchers.push_back(watcher);
+				++m_watcherCount;
 				if ((err = pthread_mutex_unlock(&m_criticalSection)) != 0)
 				{
 					fprintf(stderr, "WaitImpl::AddWatcher unlock error %s\n", strerror(err));
@@ -115,6 +137,7 @@ namespace OpenZWave
 					if ((watcher.m_callback == _callback) && (watcher.m_context == _context))
 					{
 						m_watchers.erase(it);
+						--m_watcherCount;
 						res = true;
 						break;
 					}
@@ -134,6 +157,26 @@ namespace OpenZWave
 //-----------------------------------------------------------------------------
 			void WaitImpl::Notify()
 			{
+				// Mutexes notify on every unlock, so avoid any work when nobody is waiting.  Waiters
+				// count themselves before testing the owner, and the owner changed state before
+				// calling us, so one of us sees the other.
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+#ifdef OZW_WAIT_EPOLL
+				int fd = m_fd;
+				if (fd >= 0 && m_epollWaiters > 0)
+				{
+					// wake anything blocked in WaitImpl::Multiple on this object
+					uint64_t one = 1;
+					if (write(fd, &one, sizeof(one)) < 0 && errno != EAGAIN)
+					{
+						fprintf(stderr, "WaitImpl::Notify eventfd write error %d\n", errno);
+					}
+				}
+#endif
+				if (m_watcherCount == 0)
+				{
+					return;
+				}
 				if (pthread_mutex_lock(&m_criticalSection) != 0)
 				{
 					fprintf(stderr, "WaitImpl::Notify lock error %d\n", errno);
@@ -150,6 +193,203 @@ namespace OpenZWave
 					assert(0);
 				}
 			}
+
+#ifdef OZW_WAIT_EPOLL
+//-----------------------------------------------------------------------------
+//	<WaitImpl::GetFd>
+//	The eventfd, created on first use
+//-----------------------------------------------------------------------------
+			int WaitImpl::GetFd()
+			{
+				int fd = m_fd;
+				if (fd < 0)
+				{
+					// if this fails, Wait::Multiple falls back to using watchers
+					fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+					if (fd < 0)
+					{
+						return -1;
+					}
+					int none = -1;
+					if (!m_fd.compare_exchange_strong(none, fd))
+					{
+						// another thread got there first
+						close(fd);
+						fd = none;
+					}
+				}
+				return fd;
+			}
+
+			/** \brief The epoll set of a thread, and the objects that were last added to it.
+			 *
+			 * The threads wait on the same few objects over and over, so the set is only
+			 * changed when a thread waits on something different.  The objects are told apart
+			 * by serial number, as a new object may be given the address and the descriptor of
+			 * one that has gone.
+			 */
+			struct EpollSet
+			{
+					EpollSet() :
+							m_epfd(epoll_create1(EPOLL_CLOEXEC))
+					{
+					}
+					~EpollSet()
+					{
+						if (m_epfd >= 0)
+						{
+							close(m_epfd);
+						}
+					}
+
+					int m_epfd;
+					std::vector<uint64> m_serials;
+					std::vector<int> m_fds;
+			};
+
+			static thread_local EpollSet s_epollSet;
+
+//-----------------------------------------------------------------------------
+//	<WaitImpl::EpollWaiting::EpollWaiting>
+//	Count this thread as waiting on each of the objects
+//-----------------------------------------------------------------------------
+			WaitImpl::EpollWaiting::EpollWaiting(Wait** _objects, uint32 _numObjects) :
+					m_objects(_objects), m_numObjects(_numObjects)
+			{
+				for (uint32 i = 0; i < m_numObjects; ++i)
+				{
+					++m_objects[i]->m_pImpl->m_epollWaiters;
+				}
+			}
+
+//-----------------------------------------------------------------------------
+//	<WaitImpl::EpollWaiting::~EpollWaiting>
+//	This thread is no longer waiting on the objects
+//-----------------------------------------------------------------------------
+			WaitImpl::EpollWaiting::~EpollWaiting()
+			{
+				for (uint32 i = 0; i < m_numObjects; ++i)
+				{
+					--m_objects[i]->m_pImpl->m_epollWaiters;
+				}
+			}
+
+//-----------------------------------------------------------------------------
+//	<WaitImpl::Multiple>
+//	Wait for one of multiple objects to become signalled, using epoll
+//-----------------------------------------------------------------------------
+			bool WaitImpl::Multiple(Wait** _objects, uint32 _numObjects, int32 _timeout, int32* o_result)
+			{
+				EpollSet& set = s_epollSet;
+				if (set.m_epfd < 0)
+				{
+					return false;
+				}
+
+				// Bring the epoll set up to date if this thread was last waiting on something else
+				bool same = (set.m_serials.size() == _numObjects);
+				for (uint32 i = 0; same && i < _numObjects; ++i)
+				{
+					same = (set.m_serials[i] == _objects[i]->m_pImpl->m_serial);
+				}
+				if (!same)
+				{
+					for (uint32 i = 0; i < _numObjects; ++i)
+					{
+						if (_objects[i]->m_pImpl->GetFd() < 0)
+						{
+							return false;
+						}
+					}
+					for (size_t i = 0; i < set.m_fds.size(); ++i)
+					{
+						// fails harmlessly if the object (and so its descriptor) has since gone away
+						epoll_ctl(set.m_epfd, EPOLL_CTL_DEL, set.m_fds[i], NULL);
+					}
+					set.m_serials.resize(_numObjects);
+					set.m_fds.resize(_numObjects);
+					for (uint32 i = 0; i < _numObjects; ++i)
+					{
+						struct epoll_event ev;
+						ev.events = EPOLLIN;
+						ev.data.u32 = i;
+						set.m_serials[i] = _objects[i]->m_pImpl->m_serial;
+						set.m_fds[i] = _objects[i]->m_pImpl->m_fd;
+						if (epoll_ctl(set.m_epfd, EPOLL_CTL_ADD, set.m_fds[i], &ev) != 0 && (errno != EEXIST || epoll_ctl(set.m_epfd, EPOLL_CTL_MOD, set.m_fds[i], &ev) != 0))
+						{
+							fprintf(stderr, "WaitImpl::Multiple epoll_ctl error %d\n", errno);
+							set.m_serials.clear();
+							set.m_fds.clear();
+							return false;
+						}
+					}
+				}
+
+				struct timespec deadline;
+				if (_timeout > 0)
+				{
+					clock_gettime(CLOCK_MONOTONIC, &deadline);
+					deadline.tv_sec += _timeout / 1000;
+					deadline.tv_nsec += (_timeout % 1000) * 1000000;
+					if (deadline.tv_nsec >= 1000000000)
+					{
+						deadline.tv_nsec -= 1000000000;
+						deadline.tv_sec++;
+					}
+				}
+
+				EpollWaiting waiting(_objects, _numObjects);
+				int32 timeout = _timeout;
+				while (1)
+				{
+					// The objects themselves say whether they are signalled.  The descriptors only wake us up.
+					for (uint32 i = 0; i < _numObjects; ++i)
+					{
+						if (_objects[i]->IsSignalled())
+						{
+							*o_result = (int32) i;
+							return true;
+						}
+					}
+					if (timeout == 0)
+					{
+						*o_result = -1;
+						return true;
+					}
+
+					struct epoll_event events[8];
+					int count = epoll_wait(set.m_epfd, events, 8, timeout);
+					if (count < 0 && errno != EINTR)
+					{
+						fprintf(stderr, "WaitImpl::Multiple epoll_wait error %d\n", errno);
+						return false;
+					}
+					for (int e = 0; e < count; ++e)
+					{
+						// Clear the notification.  If the object is still signalled, put it back so
+						// other threads waiting on the same object are woken too.
+						uint32 i = events[e].data.u32;
+						uint64_t value;
+						if (i < _numObjects && read(set.m_fds[i], &value, sizeof(value)) == sizeof(value) && _objects[i]->IsSignalled())
+						{
+							uint64_t one = 1;
+							if (write(set.m_fds[i], &one, sizeof(one)) < 0)
+							{
+								fprintf(stderr, "WaitImpl::Multiple eventfd write error %d\n", errno);
+							}
+						}
+					}
+
+					if (_timeout > 0)
+					{
+						struct timespec now;
+						clock_gettime(CLOCK_MONOTONIC, &now);
+						int64 remaining = (int64) (deadline.tv_sec - now.tv_sec) * 1000 + (deadline.tv_nsec - now.tv_nsec) / 1000000;
+						timeout = (remaining > 0) ? (int32) remaining : 0;
+					}
+				}
+			}
+#endif
 		} // namespace Platform
 	} // namespace Internal
 } // namespace OpenZWave
@@ -32,10 +32,16 @@
 #include <stdio.h>
 #include <pthread.h>
 #include <list>
+#include <atomic>
 #include "Defs.h"
 #include "platform/Ref.h"
 #include "platform/Wait.h"
 
+#ifdef __linux__
+// Wait::Multiple blocks in epoll_wait on an eventfd per object
+#define OZW_WAIT_EPOLL
+#endif
+
 namespace OpenZWave
 {
 	namespace Internal
@@ -56,7 +62,31 @@ namespace OpenZWave
 					bool RemoveWatcher(Wait::pfnWaitNotification_t _callback, void* _context);
 					void Notify();
 
-					static int32 Multiple(Wait** _objects, uint32 _numObjects, int32 _timeout = -1);
+#ifdef OZW_WAIT_EPOLL
+					/**
+					 * Wait for one of the objects to become signalled.
+					 * \param o_result receives the index of the first signalled object, or -1 on timeout
+					 * \return false if the objects cannot be waited on this way, in which case the
+					 * caller falls back to watchers
+					 */
+					static bool Multiple(Wait** _objects, uint32 _numObjects, int32 _timeout, int32* o_result);
+
+					/**
+					 * The eventfd, created the first time the object is waited on this way.
+					 * \return -1 if it cannot be created
+					 */
+					int GetFd();
+
+					/** \brief Counts a thread in Multiple as waiting on each of the objects, so Notify knows to wake it */
+					struct EpollWaiting
+					{
+							EpollWaiting(Wait** _objects, uint32 _numObjects);
+							~EpollWaiting();
+
+							Wait** m_objects;
+							uint32 m_numObjects;
+					};
+#endif
 
 					WaitImpl(Wait const&);					// prevent copy
 					WaitImpl& operator =(WaitImpl const&);	// prevent assignment
@@ -68,8 +98,14 @@ namespace OpenZWave
 					};
 
 					list<Watcher> m_watchers;
+					std::atomic<int32> m_watcherCount;		// So Notify can skip the lock when nobody is watching
 					Wait* m_owner;
 					pthread_mutex_t m_criticalSection;
+#ifdef OZW_WAIT_EPOLL
+					std::atomic<int> m_fd;					// eventfd that becomes readable when the owner is notified, or -1
+					uint64 m_serial;						// Unique to this object, unlike its address and descriptor
+					std::atomic<int32> m_epollWaiters;		// Threads in WaitImpl::Multiple on this object
+#endif
 			};
 		} // namespace Platform
 	} // namespace Internal
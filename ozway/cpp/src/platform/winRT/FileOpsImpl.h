@@ -54,6 +54,9 @@ namespace OpenZWave
 					bool FileRotate(const string _filename);
 					bool FileCopy(const string, const string);
 					bool FolderCreate(const string _dirname);
+					bool FileMap(const string _filename, uint8 const** o_data, size_t* o_size);
+					void FileUnmap(uint8 const* _data, size_t _size);
+					bool FileStat(const string _filename, uint64* o_mtime, uint64* o_size);
 
 			};
 		} // namespace Platform
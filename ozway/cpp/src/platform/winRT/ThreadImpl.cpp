@@ -27,6 +27,7 @@
 //-----------------------------------------------------------------------------
 #include "Defs.h"
 #include "platform/Event.h"
+#include "platform/Log.h"
 #include "platform/Thread.h"
 #include "ThreadImpl.h"
 #include "Options.h"
@@ -55,7 +56,7 @@ namespace OpenZWave
 				{
 					if (Options::Get() != nullptr)
 					{
-						Options::Get()->GetOptionAsInt("ThreadTerminateTimeout", &s_threadTerminateTimeout);
+						Options::Get()->GetOptionAsInt(Options::OptionKey_ThreadTerminateTimeout, &s_threadTerminateTimeout);
 					}
 					staticsInitialized = true;
 				}
@@ -84,6 +85,7 @@ namespace OpenZWave
 				create_task([this]()
 				{
 					m_bIsRunning = true;
+					m_owner->Running();
 					try
 					{
 						m_pfnThreadProc(m_exitEvent, m_context);
@@ -127,6 +129,25 @@ namespace OpenZWave
 				return true;
 			}
 
+//-----------------------------------------------------------------------------
+//	<ThreadImpl::SetPlacement>
+//	Threads run as tasks on the thread pool, so they cannot be placed
+//-----------------------------------------------------------------------------
+			bool ThreadImpl::SetPlacement(uint64 const _affinity, Thread::Policy const _policy, int32 const _priority)
+			{
+				Log::Write(LogLevel_Warning, "Thread placement is not supported on WinRT, ignoring it for thread %s", m_name.c_str());
+				return false;
+			}
+
+//-----------------------------------------------------------------------------
+//	<ThreadImpl::GetCpuTime>
+//	Not available for thread pool tasks
+//-----------------------------------------------------------------------------
+			uint64 ThreadImpl::GetCpuTime()
+			{
+				return 0;
+			}
+
 //-----------------------------------------------------------------------------
 //	<ThreadImpl::IsSignalled>
 //	Test whether the thread has completed
@@ -56,6 +56,8 @@ namespace OpenZWave
 					bool Start(Thread::pfnThreadProc_t _pfnThreadProc, Event* _exitEvent, void* _context);
 					void Sleep(uint32 _milliseconds);
 					bool Terminate();
+					bool SetPlacement(uint64 const _affinity, Thread::Policy const _policy, int32 const _priority);
+					uint64 GetCpuTime();
 
 					bool IsSignalled();
 
@@ -27,6 +27,9 @@
 //-----------------------------------------------------------------------------
 
 #include <windows.h>
+#include <fstream>
+#include <sys/types.h>
+#include <sys/stat.h>
 #include "FileOpsImpl.h"
 #include "Utils.h"
 
@@ -163,6 +166,48 @@ namespace OpenZWave
 				}
 				return true;
 			}
+
+			bool FileOpsImpl::FileMap(const string _filename, uint8 const** o_data, size_t* o_size)
+			{
+				/* no cheap read-only mapping here, so read the file into a heap buffer instead */
+				std::ifstream in(_filename.c_str(), std::ios_base::in | std::ios_base::binary | std::ios_base::ate);
+				if (!in.is_open())
+				{
+					return false;
+				}
+				std::streamoff size = in.tellg();
+				if (size <= 0)
+				{
+					return false;
+				}
+				uint8* data = new uint8[(size_t) size];
+				in.seekg(0, std::ios_base::beg);
+				if (!in.read((char *) data, size))
+				{
+					delete[] data;
+					return false;
+				}
+				*o_data = data;
+				*o_size = (size_t) size;
+				return true;
+			}
+
+			void FileOpsImpl::FileUnmap(uint8 const* _data, size_t _size)
+			{
+				delete[] _data;
+			}
+
+			bool FileOpsImpl::FileStat(const string _filename, uint64* o_mtime, uint64* o_size)
+			{
+				struct __stat64 st;
+				if (_stat64(_filename.c_str(), &st) != 0)
+				{
+					return false;
+				}
+				*o_mtime = (uint64) st.st_mtime;
+				*o_size = (uint64) st.st_size;
+				return true;
+			}
 		} // namespace Platform
 	} // namespace Internal
 } // namespace OpenZWave
@@ -27,6 +27,7 @@
 //-----------------------------------------------------------------------------
 #include "Defs.h"
 #include "platform/Event.h"
+#include "platform/Log.h"
 #include "platform/Thread.h"
 #include "ThreadImpl.h"
 
@@ -100,6 +101,62 @@ namespace OpenZWave
 				return true;
 			}
 
+//-----------------------------------------------------------------------------
+//	<ThreadImpl::SetPlacement>
+//	Set the CPUs and priority of the calling thread, which is this one.  Windows
+//	has no scheduling policies, so they are mapped to thread priorities.
+//-----------------------------------------------------------------------------
+			bool ThreadImpl::SetPlacement(uint64 const _affinity, Thread::Policy const _policy, int32 const _priority)
+			{
+				bool res = true;
+				if (_affinity != 0 && ::SetThreadAffinityMask(::GetCurrentThread(), (DWORD_PTR) _affinity) == 0)
+				{
+					Log::Write(LogLevel_Warning, "Unable to set the CPU affinity of thread %s: %d", m_name.c_str(), ::GetLastError());
+					res = false;
+				}
+
+				int priority = THREAD_PRIORITY_NORMAL;
+				switch (_policy)
+				{
+					case Thread::Policy_Default:
+						return res;
+					case Thread::Policy_Idle:
+						priority = THREAD_PRIORITY_IDLE;
+						break;
+					case Thread::Policy_Batch:
+						priority = THREAD_PRIORITY_BELOW_NORMAL;
+						break;
+					case Thread::Policy_Fifo:
+					case Thread::Policy_RoundRobin:
+						priority = (_priority > 50) ? THREAD_PRIORITY_TIME_CRITICAL : THREAD_PRIORITY_HIGHEST;
+						break;
+					default:
+						break;
+				}
+				if (!::SetThreadPriority(::GetCurrentThread(), priority))
+				{
+					Log::Write(LogLevel_Warning, "Unable to set the priority of thread %s: %d", m_name.c_str(), ::GetLastError());
+					res = false;
+				}
+				return res;
+			}
+
+//-----------------------------------------------------------------------------
+//	<ThreadImpl::GetCpuTime>
+//	CPU time used by the thread, in microseconds
+//-----------------------------------------------------------------------------
+			uint64 ThreadImpl::GetCpuTime()
+			{
+				FILETIME creation, exit, kernel, user;
+				if (m_hThread == INVALID_HANDLE_VALUE || !::GetThreadTimes(m_hThread, &creation, &exit, &kernel, &user))
+				{
+					return 0;
+				}
+				// FILETIMEs count 100ns intervals
+				uint64 total = (((uint64) kernel.dwHighDateTime << 32) | kernel.dwLowDateTime) + (((uint64) user.dwHighDateTime << 32) | user.dwLowDateTime);
+				return total / 10;
+			}
+
 //-----------------------------------------------------------------------------
 //	<ThreadImpl::IsSignalled>
 //	Test whether the thread has completed
@@ -127,6 +184,7 @@ namespace OpenZWave
 			void ThreadImpl::Run()
 			{
 				m_bIsRunning = true;
+				m_owner->Running();
 				m_pfnThreadProc(m_exitEvent, m_context);
 				m_bIsRunning = false;
 
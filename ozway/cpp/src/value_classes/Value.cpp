@@ -36,6 +36,7 @@
 #include "value_classes/Value.h"
 #include "platform/Log.h"
 #include "command_classes/CommandClass.h"
+#include <chrono>
 #include <ctime>
 #include "Options.h"
 
@@ -57,7 +58,7 @@ namespace OpenZWave
 // Constructor
 //-----------------------------------------------------------------------------
 			Value::Value(uint32 const _homeId, uint8 const _nodeId, ValueID::ValueGenre const _genre, uint8 const _commandClassId, uint8 const _instance, uint16 const _index, ValueID::ValueType const _type, string const& _label, string const& _units, bool const _readOnly, bool const _writeOnly, bool const _isSet, uint8 const _pollIntensity) :
-					m_min(0), m_max(0), m_refreshTime(0), m_verifyChanges(false), m_id(_homeId, _nodeId, _genre, _commandClassId, _instance, _index, _type), m_units(_units), m_readOnly(_readOnly), m_writeOnly(_writeOnly), m_isSet(_isSet), m_affectsLength(0), m_affects(), m_affectsAll(false), m_checkChange(false), m_pollIntensity(_pollIntensity)
+					m_min(0), m_max(0), m_refreshTime(0), m_changeCount(0), m_pollPending(false), m_reportCount(0), m_reportTime(0), m_verifyChanges(false), m_id(_homeId, _nodeId, _genre, _commandClassId, _instance, _index, _type), m_units(_units), m_readOnly(_readOnly), m_writeOnly(_writeOnly), m_isSet(_isSet), m_affectsLength(0), m_affects(), m_affectsAll(false), m_checkChange(false), m_pollIntensity(_pollIntensity)
 			{
 				SetLabel(_label);
 			}
@@ -67,7 +68,7 @@ namespace OpenZWave
 // Constructor (from XML)
 //-----------------------------------------------------------------------------
 			Value::Value() :
-					m_min(0), m_max(0), m_refreshTime(0), m_verifyChanges(false), m_readOnly(false), m_writeOnly(false), m_isSet(false), m_affectsLength(0), m_affects(), m_affectsAll(false), m_checkChange(false), m_pollIntensity(0)
+					m_min(0), m_max(0), m_refreshTime(0), m_changeCount(0), m_pollPending(false), m_reportCount(0), m_reportTime(0), m_verifyChanges(false), m_readOnly(false), m_writeOnly(false), m_isSet(false), m_affectsLength(0), m_affects(), m_affectsAll(false), m_checkChange(false), m_pollIntensity(0)
 			{
 			}
 
@@ -345,7 +346,7 @@ namespace OpenZWave
 					m_isSet = true;
 
 					bool bSuppress;
-					Options::Get()->GetOptionAsBool("SuppressValueRefresh", &bSuppress);
+					Options::Get()->GetOptionAsBool(Options::OptionKey_SuppressValueRefresh, &bSuppress);
 					if (!bSuppress)
 					{
 						// Notify the watchers
@@ -463,6 +464,35 @@ namespace OpenZWave
 				return c_typeName[_type];
 			}
 
+//-----------------------------------------------------------------------------
+// <Value::GetTimeMs>
+// A steady clock in ms.  Value is copied, so it keeps plain times rather than
+// TimeStamps, which cannot be.
+//-----------------------------------------------------------------------------
+			int64 Value::GetTimeMs()
+			{
+				return (int64) std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+			}
+
+//-----------------------------------------------------------------------------
+// <Value::MarkRefreshed>
+// Record the time of a refresh.  Adaptive polling only skips a poll for a
+// refresh that the previous poll did not ask for.
+//-----------------------------------------------------------------------------
+			void Value::MarkRefreshed()
+			{
+				m_refreshTime = time( NULL);	// update value refresh time
+				if (m_pollPending)
+				{
+					m_pollPending = false;
+				}
+				else
+				{
+					m_reportTime = GetTimeMs();
+					m_reportCount++;
+				}
+			}
+
 //-----------------------------------------------------------------------------
 // <Value::VerifyRefreshedValue>
 // Check a refreshed value
@@ -482,6 +512,8 @@ namespace OpenZWave
 				if (!IsSet())
 				{
 					Log::Write(LogLevel_Detail, m_id.GetNodeId(), "Initial read of value");
+					MarkRefreshed();
+					m_changeCount++;
 					Value::OnValueChanged();
 					return 2;		// confirmed change of value
 				}
@@ -532,18 +564,7 @@ namespace OpenZWave
 						}
 					}
 				}
-				m_refreshTime = time( NULL);	// update value refresh time
-
-				// check whether changes in this value should be verified (since some devices will report values that always
-				// change, where confirming changes is difficult or impossible)
-				Log::Write(LogLevel_Detail, m_id.GetNodeId(), "Changes to this value are %sverified", m_verifyChanges ? "" : "not ");
-
-				if (!m_verifyChanges)
-				{
-					// since we're not checking changes in this value, notify ValueChanged (to be on the safe side)
-					Value::OnValueChanged();
-					return 2;				// confirmed change of value
-				}
+				MarkRefreshed();
 
 				// see if the value has changed (result is used whether checking change or not)
 				bool bOriginalEqual = false;
@@ -576,10 +597,26 @@ namespace OpenZWave
 						/* Should not get here */
 						break;
 					case ValueID::ValueType_BitSet:			// BitSet
-						bOriginalEqual = (((Bitfield *) _originalValue)->GetValue() == ((Bitfield *) _newValue)->GetValue());
+						bOriginalEqual = (((Bitfield *) _originalValue)->GetValue() == *((uint32*) _newValue));	// the new value is passed as a uint32
 						break;
 				}
 
+				if (!bOriginalEqual)
+				{
+					m_changeCount++;		// adaptive polling backs off values that do not change
+				}
+
+				// check whether changes in this value should be verified (since some devices will report values that always
+				// change, where confirming changes is difficult or impossible)
+				Log::Write(LogLevel_Detail, m_id.GetNodeId(), "Changes to this value are %sverified", m_verifyChanges ? "" : "not ");
+
+				if (!m_verifyChanges)
+				{
+					// since we're not checking changes in this value, notify ValueChanged (to be on the safe side)
+					Value::OnValueChanged();
+					return 2;				// confirmed change of value
+				}
+
 				// if this is the first refresh of the value, test to see if the value has changed
 				if (!IsCheckingChange())
 				{
@@ -629,7 +666,7 @@ namespace OpenZWave
 							/* Should not get here */
 							break;
 						case ValueID::ValueType_BitSet:			// BitSet
-							bCheckEqual = (((Bitfield *) _checkValue)->GetValue() == ((Bitfield *) _newValue)->GetValue());
+							bCheckEqual = (((Bitfield *) _checkValue)->GetValue() == *((uint32*) _newValue));
 							;
 							break;
 					}
@@ -167,11 +167,17 @@ namespace OpenZWave
 					void OnValueRefreshed();			// A value in a device has been refreshed
 					void OnValueChanged();				// The refreshed value actually changed
 					int VerifyRefreshedValue(void* _originalValue, void* _checkValue, void* _newValue, ValueID::ValueType _type, int _originalValueLength = 0, int _checkValueLength = 0, int _newValueLength = 0);
+					void MarkRefreshed();				// Record the time of a refresh, and whether a poll asked for it
+					static int64 GetTimeMs();			// A steady clock in ms, for m_reportTime
 
 					int32 m_min;
 					int32 m_max;
 
 					time_t m_refreshTime;			// time_t identifying when this value was last refreshed
+					uint32 m_changeCount;			// incremented whenever a refresh reports a different value
+					bool m_pollPending;				// a poll has asked for this value, so the next refresh is its answer
+					uint32 m_reportCount;			// incremented whenever a refresh arrives that no poll asked for
+					int64 m_reportTime;				// steady clock ms (see GetTimeMs) when the last refresh that no poll asked for arrived
 					bool m_verifyChanges;		// if true, apparent changes are verified; otherwise, they're not
 					ValueID m_id;
 
@@ -0,0 +1,210 @@
+//-----------------------------------------------------------------------------
+//
+//	ConfigBundle_test.cpp
+//
+//	Test Framework for the precompiled Config Bundle
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+
+#include "ConfigBundle.h"
+#include "Options.h"
+#include "tinyxml.h"
+
+using namespace OpenZWave;
+using namespace OpenZWave::Internal;
+
+namespace
+{
+	// Write a file, and return its modification time
+	time_t WriteFile(string const& _path, string const& _text)
+	{
+		FILE* f = fopen(_path.c_str(), "wb");
+		fwrite(_text.data(), 1, _text.size(), f);
+		fclose(f);
+		struct stat st;
+		stat(_path.c_str(), &st);
+		return st.st_mtime;
+	}
+
+	// Build a bundle holding the single file "test.xml", as ozwbundle would
+	string MakeBundle(string const& _text, uint32 _sourceSize, time_t _sourceMTime, bool _corrupt = false)
+	{
+		string strings("\0test.xml\0", 10);
+		Bundle::Header header;
+		memset(&header, 0, sizeof(header));
+		memcpy(header.m_magic, Bundle::c_magic, sizeof(header.m_magic));
+		header.m_version = Bundle::c_version;
+		header.m_endian = Bundle::c_endian;
+		header.m_manufacturerOffset = sizeof(header);
+		header.m_productOffset = sizeof(header);
+		header.m_fileOffset = sizeof(header);
+		header.m_fileCount = 1;
+		header.m_stringsOffset = sizeof(header) + sizeof(Bundle::File);
+		header.m_stringsSize = (uint32) strings.size();
+
+		Bundle::File file;
+		memset(&file, 0, sizeof(file));
+		file.m_path = 1;
+		file.m_data = header.m_stringsOffset + header.m_stringsSize;
+		file.m_length = (uint32) _text.size();
+		file.m_sourceSize = _sourceSize;
+		file.m_sourceMTime = (uint64) _sourceMTime;
+		if (_corrupt)
+		{
+			// the text runs past the end of the bundle
+			file.m_length += 100;
+		}
+
+		string bundle((char const*) &header, sizeof(header));
+		bundle.append((char const*) &file, sizeof(file));
+		bundle.append(strings);
+		bundle.append(_text);
+		bundle.push_back('\0');
+		return bundle;
+	}
+
+	class ConfigBundleTest: public ::testing::Test
+	{
+		protected:
+			virtual void SetUp()
+			{
+				char dir[] = "/tmp/ozwbundleXXXXXX";
+				ASSERT_TRUE(mkdtemp(dir) != NULL);
+				m_dir = string(dir) + "/";
+			}
+			virtual void TearDown()
+			{
+				ConfigBundle::Destroy();
+				Options::Destroy();
+				unlink((m_dir + "test.xml").c_str());
+				unlink((m_dir + "test.bundle").c_str());
+				rmdir(m_dir.c_str());
+			}
+
+			// Create the Options and the ConfigBundle singletons for m_dir
+			ConfigBundle* Open()
+			{
+				Options::Create(m_dir, m_dir, "--ConfigBundle test.bundle");
+				Options::Get()->Lock();
+				return ConfigBundle::Create();
+			}
+
+			// Which copy of test.xml LoadDocument returns
+			string Load()
+			{
+				TiXmlDocument doc;
+				if (!ConfigBundle::LoadDocument("test.xml", &doc))
+				{
+					return "";
+				}
+				return doc.RootElement()->Attribute("from");
+			}
+
+			string m_dir;
+	};
+}
+
+TEST_F(ConfigBundleTest, ServesUnchangedFile)
+{
+	// the same length on disk and in the bundle, so only the mtime tells them apart
+	time_t mtime = WriteFile(m_dir + "test.xml", "<Test from=\"disk\"/>");
+	WriteFile(m_dir + "test.bundle", MakeBundle("<Test from=\"bndl\"/>", 19, mtime));
+	ConfigBundle* bundle = Open();
+	ASSERT_TRUE(bundle->IsLoaded());
+	EXPECT_TRUE(bundle->IsValid("test.xml"));
+	EXPECT_FALSE(bundle->IsValid("other.xml"));
+	EXPECT_EQ(Load(), "bndl");
+}
+
+TEST_F(ConfigBundleTest, RejectsChangedSize)
+{
+	time_t mtime = WriteFile(m_dir + "test.xml", "<Test from=\"disk\" />");
+	WriteFile(m_dir + "test.bundle", MakeBundle("<Test from=\"bndl\"/>", 19, mtime));
+	ConfigBundle* bundle = Open();
+	ASSERT_TRUE(bundle->IsLoaded());
+	EXPECT_FALSE(bundle->IsValid("test.xml"));
+	EXPECT_EQ(Load(), "disk");
+}
+
+TEST_F(ConfigBundleTest, RejectsChangedMTime)
+{
+	// as after a download in an earlier run
+	time_t mtime = WriteFile(m_dir + "test.xml", "<Test from=\"disk\"/>");
+	struct utimbuf times;
+	times.actime = mtime + 60;
+	times.modtime = mtime + 60;
+	utime((m_dir + "test.xml").c_str(), &times);
+	WriteFile(m_dir + "test.bundle", MakeBundle("<Test from=\"bndl\"/>", 19, mtime));
+	ConfigBundle* bundle = Open();
+	ASSERT_TRUE(bundle->IsLoaded());
+	EXPECT_FALSE(bundle->IsValid("test.xml"));
+	EXPECT_EQ(Load(), "disk");
+}
+
+TEST_F(ConfigBundleTest, ServesFileMissingFromDisk)
+{
+	WriteFile(m_dir + "test.bundle", MakeBundle("<Test from=\"bndl\"/>", 19, 0));
+	ConfigBundle* bundle = Open();
+	ASSERT_TRUE(bundle->IsLoaded());
+	EXPECT_TRUE(bundle->IsValid("test.xml"));
+	EXPECT_EQ(Load(), "bndl");
+}
+
+TEST_F(ConfigBundleTest, Invalidate)
+{
+	time_t mtime = WriteFile(m_dir + "test.xml", "<Test from=\"disk\"/>");
+	WriteFile(m_dir + "test.bundle", MakeBundle("<Test from=\"bndl\"/>", 19, mtime));
+	ConfigBundle* bundle = Open();
+	ASSERT_TRUE(bundle->IsValid("test.xml"));
+	bundle->Invalidate("test.xml");
+	EXPECT_FALSE(bundle->IsValid("test.xml"));
+	EXPECT_EQ(Load(), "disk");
+}
+
+TEST_F(ConfigBundleTest, RejectsCorruptBundle)
+{
+	time_t mtime = WriteFile(m_dir + "test.xml", "<Test from=\"disk\"/>");
+	WriteFile(m_dir + "test.bundle", MakeBundle("<Test from=\"bndl\"/>", 19, mtime, true));
+	ConfigBundle* bundle = Open();
+	EXPECT_FALSE(bundle->IsLoaded());
+	EXPECT_FALSE(bundle->IsValid("test.xml"));
+	EXPECT_EQ(Load(), "disk");
+}
+
+TEST_F(ConfigBundleTest, RejectsOtherVersion)
+{
+	time_t mtime = WriteFile(m_dir + "test.xml", "<Test from=\"disk\"/>");
+	string bundle = MakeBundle("<Test from=\"bndl\"/>", 19, mtime);
+	((Bundle::Header*) &bundle[0])->m_version = Bundle::c_version - 1;
+	WriteFile(m_dir + "test.bundle", bundle);
+	EXPECT_FALSE(Open()->IsLoaded());
+	EXPECT_EQ(Load(), "disk");
+}
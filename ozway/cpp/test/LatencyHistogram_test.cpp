@@ -0,0 +1,132 @@
+//-----------------------------------------------------------------------------
+//
+//	LatencyHistogram_test.cpp
+//
+//	Test Framework for the latency histograms
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include "LatencyHistogram.h"
+
+using namespace OpenZWave;
+
+namespace
+{
+	// The bucket a latency was counted in, found through the public interface
+	int32 BucketOf(uint32 _ms)
+	{
+		LatencyHistogram histogram;
+		histogram.Record(_ms);
+		for (uint32 i = 0; i < LatencyHistogram::c_bucketCount; ++i)
+		{
+			if (histogram.GetBucketCount(i) != 0)
+			{
+				return i;
+			}
+		}
+		return -1;
+	}
+}
+
+TEST(LatencyHistogram, BucketBounds)
+{
+	// The buckets cover every latency without gaps or overlaps
+	EXPECT_EQ(LatencyHistogram::GetBucketLow(0), 0u);
+	for (uint32 i = 1; i < LatencyHistogram::c_bucketCount; ++i)
+	{
+		EXPECT_EQ(LatencyHistogram::GetBucketLow(i), LatencyHistogram::GetBucketHigh(i - 1) + 1) << "bucket " << i;
+		EXPECT_LE(LatencyHistogram::GetBucketLow(i), LatencyHistogram::GetBucketHigh(i)) << "bucket " << i;
+	}
+	EXPECT_EQ(LatencyHistogram::GetBucketLow(LatencyHistogram::c_bucketCount - 1), 65536u);
+	EXPECT_EQ(LatencyHistogram::GetBucketHigh(LatencyHistogram::c_bucketCount - 1), 0xffffffffu);
+
+	// Above 4 ms, a bucket is no wider than a quarter of its lowest value
+	for (uint32 i = 4; i < LatencyHistogram::c_bucketCount - 1; ++i)
+	{
+		uint32 low = LatencyHistogram::GetBucketLow(i);
+		EXPECT_LE(LatencyHistogram::GetBucketHigh(i) - low + 1, low / 4) << "bucket " << i;
+	}
+}
+
+TEST(LatencyHistogram, Record)
+{
+	// Every latency lands in the bucket whose bounds hold it
+	uint32 const samples[] = { 0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 100, 999, 1000, 1023, 1024, 65535 };
+	for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); ++i)
+	{
+		int32 idx = BucketOf(samples[i]);
+		ASSERT_GE(idx, 0);
+		EXPECT_LE(LatencyHistogram::GetBucketLow(idx), samples[i]);
+		EXPECT_GE(LatencyHistogram::GetBucketHigh(idx), samples[i]);
+	}
+	EXPECT_EQ(BucketOf(65536), LatencyHistogram::c_bucketCount - 1);
+	EXPECT_EQ(BucketOf(0xffffffff), LatencyHistogram::c_bucketCount - 1);
+}
+
+TEST(LatencyHistogram, Percentiles)
+{
+	LatencyHistogram histogram;
+	EXPECT_EQ(histogram.GetPercentile(50), 0u);
+
+	// 98 fast replies, one slow one and one that timed out
+	for (int i = 0; i < 98; ++i)
+	{
+		histogram.Record(20);
+	}
+	histogram.Record(3000);
+	histogram.Record(100000);
+	EXPECT_EQ(histogram.GetCount(), 100u);
+
+	// Each percentile is the top of the bucket holding it, so never below the true value
+	uint32 fast = LatencyHistogram::GetBucketHigh(BucketOf(20));
+	EXPECT_EQ(histogram.GetPercentile(0), fast);
+	EXPECT_EQ(histogram.GetPercentile(50), fast);
+	EXPECT_EQ(histogram.GetPercentile(98), fast);
+	EXPECT_EQ(histogram.GetPercentile(99), LatencyHistogram::GetBucketHigh(BucketOf(3000)));
+	EXPECT_GE(histogram.GetPercentile(99), 3000u);
+	EXPECT_LT(histogram.GetPercentile(99), 3000u * 5 / 4);
+	EXPECT_EQ(histogram.GetPercentile(100), 65536u);
+	EXPECT_EQ(histogram.GetPercentile(200), 65536u);
+
+	histogram.Clear();
+	EXPECT_EQ(histogram.GetCount(), 0u);
+	EXPECT_EQ(histogram.GetPercentile(99), 0u);
+}
+
+TEST(LatencyHistogram, PercentileRank)
+{
+	// With a single sample, every percentile is that sample's bucket
+	LatencyHistogram histogram;
+	histogram.Record(2);
+	EXPECT_EQ(histogram.GetPercentile(0), 2u);
+	EXPECT_EQ(histogram.GetPercentile(100), 2u);
+
+	// The p50 of 1, 2 is 1, and of 1, 2, 3 is 2
+	histogram.Clear();
+	histogram.Record(1);
+	histogram.Record(2);
+	EXPECT_EQ(histogram.GetPercentile(50), 1u);
+	histogram.Record(3);
+	EXPECT_EQ(histogram.GetPercentile(50), 2u);
+}
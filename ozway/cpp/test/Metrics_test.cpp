@@ -0,0 +1,181 @@
+//-----------------------------------------------------------------------------
+//
+//	Metrics_test.cpp
+//
+//	Test Framework for the metrics registry and its export format
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "Metrics.h"
+#include "Options.h"
+
+using namespace OpenZWave;
+using namespace OpenZWave::Internal;
+
+namespace
+{
+	int64 QueueDepth(void* _context)
+	{
+		return *(int64*) _context;
+	}
+
+	class MetricsTest: public ::testing::Test
+	{
+		protected:
+			virtual void SetUp()
+			{
+				char dir[] = "/tmp/ozwmetricsXXXXXX";
+				ASSERT_TRUE(mkdtemp(dir) != NULL);
+				m_dir = string(dir) + "/";
+			}
+
+			virtual void TearDown()
+			{
+				Metrics::Destroy();
+				Options::Destroy();
+				unlink((m_dir + "metrics.prom").c_str());
+				unlink((m_dir + "metrics.prom.tmp").c_str());
+				rmdir(m_dir.c_str());
+			}
+
+			Metrics* Create(string const& _commandLine = "")
+			{
+				Options::Create(m_dir, m_dir, _commandLine)->Lock();
+				return Metrics::Create();
+			}
+
+			string m_dir;
+	};
+}
+
+TEST_F(MetricsTest, Label)
+{
+	EXPECT_EQ(Metrics::Label("controller", "/dev/ttyACM0"), "controller=\"/dev/ttyACM0\"");
+	EXPECT_EQ(Metrics::Label("name", "a\"b\\c\nd"), "name=\"a\\\"b\\\\c\\nd\"");
+}
+
+TEST_F(MetricsTest, Export)
+{
+	Metrics* metrics = Create();
+	int a, b;
+	std::atomic<uint32> sentA(3);
+	std::atomic<uint32> sentB(5);
+	int64 depth = -2;
+	string labelA = Metrics::Label("controller", "a");
+	metrics->AddCounter(&a, "ozw_frames_sent_total", "Frames sent", labelA, &sentA);
+	metrics->AddGauge(&a, "ozw_queue_depth", "Queued messages", "", QueueDepth, &depth);
+	vector<uint32> bounds;
+	bounds.push_back(10);
+	bounds.push_back(100);
+	Histogram* latency = metrics->AddHistogram(&a, "ozw_latency_ms", "Latency", labelA, bounds);
+	ASSERT_TRUE(latency != NULL);
+	// The second owner's series join the families the first one created
+	metrics->AddCounter(&b, "ozw_frames_sent_total", "Frames sent", Metrics::Label("controller", "b"), &sentB);
+	latency->Observe(5);
+	latency->Observe(10);
+	latency->Observe(50);
+	latency->Observe(1000);
+
+	EXPECT_EQ(metrics->Export(),
+			"# HELP ozw_frames_sent_total Frames sent\n"
+			"# TYPE ozw_frames_sent_total counter\n"
+			"ozw_frames_sent_total{controller=\"a\"} 3\n"
+			"ozw_frames_sent_total{controller=\"b\"} 5\n"
+			"# HELP ozw_queue_depth Queued messages\n"
+			"# TYPE ozw_queue_depth gauge\n"
+			"ozw_queue_depth -2\n"
+			"# HELP ozw_latency_ms Latency\n"
+			"# TYPE ozw_latency_ms histogram\n"
+			"ozw_latency_ms_bucket{controller=\"a\",le=\"10\"} 2\n"
+			"ozw_latency_ms_bucket{controller=\"a\",le=\"100\"} 3\n"
+			"ozw_latency_ms_bucket{controller=\"a\",le=\"+Inf\"} 4\n"
+			"ozw_latency_ms_sum{controller=\"a\"} 1065\n"
+			"ozw_latency_ms_count{controller=\"a\"} 4\n");
+
+	// Values are read at export time, and families without series are left out
+	sentB = 6;
+	metrics->Remove(&a);
+	EXPECT_EQ(metrics->Export(),
+			"# HELP ozw_frames_sent_total Frames sent\n"
+			"# TYPE ozw_frames_sent_total counter\n"
+			"ozw_frames_sent_total{controller=\"b\"} 6\n");
+	metrics->Remove(&b);
+	EXPECT_EQ(metrics->Export(), "");
+}
+
+TEST_F(MetricsTest, HistogramWithoutLabels)
+{
+	Metrics* metrics = Create();
+	vector<uint32> bounds(1, 1);
+	Histogram* histogram = metrics->AddHistogram(this, "ozw_retries", "Retries", "", bounds);
+	histogram->Observe(0);
+	EXPECT_EQ(metrics->Export(),
+			"# HELP ozw_retries Retries\n"
+			"# TYPE ozw_retries histogram\n"
+			"ozw_retries_bucket{le=\"1\"} 1\n"
+			"ozw_retries_bucket{le=\"+Inf\"} 1\n"
+			"ozw_retries_sum 0\n"
+			"ozw_retries_count 1\n");
+}
+
+TEST_F(MetricsTest, TypeConflict)
+{
+	Metrics* metrics = Create();
+	std::atomic<uint32> count(1);
+	metrics->AddCounter(this, "ozw_frames_total", "Frames", "", &count);
+	EXPECT_TRUE(metrics->AddHistogram(this, "ozw_frames_total", "Frames", "", vector<uint32>(1, 1)) == NULL);
+	EXPECT_EQ(metrics->Export(),
+			"# HELP ozw_frames_total Frames\n"
+			"# TYPE ozw_frames_total counter\n"
+			"ozw_frames_total 1\n");
+}
+
+TEST_F(MetricsTest, ExportToFile)
+{
+	string path = m_dir + "metrics.prom";
+	Metrics* metrics = Create("--MetricsExport " + path + " --MetricsExportInterval 1000");
+	std::atomic<uint32> count(7);
+	metrics->AddCounter(this, "ozw_frames_total", "Frames", "", &count);
+
+	// The first export happens as soon as the thread starts, perhaps before the counter was added
+	string expected = "# HELP ozw_frames_total Frames\n# TYPE ozw_frames_total counter\nozw_frames_total 7\n";
+	string text;
+	for (int i = 0; i < 300 && text != expected; ++i)
+	{
+		usleep(10000);
+		FILE* file = fopen(path.c_str(), "r");
+		if (file)
+		{
+			char buf[256];
+			size_t len = fread(buf, 1, sizeof(buf), file);
+			fclose(file);
+			text.assign(buf, len);
+		}
+	}
+	EXPECT_EQ(text, expected);
+}
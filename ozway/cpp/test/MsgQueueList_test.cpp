@@ -0,0 +1,184 @@
+//-----------------------------------------------------------------------------
+//
+//	MsgQueueList_test.cpp
+//
+//	Test Framework for the Driver send queues
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <vector>
+
+#include "Defs.h"
+#include "Driver.h"
+#include "Msg.h"
+
+namespace OpenZWave
+{
+	class MsgQueueListTest: public ::testing::Test
+	{
+		protected:
+			typedef Driver::MsgQueueList MsgQueueList;
+			typedef Driver::MsgQueueItem MsgQueueItem;
+
+			virtual void TearDown()
+			{
+				for (std::vector<Internal::Msg*>::iterator it = m_msgs.begin(); it != m_msgs.end(); ++it)
+				{
+					delete *it;
+				}
+			}
+
+			// A Basic Get for a node, made distinct by _tag
+			Internal::Msg* NewMsg(uint8 _nodeId, uint8 _tag)
+			{
+				Internal::Msg* msg = new Internal::Msg("test", _nodeId, REQUEST, FUNC_ID_ZW_SEND_DATA, true);
+				msg->Append(_nodeId);
+				msg->Append(3);
+				msg->Append(0x20);
+				msg->Append(0x02);
+				msg->Append(_tag);
+				msg->Finalize();
+				m_msgs.push_back(msg);
+				return msg;
+			}
+
+			MsgQueueItem Item(Internal::Msg* _msg)
+			{
+				MsgQueueItem item;
+				item.m_command = Driver::MsgQueueCmd_SendMsg;
+				item.m_msg = _msg;
+				return item;
+			}
+
+			// Take everything from the queue, and return the node and tag of each message in turn
+			std::vector<uint32> Drain()
+			{
+				std::vector<uint32> order;
+				while (!m_queue.empty())
+				{
+					Internal::Msg* msg = m_queue.front().m_msg;
+					order.push_back(msg->GetTargetNodeId() * 100 + msg->GetBuffer()[8]);
+					m_queue.pop_front();
+				}
+				return order;
+			}
+
+			MsgQueueList m_queue;
+			std::vector<Internal::Msg*> m_msgs;
+	};
+}
+
+using namespace OpenZWave;
+
+TEST_F(MsgQueueListTest, RoundRobin)
+{
+	// A burst for node 5 does not hold up nodes 6 and 7
+	m_queue.push_back(Item(NewMsg(5, 1)));
+	m_queue.push_back(Item(NewMsg(5, 2)));
+	m_queue.push_back(Item(NewMsg(5, 3)));
+	m_queue.push_back(Item(NewMsg(6, 1)));
+	m_queue.push_back(Item(NewMsg(7, 1)));
+	m_queue.push_back(Item(NewMsg(6, 2)));
+	EXPECT_EQ(m_queue.size(), 6u);
+
+	std::vector<uint32> order = Drain();
+	uint32 const expected[] = { 501, 601, 701, 502, 602, 503 };
+	EXPECT_EQ(order, std::vector<uint32>(expected, expected + 6));
+	EXPECT_TRUE(m_queue.empty());
+}
+
+TEST_F(MsgQueueListTest, PushFront)
+{
+	m_queue.push_back(Item(NewMsg(5, 1)));
+	m_queue.push_back(Item(NewMsg(6, 1)));
+	m_queue.push_back(Item(NewMsg(6, 2)));
+	m_queue.push_front(Item(NewMsg(6, 3)));
+
+	std::vector<uint32> order = Drain();
+	uint32 const expected[] = { 603, 501, 601, 602 };
+	EXPECT_EQ(order, std::vector<uint32>(expected, expected + 4));
+}
+
+TEST_F(MsgQueueListTest, Erase)
+{
+	m_queue.push_back(Item(NewMsg(5, 1)));
+	m_queue.push_back(Item(NewMsg(6, 1)));
+	m_queue.push_back(Item(NewMsg(5, 2)));
+	m_queue.push_back(Item(NewMsg(7, 1)));
+
+	// Remove everything for node 6, as when a node fails
+	MsgQueueList::iterator it = m_queue.begin();
+	while (it != m_queue.end())
+	{
+		if (it->m_msg->GetTargetNodeId() == 6)
+		{
+			it = m_queue.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+	EXPECT_EQ(m_queue.size(), 3u);
+
+	std::vector<uint32> order = Drain();
+	uint32 const expected[] = { 501, 701, 502 };
+	EXPECT_EQ(order, std::vector<uint32>(expected, expected + 3));
+}
+
+TEST_F(MsgQueueListTest, Contains)
+{
+	m_queue.push_back(Item(NewMsg(5, 1)));
+	m_queue.push_back(Item(NewMsg(6, 1)));
+
+	// A different message object with the same frame is found
+	EXPECT_TRUE(m_queue.Contains(NewMsg(5, 1)));
+	EXPECT_FALSE(m_queue.Contains(NewMsg(5, 2)));
+	EXPECT_FALSE(m_queue.Contains(NewMsg(7, 1)));
+
+	m_queue.pop_front();
+	EXPECT_FALSE(m_queue.Contains(NewMsg(5, 1)));
+	EXPECT_TRUE(m_queue.Contains(NewMsg(6, 1)));
+}
+
+TEST_F(MsgQueueListTest, NodeStatistics)
+{
+	m_queue.push_back(Item(NewMsg(5, 1)));
+	m_queue.push_back(Item(NewMsg(5, 2)));
+	m_queue.push_back(Item(NewMsg(6, 1)));
+	m_queue.pop_front();
+
+	uint32 depth = 0;
+	uint32 sent = 0;
+	uint64 waitTotal = 0;
+	uint32 waitMax = 0;
+	m_queue.GetNodeStatistics(5, &depth, &sent, &waitTotal, &waitMax);
+	EXPECT_EQ(depth, 1u);
+	EXPECT_EQ(sent, 1u);
+
+	depth = sent = 0;
+	m_queue.GetNodeStatistics(9, &depth, &sent, &waitTotal, &waitMax);
+	EXPECT_EQ(depth, 0u);
+	EXPECT_EQ(sent, 0u);
+}
@@ -0,0 +1,151 @@
+//-----------------------------------------------------------------------------
+//
+//	Mutex_test.cpp
+//
+//	Test Framework for the Mutex and Event objects
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <thread>
+#include <vector>
+
+#include "platform/Event.h"
+#include "platform/Mutex.h"
+#include "platform/TimeStamp.h"
+#include "platform/Wait.h"
+
+using namespace OpenZWave::Internal::Platform;
+
+namespace
+{
+	uint32 const c_threads = 4;
+	uint32 const c_iterations = 200000;
+
+	// Short critical sections from several threads, like those on the node and send mutexes
+	template<typename LockFn, typename UnlockFn>
+	int32 Contend(LockFn _lock, UnlockFn _unlock, uint32* _counter)
+	{
+		TimeStamp start;
+		std::vector<std::thread> threads;
+		for (uint32 t = 0; t < c_threads; ++t)
+		{
+			threads.push_back(std::thread([&]()
+			{
+				for (uint32 i = 0; i < c_iterations; ++i)
+				{
+					_lock();
+					++*_counter;
+					_unlock();
+				}
+			}));
+		}
+		for (size_t t = 0; t < threads.size(); ++t)
+		{
+			threads[t].join();
+		}
+		return TimeStamp() - start;
+	}
+}
+
+TEST(Mutex, Recursive)
+{
+	Mutex* mutex = new Mutex();
+	EXPECT_TRUE(mutex->IsSignalled());
+	EXPECT_TRUE(mutex->Lock());
+	EXPECT_TRUE(mutex->Lock(false));
+	EXPECT_FALSE(mutex->IsSignalled());
+	mutex->Unlock();
+	EXPECT_FALSE(mutex->IsSignalled());
+	mutex->Unlock();
+	EXPECT_TRUE(mutex->IsSignalled());
+	mutex->Release();
+}
+
+TEST(Mutex, TryLockHeldElsewhere)
+{
+	Mutex* mutex = new Mutex();
+	mutex->Lock();
+	bool locked = true;
+	std::thread other([&]()
+	{
+		locked = mutex->Lock(false);
+	});
+	other.join();
+	EXPECT_FALSE(locked);
+	mutex->Unlock();
+	mutex->Release();
+}
+
+TEST(Event, SetAndReset)
+{
+	Event* event = new Event();
+	EXPECT_EQ(Wait::Single(event, 10), -1);
+	event->Set();
+	EXPECT_EQ(Wait::Single(event, 10), 0);
+	EXPECT_EQ(Wait::Single(event, 10), 0);
+	event->Reset();
+	EXPECT_EQ(Wait::Single(event, 10), -1);
+	event->Release();
+}
+
+TEST(Event, WakesWaiter)
+{
+	Event* event = new Event();
+	std::thread setter([event]()
+	{
+		TimeStamp start;
+		while (TimeStamp() - start < 20)
+		{
+		}
+		event->Set();
+	});
+	EXPECT_EQ(Wait::Single(event, 2000), 0);
+	setter.join();
+	event->Release();
+}
+
+TEST(Mutex, ContentionBenchmark)
+{
+	// Against a plain error checking pthread mutex, which the unix Mutex used to be built on
+	pthread_mutexattr_t ma;
+	pthread_mutexattr_init(&ma);
+	pthread_mutexattr_settype(&ma, PTHREAD_MUTEX_ERRORCHECK);
+	pthread_mutex_t pm;
+	pthread_mutex_init(&pm, &ma);
+	pthread_mutexattr_destroy(&ma);
+	uint32 pthreadCount = 0;
+	int32 pthreadTime = Contend([&]() { pthread_mutex_lock(&pm); }, [&]() { pthread_mutex_unlock(&pm); }, &pthreadCount);
+	pthread_mutex_destroy(&pm);
+
+	Mutex* mutex = new Mutex();
+	uint32 mutexCount = 0;
+	int32 mutexTime = Contend([&]() { mutex->Lock(); }, [&]() { mutex->Unlock(); }, &mutexCount);
+	mutex->Release();
+
+	EXPECT_EQ(pthreadCount, c_threads * c_iterations);
+	EXPECT_EQ(mutexCount, c_threads * c_iterations);
+	printf("Mutex: %u threads x %u locks: pthread %d ms, Mutex %d ms\n", c_threads, c_iterations, pthreadTime, mutexTime);
+}
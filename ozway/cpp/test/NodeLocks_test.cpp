@@ -0,0 +1,308 @@
+//-----------------------------------------------------------------------------
+//
+//	NodeLocks_test.cpp
+//
+//	Test Framework for the node list and node locks
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <stdio.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "NodeLocks.h"
+#include "platform/Mutex.h"
+#include "platform/TimeStamp.h"
+
+using namespace OpenZWave::Internal;
+
+namespace
+{
+	// Stands in for Node, which NodeLocks only needs the mutex of
+	struct TestNode
+	{
+		Platform::Mutex* m_mutex;
+		uint32 m_value;
+	};
+
+	uint8 const c_nodes = 8;
+
+	// Roughly the cost of a value lookup, done under the lock
+	void Work(TestNode* _node)
+	{
+		volatile uint32 sum = 0;
+		for (uint32 i = 0; i < 200; ++i)
+		{
+			sum += i;
+		}
+		_node->m_value++;
+	}
+
+	class NodeLocksTest: public ::testing::Test
+	{
+		protected:
+			virtual void SetUp()
+			{
+				for (int i = 0; i < 256; ++i)
+				{
+					m_nodes[i] = NULL;
+				}
+				for (uint8 i = 1; i <= c_nodes; ++i)
+				{
+					m_nodes[i] = new TestNode();
+					m_nodes[i]->m_mutex = new Platform::Mutex();
+					m_nodes[i]->m_value = 0;
+				}
+				m_listMutex = new Platform::Mutex("nodes");
+				m_locks = new NodeLocks(m_listMutex);
+			}
+
+			virtual void TearDown()
+			{
+				delete m_locks;
+				m_listMutex->Release();
+				for (uint8 i = 1; i <= c_nodes; ++i)
+				{
+					m_nodes[i]->m_mutex->Release();
+					delete m_nodes[i];
+				}
+			}
+
+		public:
+			TestNode* Lock(uint8 _nodeId, Platform::Mutex** o_mutex, bool* o_refused = NULL)
+			{
+				bool refused;
+				return m_locks->LockNode(m_nodes, _nodeId, o_mutex, (o_refused != NULL) ? o_refused : &refused);
+			}
+
+			// A getter or setter on one node, as the Manager API does through NodeLockGuard
+			void TouchNode(uint8 _nodeId)
+			{
+				Platform::Mutex* mutex;
+				TestNode* node = Lock(_nodeId, &mutex);
+				if (node != NULL)
+				{
+					Work(node);
+				}
+				m_locks->UnlockNode(mutex);
+			}
+
+			// The same, taking every node as the Manager API did before
+			void TouchNodeAll(uint8 _nodeId)
+			{
+				m_locks->LockNodes();
+				Work(m_nodes[_nodeId]);
+				m_locks->UnlockNodes();
+			}
+
+			// Run _threads threads calling _fn _iterations times each on their own node, and return the time taken
+			template<typename Fn>
+			int32 Run(uint32 _threads, uint32 _iterations, Fn _fn)
+			{
+				Platform::TimeStamp start;
+				std::vector<std::thread> threads;
+				for (uint32 t = 0; t < _threads; ++t)
+				{
+					threads.push_back(std::thread([this, t, _iterations, _fn]()
+					{
+						for (uint32 i = 0; i < _iterations; ++i)
+						{
+							_fn(this, (uint8) (t + 1));
+						}
+					}));
+				}
+				for (size_t t = 0; t < threads.size(); ++t)
+				{
+					threads[t].join();
+				}
+				return Platform::TimeStamp() - start;
+			}
+
+		protected:
+			TestNode* m_nodes[256];
+			Platform::Mutex* m_listMutex;
+			NodeLocks* m_locks;
+	};
+}
+
+TEST_F(NodeLocksTest, SameNodeRecursive)
+{
+	Platform::Mutex* outer;
+	Platform::Mutex* inner;
+	EXPECT_EQ(Lock(3, &outer), m_nodes[3]);
+	EXPECT_TRUE(NodeLocks::HoldsSingleNode());
+	EXPECT_EQ(Lock(3, &inner), m_nodes[3]);
+	EXPECT_EQ(inner, outer);
+	EXPECT_FALSE(m_locks->UnlockNode(inner));
+	EXPECT_TRUE(m_locks->UnlockNode(outer));
+	EXPECT_FALSE(NodeLocks::HoldsSingleNode());
+	EXPECT_TRUE(m_nodes[3]->m_mutex->IsSignalled());
+}
+
+TEST_F(NodeLocksTest, MissingNode)
+{
+	Platform::Mutex* mutex;
+	bool refused = true;
+	EXPECT_EQ(Lock(100, &mutex, &refused), (TestNode*) NULL);
+	EXPECT_EQ(mutex, (Platform::Mutex*) NULL);
+	EXPECT_FALSE(refused);
+	EXPECT_FALSE(NodeLocks::HoldsSingleNode());
+	EXPECT_TRUE(m_listMutex->IsSignalled());
+}
+
+TEST_F(NodeLocksTest, SecondNodeFails)
+{
+	Platform::Mutex* first;
+	Platform::Mutex* second;
+	bool refused = true;
+	EXPECT_EQ(Lock(1, &first, &refused), m_nodes[1]);
+	EXPECT_FALSE(refused);
+	EXPECT_EQ(Lock(2, &second, &refused), (TestNode*) NULL);
+	EXPECT_EQ(second, (Platform::Mutex*) NULL);
+	EXPECT_TRUE(refused);
+	EXPECT_TRUE(m_nodes[2]->m_mutex->IsSignalled());
+	// a node that does not exist is still reported as such
+	EXPECT_EQ(Lock(100, &second, &refused), (TestNode*) NULL);
+	EXPECT_FALSE(refused);
+	m_locks->UnlockNode(second);
+	EXPECT_TRUE(m_locks->UnlockNode(first));
+}
+
+TEST_F(NodeLocksTest, SingleNodesUnderAllNodes)
+{
+	EXPECT_TRUE(m_locks->LockNodes());
+	EXPECT_FALSE(NodeLocks::HoldsSingleNode());
+	Platform::Mutex* first;
+	Platform::Mutex* second;
+	EXPECT_EQ(Lock(1, &first), m_nodes[1]);
+	EXPECT_EQ(Lock(2, &second), m_nodes[2]);
+	EXPECT_FALSE(NodeLocks::HoldsSingleNode());
+	m_locks->UnlockNode(second);
+	m_locks->UnlockNode(first);
+	m_locks->UnlockNodes();
+	EXPECT_TRUE(m_listMutex->IsSignalled());
+}
+
+TEST_F(NodeLocksTest, AllNodesWhileHoldingOneFails)
+{
+	Platform::Mutex* mutex;
+	Lock(1, &mutex);
+	EXPECT_FALSE(m_locks->LockNodes());
+	EXPECT_TRUE(m_listMutex->IsSignalled());
+	// once the node is released, it succeeds
+	EXPECT_TRUE(m_locks->UnlockNode(mutex));
+	EXPECT_TRUE(m_locks->LockNodes());
+	m_locks->UnlockNodes();
+	EXPECT_TRUE(m_listMutex->IsSignalled());
+}
+
+TEST_F(NodeLocksTest, AllNodesWaitsForSingleNode)
+{
+	std::atomic<bool> locked(false);
+	std::atomic<bool> released(false);
+	std::thread holder([&]()
+	{
+		Platform::Mutex* mutex;
+		Lock(1, &mutex);
+		locked = true;
+		usleep(50000);
+		released = true;
+		m_locks->UnlockNode(mutex);
+	});
+	while (!locked)
+	{
+		usleep(1000);
+	}
+	EXPECT_TRUE(m_locks->LockNodes());
+	EXPECT_TRUE(released);
+	m_locks->UnlockNodes();
+	holder.join();
+}
+
+TEST_F(NodeLocksTest, NoDeadlockUnderContention)
+{
+	// Each thread holds a node and asks for another one, or for all of them, as the
+	// node query and alive paths did.  This used to hang.
+	uint32 const threads = 4;
+	uint32 const iterations = 20000;
+	std::atomic<uint32> refused(0);
+	std::vector<std::thread> workers;
+	for (uint32 t = 0; t < threads; ++t)
+	{
+		workers.push_back(std::thread([&, t]()
+		{
+			for (uint32 i = 0; i < iterations; ++i)
+			{
+				uint8 nodeId = (uint8) (1 + (t + i) % c_nodes);
+				if (i % 16 == 0)
+				{
+					TouchNodeAll(nodeId);
+					continue;
+				}
+				Platform::Mutex* mutex;
+				TestNode* node = Lock(nodeId, &mutex);
+				node->m_value++;
+				Platform::Mutex* other;
+				if (Lock((uint8) (1 + nodeId % c_nodes), &other) == NULL)
+				{
+					refused++;
+				}
+				m_locks->UnlockNode(other);
+				m_locks->UnlockNode(mutex);
+			}
+		}));
+	}
+	for (size_t t = 0; t < workers.size(); ++t)
+	{
+		workers[t].join();
+	}
+
+	uint32 total = 0;
+	for (uint8 i = 1; i <= c_nodes; ++i)
+	{
+		total += m_nodes[i]->m_value;
+	}
+	EXPECT_EQ(total, threads * iterations);
+	EXPECT_EQ(refused, threads * (iterations - iterations / 16));
+	EXPECT_TRUE(m_listMutex->IsSignalled());
+}
+
+TEST_F(NodeLocksTest, ScalingBenchmark)
+{
+	// Getters and setters on different nodes, with per node locks and with the whole list locked
+	uint32 const iterations = 100000;
+	for (uint32 threads = 1; threads <= 4; threads *= 2)
+	{
+		int32 single = Run(threads, iterations, [](NodeLocksTest* _test, uint8 _nodeId) { _test->TouchNode(_nodeId); });
+		int32 all = Run(threads, iterations, [](NodeLocksTest* _test, uint8 _nodeId) { _test->TouchNodeAll(_nodeId); });
+		for (uint32 t = 1; t <= threads; ++t)
+		{
+			EXPECT_EQ(m_nodes[t]->m_value, 2 * iterations);
+			m_nodes[t]->m_value = 0;
+		}
+		printf("NodeLocks: %u threads x %u calls: node lock %d ms, all nodes %d ms\n", threads, iterations, single, all);
+	}
+}
@@ -0,0 +1,126 @@
+//-----------------------------------------------------------------------------
+//
+//	Options_test.cpp
+//
+//	Test Framework for Options
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "Options.h"
+
+using namespace OpenZWave;
+
+namespace
+{
+	class OptionsTest: public ::testing::Test
+	{
+		protected:
+			virtual void SetUp()
+			{
+				char dir[] = "/tmp/ozwoptionsXXXXXX";
+				ASSERT_TRUE(mkdtemp(dir) != NULL);
+				m_dir = string(dir) + "/";
+			}
+			virtual void TearDown()
+			{
+				Options::Destroy();
+				unlink((m_dir + "options.xml").c_str());
+				rmdir(m_dir.c_str());
+			}
+
+			void WriteOptions(string const& _xml)
+			{
+				FILE* f = fopen((m_dir + "options.xml").c_str(), "wb");
+				fwrite(_xml.data(), 1, _xml.size(), f);
+				fclose(f);
+			}
+
+			Options* Lock(string const& _commandLine = "")
+			{
+				Options* options = Options::Create(m_dir, m_dir, _commandLine);
+				options->Lock();
+				return options;
+			}
+
+			string m_dir;
+	};
+}
+
+TEST_F(OptionsTest, ReadsXML)
+{
+	WriteOptions("<Options>\n<Option name=\"PollInterval\" value=\"1234\"/>\n<Option name=\"Associate\" value=\"false\"/>\n<Option name=\"Unknown\" value=\"1\"/>\n</Options>\n");
+	Options* options = Lock();
+	int32 interval = 0;
+	EXPECT_TRUE(options->GetOptionAsInt(Options::OptionKey_PollInterval, &interval));
+	EXPECT_EQ(interval, 1234);
+	bool associate = true;
+	EXPECT_TRUE(options->GetOptionAsBool(Options::OptionKey_Associate, &associate));
+	EXPECT_FALSE(associate);
+}
+
+TEST_F(OptionsTest, RejectsMalformedXML)
+{
+	// nothing from a file that does not parse is applied, not even the options before the error
+	WriteOptions("<Options>\n<Option name=\"PollInterval\" value=\"1234\"/>\n<Option name=\"Associate\" value=\"false\">\n</Options>\n");
+	Options* options = Lock();
+	int32 interval = 0;
+	EXPECT_TRUE(options->GetOptionAsInt(Options::OptionKey_PollInterval, &interval));
+	EXPECT_EQ(interval, 30000);
+	bool associate = false;
+	EXPECT_TRUE(options->GetOptionAsBool(Options::OptionKey_Associate, &associate));
+	EXPECT_TRUE(associate);
+}
+
+TEST_F(OptionsTest, CommandLineOverridesXML)
+{
+	WriteOptions("<Options><Option name=\"PollInterval\" value=\"1234\"/></Options>");
+	Options* options = Lock("--PollInterval 5678");
+	int32 interval = 0;
+	EXPECT_TRUE(options->GetOptionAsInt(Options::OptionKey_PollInterval, &interval));
+	EXPECT_EQ(interval, 5678);
+}
+
+TEST_F(OptionsTest, SecurityStrategy)
+{
+	Options* options = Lock();
+	// SUPPORTED is the default
+	EXPECT_TRUE(options->IsSecuredCC(0x25));
+	EXPECT_TRUE(options->IsSecuredCC(0x62));
+	Options::Destroy();
+
+	options = Lock("--SecurityStrategy custom --CustomSecuredCC 0x25,0x26,zz");
+	EXPECT_TRUE(options->IsSecuredCC(0x25));
+	EXPECT_TRUE(options->IsSecuredCC(0x26));
+	EXPECT_FALSE(options->IsSecuredCC(0x62));
+	EXPECT_TRUE(options->IsCustomSecuredCC(0x26));
+	Options::Destroy();
+
+	options = Lock("--SecurityStrategy ESSENTIAL --CustomSecuredCC 0x25");
+	EXPECT_FALSE(options->IsSecuredCC(0x25));
+	EXPECT_TRUE(options->IsCustomSecuredCC(0x25));
+}
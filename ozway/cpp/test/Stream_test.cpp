@@ -0,0 +1,253 @@
+//-----------------------------------------------------------------------------
+//
+//	Stream_test.cpp
+//
+//	Test Framework for the Stream ring buffer
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <thread>
+
+#include "platform/Stream.h"
+#include "platform/TimeStamp.h"
+#include "platform/Wait.h"
+
+namespace OpenZWave
+{
+	namespace Internal
+	{
+		namespace Platform
+		{
+			class StreamTest: public ::testing::Test
+			{
+				protected:
+					virtual void SetUp()
+					{
+						// Rounded up to a 16 byte buffer, so offsets and counters wrap at different points
+						m_stream = new Stream(10);
+					}
+
+					virtual void TearDown()
+					{
+						m_stream->Release();
+					}
+
+					// Move both counters, as if _position bytes had already passed through
+					void SetPosition(uint32 _position)
+					{
+						m_stream->m_head = _position;
+						m_stream->m_tail = _position;
+					}
+
+					// Put _size bytes counting up from _first, and read them back
+					void PutGet(uint8 _first, uint32 _size)
+					{
+						uint8 in[16];
+						uint8 out[16];
+						for (uint32 i = 0; i < _size; ++i)
+						{
+							in[i] = (uint8) (_first + i);
+						}
+						ASSERT_TRUE(m_stream->Put(in, _size));
+						EXPECT_EQ(m_stream->GetDataSize(), _size);
+						ASSERT_TRUE(m_stream->Get(out, _size));
+						EXPECT_EQ(memcmp(in, out, _size), 0);
+						EXPECT_EQ(m_stream->GetDataSize(), 0u);
+					}
+
+					Stream* m_stream;
+			};
+		}
+	}
+}
+
+using namespace OpenZWave::Internal::Platform;
+
+TEST_F(StreamTest, Capacity)
+{
+	uint8 data[16] = { 0 };
+	EXPECT_FALSE(m_stream->Put(data, 11));
+	EXPECT_TRUE(m_stream->Put(data, 10));
+	EXPECT_FALSE(m_stream->Put(data, 1));
+	EXPECT_FALSE(m_stream->Get(data, 11));
+	EXPECT_TRUE(m_stream->Get(data, 10));
+	EXPECT_FALSE(m_stream->Get(data, 1));
+}
+
+TEST_F(StreamTest, BufferWraparound)
+{
+	// Every offset into the buffer, and every split of a block across its end
+	for (uint32 size = 1; size <= 10; ++size)
+	{
+		for (uint32 i = 0; i < 16; ++i)
+		{
+			PutGet((uint8) (size * 16 + i), size);
+		}
+	}
+}
+
+TEST_F(StreamTest, CounterWraparound)
+{
+	// head and tail run past 2^32, with data on both sides
+	SetPosition(0xfffffffa);
+	uint8 data[10] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 };
+	uint8 out[10];
+	ASSERT_TRUE(m_stream->Put(data, 4));
+	ASSERT_TRUE(m_stream->Put(&data[4], 6));
+	EXPECT_EQ(m_stream->GetDataSize(), 10u);
+	EXPECT_FALSE(m_stream->Put(data, 1));
+	ASSERT_TRUE(m_stream->Get(out, 10));
+	EXPECT_EQ(memcmp(data, out, 10), 0);
+	for (uint32 i = 0; i < 8; ++i)
+	{
+		PutGet((uint8) i, 7);
+	}
+}
+
+TEST_F(StreamTest, Purge)
+{
+	SetPosition(0xfffffffe);
+	uint8 data[4] = { 1, 2, 3, 4 };
+	m_stream->Put(data, 4);
+	m_stream->Purge();
+	EXPECT_EQ(m_stream->GetDataSize(), 0u);
+	PutGet(5, 10);
+}
+
+TEST_F(StreamTest, SignalThreshold)
+{
+	uint8 data[4] = { 1, 2, 3, 4 };
+	m_stream->SetSignalThreshold(4);
+	m_stream->Put(data, 3);
+	EXPECT_EQ(Wait::Single(m_stream, 10), -1);
+	m_stream->Put(data, 1);
+	EXPECT_EQ(Wait::Single(m_stream, 10), 0);
+	m_stream->SetSignalThreshold(5);
+	EXPECT_EQ(Wait::Single(m_stream, 10), -1);
+}
+
+TEST_F(StreamTest, SingleProducerSingleConsumer)
+{
+	// The reader waits on the threshold as the driver does for each frame, while the writer
+	// fills the buffer in chunks that keep wrapping it.  Run a few thousand bytes through
+	// from just below the counter wrap and check that every byte arrives in order.
+	SetPosition(0xfffff000);
+	uint32 const total = 64 * 1024;
+	std::thread writer([this, total]()
+	{
+		uint32 sent = 0;
+		uint8 chunk[7];
+		while (sent < total)
+		{
+			uint32 size = 1 + sent % 7;
+			if (size > total - sent)
+			{
+				size = total - sent;
+			}
+			for (uint32 i = 0; i < size; ++i)
+			{
+				chunk[i] = (uint8) (sent + i);
+			}
+			if (m_stream->Put(chunk, size))
+			{
+				sent += size;
+			}
+			else
+			{
+				std::this_thread::yield();
+			}
+		}
+	});
+
+	uint32 received = 0;
+	uint32 errors = 0;
+	uint8 frame[5];
+	while (received < total)
+	{
+		uint32 size = 1 + received % 5;
+		if (size > total - received)
+		{
+			size = total - received;
+		}
+		m_stream->SetSignalThreshold(size);
+		if (Wait::Single(m_stream, 2000) != 0)
+		{
+			break;
+		}
+		ASSERT_TRUE(m_stream->Get(frame, size));
+		for (uint32 i = 0; i < size; ++i)
+		{
+			if (frame[i] != (uint8) (received + i))
+			{
+				++errors;
+			}
+		}
+		received += size;
+	}
+	writer.join();
+	EXPECT_EQ(received, total);
+	EXPECT_EQ(errors, 0u);
+}
+
+TEST_F(StreamTest, ThroughputBenchmark)
+{
+	// Serial API sized frames through a 256 byte buffer, polling rather than waiting
+	Stream* stream = new Stream(256);
+	uint32 const frames = 100000;
+	uint32 const frameSize = 12;
+	TimeStamp start;
+	std::thread writer([stream, frames, frameSize]()
+	{
+		uint8 frame[frameSize] = { 0 };
+		for (uint32 i = 0; i < frames; ++i)
+		{
+			frame[0] = (uint8) i;
+			while (!stream->Put(frame, frameSize))
+			{
+				std::this_thread::yield();
+			}
+		}
+	});
+	uint8 frame[frameSize];
+	uint32 errors = 0;
+	for (uint32 i = 0; i < frames; ++i)
+	{
+		while (stream->GetDataSize() < frameSize)
+		{
+			std::this_thread::yield();
+		}
+		stream->Get(frame, frameSize);
+		if (frame[0] != (uint8) i)
+		{
+			++errors;
+		}
+	}
+	writer.join();
+	int32 elapsed = TimeStamp() - start;
+	stream->Release();
+	EXPECT_EQ(errors, 0u);
+	printf("Stream: %u frames of %u bytes in %d ms\n", frames, frameSize, elapsed);
+}
@@ -0,0 +1,224 @@
+//-----------------------------------------------------------------------------
+//
+//	TimerThread_test.cpp
+//
+//	Test Framework for the TimerThread event heap
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <vector>
+
+#include "TimerThread.h"
+#include "platform/Event.h"
+#include "platform/Thread.h"
+#include "platform/TimeStamp.h"
+
+namespace OpenZWave
+{
+	namespace Internal
+	{
+		class TimerThreadTest: public ::testing::Test
+		{
+			protected:
+				TimerThreadTest() :
+						m_timer(NULL), m_thread(NULL), m_done(new Platform::Event())
+				{
+				}
+				virtual ~TimerThreadTest()
+				{
+					if (m_thread)
+					{
+						m_thread->Stop();
+						m_thread->Release();
+					}
+					m_done->Release();
+				}
+
+				void Start()
+				{
+					m_thread = new Platform::Thread("timer");
+					m_thread->Start(TimerThread::TimerThreadEntryPoint, &m_timer);
+				}
+
+				TimerThread::TimerEventEntry* SetEvent(int32 _ms, uint32 _id)
+				{
+					return m_timer.TimerSetEvent(_ms, bind(&TimerThreadTest::Fired, this, std::placeholders::_1), &m_instance, _id);
+				}
+				void DelEvent(TimerThread::TimerEventEntry* _te)
+				{
+					m_timer.TimerDelEvent(_te);
+				}
+				size_t Queued()
+				{
+					return m_timer.m_timerHeap.size();
+				}
+
+				// Every entry is where its heapIndex says, and due no sooner than its parent
+				bool IsHeap()
+				{
+					vector<TimerThread::TimerEventEntry*> const& heap = m_timer.m_timerHeap;
+					for (uint32 i = 0; i < heap.size(); ++i)
+					{
+						if (heap[i]->heapIndex != i)
+						{
+							return false;
+						}
+						if ((i > 0) && (heap[(i - 1) / 2]->due - heap[i]->due > 0))
+						{
+							return false;
+						}
+					}
+					return true;
+				}
+
+				virtual void Fired(uint32 _id)
+				{
+					m_fired.push_back(_id);
+					if (_id == 0)
+					{
+						m_done->Set();
+					}
+				}
+
+				TimerThread m_timer;
+				Timer m_instance;
+				Platform::Thread* m_thread;
+				Platform::Event* m_done;
+				vector<uint32> m_fired;
+		};
+
+		// Cancels and sets again event 1 from its own callback
+		class TimerThreadRearmTest: public TimerThreadTest
+		{
+			protected:
+				TimerThreadRearmTest() :
+						m_first(NULL), m_second(NULL)
+				{
+				}
+				virtual void Fired(uint32 _id)
+				{
+					if ((_id == 1) && (m_second == NULL))
+					{
+						DelEvent(m_first);
+						m_second = SetEvent(10, 1);
+					}
+					TimerThreadTest::Fired(_id);
+				}
+
+				TimerThread::TimerEventEntry* m_first;
+				TimerThread::TimerEventEntry* m_second;
+		};
+	}
+}
+
+using namespace OpenZWave;
+using namespace OpenZWave::Internal;
+
+TEST_F(TimerThreadTest, HeapOrder)
+{
+	srand(1);
+	vector<TimerThread::TimerEventEntry*> events;
+	for (uint32 i = 0; i < 1000; ++i)
+	{
+		events.push_back(SetEvent(60000 + rand() % 60000, i + 1));
+	}
+	EXPECT_TRUE(IsHeap());
+
+	// Delete every third event, from all over the heap
+	for (uint32 i = 0; i < events.size(); i += 3)
+	{
+		DelEvent(events[i]);
+	}
+	EXPECT_EQ(Queued(), 666u);
+	EXPECT_TRUE(IsHeap());
+
+	// A second delete of the same event leaves the heap alone
+	DelEvent(events[0]);
+	EXPECT_EQ(Queued(), 666u);
+	EXPECT_TRUE(IsHeap());
+
+	// The deleted entries are reused
+	TimerThread::TimerEventEntry* te = SetEvent(1000, 1);
+	EXPECT_EQ(te, events[999]);
+	EXPECT_TRUE(IsHeap());
+}
+
+TEST_F(TimerThreadTest, FiresInOrder)
+{
+	Start();
+	SetEvent(150, 0);
+	SetEvent(100, 3);
+	SetEvent(20, 1);
+	DelEvent(SetEvent(30, 4));
+	SetEvent(60, 2);
+	ASSERT_EQ(Platform::Wait::Single(m_done, 5000), 0);
+	ASSERT_EQ(m_fired.size(), 4u);
+	EXPECT_EQ(m_fired[0], 1u);
+	EXPECT_EQ(m_fired[1], 2u);
+	EXPECT_EQ(m_fired[2], 3u);
+	EXPECT_EQ(m_fired[3], 0u);
+	EXPECT_EQ(Queued(), 0u);
+}
+
+TEST_F(TimerThreadRearmTest, RearmFromCallback)
+{
+	Start();
+	m_first = SetEvent(10, 1);
+	SetEvent(200, 0);
+	ASSERT_EQ(Platform::Wait::Single(m_done, 5000), 0);
+
+	// The entry still firing must not be handed out again, or deleting it
+	// once its callback returned would cancel the new event
+	EXPECT_NE(m_second, m_first);
+	ASSERT_EQ(m_fired.size(), 3u);
+	EXPECT_EQ(m_fired[0], 1u);
+	EXPECT_EQ(m_fired[1], 1u);
+	EXPECT_EQ(m_fired[2], 0u);
+}
+
+TEST_F(TimerThreadTest, ChurnBenchmark)
+{
+	// Set 10000 timers and cancel them again in a different order, as the
+	// retry and wake up timers do
+	uint32 const count = 10000;
+	srand(1);
+	vector<TimerThread::TimerEventEntry*> events(count);
+	Platform::TimeStamp start;
+	for (uint32 round = 0; round < 10; ++round)
+	{
+		for (uint32 i = 0; i < count; ++i)
+		{
+			events[i] = SetEvent(60000 + rand() % 600000, i + 1);
+		}
+		for (uint32 i = 0; i < count; ++i)
+		{
+			DelEvent(events[(i * 7919) % count]);
+		}
+	}
+	int32 elapsed = Platform::TimeStamp() - start;
+	EXPECT_EQ(Queued(), 0u);
+	printf("TimerThread: %u set and delete pairs in %d ms\n", 10 * count, elapsed);
+}
@@ -0,0 +1,137 @@
+//-----------------------------------------------------------------------------
+//
+//	TinyXmlStreamReader_test.cpp
+//
+//	Test Framework for the streaming TinyXML reader
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <string>
+
+#include "tinyxml.h"
+
+TEST(TiXmlStreamReader, Children)
+{
+	TiXmlStreamReader reader;
+	ASSERT_TRUE(reader.Parse("<?xml version=\"1.0\"?>\n<!-- prolog -->\n<Root a=\"1\">\n  <One x=\"1\"><Sub/></One>\n  <!-- skipped -->\n  text\n  <Two x=\"2\"/>\n</Root>\n", TIXML_ENCODING_UTF8));
+	ASSERT_TRUE(reader.RootElement() != NULL);
+	EXPECT_STREQ(reader.RootElement()->Value(), "Root");
+	EXPECT_STREQ(reader.RootElement()->Attribute("a"), "1");
+
+	TiXmlElement const* child = reader.NextElement();
+	ASSERT_TRUE(child != NULL);
+	EXPECT_STREQ(child->Value(), "One");
+	EXPECT_TRUE(child->FirstChildElement("Sub") != NULL);
+	EXPECT_EQ(child->Row(), 4);
+	EXPECT_EQ(child->GetDocument(), reader.Document());
+
+	child = reader.NextElement();
+	ASSERT_TRUE(child != NULL);
+	EXPECT_STREQ(child->Value(), "Two");
+	EXPECT_STREQ(child->Attribute("x"), "2");
+
+	EXPECT_TRUE(reader.NextElement() == NULL);
+	EXPECT_FALSE(reader.Error());
+	// and it stays at the end
+	EXPECT_TRUE(reader.NextElement() == NULL);
+}
+
+TEST(TiXmlStreamReader, EmptyRoot)
+{
+	TiXmlStreamReader reader;
+	ASSERT_TRUE(reader.Parse("<Root b=\"x\"/>", TIXML_ENCODING_UTF8));
+	EXPECT_STREQ(reader.RootElement()->Attribute("b"), "x");
+	EXPECT_TRUE(reader.NextElement() == NULL);
+	EXPECT_FALSE(reader.Error());
+}
+
+TEST(TiXmlStreamReader, NoRoot)
+{
+	TiXmlStreamReader reader;
+	EXPECT_FALSE(reader.Parse("", TIXML_ENCODING_UTF8));
+	EXPECT_TRUE(reader.Error());
+	EXPECT_FALSE(reader.Parse("<!-- nothing -->", TIXML_ENCODING_UTF8));
+	EXPECT_TRUE(reader.Error());
+	EXPECT_FALSE(reader.LoadFile("/nonexistent/file.xml"));
+	EXPECT_TRUE(reader.Error());
+}
+
+TEST(TiXmlStreamReader, MalformedChild)
+{
+	TiXmlStreamReader reader;
+	ASSERT_TRUE(reader.Parse("<Root>\n<One/>\n<Two x=\"2\">\n</Root>", TIXML_ENCODING_UTF8));
+	ASSERT_TRUE(reader.NextElement() != NULL);
+	EXPECT_FALSE(reader.Error());
+	EXPECT_TRUE(reader.NextElement() == NULL);
+	EXPECT_TRUE(reader.Error());
+}
+
+TEST(TiXmlStreamReader, MissingEndTag)
+{
+	TiXmlStreamReader reader;
+	ASSERT_TRUE(reader.Parse("<Root>\n<One/>\n", TIXML_ENCODING_UTF8));
+	ASSERT_TRUE(reader.NextElement() != NULL);
+	EXPECT_TRUE(reader.NextElement() == NULL);
+	EXPECT_TRUE(reader.Error());
+}
+
+TEST(TiXmlStreamReader, WrongEndTag)
+{
+	TiXmlStreamReader reader;
+	ASSERT_TRUE(reader.Parse("<Root><One/></Other>", TIXML_ENCODING_UTF8));
+	ASSERT_TRUE(reader.NextElement() != NULL);
+	EXPECT_TRUE(reader.NextElement() == NULL);
+	EXPECT_TRUE(reader.Error());
+}
+
+TEST(TiXmlStreamReader, MatchesDocument)
+{
+	// every child comes out as TiXmlDocument would have parsed it
+	std::string xml = "<Root>";
+	for (int i = 0; i < 1000; ++i)
+	{
+		xml += "<Item id=\"" + std::to_string(i) + "\"><Value v=\"&amp;" + std::to_string(i * 7) + "\"/></Item>\r\n";
+	}
+	xml += "</Root>";
+
+	TiXmlDocument doc;
+	doc.Parse(xml.c_str(), 0, TIXML_ENCODING_UTF8);
+	ASSERT_FALSE(doc.Error());
+	TiXmlStreamReader reader;
+	ASSERT_TRUE(reader.Parse(xml.c_str(), TIXML_ENCODING_UTF8));
+
+	TiXmlElement const* expected = doc.RootElement()->FirstChildElement();
+	int count = 0;
+	while (TiXmlElement const* child = reader.NextElement())
+	{
+		ASSERT_TRUE(expected != NULL);
+		EXPECT_STREQ(child->Attribute("id"), expected->Attribute("id"));
+		EXPECT_STREQ(child->FirstChildElement()->Attribute("v"), expected->FirstChildElement()->Attribute("v"));
+		expected = expected->NextSiblingElement();
+		++count;
+	}
+	EXPECT_TRUE(expected == NULL);
+	EXPECT_FALSE(reader.Error());
+	EXPECT_EQ(count, 1000);
+}
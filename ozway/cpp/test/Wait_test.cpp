@@ -0,0 +1,119 @@
+//-----------------------------------------------------------------------------
+//
+//	Wait_test.cpp
+//
+//	Test Framework for the Wait objects
+//
+//	Copyright (c) 2020 Z-Wave.Me
+//
+//	SOFTWARE NOTICE AND LICENSE
+//
+//	This file is part of OpenZWave.
+//
+//	OpenZWave is free software: you can redistribute it and/or modify
+//	it under the terms of the GNU Lesser General Public License as published
+//	by the Free Software Foundation, either version 3 of the License,
+//	or (at your option) any later version.
+//
+//	OpenZWave is distributed in the hope that it will be useful,
+//	but WITHOUT ANY WARRANTY; without even the implied warranty of
+//	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//	GNU Lesser General Public License for more details.
+//
+//	You should have received a copy of the GNU Lesser General Public License
+//	along with OpenZWave.  If not, see <http://www.gnu.org/licenses/>.
+//
+//-----------------------------------------------------------------------------
+
+#include "gtest/gtest.h"
+
+#include <thread>
+#include <unistd.h>
+
+#include "platform/Event.h"
+#include "platform/Mutex.h"
+#include "platform/TimeStamp.h"
+#include "platform/Wait.h"
+
+using namespace OpenZWave::Internal::Platform;
+
+namespace
+{
+	// Set an event from another thread once the caller is waiting on it, and
+	// return how long the caller waited, or -1 if the wait timed out
+	int32 WaitForSetLater(Event* _event)
+	{
+		TimeStamp start;
+		std::thread setter([_event]()
+		{
+			usleep(50000);
+			_event->Set();
+		});
+		int32 res = Wait::Single(_event, 2000);
+		setter.join();
+		return (res == 0) ? TimeStamp() - start : -1;
+	}
+}
+
+TEST(Wait, Timeout)
+{
+	Event* event = new Event();
+	EXPECT_EQ(Wait::Single(event, 20), -1);
+	event->Set();
+	EXPECT_EQ(Wait::Single(event, 20), 0);
+	event->Release();
+}
+
+TEST(Wait, Multiple)
+{
+	Event* events[3] = { new Event(), new Event(), new Event() };
+	Wait* objects[3] = { events[0], events[1], events[2] };
+	EXPECT_EQ(Wait::Multiple(objects, 3, 20), -1);
+	events[2]->Set();
+	events[1]->Set();
+	EXPECT_EQ(Wait::Multiple(objects, 3, 20), 1);
+	events[1]->Reset();
+	EXPECT_EQ(Wait::Multiple(objects, 3, 20), 2);
+	for (int i = 0; i < 3; ++i)
+	{
+		events[i]->Release();
+	}
+}
+
+TEST(Wait, WokenFromOtherThread)
+{
+	Event* event = new Event();
+	int32 waited = WaitForSetLater(event);
+	EXPECT_GE(waited, 0);
+	EXPECT_LT(waited, 1000);
+	event->Release();
+}
+
+TEST(Wait, ReplacedObject)
+{
+	// As Manager::ResetController does on each reset.  The new event is
+	// likely to get the address and the descriptor of the old one.
+	for (int i = 0; i < 3; ++i)
+	{
+		Event* event = new Event();
+		int32 waited = WaitForSetLater(event);
+		EXPECT_GE(waited, 0);
+		EXPECT_LT(waited, 1000);
+		event->Release();
+	}
+}
+
+TEST(Wait, MutexOwnedElsewhere)
+{
+	Mutex* mutex = new Mutex("test");
+	std::thread owner([mutex]()
+	{
+		mutex->Lock();
+		usleep(50000);
+		mutex->Unlock();
+	});
+	usleep(10000);
+	EXPECT_EQ(Wait::Single(mutex, 2000), 0);
+	owner.join();
+	mutex->Release();
+}
@@ -90,6 +90,7 @@ class TiXmlAttribute;
 class TiXmlText;
 class TiXmlDeclaration;
 class TiXmlParsingData;
+class TiXmlStreamReader;
 
 const int TIXML_MAJOR_VERSION = 2;
 const int TIXML_MINOR_VERSION = 5;
@@ -197,6 +198,7 @@ class TiXmlBase
 	friend class TiXmlNode;
 	friend class TiXmlElement;
 	friend class TiXmlDocument;
+	friend class TiXmlStreamReader;
 
 public:
 	TiXmlBase()	:	userData(0)		{}
@@ -425,6 +427,7 @@ class TiXmlNode : public TiXmlBase
 {
 	friend class TiXmlDocument;
 	friend class TiXmlElement;
+	friend class TiXmlStreamReader;
 
 public:
 	#ifdef TIXML_USE_STL	
@@ -1551,6 +1554,80 @@ private:
 };
 
 
+/**
+	A pull parser for the common case of a document made of one root element with a
+	long list of children, such as a cache or config file. The document text is read
+	in one go, but only the root element (with its attributes, but no children) and
+	the current child of the root are ever held as a DOM:
+
+	\verbatim
+	TiXmlStreamReader reader;
+	if ( reader.LoadFile( "cache.xml" ) )
+	{
+		const TiXmlElement* root = reader.RootElement();
+		while ( const TiXmlElement* child = reader.NextElement() )
+		{
+			// child is a complete subtree, valid until the next call
+		}
+		if ( reader.Error() ) ...
+	}
+	\endverbatim
+
+	The elements returned belong to Document(), so GetDocument() and Parent()
+	work as they do for a TiXmlDocument, and Row() and Column() are tracked.
+*/
+class TiXmlStreamReader
+{
+public:
+	TiXmlStreamReader();
+	~TiXmlStreamReader();
+
+	/** Load a file, and parse it up to the start tag of the root element. Returns
+		true if a root element was found.
+	*/
+	bool LoadFile( const char* filename, TiXmlEncoding encoding = TIXML_DEFAULT_ENCODING );
+
+	/** As LoadFile, but from a null terminated block of xml data. The data is
+		not copied, and must remain valid until the reader is reset or destroyed.
+	*/
+	bool Parse( const char* p, TiXmlEncoding encoding = TIXML_DEFAULT_ENCODING );
+
+	/// The root element. Its attributes are available, but it has no children.
+	const TiXmlElement* RootElement() const		{ return root; }
+
+	/** Parse the next child element of the root, including all of its children.
+		The element returned by the previous call is deleted. Returns null once the
+		end tag of the root is reached, or if there is a parse error.
+	*/
+	const TiXmlElement* NextElement();
+
+	/// The document owning the elements, for SetUserData() and error reporting.
+	TiXmlDocument* Document()					{ return &document; }
+	const TiXmlDocument* Document() const		{ return &document; }
+
+	bool Error() const							{ return document.Error(); }
+	const char* ErrorDesc() const				{ return document.ErrorDesc(); }
+	int ErrorRow() const						{ return document.ErrorRow(); }
+
+private:
+	TiXmlStreamReader( const TiXmlStreamReader& );				// not implemented.
+	void operator=( const TiXmlStreamReader& );					// not implemented.
+
+	void Reset();
+	bool ParseRootStartTag();
+
+	TiXmlDocument		document;
+	TiXmlElement*		root;
+	TiXmlElement*		current;
+	TiXmlParsingData*	data;
+	char*				buffer;
+	const char*			p;
+	TiXmlEncoding		encoding;
+	TIXML_STRING		endTag;
+	bool				done;
+};
+
+
 /**
 	A TiXmlHandle is a class that wraps a node pointer with null checks; this is
 	an incredibly useful thing. Note that TiXmlHandle is not part of the TinyXml
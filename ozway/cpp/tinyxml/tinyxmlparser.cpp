@@ -172,6 +172,7 @@ void TiXmlBase::ConvertUTF32ToUTF8( unsigned long input, char* output, int* leng
 class TiXmlParsingData
 {
 	friend class TiXmlDocument;
+	friend class TiXmlStreamReader;
   public:
 	void Stamp( const char* now, TiXmlEncoding encoding );
 
@@ -1637,3 +1638,300 @@ bool TiXmlText::Blank() const
 	return true;
 }
 
+
+TiXmlStreamReader::TiXmlStreamReader()
+	: root( 0 ), current( 0 ), data( 0 ), buffer( 0 ), p( 0 ), encoding( TIXML_DEFAULT_ENCODING ), done( true )
+{
+}
+
+
+TiXmlStreamReader::~TiXmlStreamReader()
+{
+	Reset();
+}
+
+
+void TiXmlStreamReader::Reset()
+{
+	document.Clear();
+	document.ClearError();
+	root = 0;
+	current = 0;
+	delete data;
+	data = 0;
+	delete [] buffer;
+	buffer = 0;
+	p = 0;
+	endTag = "";
+	done = true;
+}
+
+
+bool TiXmlStreamReader::LoadFile( const char* filename, TiXmlEncoding _encoding )
+{
+	Reset();
+	document.SetValue( filename );
+
+	FILE* file = fopen( filename, "rb" );
+	if ( !file )
+	{
+		document.SetError( TiXmlBase::TIXML_ERROR_OPENING_FILE, 0, 0, TIXML_ENCODING_UNKNOWN );
+		return false;
+	}
+
+	fseek( file, 0, SEEK_END );
+	long length = ftell( file );
+	fseek( file, 0, SEEK_SET );
+	if ( length <= 0 )
+	{
+		fclose( file );
+		document.SetError( TiXmlBase::TIXML_ERROR_DOCUMENT_EMPTY, 0, 0, TIXML_ENCODING_UNKNOWN );
+		return false;
+	}
+
+	buffer = new char[ length+1 ];
+	if ( fread( buffer, length, 1, file ) != 1 )
+	{
+		fclose( file );
+		delete [] buffer;
+		buffer = 0;
+		document.SetError( TiXmlBase::TIXML_ERROR_OPENING_FILE, 0, 0, TIXML_ENCODING_UNKNOWN );
+		return false;
+	}
+	fclose( file );
+	buffer[length] = 0;
+
+	// Normalize the line breaks in place, as TiXmlDocument::LoadFile does, rather
+	// than building a second copy of the document.
+	char* out = buffer;
+	for ( const char* in = buffer; *in; ++in )
+	{
+		if ( *in == 0xd )
+		{
+			*out++ = 0xa;
+			if ( *(in+1) == 0xa )
+				++in;
+		}
+		else
+		{
+			*out++ = *in;
+		}
+	}
+	*out = 0;
+
+	// Parse() resets the reader, so hand the buffer over around it.
+	char* text = buffer;
+	buffer = 0;
+	bool result = Parse( text, _encoding );
+	buffer = text;
+	return result;
+}
+
+
+bool TiXmlStreamReader::Parse( const char* _p, TiXmlEncoding _encoding )
+{
+	Reset();
+	done = false;
+	encoding = _encoding;
+	p = _p;
+
+	if ( !p || !*p )
+	{
+		document.SetError( TiXmlBase::TIXML_ERROR_DOCUMENT_EMPTY, 0, 0, TIXML_ENCODING_UNKNOWN );
+		return false;
+	}
+
+	data = new TiXmlParsingData( p, document.TabSize(), 0, 0 );
+
+	if ( encoding == TIXML_ENCODING_UNKNOWN )
+	{
+		// Check for the Microsoft UTF-8 lead bytes.
+		const unsigned char* pU = (const unsigned char*)p;
+		if (	*(pU+0) && *(pU+0) == TIXML_UTF_LEAD_0
+			 && *(pU+1) && *(pU+1) == TIXML_UTF_LEAD_1
+			 && *(pU+2) && *(pU+2) == TIXML_UTF_LEAD_2 )
+		{
+			encoding = TIXML_ENCODING_UTF8;
+		}
+	}
+
+	// Parse the prolog (declaration, comments...) up to the root element.
+	p = TiXmlBase::SkipWhiteSpace( p, encoding );
+	while ( p && *p )
+	{
+		TiXmlNode* node = document.Identify( p, encoding );
+		if ( !node )
+		{
+			break;
+		}
+		if ( node->ToElement() )
+		{
+			delete node;
+			return ParseRootStartTag();
+		}
+
+		p = node->Parse( p, data, encoding );
+		document.LinkEndChild( node );
+
+		if ( encoding == TIXML_ENCODING_UNKNOWN && node->ToDeclaration() )
+		{
+			const char* enc = node->ToDeclaration()->Encoding();
+			if ( *enc == 0
+				 || TiXmlBase::StringEqual( enc, "UTF-8", true, TIXML_ENCODING_UNKNOWN )
+				 || TiXmlBase::StringEqual( enc, "UTF8", true, TIXML_ENCODING_UNKNOWN ) )
+				encoding = TIXML_ENCODING_UTF8;
+			else
+				encoding = TIXML_ENCODING_LEGACY;
+		}
+		p = TiXmlBase::SkipWhiteSpace( p, encoding );
+	}
+
+	document.SetError( TiXmlBase::TIXML_ERROR_DOCUMENT_EMPTY, 0, 0, encoding );
+	done = true;
+	return false;
+}
+
+
+// The start tag of the root element is parsed as TiXmlElement::Parse does, but
+// we stop at the '>' rather than reading the value.
+bool TiXmlStreamReader::ParseRootStartTag()
+{
+	root = new TiXmlElement( "" );
+	document.LinkEndChild( root );
+
+	data->Stamp( p, encoding );
+	root->location = data->Cursor();
+
+	p = TiXmlBase::SkipWhiteSpace( p+1, encoding );
+	const char* pErr = p;
+	TIXML_STRING name;
+	p = TiXmlBase::ReadName( p, &name, encoding );
+	if ( !p || !*p )
+	{
+		document.SetError( TiXmlBase::TIXML_ERROR_FAILED_TO_READ_ELEMENT_NAME, pErr, data, encoding );
+		done = true;
+		return false;
+	}
+	root->SetValue( name.c_str() );
+	endTag = "</";
+	endTag += name;
+	endTag += ">";
+
+	while ( p && *p )
+	{
+		pErr = p;
+		p = TiXmlBase::SkipWhiteSpace( p, encoding );
+		if ( !p || !*p )
+		{
+			break;
+		}
+		if ( *p == '/' )
+		{
+			// Empty root element.
+			if ( *(p+1) != '>' )
+			{
+				document.SetError( TiXmlBase::TIXML_ERROR_PARSING_EMPTY, p, data, encoding );
+				done = true;
+				return false;
+			}
+			p += 2;
+			done = true;
+			return true;
+		}
+		else if ( *p == '>' )
+		{
+			++p;
+			return true;
+		}
+		else
+		{
+			TiXmlAttribute attrib;
+			attrib.SetDocument( &document );
+			pErr = p;
+			p = attrib.Parse( p, data, encoding );
+			if ( !p || !*p )
+			{
+				document.SetError( TiXmlBase::TIXML_ERROR_PARSING_ELEMENT, pErr, data, encoding );
+				done = true;
+				return false;
+			}
+			root->SetAttribute( attrib.Name(), attrib.Value() );
+		}
+	}
+
+	document.SetError( TiXmlBase::TIXML_ERROR_READING_ATTRIBUTES, pErr, data, encoding );
+	done = true;
+	return false;
+}
+
+
+const TiXmlElement* TiXmlStreamReader::NextElement()
+{
+	if ( current )
+	{
+		root->RemoveChild( current );
+		current = 0;
+	}
+
+	while ( !done )
+	{
+		const char* pWithWhiteSpace = p;
+		p = TiXmlBase::SkipWhiteSpace( p, encoding );
+		if ( !p || !*p )
+		{
+			document.SetError( TiXmlBase::TIXML_ERROR_READING_END_TAG, p, data, encoding );
+			done = true;
+			break;
+		}
+
+		if ( *p != '<' )
+		{
+			// Text directly inside the root element is parsed, and dropped.
+			TiXmlText text( "" );
+			p = text.Parse( TiXmlBase::IsWhiteSpaceCondensed() ? p : pWithWhiteSpace, data, encoding );
+			if ( !p )
+			{
+				done = true;
+			}
+			continue;
+		}
+
+		if ( TiXmlBase::StringEqual( p, "</", false, encoding ) )
+		{
+			if ( TiXmlBase::StringEqual( p, endTag.c_str(), false, encoding ) )
+			{
+				p += endTag.length();
+			}
+			else
+			{
+				document.SetError( TiXmlBase::TIXML_ERROR_READING_END_TAG, p, data, encoding );
+			}
+			done = true;
+			break;
+		}
+
+		TiXmlNode* node = root->Identify( p, encoding );
+		if ( !node )
+		{
+			done = true;
+			break;
+		}
+		p = node->Parse( p, data, encoding );
+		root->LinkEndChild( node );
+		if ( !p || document.Error() )
+		{
+			root->RemoveChild( node );
+			done = true;
+			break;
+		}
+
+		if ( node->ToElement() )
+		{
+			current = node->ToElement();
+			return current;
+		}
+		// Comments and the like are not returned.
+		root->RemoveChild( node );
+	}
+	return 0;
+}
@@ -1196,6 +1196,7 @@ DISTFILES =	.gitignore \
 	cpp/build/OZW_RunTests.sh \
 	cpp/build/libopenzwave.pc.in \
 	cpp/build/ozw_config.in \
+	cpp/build/ozwbundle.cpp \
 	cpp/build/sh2ju.sh \
 	cpp/build/support.mk \
 	cpp/build/testconfig.pl \
@@ -1268,6 +1269,8 @@ DISTFILES =	.gitignore \
 	cpp/src/Bitfield.h \
 	cpp/src/CompatOptionManager.cpp \
 	cpp/src/CompatOptionManager.h \
+	cpp/src/ConfigBundle.cpp \
+	cpp/src/ConfigBundle.h \
 	cpp/src/DNSThread.cpp \
 	cpp/src/DNSThread.h \
 	cpp/src/Defs.h \
@@ -1278,20 +1281,28 @@ DISTFILES =	.gitignore \
 	cpp/src/Group.h \
 	cpp/src/Http.cpp \
 	cpp/src/Http.h \
+	cpp/src/LatencyHistogram.cpp \
+	cpp/src/LatencyHistogram.h \
 	cpp/src/Localization.cpp \
 	cpp/src/Localization.h \
 	cpp/src/Manager.cpp \
 	cpp/src/Manager.h \
 	cpp/src/ManufacturerSpecificDB.cpp \
 	cpp/src/ManufacturerSpecificDB.h \
+	cpp/src/Metrics.cpp \
+	cpp/src/Metrics.h \
 	cpp/src/Msg.cpp \
 	cpp/src/Msg.h \
 	cpp/src/Node.cpp \
 	cpp/src/Node.h \
+	cpp/src/NodeLocks.cpp \
+	cpp/src/NodeLocks.h \
 	cpp/src/Notification.cpp \
 	cpp/src/Notification.h \
 	cpp/src/NotificationCCTypes.cpp \
 	cpp/src/NotificationCCTypes.h \
+	cpp/src/NotificationPool.cpp \
+	cpp/src/NotificationPool.h \
 	cpp/src/OZWException.h \
 	cpp/src/Options.cpp \
 	cpp/src/Options.h \
@@ -1538,8 +1549,19 @@ DISTFILES =	.gitignore \
 	cpp/src/value_classes/ValueStore.h \
 	cpp/src/value_classes/ValueString.cpp \
 	cpp/src/value_classes/ValueString.h \
+	cpp/test/ConfigBundle_test.cpp \
+	cpp/test/LatencyHistogram_test.cpp \
 	cpp/test/Makefile \
+	cpp/test/Metrics_test.cpp \
+	cpp/test/MsgQueueList_test.cpp \
+	cpp/test/Mutex_test.cpp \
+	cpp/test/NodeLocks_test.cpp \
+	cpp/test/Options_test.cpp \
+	cpp/test/Stream_test.cpp \
+	cpp/test/TimerThread_test.cpp \
+	cpp/test/TinyXmlStreamReader_test.cpp \
 	cpp/test/ValueID_test.cpp \
+	cpp/test/Wait_test.cpp \
 	cpp/test/include/gtest/gtest-death-test.h \
 	cpp/test/include/gtest/gtest-message.h \
 	cpp/test/include/gtest/gtest-param-test.h \